@@ -139,6 +139,17 @@ void p_amqp_set_content_type_binary(struct p_amqp_host *amqp_host)
   } 
 }
 
+void p_amqp_set_confirm_window(struct p_amqp_host *amqp_host, u_int32_t opt)
+{
+  if (amqp_host) amqp_host->confirm_window = opt;
+}
+
+/* records carried by the next published message, for confirm accounting */
+void p_amqp_set_publish_elems(struct p_amqp_host *amqp_host, u_int32_t opt)
+{
+  if (amqp_host) amqp_host->publish_elems = opt;
+}
+
 int p_amqp_get_sockfd(struct p_amqp_host *amqp_host)
 {
   if (amqp_host) {
@@ -219,6 +230,30 @@ int p_amqp_connect_to_publish(struct p_amqp_host *amqp_host)
     return ERR;
   }
 
+  if (amqp_host->confirm_window) {
+    amqp_confirm_select(amqp_host->conn, 1);
+
+    amqp_host->ret = amqp_get_rpc_reply(amqp_host->conn);
+    if (amqp_host->ret.reply_type != AMQP_RESPONSE_NORMAL) {
+      Log(LOG_ERR, "ERROR ( %s/%s ): Connection failed to RabbitMQ: p_amqp_connect_to_publish(): unable to enable publisher confirms\n", config.name, config.type);
+      p_amqp_close(amqp_host, TRUE);
+      return ERR;
+    }
+
+    amqp_host->confirm_slots = malloc(amqp_host->confirm_window * sizeof(struct p_amqp_confirm_slot));
+    if (!amqp_host->confirm_slots) {
+      Log(LOG_ERR, "ERROR ( %s/%s ): p_amqp_connect_to_publish(): malloc() failed (confirm_slots)\n", config.name, config.type);
+      p_amqp_close(amqp_host, TRUE);
+      return ERR;
+    }
+
+    memset(amqp_host->confirm_slots, 0, amqp_host->confirm_window * sizeof(struct p_amqp_confirm_slot));
+
+    /* delivery tags are per channel and start from 1 */
+    amqp_host->confirm_next = 1;
+    amqp_host->confirm_last = 0;
+  }
+
   // XXX: to be removed 
   amqp_host->msg_props._flags = AMQP_BASIC_CONTENT_TYPE_FLAG;
   amqp_host->msg_props.content_type = amqp_cstring_bytes("application/json");
@@ -259,6 +294,8 @@ int p_amqp_publish_string(struct p_amqp_host *amqp_host, char *json_str)
 				json_str);
   }
 
+  if (amqp_host->confirm_window) return p_amqp_confirm_published(amqp_host);
+
   return SUCCESS;
 }
 
@@ -292,11 +329,29 @@ int p_amqp_publish_binary(struct p_amqp_host *amqp_host, void *data, u_int32_t d
 				amqp_host->routing_key, amqp_host->msg_props.delivery_mode);
   }
 
+  if (amqp_host->confirm_window) return p_amqp_confirm_published(amqp_host);
+
   return SUCCESS;
 }
 
 void p_amqp_close(struct p_amqp_host *amqp_host, int set_fail)
 {
+  if (amqp_host->confirm_slots) {
+    u_int64_t tag;
+
+    for (tag = amqp_host->confirm_last + 1; tag < amqp_host->confirm_next; tag++) {
+      if (!amqp_host->confirm_slots[tag % amqp_host->confirm_window].settled)
+	amqp_host->stats.msgs_unconfirmed++;
+    }
+
+    free(amqp_host->confirm_slots);
+    amqp_host->confirm_slots = NULL;
+    amqp_host->confirm_next = 0;
+    amqp_host->confirm_last = 0;
+  }
+
+  amqp_host->publish_elems = 0;
+
   if (amqp_host->conn) {
     if (amqp_get_socket(amqp_host->conn)) amqp_connection_close(amqp_host->conn, AMQP_REPLY_SUCCESS);
 
@@ -315,11 +370,143 @@ int p_amqp_is_alive(struct p_amqp_host *amqp_host)
   else return ERR;
 }
 
-#if defined WITH_JANSSON
-int write_and_free_json_amqp(void *amqp_log, void *obj)
+int p_amqp_confirm_published(struct p_amqp_host *amqp_host)
+{
+  struct p_amqp_confirm_slot *slot;
+  u_int32_t inflight;
+
+  slot = &amqp_host->confirm_slots[amqp_host->confirm_next % amqp_host->confirm_window];
+  gettimeofday(&slot->tstamp, NULL);
+  slot->elems = amqp_host->publish_elems;
+  slot->settled = FALSE;
+  amqp_host->confirm_next++;
+  amqp_host->publish_elems = 0;
+
+  inflight = (amqp_host->confirm_next - 1) - amqp_host->confirm_last;
+  if (inflight > amqp_host->stats.inflight_max) amqp_host->stats.inflight_max = inflight;
+
+  /* window is full: let half of it drain before publishing again */
+  if (inflight >= amqp_host->confirm_window) {
+    amqp_host->stats.window_stalls++;
+    return p_amqp_confirm_wait(amqp_host, amqp_host->confirm_window / 2);
+  }
+
+  return SUCCESS;
+}
+
+int p_amqp_confirm_wait(struct p_amqp_host *amqp_host, u_int32_t max_inflight)
+{
+  amqp_frame_t frame;
+  struct timeval timeout;
+  int ret;
+
+  if (!amqp_host->conn || !amqp_host->confirm_slots) return ERR;
+
+  while (((amqp_host->confirm_next - 1) - amqp_host->confirm_last) > max_inflight) {
+    timeout.tv_sec = PM_AMQP_CONFIRM_TIMEOUT;
+    timeout.tv_usec = 0;
+
+    ret = amqp_simple_wait_frame_noblock(amqp_host->conn, &frame, &timeout);
+    if (ret != AMQP_STATUS_OK) {
+      Log(LOG_ERR, "ERROR ( %s/%s ): Connection failed to RabbitMQ: p_amqp_confirm_wait(): %s\n",
+	  config.name, config.type, amqp_error_string2(ret));
+      amqp_host->status = ret;
+      p_amqp_close(amqp_host, TRUE);
+      return ERR;
+    }
+
+    if (frame.frame_type != AMQP_FRAME_METHOD) continue;
+
+    switch (frame.payload.method.id) {
+    case AMQP_BASIC_ACK_METHOD:
+      {
+	amqp_basic_ack_t *ack = (amqp_basic_ack_t *) frame.payload.method.decoded;
+
+	p_amqp_confirm_settle(amqp_host, ack->delivery_tag, ack->multiple, TRUE);
+      }
+      break;
+    case AMQP_BASIC_NACK_METHOD:
+      {
+	amqp_basic_nack_t *nack = (amqp_basic_nack_t *) frame.payload.method.decoded;
+
+	if (config.debug) Log(LOG_DEBUG, "DEBUG ( %s/%s ): RabbitMQ nack: p_amqp_confirm_wait() [TAG=%llu MULTIPLE=%u]\n",
+				config.name, config.type, (unsigned long long) nack->delivery_tag, nack->multiple);
+	p_amqp_confirm_settle(amqp_host, nack->delivery_tag, nack->multiple, FALSE);
+      }
+      break;
+    case AMQP_CHANNEL_CLOSE_METHOD:
+    case AMQP_CONNECTION_CLOSE_METHOD:
+      Log(LOG_ERR, "ERROR ( %s/%s ): Connection failed to RabbitMQ: p_amqp_confirm_wait(): closed by the broker\n", config.name, config.type);
+      amqp_host->status = AMQP_STATUS_CONNECTION_CLOSED;
+      p_amqp_close(amqp_host, TRUE);
+      return ERR;
+    default:
+      break;
+    }
+
+    amqp_maybe_release_buffers(amqp_host->conn);
+  }
+
+  return SUCCESS;
+}
+
+void p_amqp_confirm_settle(struct p_amqp_host *amqp_host, u_int64_t tag, int multiple, int ack)
+{
+  struct p_amqp_confirm_slot *slot;
+  struct timeval now;
+  u_int64_t idx, latency;
+
+  if (tag <= amqp_host->confirm_last || tag >= amqp_host->confirm_next) return;
+
+  gettimeofday(&now, NULL);
+
+  for (idx = (multiple ? amqp_host->confirm_last + 1 : tag); idx <= tag; idx++) {
+    slot = &amqp_host->confirm_slots[idx % amqp_host->confirm_window];
+    if (slot->settled) continue;
+
+    slot->settled = TRUE;
+    if (ack) {
+      amqp_host->stats.msgs_acked++;
+      amqp_host->stats.elems_acked += slot->elems;
+    }
+    else amqp_host->stats.msgs_nacked++;
+
+    if (timercmp(&now, &slot->tstamp, >)) {
+      latency = (now.tv_sec - slot->tstamp.tv_sec) * 1000000 + (now.tv_usec - slot->tstamp.tv_usec);
+      amqp_host->stats.latency_sum += latency;
+      if (latency > amqp_host->stats.latency_max) amqp_host->stats.latency_max = latency;
+    }
+    amqp_host->stats.latency_num++;
+  }
+
+  /* slide the window past the tags settled so far */
+  while ((amqp_host->confirm_last + 1) < amqp_host->confirm_next &&
+	 amqp_host->confirm_slots[(amqp_host->confirm_last + 1) % amqp_host->confirm_window].settled)
+    amqp_host->confirm_last++;
+}
+
+int write_string_amqp(void *amqp_log, char *str)
 {
   char *orig_amqp_routing_key = NULL, dyn_amqp_routing_key[SRVBUFLEN];
   struct p_amqp_host *alog = (struct p_amqp_host *) amqp_log;
+  int ret;
+
+  if (alog->rk_rr.max) {
+    orig_amqp_routing_key = p_amqp_get_routing_key(alog);
+    P_handle_table_dyn_rr(dyn_amqp_routing_key, SRVBUFLEN, orig_amqp_routing_key, &alog->rk_rr);
+    p_amqp_set_routing_key(alog, dyn_amqp_routing_key);
+  }
+
+  ret = p_amqp_publish_string(alog, str);
+
+  if (alog->rk_rr.max) p_amqp_set_routing_key(alog, orig_amqp_routing_key);
+
+  return ret;
+}
+
+#if defined WITH_JANSSON
+int write_and_free_json_amqp(void *amqp_log, void *obj)
+{
   int ret = ERR;
 
   char *tmpbuf = NULL;
@@ -329,16 +516,8 @@ int write_and_free_json_amqp(void *amqp_log, void *obj)
   json_decref(json_obj);
 
   if (tmpbuf) {
-    if (alog->rk_rr.max) {
-      orig_amqp_routing_key = p_amqp_get_routing_key(alog);
-      P_handle_table_dyn_rr(dyn_amqp_routing_key, SRVBUFLEN, orig_amqp_routing_key, &alog->rk_rr);
-      p_amqp_set_routing_key(alog, dyn_amqp_routing_key);
-    }
-
-    ret = p_amqp_publish_string(alog, tmpbuf);
+    ret = write_string_amqp(amqp_log, tmpbuf);
     free(tmpbuf);
-
-    if (alog->rk_rr.max) p_amqp_set_routing_key(alog, orig_amqp_routing_key);
   }
 
   return ret;
@@ -29,8 +29,28 @@
 /* defines */
 #define AMQP_DEFAULT_RETRY	60
 #define PM_AMQP_MIN_FRAME_SIZE	4096
+#define PM_AMQP_CONFIRM_TIMEOUT	10
 
 /* structures */
+struct p_amqp_confirm_stats {
+  u_int64_t msgs_acked;
+  u_int64_t msgs_nacked;
+  u_int64_t msgs_unconfirmed;
+  u_int64_t elems_acked;	/* records carried by acked messages */
+  u_int64_t window_stalls;
+  u_int32_t inflight_max;
+  u_int64_t latency_num;
+  u_int64_t latency_sum;	/* usecs */
+  u_int64_t latency_max;	/* usecs */
+};
+
+/* publisher confirms: one slot per in-flight delivery tag */
+struct p_amqp_confirm_slot {
+  struct timeval tstamp;
+  u_int32_t elems;
+  u_int8_t settled;
+};
+
 struct p_amqp_host {
   char *user;
   char *passwd;
@@ -52,6 +72,13 @@ struct p_amqp_host {
   struct amqp_basic_properties_t_ msg_props;
   int status;
 
+  u_int32_t confirm_window;
+  u_int64_t confirm_next;
+  u_int64_t confirm_last;
+  u_int32_t publish_elems;
+  struct p_amqp_confirm_slot *confirm_slots;
+  struct p_amqp_confirm_stats stats;
+
   struct p_broker_timers btimers;
 };
 
@@ -78,6 +105,8 @@ EXT void p_amqp_set_frame_max(struct p_amqp_host *, u_int32_t);
 EXT void p_amqp_set_heartbeat_interval(struct p_amqp_host *, int);
 EXT void p_amqp_set_content_type_json(struct p_amqp_host *);
 EXT void p_amqp_set_content_type_binary(struct p_amqp_host *);
+EXT void p_amqp_set_confirm_window(struct p_amqp_host *, u_int32_t);
+EXT void p_amqp_set_publish_elems(struct p_amqp_host *, u_int32_t);
 
 EXT char *p_amqp_get_routing_key(struct p_amqp_host *);
 EXT int p_amqp_get_routing_key_rr(struct p_amqp_host *);
@@ -91,7 +120,11 @@ EXT int p_amqp_publish_string(struct p_amqp_host *, char *);
 EXT int p_amqp_publish_binary(struct p_amqp_host *, void *, u_int32_t);
 EXT void p_amqp_close(struct p_amqp_host *, int);
 EXT int p_amqp_is_alive(struct p_amqp_host *);
+EXT int p_amqp_confirm_published(struct p_amqp_host *);
+EXT int p_amqp_confirm_wait(struct p_amqp_host *, u_int32_t);
+EXT void p_amqp_confirm_settle(struct p_amqp_host *, u_int64_t, int, int);
 
+EXT int write_string_amqp(void *, char *);
 EXT int write_and_free_json_amqp(void *, void *);
 
 /* global vars */
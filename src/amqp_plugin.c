@@ -341,9 +341,12 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
 
   char *json_buf = NULL;
   int json_buf_off = 0;
+  struct pm_json_buf json_enc;
 
 #ifdef WITH_AVRO
   avro_writer_t avro_writer;
+  avro_value_iface_t *avro_iface = NULL;
+  avro_value_t avro_value;
   char *avro_buf = NULL;
   int avro_buffer_full = FALSE;
 #endif
@@ -374,6 +377,7 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
   p_amqp_set_vhost(&amqpp_amqp_host, config.amqp_vhost);
   p_amqp_set_persistent_msg(&amqpp_amqp_host, config.amqp_persistent_msg);
   p_amqp_set_frame_max(&amqpp_amqp_host, config.amqp_frame_max);
+  p_amqp_set_confirm_window(&amqpp_amqp_host, config.amqp_confirm_window);
 
   if (config.message_broker_output & PRINT_OUTPUT_JSON) p_amqp_set_content_type_json(&amqpp_amqp_host);
   else if (config.message_broker_output & PRINT_OUTPUT_AVRO) p_amqp_set_content_type_binary(&amqpp_amqp_host);
@@ -396,6 +400,7 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
   memset(&empty_pmpls, 0, sizeof(struct pkt_mpls_primitives));
   memset(&empty_ptun, 0, sizeof(struct pkt_tunnel_primitives));
   memset(empty_pcust, 0, config.cpptrs.len);
+  memset(&json_enc, 0, sizeof(json_enc));
 
   ret = p_amqp_connect_to_publish(&amqpp_amqp_host);
   if (ret) return;
@@ -434,6 +439,10 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
       }
       else memset(json_buf, 0, config.sql_multi_values);
     }
+
+#ifdef WITH_JANSSON
+    pm_json_buf_init(&json_enc, 0);
+#endif
   }
   else if (config.message_broker_output & PRINT_OUTPUT_AVRO) {
 #ifdef WITH_AVRO
@@ -447,12 +456,15 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
     }
 
     avro_writer = avro_writer_memory(avro_buf, config.avro_buffer_size);
+
+    /* class and value are built once and reused for all records */
+    avro_iface = avro_generic_class_from_schema(avro_acct_schema);
+    check_i(avro_generic_value_new(avro_iface, &avro_value));
 #endif
   }
 
   for (j = 0; j < index; j++) {
-    void *json_obj;
-    char *json_str;
+    char *json_str = NULL;
 
     if (queue[j]->valid != PRINT_CACHE_COMMITTED) continue;
 
@@ -479,24 +491,25 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
 
     if (config.message_broker_output & PRINT_OUTPUT_JSON) {
 #ifdef WITH_JANSSON
-      json_t *json_obj = json_object();
       int idx;
 
-      for (idx = 0; idx < N_PRIMITIVES && cjhandler[idx]; idx++) cjhandler[idx](json_obj, queue[j]);
-      add_writer_name_and_pid_json(json_obj, config.name, writer_pid);
+      /* serialized in place, json_str is not to be freed */
+      pm_json_buf_begin(&json_enc);
+      for (idx = 0; idx < N_PRIMITIVES && cjhandler[idx]; idx++) cjhandler[idx](&json_enc, queue[j]);
+      pm_json_buf_add_writer_id(&json_enc, config.name, writer_pid);
+      pm_json_buf_end(&json_enc);
 
-      json_str = compose_json_str(json_obj);
+      json_str = json_enc.base;
 #endif
     }
     else if (config.message_broker_output & PRINT_OUTPUT_AVRO) {
 #ifdef WITH_AVRO
-      avro_value_iface_t *avro_iface = avro_generic_class_from_schema(avro_acct_schema);
-      avro_value_t avro_value = compose_avro(config.what_to_count, config.what_to_count_2, queue[j]->flow_type,
-                           &queue[j]->primitives, pbgp, pnat, pmpls, ptun, pcust, pvlen, queue[j]->bytes_counter,
-                           queue[j]->packet_counter, queue[j]->flow_counter, queue[j]->tcp_flags,
-                           &queue[j]->basetime, queue[j]->stitch, avro_iface);
       size_t avro_value_size;
 
+      compose_avro(config.what_to_count, config.what_to_count_2, queue[j]->flow_type,
+                   &queue[j]->primitives, pbgp, pnat, pmpls, ptun, pcust, pvlen, queue[j]->bytes_counter,
+                   queue[j]->packet_counter, queue[j]->flow_counter, queue[j]->tcp_flags,
+                   &queue[j]->basetime, queue[j]->stitch, &avro_value);
       add_writer_name_and_pid_avro(avro_value, config.name, writer_pid);
       avro_value_sizeof(&avro_value, &avro_value_size);
 
@@ -518,9 +531,6 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
       else {
         mv_num++;
       }
-
-      avro_value_decref(&avro_value);
-      avro_value_iface_decref(avro_iface);
 #else
       if (config.debug) Log(LOG_DEBUG, "DEBUG ( %s/%s ): compose_avro(): AVRO object not created due to missing --enable-avro\n", config.name, config.type);
 #endif
@@ -530,7 +540,7 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
       char *tmp_str = NULL;
 
       if (json_str && config.sql_multi_values) {
-	int json_strlen = (strlen(json_str) ? (strlen(json_str) + 1) : 0);
+	int json_strlen = (json_enc.len ? (json_enc.len + 1) : 0);
 
 	if (json_strlen >= (config.sql_multi_values - json_buf_off)) {
 	  if (json_strlen >= config.sql_multi_values) {
@@ -542,13 +552,14 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
 	  json_str = json_buf;
         }
         else {
-	  strcat(json_buf, json_str);
+	  memcpy(&json_buf[json_buf_off], json_str, json_enc.len);
+	  json_buf_off += json_enc.len;
 	  mv_num++;
 
-	  string_add_newline(json_buf);
-	  json_buf_off = strlen(json_buf);
+	  json_buf[json_buf_off] = '\n';
+	  json_buf_off++;
+	  json_buf[json_buf_off] = '\0';
 
-	  free(json_str);
 	  json_str = NULL;
         }
       }
@@ -568,6 +579,7 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
         }
 
         Log(LOG_DEBUG, "DEBUG ( %s/%s ): %s\n\n", config.name, config.type, json_str);
+        p_amqp_set_publish_elems(&amqpp_amqp_host, (config.sql_multi_values ? mv_num : 1));
         ret = p_amqp_publish_string(&amqpp_amqp_host, json_str);
 
 	if (config.sql_multi_values) {
@@ -581,7 +593,6 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
 	  json_buf_off = strlen(json_buf);
         }
 
-        free(json_str);
         json_str = NULL;
 
         if (!ret) {
@@ -607,6 +618,7 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
           p_amqp_set_routing_key(&amqpp_amqp_host, dyn_amqp_routing_key);
         }
 
+        p_amqp_set_publish_elems(&amqpp_amqp_host, mv_num);
         ret = p_amqp_publish_binary(&amqpp_amqp_host, avro_buf, avro_writer_tell(avro_writer));
         avro_writer_reset(avro_writer);
         avro_buffer_full = FALSE;
@@ -625,6 +637,7 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
       if (json_buf && json_buf_off) {
 	/* no handling of dyn routing keys here: not compatible */
 	Log(LOG_DEBUG, "DEBUG ( %s/%s ): %s\n\n", config.name, config.type, json_buf);
+	p_amqp_set_publish_elems(&amqpp_amqp_host, mv_num);
 	ret = p_amqp_publish_string(&amqpp_amqp_host, json_buf);
 
 	if (!ret) qn += mv_num;
@@ -633,6 +646,7 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
     else if (config.message_broker_output & PRINT_OUTPUT_AVRO) {
 #ifdef WITH_AVRO
       if (avro_writer_tell(avro_writer)) {
+        p_amqp_set_publish_elems(&amqpp_amqp_host, mv_num);
         ret = p_amqp_publish_binary(&amqpp_amqp_host, avro_buf, avro_writer_tell(avro_writer));
         avro_writer_free(avro_writer);
 
@@ -662,8 +676,25 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
     }
   }
 
+  /* publisher confirms: wait for the tail of the window before leaving */
+  if (config.amqp_confirm_window) p_amqp_confirm_wait(&amqpp_amqp_host, 0);
+
   p_amqp_close(&amqpp_amqp_host, FALSE);
 
+  if (config.amqp_confirm_window) {
+    struct p_amqp_confirm_stats *stats = &amqpp_amqp_host.stats;
+
+    Log(LOG_INFO, "INFO ( %s/%s ): AMQP confirms (PID: %u, ACKED: %llu, NACKED: %llu, UNCONFIRMED: %llu, INFLIGHT max: %u/%u, STALLS: %llu, LAT avg/max: %llu/%llu ms)\n",
+	config.name, config.type, writer_pid, (unsigned long long)stats->msgs_acked, (unsigned long long)stats->msgs_nacked,
+	(unsigned long long)stats->msgs_unconfirmed, stats->inflight_max, config.amqp_confirm_window,
+	(unsigned long long)stats->window_stalls,
+	(unsigned long long)(stats->latency_num ? ((stats->latency_sum / stats->latency_num) / 1000) : 0),
+	(unsigned long long)(stats->latency_max / 1000));
+
+    /* nacked and never confirmed messages did not make it */
+    qn = stats->elems_acked;
+  }
+
   Log(LOG_INFO, "INFO ( %s/%s ): *** Purging cache - END (PID: %u, QN: %u/%u, ET: %u) ***\n",
 		config.name, config.type, writer_pid, qn, saved_index, duration);
 
@@ -672,8 +703,14 @@ void amqp_cache_purge(struct chained_cache *queue[], int index, int safe_action)
   if (empty_pcust) free(empty_pcust);
 
   if (json_buf) free(json_buf);
+  if (json_enc.base) free(json_enc.base);
 
 #ifdef WITH_AVRO
+  if (avro_iface) {
+    avro_value_decref(&avro_value);
+    avro_value_iface_decref(avro_iface);
+  }
+
   if (avro_buf) free(avro_buf);
 #endif
 }
@@ -27,6 +27,9 @@
 #include "addr.h"
 #include "bgp.h"
 #include "thread_pool.h"
+#if defined HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #if defined WITH_RABBITMQ
 #include "amqp_common.h"
 #endif
@@ -37,6 +40,11 @@
 /* variables to be exported away */
 thread_pool_t *bgp_pool;
 
+/* BGP workers */
+static thread_pool_t *bgp_workers_pool;
+static struct bgp_worker *bgp_workers;
+static int bgp_workers_num;
+
 /* Functions */
 void nfacctd_bgp_wrapper()
 {
@@ -75,7 +83,7 @@ void skinny_bgp_daemon_online()
   afi_t afi;
   safi_t safi;
   int clen = sizeof(client), yes=1, no=0;
-  time_t now, dump_refresh_deadline;
+  time_t now, dump_refresh_deadline, snapshot_deadline = 0;
   struct hosts_table allow;
   struct bgp_md5_table bgp_md5;
   struct timeval dump_refresh_timeout, *drt_ptr;
@@ -84,7 +92,7 @@ void skinny_bgp_daemon_online()
   /* select() stuff */
   fd_set read_descs, bkp_read_descs; 
   int fd, select_fd, bkp_select_fd, recalc_fds, select_num;
-  int recv_fd, send_fd;
+  int recv_fd, send_fd, peers_locked = FALSE;
 
   /* initial cleanups */
   reload_map_bgp_thread = FALSE;
@@ -394,6 +402,15 @@ void skinny_bgp_daemon_online()
       }
       dump_refresh_deadline = tmp_time;
       dump_refresh_deadline += config.bgp_table_dump_refresh_time; /* it's a deadline not a basetime */
+
+      /* RIB changes are journaled per peer only if dumps are incremental */
+      bgp_misc_db->dump.checkpoint = config.bgp_table_dump_checkpoint;
+
+      /* writers would overwrite each other's files otherwise */
+      if (config.bgp_table_dump_workers > 1 && config.bgp_table_dump_file && !strstr(config.bgp_table_dump_file, "$peer_src_ip")) {
+        Log(LOG_WARNING, "WARN ( %s/%s ): 'bgp_table_dump_workers' requires $peer_src_ip in 'bgp_table_dump_file'. Using a single writer.\n", config.name, bgp_misc_db->log_str);
+        config.bgp_table_dump_workers = 1;
+      }
     }
     else {
       config.bgp_table_dump_file = NULL;
@@ -410,6 +427,22 @@ void skinny_bgp_daemon_online()
 
   bgp_link_misc_structs(bgp_misc_db);
 
+  /* warm restart: RIB is restored before any session is accepted */
+  if (config.bgp_table_snapshot_file) {
+    if (!config.bgp_table_snapshot_refresh_time) config.bgp_table_snapshot_refresh_time = BGP_SNAPSHOT_REFRESH_TIME;
+    if (!config.bgp_table_snapshot_stale_time) config.bgp_table_snapshot_stale_time = BGP_SNAPSHOT_STALE_TIME;
+
+    bgp_snapshot_load(config.bgp_table_snapshot_file);
+    snapshot_deadline = (time(NULL) + config.bgp_table_snapshot_refresh_time);
+  }
+
+  /* established sessions are handed over to BGP workers, if any */
+  if (config.nfacctd_bgp_threads) {
+    if (config.bgp_xconnect_map)
+      Log(LOG_WARNING, "WARN ( %s/%s ): 'bgp_daemon_threads' is not compatible with 'bgp_daemon_xconnect_map'. Ignored.\n", config.name, bgp_misc_db->log_str);
+    else bgp_workers_init(config.nfacctd_bgp_threads);
+  }
+
   for (;;) {
     select_again:
 
@@ -447,10 +480,46 @@ void skinny_bgp_daemon_online()
     }
     else drt_ptr = NULL;
 
+    /* free up what RIB readers are done with; retry shortly if anything is left */
+    bgp_rib_reclaim(bgp_misc_db);
+
+    if (bgp_misc_db->rib_retired_head && (!drt_ptr || drt_ptr->tv_sec > BGP_RIB_RECLAIM_INTERVAL)) {
+      dump_refresh_timeout.tv_sec = BGP_RIB_RECLAIM_INTERVAL;
+      dump_refresh_timeout.tv_usec = 0;
+      drt_ptr = &dump_refresh_timeout;
+    }
+
+    /* wake up for RIB snapshots and for expiring stale routes */
+    if (snapshot_deadline || bgp_misc_db->peers_stale_num) {
+      time_t next = 0;
+
+      now = time(NULL);
+      if (snapshot_deadline) next = snapshot_deadline;
+      if (bgp_misc_db->peers_stale_num && (!next || bgp_misc_db->peers_stale_deadline < next))
+	next = bgp_misc_db->peers_stale_deadline;
+
+      if (!drt_ptr || drt_ptr->tv_sec > (next - now)) {
+	dump_refresh_timeout.tv_sec = (next > now ? (next - now) : 0);
+	dump_refresh_timeout.tv_usec = 0;
+	drt_ptr = &dump_refresh_timeout;
+      }
+    }
+
     select_num = select(select_fd, &read_descs, NULL, NULL, drt_ptr);
     if (select_num < 0) goto select_again;
     now = time(NULL);
 
+    if (snapshot_deadline && now >= snapshot_deadline) {
+      /* held while forking, as for dumps */
+      if (bgp_workers_num) bgp_rib_writers_pause(bgp_routing_db, bgp_misc_db);
+      bgp_handle_snapshot_event();
+      if (bgp_workers_num) bgp_rib_writers_resume(bgp_routing_db, bgp_misc_db);
+
+      while (snapshot_deadline <= now) snapshot_deadline += config.bgp_table_snapshot_refresh_time;
+    }
+
+    bgp_snapshot_stale_expire(now);
+
     /* signals handling */
     if (reload_map_bgp_thread) {
       if (config.nfacctd_bgp_allow_file) load_allow_file(config.nfacctd_bgp_allow_file, &allow);
@@ -478,6 +547,9 @@ void skinny_bgp_daemon_online()
     }
 
     if (reload_log_bgp_thread) {
+      pthread_mutex_lock(&bgp_misc_db->peers_mutex);
+      pthread_mutex_lock(&bgp_misc_db->msglog_mutex);
+
       for (peers_idx = 0; peers_idx < config.nfacctd_bgp_max_peers; peers_idx++) {
 	if (bgp_misc_db->peers_log[peers_idx].fd) {
 	  fclose(bgp_misc_db->peers_log[peers_idx].fd);
@@ -487,13 +559,18 @@ void skinny_bgp_daemon_online()
 	else break;
       }
 
+      pthread_mutex_unlock(&bgp_misc_db->msglog_mutex);
+      pthread_mutex_unlock(&bgp_misc_db->peers_mutex);
+
       reload_log_bgp_thread = FALSE;
     }
 
     if (bgp_misc_db->msglog_backend_methods || bgp_misc_db->dump_backend_methods) {
+      pthread_mutex_lock(&bgp_misc_db->msglog_mutex);
       gettimeofday(&bgp_misc_db->log_tstamp, NULL);
       compose_timestamp(bgp_misc_db->log_tstamp_str, SRVBUFLEN, &bgp_misc_db->log_tstamp, TRUE,
 			config.timestamps_since_epoch, config.timestamps_rfc3339, config.timestamps_utc);
+      pthread_mutex_unlock(&bgp_misc_db->msglog_mutex);
 
       if (bgp_misc_db->dump_backend_methods) {
 	while (bgp_misc_db->log_tstamp.tv_sec > dump_refresh_deadline) {
@@ -503,7 +580,10 @@ void skinny_bgp_daemon_online()
 			    config.timestamps_since_epoch, config.timestamps_rfc3339, config.timestamps_utc);
 	  bgp_misc_db->dump.period = config.bgp_table_dump_refresh_time;
 
+	  /* workers are held while forking, so that the dump sees a consistent RIB */
+	  if (bgp_workers_num) bgp_rib_writers_pause(bgp_routing_db, bgp_misc_db);
 	  bgp_handle_dump_event();
+	  if (bgp_workers_num) bgp_rib_writers_resume(bgp_routing_db, bgp_misc_db);
 	  dump_refresh_deadline += config.bgp_table_dump_refresh_time;
 	}
       }
@@ -540,6 +620,10 @@ void skinny_bgp_daemon_online()
     if (FD_ISSET(config.bgp_sock, &read_descs)) {
       int peers_check_idx, peers_num;
 
+      /* BGP workers may be closing sessions, hence freeing slots, meanwhile */
+      pthread_mutex_lock(&bgp_misc_db->peers_mutex);
+      peers_locked = TRUE;
+
       fd = accept(config.bgp_sock, (struct sockaddr *) &client, &clen);
       if (fd == ERR) goto read_data;
 
@@ -602,7 +686,7 @@ void skinny_bgp_daemon_online()
       }
 
       peer->fd = fd;
-      FD_SET(peer->fd, &bkp_read_descs);
+      if (!bgp_workers_num) FD_SET(peer->fd, &bkp_read_descs);
       peer->addr.family = ((struct sockaddr *)&client)->sa_family;
       if (peer->addr.family == AF_INET) {
 	peer->addr.address.ipv4.s_addr = ((struct sockaddr_in *)&client)->sin_addr.s_addr;
@@ -639,8 +723,13 @@ void skinny_bgp_daemon_online()
 	      bgp_peer_print(&peers[peers_check_idx], bgp_peer_str, INET6_ADDRSTRLEN);
               Log(LOG_INFO, "INFO ( %s/%s ): [%s] Replenishing stale connection by peer.\n",
 			config.name, bgp_misc_db->log_str, bgp_peer_str);
-              FD_CLR(peers[peers_check_idx].fd, &bkp_read_descs);
-              bgp_peer_close(&peers[peers_check_idx], FUNC_TYPE_BGP, FALSE, FALSE, FALSE, FALSE, NULL);
+
+	      /* owned by a BGP worker: wake it up for it to close the session */
+	      if (bgp_workers_num) shutdown(peers[peers_check_idx].fd, SHUT_RDWR);
+	      else {
+                FD_CLR(peers[peers_check_idx].fd, &bkp_read_descs);
+                bgp_peer_close(&peers[peers_check_idx], FUNC_TYPE_BGP, FALSE, FALSE, FALSE, FALSE, NULL);
+	      }
 	    }
 	    else {
 	      Log(LOG_WARNING, "WARN ( %s/%s ): [%s] Refusing new connection from existing peer (residual holdtime: %u).\n",
@@ -686,10 +775,23 @@ void skinny_bgp_daemon_online()
       }
 
       if (config.nfacctd_bgp_neighbors_file) write_neighbors_file(config.nfacctd_bgp_neighbors_file, FUNC_TYPE_BGP);
+
+      if (bgp_workers_num && bgp_workers_add_peer(peer) == ERR) {
+	bgp_peer_close(peer, FUNC_TYPE_BGP, FALSE, FALSE, FALSE, FALSE, NULL);
+	goto read_data;
+      }
     }
 
     read_data:
 
+    if (peers_locked) {
+      pthread_mutex_unlock(&bgp_misc_db->peers_mutex);
+      peers_locked = FALSE;
+    }
+
+    /* sessions are all read by BGP workers */
+    if (bgp_workers_num) goto select_again;
+
     /*
        We have something coming in: let's lookup which peer is that.
        FvD: To avoid starvation of the "later established" peers, we
@@ -799,10 +901,175 @@ void skinny_bgp_daemon_online()
   }
 }
 
+int bgp_workers_init(int num)
+{
+#if defined HAVE_SYS_EPOLL_H
+  int idx;
+
+  if (num <= 0) return 0;
+
+  bgp_workers = malloc(num * sizeof(struct bgp_worker));
+  if (!bgp_workers) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): Unable to malloc() BGP workers structure. Terminating thread.\n", config.name, bgp_misc_db->log_str);
+    exit_all(1);
+  }
+  memset(bgp_workers, 0, num * sizeof(struct bgp_worker));
+
+  for (idx = 0; idx < num; idx++) {
+    bgp_workers[idx].id = idx;
+    bgp_workers[idx].epoll_fd = epoll_create(BGP_WORKER_EVENTS);
+
+    if (bgp_workers[idx].epoll_fd < 0) {
+      Log(LOG_ERR, "ERROR ( %s/%s ): epoll_create() failed for BGP worker #%d (errno: %d). Terminating thread.\n",
+	  config.name, bgp_misc_db->log_str, idx, errno);
+      exit_all(1);
+    }
+  }
+
+  bgp_workers_pool = allocate_thread_pool(num);
+  assert(bgp_workers_pool);
+
+  for (idx = 0; idx < num; idx++)
+    send_to_pool(bgp_workers_pool, bgp_worker_daemon, &bgp_workers[idx]);
+
+  bgp_workers_num = num;
+  Log(LOG_INFO, "INFO ( %s/%s ): %d BGP worker thread(s) initialized\n", config.name, bgp_misc_db->log_str, num);
+
+  return num;
+#else
+  if (num > 0)
+    Log(LOG_WARNING, "WARN ( %s/%s ): 'bgp_daemon_threads' requires epoll() support. Ignored.\n", config.name, bgp_misc_db->log_str);
+
+  return 0;
+#endif
+}
+
+/* Hands a just established session to the least loaded worker */
+int bgp_workers_add_peer(struct bgp_peer *peer)
+{
+#if defined HAVE_SYS_EPOLL_H
+  struct bgp_worker *bw = NULL;
+  struct epoll_event ev;
+  char bgp_peer_str[INET6_ADDRSTRLEN];
+  int idx;
+
+  if (!peer || !bgp_workers_num) return ERR;
+
+  for (idx = 0; idx < bgp_workers_num; idx++) {
+    if (!bw || __atomic_load_n(&bgp_workers[idx].peers, __ATOMIC_RELAXED) < __atomic_load_n(&bw->peers, __ATOMIC_RELAXED))
+      bw = &bgp_workers[idx];
+  }
+
+  if (!bw) return ERR;
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = peer;
+
+  __atomic_add_fetch(&bw->peers, 1, __ATOMIC_RELAXED);
+
+  if (epoll_ctl(bw->epoll_fd, EPOLL_CTL_ADD, peer->fd, &ev) < 0) {
+    __atomic_sub_fetch(&bw->peers, 1, __ATOMIC_RELAXED);
+
+    bgp_peer_print(peer, bgp_peer_str, INET6_ADDRSTRLEN);
+    Log(LOG_ERR, "ERROR ( %s/%s ): [%s] epoll_ctl() failed for BGP worker #%d (errno: %d).\n",
+	config.name, bgp_misc_db->log_str, bgp_peer_str, bw->id, errno);
+
+    return ERR;
+  }
+
+  return SUCCESS;
+#else
+  return ERR;
+#endif
+}
+
+#if defined HAVE_SYS_EPOLL_H
+static void bgp_worker_peer_close(struct bgp_worker *bw, struct bgp_peer *peer, int ret)
+{
+  pthread_mutex_lock(&bgp_misc_db->peers_mutex);
+
+  epoll_ctl(bw->epoll_fd, EPOLL_CTL_DEL, peer->fd, NULL);
+
+  if (ret > 0) bgp_peer_close(peer, FUNC_TYPE_BGP, FALSE, TRUE, ret, BGP_NOTIFY_SUBCODE_UNSPECIFIC, NULL);
+  else bgp_peer_close(peer, FUNC_TYPE_BGP, FALSE, FALSE, FALSE, FALSE, NULL);
+
+  pthread_mutex_unlock(&bgp_misc_db->peers_mutex);
+
+  __atomic_sub_fetch(&bw->peers, 1, __ATOMIC_RELAXED);
+}
+#endif
+
+/*
+   BGP worker: reads and parses messages of the peers it owns and applies
+   them to the RIB. Peers are accepted, and assigned, by the BGP thread.
+*/
+void bgp_worker_daemon(struct bgp_worker *bw)
+{
+#if defined HAVE_SYS_EPOLL_H
+  struct epoll_event events[BGP_WORKER_EVENTS];
+  struct bgp_peer *peer;
+  char bgp_reply_pkt[BGP_BUFFER_SIZE], *bgp_reply_pkt_ptr;
+  char bgp_peer_str[INET6_ADDRSTRLEN];
+  int events_num, idx, ret;
+  time_t now;
+
+  if (!bw) return;
+
+  for (;;) {
+    events_num = epoll_wait(bw->epoll_fd, events, BGP_WORKER_EVENTS, ERR);
+    if (events_num < 0) {
+      if (errno != EINTR)
+	Log(LOG_WARNING, "WARN ( %s/%s ): epoll_wait() failed for BGP worker #%d (errno: %d).\n",
+	    config.name, bgp_misc_db->log_str, bw->id, errno);
+
+      continue;
+    }
+
+    now = time(NULL);
+
+    if (bgp_misc_db->msglog_backend_methods) {
+      pthread_mutex_lock(&bgp_misc_db->msglog_mutex);
+      gettimeofday(&bgp_misc_db->log_tstamp, NULL);
+      compose_timestamp(bgp_misc_db->log_tstamp_str, SRVBUFLEN, &bgp_misc_db->log_tstamp, TRUE,
+			config.timestamps_since_epoch, config.timestamps_rfc3339, config.timestamps_utc);
+      pthread_mutex_unlock(&bgp_misc_db->msglog_mutex);
+    }
+
+    for (idx = 0; idx < events_num; idx++) {
+      peer = (struct bgp_peer *) events[idx].data.ptr;
+
+      ret = recv(peer->fd, &peer->buf.base[peer->buf.truncated_len], (peer->buf.len - peer->buf.truncated_len), 0);
+      peer->msglen = (ret + peer->buf.truncated_len);
+
+      if (ret <= 0) {
+	bgp_peer_print(peer, bgp_peer_str, INET6_ADDRSTRLEN);
+	Log(LOG_INFO, "INFO ( %s/%s ): [%s] BGP connection reset by peer (%d).\n", config.name, bgp_misc_db->log_str, bgp_peer_str, errno);
+
+	bgp_worker_peer_close(bw, peer, FALSE);
+	continue;
+      }
+
+      /* see skinny_bgp_daemon_online() */
+      if (peer->status == Established && ((now - peer->last_keepalive) > (peer->ht / 2))) {
+	bgp_reply_pkt_ptr = bgp_reply_pkt;
+	bgp_reply_pkt_ptr += bgp_write_keepalive_msg(bgp_reply_pkt_ptr);
+	ret = send(peer->fd, bgp_reply_pkt, bgp_reply_pkt_ptr - bgp_reply_pkt, 0);
+	peer->last_keepalive = now;
+      }
+
+      ret = bgp_parse_msg(peer, now, TRUE);
+      if (ret) bgp_worker_peer_close(bw, peer, ret);
+    }
+  }
+#endif
+}
+
 void bgp_prepare_thread()
 {
   bgp_misc_db = &inter_domain_misc_dbs[FUNC_TYPE_BGP];
   memset(bgp_misc_db, 0, sizeof(struct bgp_misc_structs));
+  bgp_misc_locks_init(bgp_misc_db);
 
   bgp_misc_db->is_thread = TRUE;
   bgp_misc_db->has_lglass = FALSE;
@@ -815,6 +1082,7 @@ void bgp_prepare_daemon()
 {
   bgp_misc_db = &inter_domain_misc_dbs[FUNC_TYPE_BGP];
   memset(bgp_misc_db, 0, sizeof(struct bgp_misc_structs));
+  bgp_misc_locks_init(bgp_misc_db);
 
   bgp_misc_db->is_thread = FALSE;
   if (config.bgp_lg) bgp_misc_db->has_lglass = TRUE;
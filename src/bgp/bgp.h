@@ -21,6 +21,7 @@
 
 /* includes */
 #include <sys/poll.h>
+#include <pthread.h>
 #include "bgp_prefix.h"
 #include "bgp_packet.h"
 #include "bgp_table.h"
@@ -81,6 +82,11 @@
    nfacctd_bgp_stdcomm_pattern, nfacctd_bgp_extcomm_pattern */
 #define MAX_BGP_COMM_PATTERNS	16
 
+/* Community patterns compiled against numeric values, see load_comm_patterns() */
+#define BGP_COMM_MATCH_FIELDS	3
+#define BGP_COMM_MATCH_DIGITS	10
+#define BGP_COMM_MATCH_ANY	0xFF
+
 #define BGP_DAEMON_NONE		0
 #define BGP_DAEMON_TRUE		1
 #define BGP_DAEMON_ONLINE	1
@@ -94,10 +100,77 @@
 #define BGP_LOOKUP_ERR		-1
 
 /* structures */
+struct bgp_comm_match_field {
+  u_int8_t len; /* digits */
+  u_int8_t prefix; /* value has to start with the pattern only */
+  u_int8_t wildcards;
+  u_int32_t value; /* no wildcards */
+  u_int8_t digit[BGP_COMM_MATCH_DIGITS]; /* wildcards: 0-9 or BGP_COMM_MATCH_ANY */
+};
+
+struct bgp_comm_matcher {
+  u_int8_t substr; /* not compilable: substring matched as configured */
+  u_int8_t fields;
+  struct bgp_comm_match_field field[BGP_COMM_MATCH_FIELDS];
+};
+
+struct bgp_comm_matchers {
+  char **patterns; /* as configured, for string matching */
+  u_int8_t compiled; /* bgp_comm_pattern_anchored: patterns turned into matchers */
+  int num;
+  struct bgp_comm_matcher m[MAX_BGP_COMM_PATTERNS];
+};
+
 struct bgp_dump_event {
   struct timeval tstamp;
   char tstamp_str[SRVBUFLEN];
   int period;
+  int checkpoint; /* incremental dumps: a full one every this many */
+  u_int32_t seq;
+  u_int8_t delta; /* the peer being dumped is dumped incrementally */
+  struct bgp_dump_writer writer;
+};
+
+/* memory accounting of interned path attributes, per type */
+#define BGP_ATTR_MEM_ATTR	0
+#define BGP_ATTR_MEM_ASPATH	1
+#define BGP_ATTR_MEM_COMM	2
+#define BGP_ATTR_MEM_ECOMM	3
+#define BGP_ATTR_MEM_LCOMM	4
+#define BGP_ATTR_MEM_MAX	5
+
+struct bgp_attr_mem {
+  u_int64_t num;
+  u_int64_t bytes;
+};
+
+/*
+   Free objects are kept aside for reuse, up to 'max', instead of going
+   back to malloc(): routes churn, and objects are often freed by a thread
+   other than the one allocating them (ie. RIB reclaim vs BGP workers).
+*/
+#define BGP_POOL_MAX		4096
+
+struct bgp_pool {
+  void *head; /* free objects, linked through their first word */
+  u_int32_t num;
+  u_int32_t max;
+  size_t size;
+  pthread_mutex_t mutex;
+};
+
+struct bgp_peer_pools {
+  struct bgp_pool info;
+  struct bgp_pool extra;
+};
+
+/* last attribute blob seen from a peer and its interned bgp_attr */
+struct bgp_attr_cache {
+  struct bgp_attr *attr;
+  char *blob;
+  u_int16_t len;
+  u_int16_t size;
+  u_int8_t cap_4as; /* AS_PATH is parsed depending on it */
 };
 
 struct bgp_rt_structs {
@@ -107,6 +180,9 @@ struct bgp_rt_structs {
   struct hash *ecomhash;
   struct hash *lcomhash;
   struct bgp_table *rib[AFI_MAX][SAFI_MAX];
+  struct bgp_attr_mem attr_mem[BGP_ATTR_MEM_MAX];
+  pthread_mutex_t attr_mutex; /* recursive; attribute hashes and refcounts */
+  struct bgp_pool attr_pool; /* under attr_mutex */
 };
 
 struct bgp_peer_cache {
@@ -131,6 +207,7 @@ struct bgp_misc_structs {
   int is_thread;
   int has_lglass;
   int skip_rib;
+  int nlri_batch; /* max NLRIs per batch, 0 to process them one by one */
 
 #if defined WITH_RABBITMQ
   struct p_amqp_host *msglog_amqp_host;
@@ -172,10 +249,37 @@ struct bgp_misc_structs {
   u_int32_t (*route_info_modulo)(struct bgp_peer *, path_id_t *, int);
   struct bgp_peer *(*bgp_lookup_find_peer)(struct sockaddr *, struct xflow_status_entry *, u_int16_t, int);
   int (*bgp_lookup_node_match_cmp)(struct bgp_info *, struct node_match_cmp_term2 *);
+  struct bgp_peer *(*bgp_lookup_cache_peer)(struct bgp_peer *);
 
   int msglog_backend_methods;
   int dump_backend_methods;
   int dump_input_backend_methods;
+
+  struct bgp_rib_retired *rib_retired_head;
+  struct bgp_rib_retired *rib_retired_tail;
+  u_int64_t rib_retired_num;
+  pthread_mutex_t rib_retired_mutex;
+
+  /*
+    Lock order, when more than one is needed: peers_mutex, RIB table
+    (struct bgp_table), attr_mutex, msglog_mutex, rib_retired_mutex
+  */
+  pthread_mutex_t peers_mutex; /* peers[] slots and peers_log[] */
+  pthread_mutex_t msglog_mutex; /* msglog output, log_seq, log_tstamp */
+
+  struct bgp_peer_stale *peers_stale; /* warm restart, see bgp_snapshot.c */
+  int peers_stale_num;
+  time_t peers_stale_deadline;
+};
+
+/* BGP worker threads: each runs an epoll loop over the peers it owns */
+#define BGP_WORKERS_MAX		64
+#define BGP_WORKER_EVENTS	64
+
+struct bgp_worker {
+  int id;
+  int epoll_fd;
+  u_int32_t peers;
 };
 
 struct bgp_xconnect {
@@ -247,11 +351,30 @@ struct bgp_peer {
 
   struct bgp_xconnect xc;
   int xconnect_fd;
+
+  u_int64_t lookup_gen; /* odd while routes of the peer are being changed */
+
+  struct bgp_dump_journal journal;
+
+  struct bgp_peer_pools *pools; /* kept across bgp_peer_init() of the slot */
+  struct bgp_attr_cache attr_cache;
+};
+
+/*
+  NLRIs of an UPDATE applied as a batch: the table lock is held from
+  the first prefix to the flush and the last node got, locked on our
+  behalf, is the starting point of the next descent in the trie.
+*/
+struct bgp_nlri_batch {
+  struct bgp_table *table;
+  struct bgp_node *hint;
+  int count;
 };
 
 struct bgp_msg_data {
   struct bgp_peer *peer;
   struct bgp_msg_extra_data extra;
+  struct bgp_nlri_batch *batch;
 };
 
 /* these includes require definition of bgp_rt_structs and bgp_peer */
@@ -337,6 +460,7 @@ struct bgp_lg_rep_gp_data {
 #include "bgp_msg.h"
 #include "bgp_lookup.h"
 #include "bgp_util.h"
+#include "bgp_snapshot.h"
 
 /* prototypes */
 #if (!defined __BGP_C)
@@ -349,6 +473,9 @@ EXT void skinny_bgp_daemon();
 EXT void skinny_bgp_daemon_online();
 EXT void bgp_prepare_thread();
 EXT void bgp_prepare_daemon();
+EXT int bgp_workers_init(int);
+EXT int bgp_workers_add_peer(struct bgp_peer *);
+EXT void bgp_worker_daemon(struct bgp_worker *);
 #undef EXT
 
 /* global variables */
@@ -363,6 +490,9 @@ EXT char *std_comm_patterns[MAX_BGP_COMM_PATTERNS];
 EXT char *ext_comm_patterns[MAX_BGP_COMM_PATTERNS];
 EXT char *lrg_comm_patterns[MAX_BGP_COMM_PATTERNS];
 EXT char *std_comm_patterns_to_asn[MAX_BGP_COMM_PATTERNS];
+EXT struct bgp_comm_matchers std_comm_matchers;
+EXT struct bgp_comm_matchers lrg_comm_matchers;
+EXT struct bgp_comm_matchers std_comm_matchers_to_asn;
 EXT struct bgp_comm_range peer_src_as_ifrange; 
 EXT struct bgp_comm_range peer_src_as_asrange; 
 EXT u_int32_t (*bgp_route_info_modulo)(struct bgp_peer *, path_id_t *, int);
@@ -342,9 +342,25 @@ aspath_free (struct aspath *aspath)
   if (aspath->segments)
     assegment_free_all (aspath->segments);
   if (aspath->str) free(aspath->str);
+  if (aspath->str_radius) free(aspath->str_radius);
   free(aspath);
 }
 
+/* Memory held by an interned AS path. */
+static u_int64_t
+aspath_mem_size (struct aspath *aspath)
+{
+  struct assegment *seg;
+  u_int64_t size = sizeof (struct aspath);
+
+  for (seg = aspath->segments; seg; seg = seg->next)
+    size += (sizeof (struct assegment) + (seg->length * sizeof (as_t)));
+
+  if (aspath->str) size += (strlen (aspath->str) + 1);
+
+  return size;
+}
+
 /* Unintern aspath from AS path bucket. */
 void
 aspath_unintern(struct bgp_peer *peer, struct aspath *aspath)
@@ -358,6 +374,8 @@ aspath_unintern(struct bgp_peer *peer, struct aspath *aspath)
 
   if (!inter_domain_routing_db) return;
 
+  pthread_mutex_lock (&inter_domain_routing_db->attr_mutex);
+
   if (aspath->refcnt)
     aspath->refcnt--;
 
@@ -365,8 +383,11 @@ aspath_unintern(struct bgp_peer *peer, struct aspath *aspath)
     /* This aspath must exist in aspath hash table. */
     ret = hash_release(inter_domain_routing_db->ashash, aspath);
     assert (ret != NULL);
+    bgp_attr_mem_del (inter_domain_routing_db, BGP_ATTR_MEM_ASPATH, aspath_mem_size (aspath));
     aspath_free (aspath);
   }
+
+  pthread_mutex_unlock (&inter_domain_routing_db->attr_mutex);
 }
 
 /* Return the start or end delimiters for a particular Segment type */
@@ -664,6 +685,8 @@ aspath_intern (struct bgp_peer *peer, struct aspath *aspath)
   /* Assert this AS path structure is not interned. */
   assert (aspath->refcnt == 0);
 
+  pthread_mutex_lock (&inter_domain_routing_db->attr_mutex);
+
   /* Check AS path hash. */
   find = hash_get(peer, inter_domain_routing_db->ashash, aspath, hash_alloc_intern);
 
@@ -675,6 +698,11 @@ aspath_intern (struct bgp_peer *peer, struct aspath *aspath)
   if (! find->str)
     find->str = aspath_make_str_count (find);
 
+  if (find->refcnt == 1)
+    bgp_attr_mem_add (inter_domain_routing_db, BGP_ATTR_MEM_ASPATH, aspath_mem_size (find));
+
+  pthread_mutex_unlock (&inter_domain_routing_db->attr_mutex);
+
   return find;
 }
 
@@ -813,6 +841,7 @@ struct aspath *aspath_parse(struct bgp_peer *peer, char *s, size_t length, int u
   as.segments = assegments_parse(s, length, use32bit);
   
   /* If already same aspath exist then return it. */
+  pthread_mutex_lock (&inter_domain_routing_db->attr_mutex);
   find = hash_get (peer, inter_domain_routing_db->ashash, &as, aspath_hash_alloc);
   
   /* aspath_hash_alloc dupes segments too. that probably could be
@@ -822,9 +851,14 @@ struct aspath *aspath_parse(struct bgp_peer *peer, char *s, size_t length, int u
   if (as.str)
     free(as.str);
   
-  if (! find)
-    return NULL;
-  find->refcnt++;
+  if (find)
+    {
+      find->refcnt++;
+
+      if (find->refcnt == 1)
+	bgp_attr_mem_add (inter_domain_routing_db, BGP_ATTR_MEM_ASPATH, aspath_mem_size (find));
+    }
+  pthread_mutex_unlock (&inter_domain_routing_db->attr_mutex);
 
   return find;
 }
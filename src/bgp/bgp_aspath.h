@@ -62,6 +62,9 @@ struct aspath
   as_t last_as;
 
   char *str;
+
+  /* str trimmed to bgp_aspath_radius, rendered on first use */
+  char *str_radius;
 };
 
 #define ASPATH_STR_DEFAULT_LEN 32
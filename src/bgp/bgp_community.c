@@ -58,6 +58,7 @@ community_free (struct community *com)
 {
   if (com->val) free(com->val);
   if (com->str) free(com->str);
+  if (com->str_filtered) free(com->str_filtered);
   free(com);
 }
 
@@ -210,6 +211,32 @@ community_uniq_sort (struct bgp_peer *peer, struct community *com)
   return new;
 }
 
+/* Memory held by an interned communities attribute. */
+static u_int64_t
+community_mem_size (struct community *com)
+{
+  u_int64_t size = sizeof (struct community) + (com->size * sizeof (u_int32_t));
+
+  if (com->str) size += (strlen (com->str) + 1);
+
+  return size;
+}
+
+/* Return TRUE if wire values are already in the form community_uniq_sort()
+   would produce them: sorted and without duplicates. Values are in network
+   byte order, hence memcmp() matches community_compare() ordering. */
+static int
+community_is_canonical (struct community *com)
+{
+  int i;
+
+  for (i = 1; i < com->size; i++)
+    if (memcmp (com->val + (i - 1), com->val + i, sizeof (u_int32_t)) >= 0)
+      return FALSE;
+
+  return TRUE;
+}
+
 /* Convert communities attribute to string.
 
    For Well-known communities value, below keyword is used.
@@ -347,6 +374,7 @@ community_intern (struct bgp_peer *peer, struct community *com)
   assert (com->refcnt == 0);
 
   /* Lookup community hash. */
+  pthread_mutex_lock (&inter_domain_routing_db->attr_mutex);
   find = (struct community *) hash_get(peer, inter_domain_routing_db->comhash, com, hash_alloc_intern);
 
   /* Arguemnt com is allocated temporary.  So when it is not used in
@@ -361,6 +389,11 @@ community_intern (struct bgp_peer *peer, struct community *com)
   if (! find->str)
     find->str = community_com2str (peer, find);
 
+  if (find->refcnt == 1)
+    bgp_attr_mem_add (inter_domain_routing_db, BGP_ATTR_MEM_COMM, community_mem_size (find));
+
+  pthread_mutex_unlock (&inter_domain_routing_db->attr_mutex);
+
   return find;
 }
 
@@ -377,6 +410,8 @@ community_unintern (struct bgp_peer *peer, struct community *com)
 
   if (!inter_domain_routing_db) return;
 
+  pthread_mutex_lock (&inter_domain_routing_db->attr_mutex);
+
   if (com->refcnt)
     com->refcnt--;
 
@@ -386,25 +421,48 @@ community_unintern (struct bgp_peer *peer, struct community *com)
     ret = (struct community *) hash_release(inter_domain_routing_db->comhash, com);
     assert (ret != NULL);
 
+    bgp_attr_mem_del (inter_domain_routing_db, BGP_ATTR_MEM_COMM, community_mem_size (com));
+
     community_free (com);
   }
+
+  pthread_mutex_unlock (&inter_domain_routing_db->attr_mutex);
 }
 
 /* Create new community attribute. */
 struct community *
 community_parse (struct bgp_peer *peer, u_int32_t *pnt, u_short length)
 {
+  struct bgp_rt_structs *inter_domain_routing_db;
   struct community tmp;
-  struct community *new;
+  struct community *new, *find;
 
   /* If length is malformed return NULL. */
   if (length % 4)
     return NULL;
 
   /* Make temporary community for hash look up. */
+  memset (&tmp, 0, sizeof (tmp));
   tmp.size = length / 4;
   tmp.val = pnt;
 
+  /* Already interned with the same values, ie. by another peer: take
+     a reference without building a sorted copy first. */
+  if (peer && tmp.size && community_is_canonical (&tmp))
+    {
+      inter_domain_routing_db = bgp_select_routing_db(peer->type);
+
+      if (inter_domain_routing_db)
+	{
+	  pthread_mutex_lock (&inter_domain_routing_db->attr_mutex);
+	  find = (struct community *) hash_get(peer, inter_domain_routing_db->comhash, &tmp, NULL);
+	  if (find) find->refcnt++;
+	  pthread_mutex_unlock (&inter_domain_routing_db->attr_mutex);
+
+	  if (find) return find;
+	}
+    }
+
   new = community_uniq_sort (peer, &tmp);
 
   return community_intern (peer, new);
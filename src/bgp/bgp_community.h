@@ -42,6 +42,9 @@ struct community
   /* String of community attribute.  This sring is used by vty output
      and expanded community-list for regular expression match.  */
   char *str;
+
+  /* str filtered by bgp_stdcomm_pattern, rendered on first use */
+  char *str_filtered;
 };
 
 /* Well-known communities value.  */
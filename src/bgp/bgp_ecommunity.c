@@ -59,6 +59,7 @@ ecommunity_free (struct ecommunity *ecom)
 {
   if (ecom->val) free(ecom->val);
   if (ecom->str) free(ecom->str);
+  if (ecom->str_filtered) free(ecom->str_filtered);
   free(ecom);
 }
 
@@ -139,12 +140,38 @@ ecommunity_uniq_sort (struct bgp_peer *peer, struct ecommunity *ecom)
   return new;
 }
 
+/* Memory held by an interned Extended Communities attribute.  */
+static u_int64_t
+ecommunity_mem_size (struct ecommunity *ecom)
+{
+  u_int64_t size = sizeof (struct ecommunity) + (ecom->size * ECOMMUNITY_SIZE);
+
+  if (ecom->str) size += (strlen (ecom->str) + 1);
+
+  return size;
+}
+
+/* Return TRUE if wire values are already sorted and unique, ie. in the
+   form ecommunity_uniq_sort() would produce them.  */
+static int
+ecommunity_is_canonical (struct ecommunity *ecom)
+{
+  int i;
+
+  for (i = 1; i < ecom->size; i++)
+    if (memcmp (ecom->val + ((i - 1) * ECOMMUNITY_SIZE), ecom->val + (i * ECOMMUNITY_SIZE), ECOMMUNITY_SIZE) >= 0)
+      return FALSE;
+
+  return TRUE;
+}
+
 /* Parse Extended Communites Attribute in BGP packet.  */
 struct ecommunity *
 ecommunity_parse (struct bgp_peer *peer, u_int8_t *pnt, u_short length)
 {
+  struct bgp_rt_structs *inter_domain_routing_db;
   struct ecommunity tmp;
-  struct ecommunity *new;
+  struct ecommunity *new, *find;
 
   /* Length check.  */
   if (length % ECOMMUNITY_SIZE)
@@ -152,9 +179,27 @@ ecommunity_parse (struct bgp_peer *peer, u_int8_t *pnt, u_short length)
 
   /* Prepare tmporary structure for making a new Extended Communities
      Attribute.  */
+  memset (&tmp, 0, sizeof (tmp));
   tmp.size = length / ECOMMUNITY_SIZE;
   tmp.val = pnt;
 
+  /* Already interned with the same values, ie. by another peer: take
+     a reference without building a sorted copy first.  */
+  if (peer && tmp.size && ecommunity_is_canonical (&tmp))
+    {
+      inter_domain_routing_db = bgp_select_routing_db(peer->type);
+
+      if (inter_domain_routing_db)
+	{
+	  pthread_mutex_lock (&inter_domain_routing_db->attr_mutex);
+	  find = (struct ecommunity *) hash_get(peer, inter_domain_routing_db->ecomhash, &tmp, NULL);
+	  if (find) find->refcnt++;
+	  pthread_mutex_unlock (&inter_domain_routing_db->attr_mutex);
+
+	  if (find) return find;
+	}
+    }
+
   /* Create a new Extended Communities Attribute by uniq and sort each
      Extended Communities value  */
   new = ecommunity_uniq_sort (peer, &tmp);
@@ -177,6 +222,7 @@ ecommunity_intern (struct bgp_peer *peer, struct ecommunity *ecom)
 
   assert (ecom->refcnt == 0);
 
+  pthread_mutex_lock (&inter_domain_routing_db->attr_mutex);
   find = (struct ecommunity *) hash_get(peer, inter_domain_routing_db->ecomhash, ecom, hash_alloc_intern);
 
   if (find != ecom)
@@ -187,6 +233,11 @@ ecommunity_intern (struct bgp_peer *peer, struct ecommunity *ecom)
   if (! find->str)
     find->str = ecommunity_ecom2str (peer, find, ECOMMUNITY_FORMAT_DISPLAY);
 
+  if (find->refcnt == 1)
+    bgp_attr_mem_add (inter_domain_routing_db, BGP_ATTR_MEM_ECOMM, ecommunity_mem_size (find));
+
+  pthread_mutex_unlock (&inter_domain_routing_db->attr_mutex);
+
   return find;
 }
 
@@ -203,6 +254,8 @@ ecommunity_unintern (struct bgp_peer *peer, struct ecommunity *ecom)
 
   if (!inter_domain_routing_db) return;
 
+  pthread_mutex_lock (&inter_domain_routing_db->attr_mutex);
+
   if (ecom->refcnt)
     ecom->refcnt--;
 
@@ -212,8 +265,12 @@ ecommunity_unintern (struct bgp_peer *peer, struct ecommunity *ecom)
     ret = (struct ecommunity *) hash_release(inter_domain_routing_db->ecomhash, ecom);
     assert (ret != NULL);
 
+    bgp_attr_mem_del (inter_domain_routing_db, BGP_ATTR_MEM_ECOMM, ecommunity_mem_size (ecom));
+
     ecommunity_free(ecom);
   }
+
+  pthread_mutex_unlock (&inter_domain_routing_db->attr_mutex);
 }
 
 /* Utinity function to make hash key.  */
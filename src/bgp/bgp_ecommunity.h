@@ -61,6 +61,9 @@ struct ecommunity
 
   /* Human readable format string.  */
   char *str;
+
+  /* str filtered by bgp_extcomm_pattern, rendered on first use */
+  char *str_filtered;
 };
 
 /* Extended community value is eight octet.  */
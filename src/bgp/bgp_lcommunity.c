@@ -56,6 +56,7 @@ lcommunity_free (struct lcommunity *lcom)
 {
   if (lcom->val) free(lcom->val);
   if (lcom->str) free(lcom->str);
+  if (lcom->str_filtered) free(lcom->str_filtered);
   free(lcom);
 }
 
@@ -136,12 +137,38 @@ lcommunity_uniq_sort (struct bgp_peer *peer, struct lcommunity *lcom)
   return new;
 }
 
+/* Memory held by an interned Large Communities attribute.  */
+static u_int64_t
+lcommunity_mem_size (struct lcommunity *lcom)
+{
+  u_int64_t size = sizeof (struct lcommunity) + (lcom->size * LCOMMUNITY_SIZE);
+
+  if (lcom->str) size += (strlen (lcom->str) + 1);
+
+  return size;
+}
+
+/* Return TRUE if wire values are already sorted and unique, ie. in the
+   form lcommunity_uniq_sort() would produce them.  */
+static int
+lcommunity_is_canonical (struct lcommunity *lcom)
+{
+  int i;
+
+  for (i = 1; i < lcom->size; i++)
+    if (memcmp (lcom->val + ((i - 1) * LCOMMUNITY_SIZE), lcom->val + (i * LCOMMUNITY_SIZE), LCOMMUNITY_SIZE) >= 0)
+      return FALSE;
+
+  return TRUE;
+}
+
 /* Parse Large Communites Attribute in BGP packet.  */
 struct lcommunity *
 lcommunity_parse (struct bgp_peer *peer, u_int8_t *pnt, u_short length)
 {
+  struct bgp_rt_structs *inter_domain_routing_db;
   struct lcommunity tmp;
-  struct lcommunity *new;
+  struct lcommunity *new, *find;
 
   /* Length check.  */
   if (length % LCOMMUNITY_SIZE)
@@ -149,9 +176,27 @@ lcommunity_parse (struct bgp_peer *peer, u_int8_t *pnt, u_short length)
 
   /* Prepare tmporary structure for making a new Large Communities
      Attribute.  */
+  memset (&tmp, 0, sizeof (tmp));
   tmp.size = length / LCOMMUNITY_SIZE;
   tmp.val = pnt;
 
+  /* Already interned with the same values, ie. by another peer: take
+     a reference without building a sorted copy first.  */
+  if (peer && tmp.size && lcommunity_is_canonical (&tmp))
+    {
+      inter_domain_routing_db = bgp_select_routing_db(peer->type);
+
+      if (inter_domain_routing_db)
+	{
+	  pthread_mutex_lock (&inter_domain_routing_db->attr_mutex);
+	  find = (struct lcommunity *) hash_get(peer, inter_domain_routing_db->lcomhash, &tmp, NULL);
+	  if (find) find->refcnt++;
+	  pthread_mutex_unlock (&inter_domain_routing_db->attr_mutex);
+
+	  if (find) return find;
+	}
+    }
+
   /* Create a new Large Communities Attribute by uniq and sort each
      Large Communities value  */
   new = lcommunity_uniq_sort (peer, &tmp);
@@ -174,6 +219,7 @@ lcommunity_intern (struct bgp_peer *peer, struct lcommunity *lcom)
 
   assert (lcom->refcnt == 0);
 
+  pthread_mutex_lock (&inter_domain_routing_db->attr_mutex);
   find = (struct lcommunity *) hash_get(peer, inter_domain_routing_db->lcomhash, lcom, hash_alloc_intern);
 
   if (find != lcom)
@@ -184,6 +230,11 @@ lcommunity_intern (struct bgp_peer *peer, struct lcommunity *lcom)
   if (! find->str)
     find->str = lcommunity_lcom2str (peer, find);
 
+  if (find->refcnt == 1)
+    bgp_attr_mem_add (inter_domain_routing_db, BGP_ATTR_MEM_LCOMM, lcommunity_mem_size (find));
+
+  pthread_mutex_unlock (&inter_domain_routing_db->attr_mutex);
+
   return find;
 }
 
@@ -200,6 +251,8 @@ lcommunity_unintern (struct bgp_peer *peer, struct lcommunity *lcom)
 
   if (!inter_domain_routing_db) return;
 
+  pthread_mutex_lock (&inter_domain_routing_db->attr_mutex);
+
   if (lcom->refcnt)
     lcom->refcnt--;
 
@@ -209,8 +262,12 @@ lcommunity_unintern (struct bgp_peer *peer, struct lcommunity *lcom)
     ret = (struct lcommunity *) hash_release(inter_domain_routing_db->lcomhash, lcom);
     assert (ret != NULL);
 
+    bgp_attr_mem_del (inter_domain_routing_db, BGP_ATTR_MEM_LCOMM, lcommunity_mem_size (lcom));
+
     lcommunity_free(lcom);
   }
+
+  pthread_mutex_unlock (&inter_domain_routing_db->attr_mutex);
 }
 
 /* Utinity function to make hash key.  */
@@ -40,6 +40,9 @@ struct lcommunity
 
   /* Human readable format string.  */
   char *str;
+
+  /* str filtered by bgp_lrgcomm_pattern, rendered on first use */
+  char *str_filtered;
 };
 
 /* Extended community value is eight octet.  */
@@ -34,6 +34,120 @@
 #include "kafka_common.h"
 #endif
 
+/* per-thread override of bms->peer_str: BMP workers log embedded BGP peers
+   concurrently and must not swap the shared key under each other's feet */
+static __thread char *bgp_peer_log_str_self;
+
+void bgp_peer_log_str_set(char *peer_str)
+{
+  bgp_peer_log_str_self = peer_str;
+}
+
+static char *bgp_peer_log_str(struct bgp_misc_structs *bms)
+{
+  if (bgp_peer_log_str_self) return bgp_peer_log_str_self;
+
+  return bms->peer_str;
+}
+
+static __thread struct bgp_log_batch bgp_log_batch_self;
+
+/*
+  Opens a batch of msglog entries for the peer: until bgp_peer_log_batch_end(),
+  entries sent to Kafka are appended, newline-separated, to a per-thread buffer
+  and produced every 'max' of them. Other backends are not affected.
+*/
+void bgp_peer_log_batch_begin(struct bgp_peer *peer, int max)
+{
+  struct bgp_misc_structs *bms;
+
+  if (!peer || !peer->log || max < 2) return;
+
+  bms = bgp_select_misc_db(peer->type);
+  if (!bms || !bms->msglog_kafka_topic) return;
+
+  bgp_log_batch_self.peer = peer;
+  bgp_log_batch_self.max = max;
+  bgp_log_batch_self.num = 0;
+  bgp_log_batch_self.len = 0;
+}
+
+/* msglog_mutex held */
+static int bgp_peer_log_batch_flush(struct bgp_peer *peer)
+{
+  struct bgp_log_batch *blb = &bgp_log_batch_self;
+  int ret = SUCCESS;
+
+  if (!blb->num) return ret;
+
+#ifdef WITH_KAFKA
+  p_kafka_set_topic(peer->log->kafka_host, peer->log->filename);
+  ret = write_string_kafka(peer->log->kafka_host, blb->buf, blb->len);
+  p_kafka_unset_topic(peer->log->kafka_host);
+#endif
+
+  blb->num = 0;
+  blb->len = 0;
+
+  return ret;
+}
+
+/* msglog_mutex held; obj is freed */
+static int bgp_peer_log_batch_add(struct bgp_peer *peer, void *obj)
+{
+  struct bgp_log_batch *blb = &bgp_log_batch_self;
+  char *str, *new_buf;
+  size_t str_len, new_size;
+
+  str = compose_json_str(obj);
+  if (!str) return ERR;
+
+  str_len = strlen(str);
+
+  if ((blb->len + str_len + 2) > blb->size) {
+    new_size = MAX((blb->size * 2), (blb->len + str_len + 2));
+    new_buf = realloc(blb->buf, new_size);
+    if (!new_buf) {
+      free(str);
+      return ERR;
+    }
+
+    blb->buf = new_buf;
+    blb->size = new_size;
+  }
+
+  memcpy(&blb->buf[blb->len], str, str_len);
+  blb->len += str_len;
+  blb->buf[blb->len] = '\n';
+  blb->len++;
+  blb->buf[blb->len] = '\0';
+  blb->num++;
+  free(str);
+
+  if (blb->num >= blb->max) return bgp_peer_log_batch_flush(peer);
+
+  return SUCCESS;
+}
+
+int bgp_peer_log_batch_end(struct bgp_peer *peer)
+{
+  struct bgp_misc_structs *bms;
+  int ret;
+
+  if (!peer || bgp_log_batch_self.peer != peer) return SUCCESS;
+
+  bms = bgp_select_misc_db(peer->type);
+  if (!bms) return ERR;
+
+  pthread_mutex_lock(&bms->msglog_mutex);
+  ret = bgp_peer_log_batch_flush(peer);
+  pthread_mutex_unlock(&bms->msglog_mutex);
+
+  bgp_log_batch_self.peer = NULL;
+
+  return ret;
+}
+
 int bgp_peer_log_msg(struct bgp_node *route, struct bgp_info *ri, afi_t afi, safi_t safi,
 		     char *event_type, int output, char **output_data, int log_type)
 {
@@ -57,6 +171,9 @@ int bgp_peer_log_msg(struct bgp_node *route, struct bgp_info *ri, afi_t afi, saf
   else if (!strcmp(event_type, "log")) etype = BGP_LOGDUMP_ET_LOG;
   else if (!strcmp(event_type, "lglass")) etype = BGP_LOGDUMP_ET_LG;
 
+  /* BGP workers log concurrently: output, seq and timestamp are shared */
+  if (etype == BGP_LOGDUMP_ET_LOG) pthread_mutex_lock(&bms->msglog_mutex);
+
 #ifdef WITH_RABBITMQ
   if ((bms->msglog_amqp_routing_key && etype == BGP_LOGDUMP_ET_LOG) ||
       (bms->dump_amqp_routing_key && etype == BGP_LOGDUMP_ET_DUMP))
@@ -82,7 +199,10 @@ int bgp_peer_log_msg(struct bgp_node *route, struct bgp_info *ri, afi_t afi, saf
     if (etype == BGP_LOGDUMP_ET_LOG) {
       json_object_set_new_nocheck(obj, "seq", json_integer((json_int_t)bms->log_seq));
       bgp_peer_log_seq_increment(&bms->log_seq);
+    }
 
+    /* incremental dumps qualify their entries, full dumps go with MISC */
+    if (etype == BGP_LOGDUMP_ET_LOG || (etype == BGP_LOGDUMP_ET_DUMP && log_type != BGP_LOG_TYPE_MISC)) {
       switch (log_type) {
       case BGP_LOG_TYPE_UPDATE:
 	json_object_set_new_nocheck(obj, "log_type", json_string("update"));
@@ -110,7 +230,7 @@ int bgp_peer_log_msg(struct bgp_node *route, struct bgp_info *ri, afi_t afi, saf
       bms->bgp_peer_logdump_extra_data(&ri->extra->bmed, output, obj);
 
     addr_to_str(ip_address, &peer->addr);
-    json_object_set_new_nocheck(obj, bms->peer_str, json_string(ip_address));
+    json_object_set_new_nocheck(obj, bgp_peer_log_str(bms), json_string(ip_address));
 
     json_object_set_new_nocheck(obj, "event_type", json_string(event_type));
 
@@ -187,13 +307,18 @@ int bgp_peer_log_msg(struct bgp_node *route, struct bgp_info *ri, afi_t afi, saf
     if ((bms->msglog_kafka_topic && etype == BGP_LOGDUMP_ET_LOG) ||
         (bms->dump_kafka_topic && etype == BGP_LOGDUMP_ET_DUMP)) {
       add_writer_name_and_pid_json(obj, config.proc_name, writer_pid);
-      kafka_ret = write_and_free_json_kafka(peer->log->kafka_host, obj);
+      if (etype == BGP_LOGDUMP_ET_LOG && bgp_log_batch_self.peer == peer)
+	kafka_ret = bgp_peer_log_batch_add(peer, obj);
+      else
+	kafka_ret = write_and_free_json_kafka(peer->log->kafka_host, obj);
       p_kafka_unset_topic(peer->log->kafka_host);
     }
 #endif
 #endif
   }
 
+  if (etype == BGP_LOGDUMP_ET_LOG) pthread_mutex_unlock(&bms->msglog_mutex);
+
   return (ret | amqp_ret | kafka_ret);
 }
 
@@ -206,6 +331,8 @@ int bgp_peer_log_init(struct bgp_peer *peer, int output, int type)
 
   if (!bms || !peer) return ERR;
 
+  pthread_mutex_lock(&bms->msglog_mutex);
+
   if (bms->msglog_file)
     bgp_peer_log_dynname(log_filename, SRVBUFLEN, bms->msglog_file, peer); 
 
@@ -282,7 +409,7 @@ int bgp_peer_log_init(struct bgp_peer *peer, int output, int type)
 	bms->bgp_peer_logdump_initclose_extras(peer, output, obj);
 
       addr_to_str(ip_address, &peer->addr);
-      json_object_set_new_nocheck(obj, bms->peer_str, json_string(ip_address));
+      json_object_set_new_nocheck(obj, bgp_peer_log_str(bms), json_string(ip_address));
 
       json_object_set_new_nocheck(obj, "event_type", json_string(event_type));
 
@@ -310,6 +437,8 @@ int bgp_peer_log_init(struct bgp_peer *peer, int output, int type)
     }
   }
 
+  pthread_mutex_unlock(&bms->msglog_mutex);
+
   return (ret | amqp_ret | kafka_ret);
 }
 
@@ -324,6 +453,8 @@ int bgp_peer_log_close(struct bgp_peer *peer, int output, int type)
 
   if (!bms || !peer || !peer->log) return ERR;
 
+  pthread_mutex_lock(&bms->msglog_mutex);
+
 #ifdef WITH_RABBITMQ
   if (bms->msglog_amqp_routing_key)
     p_amqp_set_routing_key(peer->log->amqp_host, peer->log->filename);
@@ -356,7 +487,7 @@ int bgp_peer_log_close(struct bgp_peer *peer, int output, int type)
       bms->bgp_peer_logdump_initclose_extras(peer, output, obj);
 
     addr_to_str(ip_address, &peer->addr);
-    json_object_set_new_nocheck(obj, bms->peer_str, json_string(ip_address));
+    json_object_set_new_nocheck(obj, bgp_peer_log_str(bms), json_string(ip_address));
 
     json_object_set_new_nocheck(obj, "event_type", json_string(event_type));
 
@@ -388,6 +519,8 @@ int bgp_peer_log_close(struct bgp_peer *peer, int output, int type)
     }
   }
 
+  pthread_mutex_unlock(&bms->msglog_mutex);
+
   return (ret | amqp_ret | kafka_ret);
 }
 
@@ -481,12 +614,15 @@ int bgp_peer_dump_init(struct bgp_peer *peer, int output, int type)
       bms->bgp_peer_logdump_initclose_extras(peer, output, obj);
 
     addr_to_str(ip_address, &peer->addr);
-    json_object_set_new_nocheck(obj, bms->peer_str, json_string(ip_address));
+    json_object_set_new_nocheck(obj, bgp_peer_log_str(bms), json_string(ip_address));
 
     json_object_set_new_nocheck(obj, "event_type", json_string(event_type));
 
     json_object_set_new_nocheck(obj, "dump_period", json_integer((json_int_t)bms->dump.period));
 
+    if (bms->dump.checkpoint)
+      json_object_set_new_nocheck(obj, "dump_type", json_string(bms->dump.delta ? "delta" : "full"));
+
     if (bms->dump_file)
       write_and_free_json(peer->log->fd, obj);
 
@@ -541,7 +677,7 @@ int bgp_peer_dump_close(struct bgp_peer *peer, struct bgp_dump_stats *bds, int o
       bms->bgp_peer_logdump_initclose_extras(peer, output, obj);
 
     addr_to_str(ip_address, &peer->addr);
-    json_object_set_new_nocheck(obj, bms->peer_str, json_string(ip_address));
+    json_object_set_new_nocheck(obj, bgp_peer_log_str(bms), json_string(ip_address));
 
     json_object_set_new_nocheck(obj, "event_type", json_string(event_type));
 
@@ -551,6 +687,22 @@ int bgp_peer_dump_close(struct bgp_peer *peer, struct bgp_dump_stats *bds, int o
       json_object_set_new_nocheck(obj, "tables", json_integer((json_int_t)bds->tables));
     }
 
+    if (bms->dump.checkpoint)
+      json_object_set_new_nocheck(obj, "dump_type", json_string(bms->dump.delta ? "delta" : "full"));
+
+    if (bms->dump.writer.num > 1) {
+      struct timeval now;
+      u_int64_t et_msecs;
+
+      gettimeofday(&now, NULL);
+      et_msecs = ((now.tv_sec - bms->dump.writer.start.tv_sec) * 1000) +
+		 ((now.tv_usec - bms->dump.writer.start.tv_usec) / 1000);
+
+      json_object_set_new_nocheck(obj, "dump_writer", json_integer((json_int_t)bms->dump.writer.id));
+
+      json_object_set_new_nocheck(obj, "dump_writer_et_msecs", json_integer((json_int_t)et_msecs));
+    }
+
     if (bms->dump_file)
       write_and_free_json(peer->log->fd, obj);
 
@@ -575,6 +727,208 @@ int bgp_peer_dump_close(struct bgp_peer *peer, struct bgp_dump_stats *bds, int o
   return (ret | amqp_ret | kafka_ret);
 }
 
+/*
+   called by the dump writer forked by the daemon: it forks further writers
+   and carries on as writer #0; peers are shared among writers by index
+*/
+void bgp_dump_writers_spawn(struct bgp_misc_structs *bms, int num)
+{
+  struct bgp_dump_writer *bdw = &bms->dump.writer;
+  int idx;
+  pid_t ret;
+
+  memset(bdw, 0, sizeof(struct bgp_dump_writer));
+  bdw->num = ((num > 1) ? num : 1);
+  bdw->spawned = 1;
+
+  for (idx = 1; idx < bdw->num; idx++) {
+    ret = fork();
+
+    if (!ret) {
+      bdw->id = idx;
+      break;
+    }
+    else if (ret == -1) {
+      Log(LOG_WARNING, "WARN ( %s/%s ): Unable to fork dump writer #%u: %s. Its peers go to writer #0.\n",
+	  config.name, bms->log_str, idx, strerror(errno));
+      break;
+    }
+    else bdw->spawned++;
+  }
+
+  gettimeofday(&bdw->start, NULL);
+}
+
+int bgp_dump_writer_owns(struct bgp_misc_structs *bms, int peers_idx)
+{
+  struct bgp_dump_writer *bdw = &bms->dump.writer;
+  int share;
+
+  if (bdw->num <= 1) return TRUE;
+
+  share = (peers_idx % bdw->num);
+
+  return (share == bdw->id || (!bdw->id && share >= bdw->spawned));
+}
+
+void bgp_dump_journal_add(struct bgp_peer *peer, u_int8_t type, afi_t afi, safi_t safi, struct prefix *p, struct bgp_info *ri)
+{
+  struct bgp_dump_journal *bdj;
+  struct bgp_dump_delta *bdd;
+
+  if (!peer || !p) return;
+
+  bdj = &peer->journal;
+
+  /* the peer is going to be dumped in full anyway */
+  if (bdj->full) return;
+
+  if (bdj->num == bdj->size) {
+    u_int32_t size = (bdj->size ? (bdj->size * 2) : 64);
+
+    /* too many changes to be worth tracking: switch to a full dump */
+    if (size > BGP_DUMP_JOURNAL_MAX || !(bdd = realloc(bdj->delta, (size * sizeof(struct bgp_dump_delta))))) {
+      free(bdj->delta);
+      bdj->delta = NULL;
+      bdj->num = 0;
+      bdj->size = 0;
+      bdj->full = TRUE;
+
+      return;
+    }
+
+    bdj->delta = bdd;
+    bdj->size = size;
+  }
+
+  bdd = &bdj->delta[bdj->num];
+  memset(bdd, 0, sizeof(struct bgp_dump_delta));
+
+  bdd->seq = bdj->num;
+  bdd->type = type;
+  bdd->afi = afi;
+  bdd->safi = safi;
+  memcpy(&bdd->p, p, sizeof(struct prefix));
+
+  if (ri && ri->extra) {
+    memcpy(&bdd->rd, &ri->extra->rd, sizeof(rd_t));
+    memcpy(bdd->label, ri->extra->label, sizeof(bdd->label));
+    bdd->path_id = ri->extra->path_id;
+  }
+
+  bdj->num++;
+}
+
+void bgp_dump_journal_reset(struct bgp_peer *peer)
+{
+  struct bgp_dump_journal *bdj;
+
+  if (!peer) return;
+
+  bdj = &peer->journal;
+  bdj->num = 0;
+  bdj->full = FALSE;
+
+  /* do not hold on to memory after a burst of changes */
+  if (bdj->size > BGP_DUMP_JOURNAL_KEEP) {
+    free(bdj->delta);
+    bdj->delta = NULL;
+    bdj->size = 0;
+  }
+}
+
+/* orders journal entries by route and then by arrival */
+static int bgp_dump_delta_route_cmp(const struct bgp_dump_delta *a, const struct bgp_dump_delta *b)
+{
+  int ret;
+
+  if (a->afi != b->afi) return (a->afi < b->afi ? -1 : 1);
+  if (a->safi != b->safi) return (a->safi < b->safi ? -1 : 1);
+  if (a->p.family != b->p.family) return (a->p.family < b->p.family ? -1 : 1);
+  if (a->p.prefixlen != b->p.prefixlen) return (a->p.prefixlen < b->p.prefixlen ? -1 : 1);
+  if ((ret = memcmp(&a->p.u.prefix, &b->p.u.prefix, PSIZE(a->p.prefixlen)))) return ret;
+  if ((ret = memcmp(&a->rd, &b->rd, sizeof(rd_t)))) return ret;
+  if (a->path_id != b->path_id) return (a->path_id < b->path_id ? -1 : 1);
+
+  return FALSE;
+}
+
+static int bgp_dump_delta_cmp(const void *a, const void *b)
+{
+  const struct bgp_dump_delta *bdd_a = a, *bdd_b = b;
+  int ret;
+
+  if ((ret = bgp_dump_delta_route_cmp(bdd_a, bdd_b))) return ret;
+
+  return (bdd_a->seq < bdd_b->seq ? -1 : (bdd_a->seq > bdd_b->seq));
+}
+
+/* dumps the latest change of every route in the journal of the peer */
+static u_int64_t bgp_dump_journal_walk(struct bgp_peer *peer, struct bgp_rt_structs *inter_domain_routing_db,
+				       char *event_type, int output)
+{
+  struct bgp_misc_structs *bms = bgp_select_misc_db(peer->type);
+  struct bgp_dump_journal *bdj = &peer->journal;
+  struct bgp_dump_delta *bdd;
+  struct bgp_node *node, node_local;
+  struct bgp_info *ri, ri_local;
+  struct bgp_info_extra extra_local;
+  u_int32_t idx, modulo, peer_buckets;
+  u_int64_t dump_elems = 0;
+  rd_t rd_zero;
+
+  if (!bms || !bdj->num) return dump_elems;
+
+  memset(&rd_zero, 0, sizeof(rd_t));
+
+  qsort(bdj->delta, bdj->num, sizeof(struct bgp_dump_delta), bgp_dump_delta_cmp);
+
+  for (idx = 0; idx < bdj->num; idx++) {
+    bdd = &bdj->delta[idx];
+
+    /* superseded by a later change to the same route */
+    if ((idx + 1) < bdj->num && !bgp_dump_delta_route_cmp(bdd, &bdj->delta[idx + 1])) continue;
+
+    if (bdd->type == BGP_LOG_TYPE_WITHDRAW) {
+      memset(&node_local, 0, sizeof(struct bgp_node));
+      memcpy(&node_local.p, &bdd->p, sizeof(struct prefix));
+
+      memset(&extra_local, 0, sizeof(struct bgp_info_extra));
+      memcpy(&extra_local.rd, &bdd->rd, sizeof(rd_t));
+      memcpy(extra_local.label, bdd->label, sizeof(extra_local.label));
+      extra_local.path_id = bdd->path_id;
+
+      memset(&ri_local, 0, sizeof(struct bgp_info));
+      ri_local.peer = peer;
+      ri_local.extra = &extra_local;
+
+      bgp_peer_log_msg(&node_local, &ri_local, bdd->afi, bdd->safi, event_type, output, NULL, BGP_LOG_TYPE_WITHDRAW);
+      dump_elems++;
+
+      continue;
+    }
+
+    node = bgp_node_lookup(inter_domain_routing_db->rib[bdd->afi][bdd->safi], &bdd->p);
+    if (!node) continue;
+
+    modulo = bms->route_info_modulo(peer, NULL, bms->table_per_peer_buckets);
+
+    for (peer_buckets = 0; peer_buckets < bms->table_per_peer_buckets; peer_buckets++) {
+      for (ri = node->info[modulo+peer_buckets]; ri; ri = ri->next) {
+	if (ri->peer != peer) continue;
+
+	if (memcmp((ri->extra ? &ri->extra->rd : &rd_zero), &bdd->rd, sizeof(rd_t))) continue;
+	if ((ri->extra ? ri->extra->path_id : 0) != bdd->path_id) continue;
+
+	bgp_peer_log_msg(node, ri, bdd->afi, bdd->safi, event_type, output, NULL, BGP_LOG_TYPE_UPDATE);
+	dump_elems++;
+      }
+    }
+  }
+
+  return dump_elems;
+}
+
 void bgp_handle_dump_event()
 {
   struct bgp_misc_structs *bms = bgp_select_misc_db(FUNC_TYPE_BGP);
@@ -603,6 +957,9 @@ void bgp_handle_dump_event()
     signal(SIGINT, SIG_IGN);
     signal(SIGHUP, SIG_IGN);
     pm_setproctitle("%s %s [%s]", config.type, "Core Process -- BGP Dump Writer", config.name, bms->log_str);
+
+    /* peers are shared among writers; each one has its own outputs */
+    bgp_dump_writers_spawn(bms, config.bgp_table_dump_workers);
     memset(last_filename, 0, sizeof(last_filename));
     memset(current_filename, 0, sizeof(current_filename));
     memset(&peer_log, 0, sizeof(struct bgp_peer_log));
@@ -625,12 +982,13 @@ void bgp_handle_dump_event()
 #endif
 
     dumper_pid = getpid();
-    Log(LOG_INFO, "INFO ( %s/%s ): *** Dumping BGP tables - START (PID: %u) ***\n", config.name, bms->log_str, dumper_pid);
+    Log(LOG_INFO, "INFO ( %s/%s ): *** Dumping BGP tables - START (PID: %u, WRITER: %u/%u) ***\n", config.name, bms->log_str, dumper_pid,
+	bms->dump.writer.id, bms->dump.writer.num);
     start = time(NULL);
     tables_num = 0;
 
     for (peer = NULL, saved_peer = NULL, peers_idx = 0; peers_idx < config.nfacctd_bgp_max_peers; peers_idx++) {
-      if (peers[peers_idx].fd) {
+      if (peers[peers_idx].fd && bgp_dump_writer_owns(bms, peers_idx)) {
         peer = &peers[peers_idx];
 	peer->log = &peer_log; /* abusing struct bgp_peer a bit, but we are in a child */
 
@@ -687,32 +1045,39 @@ void bgp_handle_dump_event()
 	}
 #endif
 
+	/* incremental dumps: peers not tracked since the last dump go in full */
+	bms->dump.delta = (bms->dump.checkpoint && (bms->dump.seq % bms->dump.checkpoint) && !peer->journal.full);
+
 	bgp_peer_dump_init(peer, config.bgp_table_dump_output, FUNC_TYPE_BGP);
         inter_domain_routing_db = bgp_select_routing_db(FUNC_TYPE_BGP);
 	dump_elems = 0;
 
 	if (!inter_domain_routing_db) return;
 
-	for (afi = AFI_IP; afi < AFI_MAX; afi++) {
-	  for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++) {
-	    table = inter_domain_routing_db->rib[afi][safi];
-	    node = bgp_table_top(peer, table);
-
-	    while (node) {
-	      u_int32_t modulo = bgp_route_info_modulo(peer, NULL, bms->table_per_peer_buckets);
-	      u_int32_t peer_buckets;
-	      struct bgp_info *ri;
-
-	      for (peer_buckets = 0; peer_buckets < config.bgp_table_per_peer_buckets; peer_buckets++) {
-	        for (ri = node->info[modulo+peer_buckets]; ri; ri = ri->next) {
-		  if (ri->peer == peer) {
-	            bgp_peer_log_msg(node, ri, afi, safi, event_type, config.bgp_table_dump_output, NULL, BGP_LOG_TYPE_MISC);
-	            dump_elems++;
+	if (bms->dump.delta)
+	  dump_elems = bgp_dump_journal_walk(peer, inter_domain_routing_db, event_type, config.bgp_table_dump_output);
+	else {
+	  for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+	    for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++) {
+	      table = inter_domain_routing_db->rib[afi][safi];
+	      node = bgp_table_top(peer, table);
+
+	      while (node) {
+		u_int32_t modulo = bgp_route_info_modulo(peer, NULL, bms->table_per_peer_buckets);
+		u_int32_t peer_buckets;
+		struct bgp_info *ri;
+
+		for (peer_buckets = 0; peer_buckets < config.bgp_table_per_peer_buckets; peer_buckets++) {
+		  for (ri = node->info[modulo+peer_buckets]; ri; ri = ri->next) {
+		    if (ri->peer == peer) {
+		      bgp_peer_log_msg(node, ri, afi, safi, event_type, config.bgp_table_dump_output, NULL, BGP_LOG_TYPE_MISC);
+		      dump_elems++;
+		    }
 		  }
 		}
-	      }
 
-	      node = bgp_route_next(peer, node);
+		node = bgp_route_next(peer, node);
+	      }
 	    }
 	  }
 	}
@@ -743,14 +1108,22 @@ void bgp_handle_dump_event()
     }
 
     duration = time(NULL)-start;
-    Log(LOG_INFO, "INFO ( %s/%s ): *** Dumping BGP tables - END (PID: %u, TABLES: %u ET: %u) ***\n",
-		config.name, bms->log_str, dumper_pid, tables_num, duration);
+    Log(LOG_INFO, "INFO ( %s/%s ): *** Dumping BGP tables - END (PID: %u, WRITER: %u/%u, TABLES: %u ET: %u) ***\n",
+		config.name, bms->log_str, dumper_pid, bms->dump.writer.id, bms->dump.writer.num, tables_num, duration);
 
     exit(0);
   default: /* Parent */
     if (ret == -1) { /* Something went wrong */
       Log(LOG_WARNING, "WARN ( %s/%s ): Unable to fork BGP table dump writer: %s\n", config.name, bms->log_str, strerror(errno));
     }
+    else if (bms->dump.checkpoint) {
+      /* changes so far are with the dump writer now */
+      for (peers_idx = 0; peers_idx < config.nfacctd_bgp_max_peers; peers_idx++) {
+	if (peers[peers_idx].fd) bgp_dump_journal_reset(&peers[peers_idx]);
+      }
+
+      bms->dump.seq++;
+    }
 
     break;
   }
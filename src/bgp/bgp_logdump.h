@@ -48,6 +48,48 @@ struct bgp_dump_stats {
   u_int32_t tables;
 };
 
+/* parallel dumps: writer processes, each dumping its own share of peers */
+#define BGP_DUMP_WRITERS_MAX	64
+
+struct bgp_dump_writer {
+  int id;
+  int num;
+  int spawned; /* writer #0 only: peers of writers failed to fork fall back to it */
+  struct timeval start;
+};
+
+/* incremental dumps: per-peer journal of RIB changes since the last dump */
+#define BGP_DUMP_JOURNAL_MAX	262144 /* entries, beyond it the peer is dumped in full */
+#define BGP_DUMP_JOURNAL_KEEP	4096 /* entries, journal memory retained across dumps */
+
+struct bgp_dump_delta {
+  u_int32_t seq;
+  u_int8_t type; /* BGP_LOG_TYPE_UPDATE, BGP_LOG_TYPE_WITHDRAW */
+  afi_t afi;
+  safi_t safi;
+  struct prefix p;
+  rd_t rd;
+  path_id_t path_id;
+  u_char label[3];
+};
+
+struct bgp_dump_journal {
+  struct bgp_dump_delta *delta;
+  u_int32_t num;
+  u_int32_t size;
+  u_int8_t full; /* changes were not tracked, ie. new session or overflow */
+};
+
+/* msglog entries of a batch of NLRIs, packed in a single Kafka message */
+struct bgp_log_batch {
+  struct bgp_peer *peer;
+  int max;
+  int num;
+  char *buf;
+  size_t len;
+  size_t size;
+};
+
 /* prototypes */
 #if (!defined __BGP_LOGDUMP_C)
 #define EXT extern
@@ -58,11 +100,18 @@ EXT int bgp_peer_log_init(struct bgp_peer *, int, int);
 EXT int bgp_peer_log_close(struct bgp_peer *, int, int);
 EXT void bgp_peer_log_seq_init(u_int64_t *);
 EXT void bgp_peer_log_seq_increment(u_int64_t *);
+EXT void bgp_peer_log_str_set(char *);
+EXT void bgp_peer_log_batch_begin(struct bgp_peer *, int);
+EXT int bgp_peer_log_batch_end(struct bgp_peer *);
 EXT void bgp_peer_log_dynname(char *, int, char *, struct bgp_peer *);
 EXT int bgp_peer_log_msg(struct bgp_node *, struct bgp_info *, afi_t, safi_t, char *, int, char **, int);
 EXT int bgp_peer_dump_init(struct bgp_peer *, int, int);
 EXT int bgp_peer_dump_close(struct bgp_peer *, struct bgp_dump_stats *, int, int);
 EXT void bgp_handle_dump_event();
+EXT void bgp_dump_writers_spawn(struct bgp_misc_structs *, int);
+EXT int bgp_dump_writer_owns(struct bgp_misc_structs *, int);
+EXT void bgp_dump_journal_add(struct bgp_peer *, u_int8_t, afi_t, safi_t, struct prefix *, struct bgp_info *);
+EXT void bgp_dump_journal_reset(struct bgp_peer *);
 EXT void bgp_daemon_msglog_init_amqp_host();
 EXT void bgp_table_dump_init_amqp_host();
 EXT int bgp_daemon_msglog_init_kafka_host();
@@ -30,6 +30,24 @@
 #include "addr.h"
 #include "bgp.h"
 #include "pmbgpd.h"
+#include "thread_pool.h"
+#include "jhash.h"
+
+/* lookup caches, one per type per collector thread */
+static __thread struct bgp_lookup_cache *bgp_lookup_cache_local[FUNC_TYPE_MAX];
+static struct bgp_lookup_cache *bgp_lookup_caches;
+static pthread_mutex_t bgp_lookup_caches_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* warm restart: tables restored from a RIB snapshot are looked up on behalf
+   of the stale peer until the live session sends End-of-RIB for them */
+static struct bgp_peer *bgp_lookup_table_peer(int type, struct sockaddr *sa, u_int16_t l3_proto, safi_t safi, struct bgp_peer *peer)
+{
+  struct bgp_peer *stale_peer;
+
+  if (type == FUNC_TYPE_BGP && (stale_peer = bgp_snapshot_stale_find(sa, l3_proto, safi))) return stale_peer;
+
+  return peer;
+}
 
 void bgp_srcdst_lookup(struct packet_ptrs *pptrs, int type)
 {
@@ -37,17 +55,14 @@ void bgp_srcdst_lookup(struct packet_ptrs *pptrs, int type)
   struct bgp_rt_structs *inter_domain_routing_db;
   struct sockaddr *sa = (struct sockaddr *) pptrs->f_agent, sa_local;
   struct xflow_status_entry *xs_entry = (struct xflow_status_entry *) pptrs->f_status;
-  struct bgp_peer *peer;
+  struct bgp_peer *peer, *live_peer, *table_peer;
   struct bgp_node *default_node, *result;
   struct bgp_info *info;
   struct node_match_cmp_term2 nmct2;
   struct prefix default_prefix;
   int compare_bgp_port;
   int follow_default = config.nfacctd_bgp_follow_default;
-  struct in_addr pref4;
-#if defined ENABLE_IPV6
-  struct in6_addr pref6;
-#endif
+  struct host_addr ha;
   safi_t safi;
   rd_t rd;
 
@@ -58,6 +73,9 @@ void bgp_srcdst_lookup(struct packet_ptrs *pptrs, int type)
 
   pptrs->bgp_src = NULL;
   pptrs->bgp_dst = NULL;
+
+  /* results are referenced until the caller goes through bgp_rib_read_exit() */
+  bgp_rib_read_enter();
   pptrs->bgp_src_info = NULL;
   pptrs->bgp_dst_info = NULL;
   pptrs->bgp_peer = NULL;
@@ -92,7 +110,14 @@ void bgp_srcdst_lookup(struct packet_ptrs *pptrs, int type)
 
   start_again_follow_default:
 
-  peer = bms->bgp_lookup_find_peer(sa, xs_entry, pptrs->l3_proto, compare_bgp_port);
+  live_peer = bms->bgp_lookup_find_peer(sa, xs_entry, pptrs->l3_proto, compare_bgp_port);
+
+  if (pptrs->bitr) {
+    safi = SAFI_MPLS_VPN;
+    memcpy(&rd, &pptrs->bitr, sizeof(rd));
+  }
+
+  peer = bgp_lookup_table_peer(type, sa, pptrs->l3_proto, safi, live_peer);
   pptrs->bgp_peer = (char *) peer;
 
   if (peer) {
@@ -112,11 +137,6 @@ void bgp_srcdst_lookup(struct packet_ptrs *pptrs, int type)
       memcpy(&peer_dst_ip, &pbgp.peer_dst_ip, sizeof(struct host_addr));
     }
 
-    if (pptrs->bitr) {
-      safi = SAFI_MPLS_VPN;
-      memcpy(&rd, &pptrs->bitr, sizeof(rd));
-    }
-
     /* XXX: can be further optimized for the case of no SAFI_UNICAST rib */
     start_again_mpls_label:
 
@@ -127,12 +147,9 @@ void bgp_srcdst_lookup(struct packet_ptrs *pptrs, int type)
 	nmct2.rd = &rd;
 	nmct2.peer_dst_ip = NULL;
 
-        memcpy(&pref4, &((struct pm_iphdr *)pptrs->iph_ptr)->ip_src, sizeof(struct in_addr));
-	bgp_node_match_ipv4(inter_domain_routing_db->rib[AFI_IP][safi],
-			    &pref4, (struct bgp_peer *) pptrs->bgp_peer,
-		     	    bgp_route_info_modulo_pathid,
-			    bms->bgp_lookup_node_match_cmp, &nmct2,
-			    &result, &info);
+        ha.family = AF_INET;
+        memcpy(&ha.address.ipv4, &((struct pm_iphdr *)pptrs->iph_ptr)->ip_src, sizeof(struct in_addr));
+	bgp_srcdst_lookup_match(type, inter_domain_routing_db->rib[AFI_IP][safi], &ha, &nmct2, &result, &info);
       }
 
       if (!pptrs->bgp_src_info && result) {
@@ -151,12 +168,9 @@ void bgp_srcdst_lookup(struct packet_ptrs *pptrs, int type)
         nmct2.rd = &rd;
         nmct2.peer_dst_ip = &peer_dst_ip;
 
-	memcpy(&pref4, &((struct pm_iphdr *)pptrs->iph_ptr)->ip_dst, sizeof(struct in_addr));
-	bgp_node_match_ipv4(inter_domain_routing_db->rib[AFI_IP][safi],
-			    &pref4, (struct bgp_peer *) pptrs->bgp_peer,
-			    bgp_route_info_modulo_pathid,
-			    bms->bgp_lookup_node_match_cmp, &nmct2,
-			    &result, &info);
+	ha.family = AF_INET;
+	memcpy(&ha.address.ipv4, &((struct pm_iphdr *)pptrs->iph_ptr)->ip_dst, sizeof(struct in_addr));
+	bgp_srcdst_lookup_match(type, inter_domain_routing_db->rib[AFI_IP][safi], &ha, &nmct2, &result, &info);
       }
 
       if (!pptrs->bgp_dst_info && result) {
@@ -177,12 +191,9 @@ void bgp_srcdst_lookup(struct packet_ptrs *pptrs, int type)
         nmct2.rd = &rd;
         nmct2.peer_dst_ip = NULL;
 
-        memcpy(&pref6, &((struct ip6_hdr *)pptrs->iph_ptr)->ip6_src, sizeof(struct in6_addr));
-	bgp_node_match_ipv6(inter_domain_routing_db->rib[AFI_IP6][safi],
-		            &pref6, (struct bgp_peer *) pptrs->bgp_peer,
-		            bgp_route_info_modulo_pathid,
-		            bms->bgp_lookup_node_match_cmp, &nmct2,
-		            &result, &info);
+        ha.family = AF_INET6;
+        memcpy(&ha.address.ipv6, &((struct ip6_hdr *)pptrs->iph_ptr)->ip6_src, sizeof(struct in6_addr));
+	bgp_srcdst_lookup_match(type, inter_domain_routing_db->rib[AFI_IP6][safi], &ha, &nmct2, &result, &info);
       }
 
       if (!pptrs->bgp_src_info && result) {
@@ -200,12 +211,9 @@ void bgp_srcdst_lookup(struct packet_ptrs *pptrs, int type)
         nmct2.rd = &rd;
         nmct2.peer_dst_ip = &peer_dst_ip;
 
-        memcpy(&pref6, &((struct ip6_hdr *)pptrs->iph_ptr)->ip6_dst, sizeof(struct in6_addr));
-	bgp_node_match_ipv6(inter_domain_routing_db->rib[AFI_IP6][safi],
-	     		    &pref6, (struct bgp_peer *) pptrs->bgp_peer,
-			    bgp_route_info_modulo_pathid,
-			    bms->bgp_lookup_node_match_cmp, &nmct2,
-			    &result, &info);
+        ha.family = AF_INET6;
+        memcpy(&ha.address.ipv6, &((struct ip6_hdr *)pptrs->iph_ptr)->ip6_dst, sizeof(struct in6_addr));
+	bgp_srcdst_lookup_match(type, inter_domain_routing_db->rib[AFI_IP6][safi], &ha, &nmct2, &result, &info);
       }
 
       if (!pptrs->bgp_dst_info && result) {
@@ -220,16 +228,18 @@ void bgp_srcdst_lookup(struct packet_ptrs *pptrs, int type)
 #endif
 
     if ((!pptrs->bgp_src || !pptrs->bgp_dst) && safi != SAFI_MPLS_LABEL) {
-      if (pptrs->l3_proto == ETHERTYPE_IP && inter_domain_routing_db->rib[AFI_IP][SAFI_MPLS_LABEL]) {
-        safi = SAFI_MPLS_LABEL;
-        goto start_again_mpls_label;
-      }
+      if ((pptrs->l3_proto == ETHERTYPE_IP && inter_domain_routing_db->rib[AFI_IP][SAFI_MPLS_LABEL])
 #if defined ENABLE_IPV6
-      else if (pptrs->l3_proto == ETHERTYPE_IPV6 && inter_domain_routing_db->rib[AFI_IP6][SAFI_MPLS_LABEL]) {
+	  || (pptrs->l3_proto == ETHERTYPE_IPV6 && inter_domain_routing_db->rib[AFI_IP6][SAFI_MPLS_LABEL])
+#endif
+	 ) {
         safi = SAFI_MPLS_LABEL;
-        goto start_again_mpls_label;
+
+	if ((table_peer = bgp_lookup_table_peer(type, sa, pptrs->l3_proto, safi, live_peer))) {
+	  pptrs->bgp_peer = (char *) table_peer;
+	  goto start_again_mpls_label;
+	}
       }
-#endif
     }
 
     if (follow_default && safi != SAFI_MPLS_VPN) {
@@ -577,6 +587,161 @@ int bgp_lookup_node_match_cmp_bgp(struct bgp_info *info, struct node_match_cmp_t
   return TRUE;
 }
 
+void bgp_srcdst_lookup_match(int type, const struct bgp_table *table, struct host_addr *addr, struct node_match_cmp_term2 *nmct2,
+			     struct bgp_node **result_node, struct bgp_info **result_info)
+{
+  struct bgp_misc_structs *bms;
+  struct bgp_lookup_cache *cache = NULL;
+  struct bgp_lookup_cache_entry *entry = NULL;
+  struct bgp_lookup_cache_key key;
+  u_int64_t gen = 0;
+
+  bms = bgp_select_misc_db(type);
+
+  if (!bms || !nmct2 || !nmct2->peer) return;
+
+  if (config.bgp_lookup_cache_entries && table) cache = bgp_lookup_cache_get(type);
+
+  if (cache) {
+    /* peer routes being changed right now: don't trust, don't populate */
+    gen = __atomic_load_n(&nmct2->peer->lookup_gen, __ATOMIC_SEQ_CST);
+    if (gen & 1) {
+      cache->misses++;
+      cache = NULL;
+    }
+  }
+
+  if (cache) {
+    memset(&key, 0, sizeof(key));
+    key.peer = nmct2->peer;
+    key.table = table;
+    key.safi = nmct2->safi;
+    key.addr.family = addr->family;
+    if (addr->family == AF_INET) memcpy(&key.addr.address.ipv4, &addr->address.ipv4, 4);
+#if defined ENABLE_IPV6
+    else if (addr->family == AF_INET6) memcpy(&key.addr.address.ipv6, &addr->address.ipv6, 16);
+#endif
+    if (nmct2->rd) memcpy(&key.rd, nmct2->rd, sizeof(rd_t));
+    if (nmct2->peer_dst_ip) {
+      memcpy(&key.peer_dst_ip, nmct2->peer_dst_ip, sizeof(struct host_addr));
+      key.has_peer_dst_ip = TRUE;
+    }
+
+    entry = &cache->table[jhash(&key, sizeof(key), 0) % cache->entries];
+
+    if (entry->gen == gen && !memcmp(&entry->key, &key, sizeof(key))) {
+      (*result_node) = entry->node;
+      (*result_info) = entry->info;
+      cache->hits++;
+
+      return;
+    }
+
+    cache->misses++;
+  }
+
+  if (addr->family == AF_INET)
+    bgp_node_match_ipv4(table, &addr->address.ipv4, nmct2->peer, bgp_route_info_modulo_pathid,
+			bms->bgp_lookup_node_match_cmp, nmct2, result_node, result_info);
+#if defined ENABLE_IPV6
+  else if (addr->family == AF_INET6)
+    bgp_node_match_ipv6(table, &addr->address.ipv6, nmct2->peer, bgp_route_info_modulo_pathid,
+			bms->bgp_lookup_node_match_cmp, nmct2, result_node, result_info);
+#endif
+
+  if (entry) {
+    memcpy(&entry->key, &key, sizeof(key));
+    entry->gen = gen;
+    entry->node = (*result_node);
+    entry->info = (*result_info);
+  }
+}
+
+struct bgp_lookup_cache *bgp_lookup_cache_get(int type)
+{
+  struct bgp_misc_structs *bms;
+  struct bgp_lookup_cache *cache;
+
+  if (type <= FUNC_TYPE_NULL || type >= FUNC_TYPE_MAX) return NULL;
+  if (bgp_lookup_cache_local[type]) return bgp_lookup_cache_local[type];
+
+  bms = bgp_select_misc_db(type);
+
+  if (!bms) return NULL;
+
+  cache = malloc(sizeof(struct bgp_lookup_cache));
+  if (cache) {
+    memset(cache, 0, sizeof(struct bgp_lookup_cache));
+    cache->type = type;
+    cache->entries = config.bgp_lookup_cache_entries;
+    cache->table = malloc(cache->entries * sizeof(struct bgp_lookup_cache_entry));
+  }
+
+  if (!cache || !cache->table) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): malloc() failed (bgp_lookup_cache_get). Exiting ..\n", config.name, bms->log_str);
+    exit_all(1);
+  }
+
+  /* entries with no peer in their key never match */
+  memset(cache->table, 0, cache->entries * sizeof(struct bgp_lookup_cache_entry));
+
+  pthread_mutex_lock(&bgp_lookup_caches_mutex);
+  cache->next = bgp_lookup_caches;
+  __atomic_store_n(&bgp_lookup_caches, cache, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&bgp_lookup_caches_mutex);
+
+  bgp_lookup_cache_local[type] = cache;
+
+  return cache;
+}
+
+/*
+  Writers wrap any change to the routes of a peer with these two calls:
+  the peer generation is odd while the change is in progress and cached
+  lookups against the peer are void once it completes.
+*/
+static struct bgp_peer *bgp_lookup_cache_gen_peer(struct bgp_peer *peer)
+{
+  struct bgp_misc_structs *bms;
+
+  if (!peer || !config.bgp_lookup_cache_entries) return NULL;
+
+  bms = bgp_select_misc_db(peer->type);
+
+  if (bms && bms->bgp_lookup_cache_peer) return (*bms->bgp_lookup_cache_peer)(peer);
+  else return peer;
+}
+
+void bgp_lookup_cache_change_begin(struct bgp_peer *peer)
+{
+  struct bgp_peer *gen_peer = bgp_lookup_cache_gen_peer(peer);
+
+  if (gen_peer) __atomic_add_fetch(&gen_peer->lookup_gen, 1, __ATOMIC_SEQ_CST);
+}
+
+void bgp_lookup_cache_change_end(struct bgp_peer *peer)
+{
+  struct bgp_peer *gen_peer = bgp_lookup_cache_gen_peer(peer);
+
+  if (gen_peer) __atomic_add_fetch(&gen_peer->lookup_gen, 1, __ATOMIC_RELEASE);
+}
+
+void bgp_lookup_cache_print_stats(time_t now)
+{
+  struct bgp_misc_structs *bms;
+  struct bgp_lookup_cache *cache;
+
+  /* called from a signal handler: no locking, caches are never freed */
+  for (cache = __atomic_load_n(&bgp_lookup_caches, __ATOMIC_ACQUIRE); cache; cache = cache->next) {
+    bms = bgp_select_misc_db(cache->type);
+    if (!bms) continue;
+
+    Log(LOG_NOTICE, "NOTICE ( %s/%s ): stats [lookup cache] time=%u entries=%u hits=%llu misses=%llu\n",
+	config.name, bms->log_str, now, cache->entries, (unsigned long long) cache->hits,
+	(unsigned long long) cache->misses);
+  }
+}
+
 void pkt_to_cache_legacy_bgp_primitives(struct cache_legacy_bgp_primitives *c, struct pkt_legacy_bgp_primitives *p,
 					pm_cfgreg_t what_to_count, pm_cfgreg_t what_to_count_2)
 {
@@ -770,6 +935,9 @@ int bgp_lg_daemon_ip_lookup(struct bgp_lg_req_ipl_data *req, struct bgp_lg_rep *
 
   if (!req || !rep || !bms || !inter_domain_routing_db) return BGP_LOOKUP_ERR;
 
+  /* rep references RIB data until bgp_rib_read_exit() */
+  bgp_rib_read_enter();
+
   memset(&peer_ha, 0, sizeof(peer_ha));
   memset(rep, 0, sizeof(struct bgp_lg_rep));
   safi = SAFI_UNICAST;
@@ -22,6 +22,33 @@
 #ifndef _BGP_LOOKUP_H_
 #define _BGP_LOOKUP_H_
 
+/* structures */
+struct bgp_lookup_cache_key {
+  struct bgp_peer *peer;
+  const struct bgp_table *table;
+  struct host_addr addr;
+  struct host_addr peer_dst_ip;
+  rd_t rd;
+  u_int8_t safi;
+  u_int8_t has_peer_dst_ip;
+};
+
+struct bgp_lookup_cache_entry {
+  struct bgp_lookup_cache_key key;
+  u_int64_t gen;
+  struct bgp_node *node;
+  struct bgp_info *info;
+};
+
+struct bgp_lookup_cache {
+  int type;
+  u_int32_t entries;
+  struct bgp_lookup_cache_entry *table;
+  u_int64_t hits;
+  u_int64_t misses;
+  struct bgp_lookup_cache *next;
+};
+
 /* prototypes */
 #if (!defined __BGP_LOOKUP_C)
 #define EXT extern
@@ -33,6 +60,12 @@ EXT void bgp_follow_nexthop_lookup(struct packet_ptrs *, int);
 EXT struct bgp_peer *bgp_lookup_find_bgp_peer(struct sockaddr *, struct xflow_status_entry *, u_int16_t, int); 
 EXT u_int32_t bgp_route_info_modulo_pathid(struct bgp_peer *, path_id_t *, int);
 EXT int bgp_lookup_node_match_cmp_bgp(struct bgp_info *, struct node_match_cmp_term2 *);
+EXT void bgp_srcdst_lookup_match(int, const struct bgp_table *, struct host_addr *, struct node_match_cmp_term2 *,
+				 struct bgp_node **, struct bgp_info **);
+EXT struct bgp_lookup_cache *bgp_lookup_cache_get(int);
+EXT void bgp_lookup_cache_change_begin(struct bgp_peer *);
+EXT void bgp_lookup_cache_change_end(struct bgp_peer *);
+EXT void bgp_lookup_cache_print_stats(time_t);
 EXT void pkt_to_cache_legacy_bgp_primitives(struct cache_legacy_bgp_primitives *, struct pkt_legacy_bgp_primitives *, pm_cfgreg_t, pm_cfgreg_t);
 EXT void cache_to_pkt_legacy_bgp_primitives(struct pkt_legacy_bgp_primitives *, struct cache_legacy_bgp_primitives *);
 EXT void free_cache_legacy_bgp_primitives(struct cache_legacy_bgp_primitives **);
@@ -574,7 +574,8 @@ int bgp_parse_update_msg(struct bgp_msg_data *bmd, char *pkt)
   struct bgp_peer *peer = bmd->peer;
   struct bgp_header bhdr;
   u_char *startp, *endp;
-  struct bgp_attr attr;
+  struct bgp_attr attr, *attr_interned = NULL;
+  char *attr_blob = NULL;
   u_int16_t attribute_len;
   u_int16_t update_len;
   u_int16_t withdraw_len;
@@ -626,8 +627,16 @@ int bgp_parse_update_msg(struct bgp_msg_data *bmd, char *pkt)
   }
 
   if (attribute_len > 0) {
-    ret = bgp_attr_parse(peer, &attr, pkt, attribute_len, &mp_update, &mp_withdraw);
-    if (ret < 0) return ret;
+    attr_blob = pkt;
+
+    /* same attributes as the previous UPDATE: no parsing at all */
+    if ((attr_interned = bgp_attr_cache_lookup(peer, attr_blob, attribute_len)))
+      attr_interned = bgp_attr_intern(peer, attr_interned);
+    else {
+      ret = bgp_attr_parse(peer, &attr, pkt, attribute_len, &mp_update, &mp_withdraw);
+      if (ret < 0) return ret;
+    }
+
     pkt += attribute_len;
   }
 
@@ -640,15 +649,23 @@ int bgp_parse_update_msg(struct bgp_msg_data *bmd, char *pkt)
     update.length = update_len;
   }
 
+  /* attributes are interned once per UPDATE rather than per prefix */
+  if (!attr_interned && (update.length || mp_update.length)) {
+    attr_interned = bgp_attr_intern(peer, &attr);
+
+    if (attr_blob && !mp_update.afi && !mp_withdraw.afi)
+      bgp_attr_cache_update(peer, attr_blob, attribute_len, attr_interned);
+  }
+
   /* NLRI parsing */
   if (withdraw.length) bgp_nlri_parse(bmd, NULL, &withdraw);
-  if (update.length)  bgp_nlri_parse(bmd, &attr, &update);
+  if (update.length)  bgp_nlri_parse(bmd, attr_interned, &update);
 	
   if (mp_update.length
 	  && mp_update.afi == AFI_IP
 	  && (mp_update.safi == SAFI_UNICAST || mp_update.safi == SAFI_MPLS_LABEL ||
 	      mp_update.safi == SAFI_MPLS_VPN))
-    bgp_nlri_parse(bmd, &attr, &mp_update);
+    bgp_nlri_parse(bmd, attr_interned, &mp_update);
 
   if (mp_withdraw.length
 	  && mp_withdraw.afi == AFI_IP
@@ -661,7 +678,7 @@ int bgp_parse_update_msg(struct bgp_msg_data *bmd, char *pkt)
 	  && mp_update.afi == AFI_IP6
 	  && (mp_update.safi == SAFI_UNICAST || mp_update.safi == SAFI_MPLS_LABEL ||
 	      mp_update.safi == SAFI_MPLS_VPN))
-    bgp_nlri_parse(bmd, &attr, &mp_update);
+    bgp_nlri_parse(bmd, attr_interned, &mp_update);
 
   if (mp_withdraw.length
 	  && mp_withdraw.afi == AFI_IP6
@@ -670,11 +687,18 @@ int bgp_parse_update_msg(struct bgp_msg_data *bmd, char *pkt)
     bgp_nlri_parse(bmd, NULL, &mp_withdraw);
 #endif
 
-  /* Receipt of End-of-RIB can be processed here; being a silent
-	 BGP receiver only, honestly it doesn't matter to us */
+  /* Receipt of End-of-RIB: being a silent BGP receiver only, it
+	 matters just to drop stale routes restored from a RIB snapshot */
+  if (!withdraw_len && !update_len) {
+    if (!attribute_len) bgp_snapshot_stale_refresh(peer, AFI_IP, SAFI_UNICAST);
+    else if (mp_withdraw.afi && !mp_withdraw.length && !mp_update.afi)
+      bgp_snapshot_stale_refresh(peer, mp_withdraw.afi, mp_withdraw.safi);
+  }
 
   /* Everything is done.  We unintern temporary structures which
 	 interned in bgp_attr_parse(). */
+  if (attr_interned)
+    bgp_attr_unintern(peer, attr_interned);
   if (attr.aspath)
     aspath_unintern(peer, attr.aspath);
   if (attr.community)
@@ -969,9 +993,58 @@ int bgp_attr_parse_mp_unreach(struct bgp_peer *peer, u_int16_t len, struct bgp_a
 
 
 /* BGP UPDATE NLRI parsing */
+/*
+  Table lock and node for a NLRI: taken and released per NLRI or, when
+  batching, the lock is held up to bgp_nlri_batch_flush()
+*/
+static struct bgp_node *bgp_nlri_node_get(struct bgp_msg_data *bmd, struct bgp_table *table, struct prefix *p)
+{
+  struct bgp_nlri_batch *batch = bmd->batch;
+  struct bgp_node *route;
+
+  if (!batch) {
+    BGP_TABLE_LOCK(table);
+    return bgp_node_get(bmd->peer, table, p);
+  }
+
+  if (batch->table != table) {
+    bgp_nlri_batch_flush(bmd->peer, batch);
+    BGP_TABLE_LOCK(table);
+    batch->table = table;
+  }
+
+  route = bgp_node_get_hint(bmd->peer, table, p, batch->hint);
+
+  /* the hint is kept locked: a withdraw may otherwise delete it */
+  bgp_lock_node(bmd->peer, route);
+  if (batch->hint) bgp_unlock_node(bmd->peer, batch->hint);
+  batch->hint = route;
+  batch->count++;
+
+  return route;
+}
+
+static void bgp_nlri_node_put(struct bgp_msg_data *bmd, struct bgp_table *table, struct bgp_node *route)
+{
+  bgp_unlock_node(bmd->peer, route);
+  if (!bmd->batch) BGP_TABLE_UNLOCK(table);
+}
+
+void bgp_nlri_batch_flush(struct bgp_peer *peer, struct bgp_nlri_batch *batch)
+{
+  if (batch->table) {
+    if (batch->hint) bgp_unlock_node(peer, batch->hint);
+    BGP_TABLE_UNLOCK(batch->table);
+  }
+
+  memset(batch, 0, sizeof(struct bgp_nlri_batch));
+}
+
 int bgp_nlri_parse(struct bgp_msg_data *bmd, void *attr, struct bgp_nlri *info)
 {
   struct bgp_peer *peer = bmd->peer;
+  struct bgp_misc_structs *bms;
+  struct bgp_nlri_batch batch;
   u_char *pnt;
   u_char *lim;
   u_char safi, label[3];
@@ -986,10 +1059,19 @@ int bgp_nlri_parse(struct bgp_msg_data *bmd, void *attr, struct bgp_nlri *info)
   rd_t rd;
   path_id_t path_id;
 
+  bms = bgp_select_misc_db(peer->type);
+  if (!bms) return ERR;
+
   memset(&p, 0, sizeof(struct prefix));
   memset(&rd, 0, sizeof(rd_t));
   memset(&path_id, 0, sizeof(path_id_t));
 
+  if (bms->nlri_batch) {
+    memset(&batch, 0, sizeof(batch));
+    if (!bms->skip_rib) bmd->batch = &batch;
+    if (bms->msglog_backend_methods) bgp_peer_log_batch_begin(peer, bms->nlri_batch);
+  }
+
   pnt = info->nlri;
   lim = pnt + info->length;
   end = info->length;
@@ -1011,10 +1093,16 @@ int bgp_nlri_parse(struct bgp_msg_data *bmd, void *attr, struct bgp_nlri *info)
     p.family = bgp_afi2family (info->afi);
 
     if (info->safi == SAFI_UNICAST) { 
-      if ((info->afi == AFI_IP && p.prefixlen > 32) || (info->afi == AFI_IP6 && p.prefixlen > 128)) return ERR;
+      if ((info->afi == AFI_IP && p.prefixlen > 32) || (info->afi == AFI_IP6 && p.prefixlen > 128)) {
+        ret = ERR;
+        goto exit_lane;
+      }
 
       psize = ((p.prefixlen+7)/8);
-      if (psize > end) return ERR;
+      if (psize > end) {
+        ret = ERR;
+        goto exit_lane;
+      }
 
       /* Fetch prefix from NLRI packet. */
       memcpy(&p.u.prefix, pnt, psize);
@@ -1022,10 +1110,16 @@ int bgp_nlri_parse(struct bgp_msg_data *bmd, void *attr, struct bgp_nlri *info)
       // XXX: check address correctnesss now that we have it?
     }
     else if (info->safi == SAFI_MPLS_LABEL) { /* rfc3107 labeled unicast */
-      if ((info->afi == AFI_IP && p.prefixlen > 56) || (info->afi == AFI_IP6 && p.prefixlen > 152)) return ERR;
+      if ((info->afi == AFI_IP && p.prefixlen > 56) || (info->afi == AFI_IP6 && p.prefixlen > 152)) {
+        ret = ERR;
+        goto exit_lane;
+      }
 
       psize = ((p.prefixlen+7)/8);
-      if (psize > end) return ERR;
+      if (psize > end) {
+        ret = ERR;
+        goto exit_lane;
+      }
 
       /* Fetch label (3) and prefix from NLRI packet */
       memcpy(label, pnt, 3);
@@ -1033,10 +1127,16 @@ int bgp_nlri_parse(struct bgp_msg_data *bmd, void *attr, struct bgp_nlri *info)
       p.prefixlen -= 24;
     }
     else if (info->safi == SAFI_MPLS_VPN) { /* rfc4364 BGP/MPLS IP Virtual Private Networks */
-      if ((info->afi == AFI_IP && p.prefixlen > 120) || (info->afi == AFI_IP6 && p.prefixlen > 216)) return ERR;
+      if ((info->afi == AFI_IP && p.prefixlen > 120) || (info->afi == AFI_IP6 && p.prefixlen > 216)) {
+        ret = ERR;
+        goto exit_lane;
+      }
 
       psize = ((p.prefixlen+7)/8);
-      if (psize > end) return ERR;
+      if (psize > end) {
+        ret = ERR;
+        goto exit_lane;
+      }
 
       /* Fetch label (3), RD (8) and prefix from NLRI packet */
       memcpy(label, pnt, 3);
@@ -1065,7 +1165,8 @@ int bgp_nlri_parse(struct bgp_msg_data *bmd, void *attr, struct bgp_nlri *info)
 	rda4->val = ntohs(tmp16);
 	break;
       default:
-	return ERR;
+	ret = ERR;
+	goto exit_lane;
 	break;
       }
     
@@ -1078,9 +1179,23 @@ int bgp_nlri_parse(struct bgp_msg_data *bmd, void *attr, struct bgp_nlri *info)
       ret = bgp_process_update(bmd, &p, attr, info->afi, safi, &rd, &path_id, label);
     else
       ret = bgp_process_withdraw(bmd, &p, attr, info->afi, safi, &rd, &path_id, label);
+
+    if (bmd->batch && batch.count >= bms->nlri_batch) bgp_nlri_batch_flush(peer, &batch);
   }
 
-  return SUCCESS;
+  ret = SUCCESS;
+
+  exit_lane:
+  if (bms->nlri_batch) {
+    if (bmd->batch) {
+      bgp_nlri_batch_flush(peer, bmd->batch);
+      bmd->batch = NULL;
+    }
+
+    bgp_peer_log_batch_end(peer);
+  }
+
+  return ret;
 }
 
 int bgp_process_update(struct bgp_msg_data *bmd, struct prefix *p, void *attr, afi_t afi, safi_t safi,
@@ -1091,7 +1206,8 @@ int bgp_process_update(struct bgp_msg_data *bmd, struct prefix *p, void *attr, a
   struct bgp_misc_structs *bms;
   struct bgp_node *route = NULL, route_local;
   struct bgp_info *ri = NULL, *new = NULL, ri_local;
-  struct bgp_attr *attr_new = NULL;
+  struct bgp_attr *attr_new = NULL, *attr_old = NULL;
+  struct bgp_table *table;
   u_int32_t modulo;
 
   if (!peer) return ERR;
@@ -1103,7 +1219,12 @@ int bgp_process_update(struct bgp_msg_data *bmd, struct prefix *p, void *attr, a
 
   if (!bms->skip_rib) { 
     modulo = bms->route_info_modulo(peer, path_id, bms->table_per_peer_buckets);
-    route = bgp_node_get(peer, inter_domain_routing_db->rib[afi][safi], p);
+    table = inter_domain_routing_db->rib[afi][safi];
+
+    /* interned out of the table lock, it may well be dropped right away */
+    attr_new = bgp_attr_intern(peer, attr);
+
+    route = bgp_nlri_node_get(bmd, table, p);
 
     /* Check previously received route. */
     for (ri = route->info[modulo]; ri; ri = ri->next) {
@@ -1133,12 +1254,10 @@ int bgp_process_update(struct bgp_msg_data *bmd, struct prefix *p, void *attr, a
       }
     }
 
-    attr_new = bgp_attr_intern(peer, attr);
-
     if (ri) {
       /* Received same information */
       if (attrhash_cmp(ri->attr, attr_new)) {
-        bgp_unlock_node(peer, route);
+        bgp_nlri_node_put(bmd, table, route);
         bgp_attr_unintern(peer, attr_new);
 
         if (bms->msglog_backend_methods)
@@ -1147,13 +1266,18 @@ int bgp_process_update(struct bgp_msg_data *bmd, struct prefix *p, void *attr, a
         return SUCCESS;
       }
       else {
-        /* Update to new attribute.  */
-        bgp_attr_unintern(peer, ri->attr);
-        ri->attr = attr_new;
+        /* Update to new attribute; RIB readers may still hold the old one */
+        bgp_lookup_cache_change_begin(peer);
+        attr_old = ri->attr;
+        BGP_RIB_STORE(ri->attr, attr_new);
+        bgp_rib_retire(peer, BGP_RIB_RETIRED_ATTR, attr_old);
         bgp_info_extra_process(peer, ri, safi, path_id, rd, label);
         if (bms->bgp_extra_data_process) (*bms->bgp_extra_data_process)(&bmd->extra, ri);
+        bgp_lookup_cache_change_end(peer);
 
-        bgp_unlock_node (peer, route);
+        if (bms->dump.checkpoint) bgp_dump_journal_add(peer, BGP_LOG_TYPE_UPDATE, afi, safi, p, ri);
+
+        bgp_nlri_node_put(bmd, table, route);
 
         if (bms->msglog_backend_methods)
 	  goto log_update;
@@ -1170,13 +1294,22 @@ int bgp_process_update(struct bgp_msg_data *bmd, struct prefix *p, void *attr, a
       bgp_info_extra_process(peer, new, safi, path_id, rd, label);
       if (bms->bgp_extra_data_process) (*bms->bgp_extra_data_process)(&bmd->extra, new);
     }
-    else return ERR;
+    else {
+      bgp_nlri_node_put(bmd, table, route);
+      bgp_attr_unintern(peer, attr_new);
+
+      return ERR;
+    }
 
     /* Register new BGP information. */
+    bgp_lookup_cache_change_begin(peer);
     bgp_info_add(peer, route, new, modulo);
+    bgp_lookup_cache_change_end(peer);
+
+    if (bms->dump.checkpoint) bgp_dump_journal_add(peer, BGP_LOG_TYPE_UPDATE, afi, safi, p, new);
 
     /* route_node_get lock */
-    bgp_unlock_node(peer, route);
+    bgp_nlri_node_put(bmd, table, route);
 
     if (bms->msglog_backend_methods) {
       ri = new;
@@ -1226,6 +1359,7 @@ int bgp_process_withdraw(struct bgp_msg_data *bmd, struct prefix *p, void *attr,
   struct bgp_misc_structs *bms;
   struct bgp_node *route = NULL, route_local;
   struct bgp_info *ri = NULL, ri_local;
+  struct bgp_table *table = NULL;
   u_int32_t modulo;
 
   if (!peer) return ERR;
@@ -1239,7 +1373,8 @@ int bgp_process_withdraw(struct bgp_msg_data *bmd, struct prefix *p, void *attr,
     modulo = bms->route_info_modulo(peer, path_id, bms->table_per_peer_buckets);
 
     /* Lookup node. */
-    route = bgp_node_get(peer, inter_domain_routing_db->rib[afi][safi], p);
+    table = inter_domain_routing_db->rib[afi][safi];
+    route = bgp_nlri_node_get(bmd, table, p);
 
     /* Check previously received route. */
     for (ri = route->info[modulo]; ri; ri = ri->next) {
@@ -1292,10 +1427,16 @@ int bgp_process_withdraw(struct bgp_msg_data *bmd, struct prefix *p, void *attr,
 
   if (!bms->skip_rib) {
     /* Withdraw specified route from routing table. */
-    if (ri) bgp_info_delete(peer, route, ri, modulo); 
+    if (ri) {
+      if (bms->dump.checkpoint) bgp_dump_journal_add(peer, BGP_LOG_TYPE_WITHDRAW, afi, safi, p, ri);
+
+      bgp_lookup_cache_change_begin(peer);
+      bgp_info_delete(peer, route, ri, modulo); 
+      bgp_lookup_cache_change_end(peer);
+    }
 
     /* Unlock bgp_node_get() lock. */
-    bgp_unlock_node(peer, route);
+    bgp_nlri_node_put(bmd, table, route);
   }
   else {
     if (bms->msglog_backend_methods) {
@@ -50,6 +50,7 @@ EXT int bgp_attr_parse_origin(struct bgp_peer *, u_int16_t, struct bgp_attr *, c
 EXT int bgp_attr_parse_mp_reach(struct bgp_peer *, u_int16_t, struct bgp_attr *, char *, struct bgp_nlri *);
 EXT int bgp_attr_parse_mp_unreach(struct bgp_peer *, u_int16_t, struct bgp_attr *, char *, struct bgp_nlri *);
 EXT int bgp_nlri_parse(struct bgp_msg_data *, void *, struct bgp_nlri *);
+EXT void bgp_nlri_batch_flush(struct bgp_peer *, struct bgp_nlri_batch *);
 EXT int bgp_process_update(struct bgp_msg_data *, struct prefix *, void *, afi_t, safi_t, rd_t *, path_id_t *, char *);
 EXT int bgp_process_withdraw(struct bgp_msg_data *, struct prefix *, void *, afi_t, safi_t, rd_t *, path_id_t *, char *);
 #undef EXT
@@ -0,0 +1,661 @@
+/*
+    pmacct (Promiscuous mode IP Accounting package)
+    pmacct is Copyright (C) 2003-2018 by Paolo Lucente
+*/
+
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#define __BGP_SNAPSHOT_C
+
+#include "../pmacct.h"
+#include "addr.h"
+#include "bgp.h"
+#include <sys/mman.h>
+
+/* maps interned attributes to their index in the snapshot being written */
+struct bgp_snapshot_attr_idx {
+  struct bgp_attr *attr;
+  u_int32_t idx;
+};
+
+static u_int32_t bgp_snapshot_attr_idx_hash(struct bgp_attr *attr, u_int32_t size)
+{
+  return ((((u_int64_t) attr >> 4) * 2654435761U) & (size - 1));
+}
+
+static u_int16_t bgp_snapshot_aspath_len(struct aspath *aspath)
+{
+  struct assegment *seg;
+  u_int32_t len = 0;
+
+  if (aspath) {
+    for (seg = aspath->segments; seg; seg = seg->next) len += (2 + (seg->length * 4));
+  }
+
+  return (len > UINT16_MAX ? 0 : len);
+}
+
+static int bgp_snapshot_write_attr(FILE *fd, struct bgp_attr *attr)
+{
+  struct bgp_snapshot_rec bsr;
+  struct bgp_snapshot_attr bsa;
+  struct assegment *seg;
+  u_int32_t as;
+  u_int8_t seg_hdr[2];
+  int idx;
+
+  memset(&bsa, 0, sizeof(bsa));
+  bsa.nexthop = attr->nexthop;
+  memcpy(&bsa.mp_nexthop, &attr->mp_nexthop, sizeof(struct host_addr));
+  bsa.med = attr->med;
+  bsa.local_pref = attr->local_pref;
+  bsa.flag = attr->flag;
+  bsa.origin = attr->origin;
+  bsa.aspath_len = bgp_snapshot_aspath_len(attr->aspath);
+  if (attr->community) bsa.comm_len = (attr->community->size * 4);
+  if (attr->ecommunity) bsa.ecomm_len = (attr->ecommunity->size * ECOMMUNITY_SIZE);
+  if (attr->lcommunity) bsa.lcomm_len = (attr->lcommunity->size * LCOMMUNITY_SIZE);
+
+  memset(&bsr, 0, sizeof(bsr));
+  bsr.type = BGP_SNAPSHOT_REC_ATTR;
+  bsr.len = (sizeof(bsa) + bsa.aspath_len + bsa.comm_len + bsa.ecomm_len + bsa.lcomm_len);
+
+  if (fwrite(&bsr, sizeof(bsr), 1, fd) != 1) return ERR;
+  if (fwrite(&bsa, sizeof(bsa), 1, fd) != 1) return ERR;
+
+  if (bsa.aspath_len) {
+    for (seg = attr->aspath->segments; seg; seg = seg->next) {
+      seg_hdr[0] = seg->type;
+      seg_hdr[1] = seg->length;
+      if (fwrite(seg_hdr, sizeof(seg_hdr), 1, fd) != 1) return ERR;
+
+      for (idx = 0; idx < seg->length; idx++) {
+	as = htonl(seg->as[idx]);
+	if (fwrite(&as, sizeof(as), 1, fd) != 1) return ERR;
+      }
+    }
+  }
+
+  if (bsa.comm_len && fwrite(attr->community->val, bsa.comm_len, 1, fd) != 1) return ERR;
+  if (bsa.ecomm_len && fwrite(attr->ecommunity->val, bsa.ecomm_len, 1, fd) != 1) return ERR;
+  if (bsa.lcomm_len && fwrite(attr->lcommunity->val, bsa.lcomm_len, 1, fd) != 1) return ERR;
+
+  return SUCCESS;
+}
+
+static int bgp_snapshot_write(char *filename, struct bgp_misc_structs *bms, struct bgp_rt_structs *inter_domain_routing_db)
+{
+  char tmp_filename[SRVBUFLEN], *fd_buf = NULL;
+  struct bgp_snapshot_hdr bsh;
+  struct bgp_snapshot_rec bsr;
+  struct bgp_snapshot_peer bsp;
+  struct bgp_snapshot_route bsrt;
+  struct bgp_snapshot_attr_idx *attr_idx = NULL;
+  struct bgp_peer *peer, peer_local;
+  struct bgp_peer_stale *bps;
+  struct bgp_table *table;
+  struct bgp_node *node;
+  struct bgp_info *ri;
+  u_int32_t *peers_map = NULL, *peers_stale_map = NULL, peers_num = 0, attrs_num = 0;
+  u_int32_t attr_idx_size, attr_idx_bucket, ri_idx, peer_idx;
+  u_int64_t routes_num = 0;
+  int peers_idx, peers_check_idx, ret = ERR;
+  FILE *fd;
+  afi_t afi;
+  safi_t safi;
+
+  snprintf(tmp_filename, SRVBUFLEN, "%s.tmp", filename);
+
+  fd = open_output_file(tmp_filename, "w", TRUE);
+  if (!fd) return ERR;
+
+  fd_buf = malloc(OUTPUT_FILE_BUFSZ);
+  if (fd_buf) setvbuf(fd, fd_buf, _IOFBF, OUTPUT_FILE_BUFSZ);
+
+  peers_map = calloc(config.nfacctd_bgp_max_peers, sizeof(u_int32_t));
+  if (bms->peers_stale_num) peers_stale_map = calloc(bms->peers_stale_num, sizeof(u_int32_t));
+
+  /* interned attributes are known in number: at most half full */
+  for (attr_idx_size = 1024; attr_idx_size < (inter_domain_routing_db->attr_mem[BGP_ATTR_MEM_ATTR].num * 2); attr_idx_size *= 2);
+  attr_idx = calloc(attr_idx_size, sizeof(struct bgp_snapshot_attr_idx));
+
+  if (!peers_map || (bms->peers_stale_num && !peers_stale_map) || !attr_idx) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): [%s] malloc() failed (bgp_snapshot_write).\n", config.name, bms->log_str, filename);
+    goto exit_lane;
+  }
+
+  memset(&bsh, 0, sizeof(bsh));
+  memcpy(bsh.magic, BGP_SNAPSHOT_MAGIC, sizeof(bsh.magic));
+  bsh.version = BGP_SNAPSHOT_VERSION;
+  bsh.byte_order = BGP_SNAPSHOT_BYTE_ORDER;
+  bsh.tstamp = time(NULL);
+  if (fwrite(&bsh, sizeof(bsh), 1, fd) != 1) goto exit_lane;
+
+  memset(&bsr, 0, sizeof(bsr));
+  bsr.type = BGP_SNAPSHOT_REC_PEER;
+  bsr.len = sizeof(bsp);
+
+  /* indexes are stored off by one, zero meaning the peer is not in the snapshot */
+  for (peers_idx = 0; peers_idx < config.nfacctd_bgp_max_peers; peers_idx++) {
+    peer = &peers[peers_idx];
+    if (!peer->fd || peer->status != Established) continue;
+
+    memset(&bsp, 0, sizeof(bsp));
+    memcpy(&bsp.addr, &peer->addr, sizeof(struct host_addr));
+    memcpy(&bsp.id, &peer->id, sizeof(struct host_addr));
+    bsp.as = peer->as;
+    bsp.cap_add_paths = peer->cap_add_paths;
+
+    if (fwrite(&bsr, sizeof(bsr), 1, fd) != 1 || fwrite(&bsp, sizeof(bsp), 1, fd) != 1) goto exit_lane;
+    peers_map[peers_idx] = ++peers_num;
+  }
+
+  /* routes restored at startup are carried over if their peer is still missing */
+  for (peers_idx = 0; peers_idx < bms->peers_stale_num; peers_idx++) {
+    bps = &bms->peers_stale[peers_idx];
+    if (!bps->pending_afi[AFI_IP] && !bps->pending_afi[AFI_IP6]) continue;
+
+    for (peers_check_idx = 0; peers_check_idx < config.nfacctd_bgp_max_peers; peers_check_idx++) {
+      if (peers_map[peers_check_idx] && !memcmp(&peers[peers_check_idx].addr, &bps->peer.addr, sizeof(struct host_addr))) break;
+    }
+    if (peers_check_idx < config.nfacctd_bgp_max_peers) continue;
+
+    memset(&bsp, 0, sizeof(bsp));
+    memcpy(&bsp.addr, &bps->peer.addr, sizeof(struct host_addr));
+    memcpy(&bsp.id, &bps->peer.id, sizeof(struct host_addr));
+    bsp.as = bps->peer.as;
+    bsp.cap_add_paths = bps->peer.cap_add_paths;
+
+    if (fwrite(&bsr, sizeof(bsr), 1, fd) != 1 || fwrite(&bsp, sizeof(bsp), 1, fd) != 1) goto exit_lane;
+    peers_stale_map[peers_idx] = ++peers_num;
+  }
+
+  memset(&peer_local, 0, sizeof(peer_local));
+  peer_local.type = FUNC_TYPE_BGP;
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+    for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++) {
+      table = inter_domain_routing_db->rib[afi][safi];
+
+      for (node = bgp_table_top(&peer_local, table); node; node = bgp_route_next(&peer_local, node)) {
+	for (ri_idx = 0; ri_idx < (bms->table_peer_buckets * bms->table_per_peer_buckets); ri_idx++) {
+	  for (ri = node->info[ri_idx]; ri; ri = ri->next) {
+	    if (!ri->attr) continue;
+
+	    peer_idx = 0;
+	    if (ri->peer >= peers && ri->peer < &peers[config.nfacctd_bgp_max_peers])
+	      peer_idx = peers_map[ri->peer - peers];
+	    else if (peers_stale_map) {
+	      bps = (struct bgp_peer_stale *) ri->peer;
+
+	      if (bps >= bms->peers_stale && bps < &bms->peers_stale[bms->peers_stale_num])
+		peer_idx = peers_stale_map[bps - bms->peers_stale];
+	    }
+
+	    if (!peer_idx) continue;
+
+	    memset(&bsrt, 0, sizeof(bsrt));
+	    bsrt.peer = (peer_idx - 1);
+
+	    for (attr_idx_bucket = bgp_snapshot_attr_idx_hash(ri->attr, attr_idx_size);
+		 attr_idx[attr_idx_bucket].attr && attr_idx[attr_idx_bucket].attr != ri->attr;
+		 attr_idx_bucket = ((attr_idx_bucket + 1) & (attr_idx_size - 1)));
+
+	    if (!attr_idx[attr_idx_bucket].attr) {
+	      if (bgp_snapshot_write_attr(fd, ri->attr)) goto exit_lane;
+
+	      /* keep it half full at most, beyond that attributes are just repeated */
+	      if (attrs_num < (attr_idx_size / 2)) {
+		attr_idx[attr_idx_bucket].attr = ri->attr;
+		attr_idx[attr_idx_bucket].idx = attrs_num;
+	      }
+
+	      bsrt.attr = attrs_num;
+	      attrs_num++;
+	    }
+	    else bsrt.attr = attr_idx[attr_idx_bucket].idx;
+
+	    bsrt.afi = afi;
+	    bsrt.safi = safi;
+	    bsrt.family = node->p.family;
+	    bsrt.prefixlen = node->p.prefixlen;
+	    memcpy(bsrt.prefix, &node->p.u.prefix, (node->p.family == AF_INET ? 4 : 16));
+
+	    if (ri->extra) {
+	      memcpy(&bsrt.rd, &ri->extra->rd, sizeof(rd_t));
+	      bsrt.path_id = ri->extra->path_id;
+	      memcpy(bsrt.label, ri->extra->label, sizeof(bsrt.label));
+	    }
+
+	    bsr.type = BGP_SNAPSHOT_REC_ROUTE;
+	    bsr.len = sizeof(bsrt);
+	    if (fwrite(&bsr, sizeof(bsr), 1, fd) != 1 || fwrite(&bsrt, sizeof(bsrt), 1, fd) != 1) goto exit_lane;
+
+	    routes_num++;
+	  }
+	}
+      }
+    }
+  }
+
+  if (fflush(fd) || fsync(fileno(fd))) goto exit_lane;
+
+  ret = SUCCESS;
+
+  exit_lane:
+  close_output_file(fd);
+  free(fd_buf);
+  free(peers_map);
+  free(peers_stale_map);
+  free(attr_idx);
+
+  if (!ret) {
+    if (rename(tmp_filename, filename)) {
+      Log(LOG_ERR, "ERROR ( %s/%s ): [%s] rename() failed: %s\n", config.name, bms->log_str, filename, strerror(errno));
+      ret = ERR;
+    }
+    else {
+      Log(LOG_INFO, "INFO ( %s/%s ): [%s] RIB snapshot written (peers: %u, attributes: %u, routes: %llu)\n",
+	  config.name, bms->log_str, filename, peers_num, attrs_num, (unsigned long long) routes_num);
+    }
+  }
+  else {
+    Log(LOG_ERR, "ERROR ( %s/%s ): [%s] RIB snapshot failed: %s\n", config.name, bms->log_str, filename, strerror(errno));
+    unlink(tmp_filename);
+  }
+
+  return ret;
+}
+
+void bgp_handle_snapshot_event()
+{
+  struct bgp_misc_structs *bms = bgp_select_misc_db(FUNC_TYPE_BGP);
+  struct bgp_rt_structs *inter_domain_routing_db = bgp_select_routing_db(FUNC_TYPE_BGP);
+  int ret;
+
+  /* pre-flight check */
+  if (!bms || !inter_domain_routing_db || !config.bgp_table_snapshot_file) return;
+
+  switch (ret = fork()) {
+  case 0: /* Child */
+    /* we have to ignore signals to avoid loops: because we are already forked */
+    signal(SIGINT, SIG_IGN);
+    signal(SIGHUP, SIG_IGN);
+    pm_setproctitle("%s %s [%s]", config.type, "Core Process -- BGP Snapshot Writer", config.name);
+
+    ret = bgp_snapshot_write(config.bgp_table_snapshot_file, bms, inter_domain_routing_db);
+
+    exit(ret ? 1 : 0);
+  default: /* Parent */
+    if (ret == -1) { /* Something went wrong */
+      Log(LOG_WARNING, "WARN ( %s/%s ): Unable to fork BGP RIB snapshot writer: %s\n", config.name, bms->log_str, strerror(errno));
+    }
+
+    break;
+  }
+}
+
+static int bgp_snapshot_load_attr(struct bgp_peer *peer, struct bgp_attr *attr, u_char *ptr, u_int32_t len)
+{
+  struct bgp_snapshot_attr bsa;
+
+  if (len < sizeof(bsa)) return ERR;
+
+  memcpy(&bsa, ptr, sizeof(bsa));
+  ptr += sizeof(bsa);
+  len -= sizeof(bsa);
+
+  if (len != (bsa.aspath_len + bsa.comm_len + bsa.ecomm_len + bsa.lcomm_len)) return ERR;
+
+  memset(attr, 0, sizeof(struct bgp_attr));
+  attr->nexthop = bsa.nexthop;
+  memcpy(&attr->mp_nexthop, &bsa.mp_nexthop, sizeof(struct host_addr));
+  attr->med = bsa.med;
+  attr->local_pref = bsa.local_pref;
+  attr->flag = bsa.flag;
+  attr->origin = bsa.origin;
+
+  /* parsers give back interned structures, as if received from the wire */
+  if (bsa.aspath_len) {
+    attr->aspath = aspath_parse(peer, (char *) ptr, bsa.aspath_len, TRUE);
+    if (!attr->aspath) return ERR;
+    ptr += bsa.aspath_len;
+  }
+
+  if (bsa.comm_len) {
+    attr->community = community_parse(peer, (u_int32_t *) ptr, bsa.comm_len);
+    ptr += bsa.comm_len;
+  }
+
+  if (bsa.ecomm_len) {
+    attr->ecommunity = ecommunity_parse(peer, ptr, bsa.ecomm_len);
+    ptr += bsa.ecomm_len;
+  }
+
+  if (bsa.lcomm_len) {
+    attr->lcommunity = lcommunity_parse(peer, ptr, bsa.lcomm_len);
+    ptr += bsa.lcomm_len;
+  }
+
+  return SUCCESS;
+}
+
+static int bgp_snapshot_load_route(struct bgp_peer_stale *bps, struct bgp_attr *attr, struct bgp_snapshot_route *bsrt,
+				   struct bgp_misc_structs *bms, struct bgp_rt_structs *inter_domain_routing_db)
+{
+  struct bgp_peer *peer = &bps->peer;
+  struct bgp_table *table;
+  struct bgp_node *node;
+  struct bgp_info *ri;
+  struct bgp_attr *attr_new;
+  struct prefix p;
+  u_int32_t modulo;
+
+  if (bsrt->afi >= AFI_MAX || bsrt->safi >= SAFI_MAX) return ERR;
+
+  memset(&p, 0, sizeof(p));
+  p.family = bsrt->family;
+  p.prefixlen = bsrt->prefixlen;
+
+  if (p.family == AF_INET && p.prefixlen <= IPV4_MAX_PREFIXLEN) memcpy(&p.u.prefix, bsrt->prefix, 4);
+#if defined ENABLE_IPV6
+  else if (p.family == AF_INET6 && p.prefixlen <= IPV6_MAX_PREFIXLEN) memcpy(&p.u.prefix, bsrt->prefix, 16);
+#endif
+  else return ERR;
+
+  table = inter_domain_routing_db->rib[bsrt->afi][bsrt->safi];
+  if (!table) return ERR;
+
+  attr_new = bgp_attr_intern(peer, attr);
+
+  ri = bgp_info_new(peer);
+  if (!ri) {
+    bgp_attr_unintern(peer, attr_new);
+    return ERR;
+  }
+
+  ri->peer = peer;
+  ri->attr = attr_new;
+  bgp_info_extra_process(peer, ri, bsrt->safi, &bsrt->path_id, &bsrt->rd, (char *) bsrt->label);
+  modulo = bms->route_info_modulo(peer, &bsrt->path_id, bms->table_per_peer_buckets);
+
+  BGP_TABLE_LOCK(table);
+  node = bgp_node_get(peer, table, &p);
+  bgp_info_add(peer, node, ri, modulo);
+  bgp_unlock_node(peer, node);
+  BGP_TABLE_UNLOCK(table);
+
+  if (!bps->pending[bsrt->afi][bsrt->safi]) {
+    bps->pending[bsrt->afi][bsrt->safi] = TRUE;
+    bps->pending_afi[bsrt->afi]++;
+  }
+
+  return SUCCESS;
+}
+
+/*
+   loads a RIB snapshot at startup: routes are installed on behalf of stale
+   peers and used for lookups until the session of the peer comes back and
+   sends End-of-RIB, or the stale time expires, whichever comes first.
+*/
+int bgp_snapshot_load(char *filename)
+{
+  struct bgp_misc_structs *bms = bgp_select_misc_db(FUNC_TYPE_BGP);
+  struct bgp_rt_structs *inter_domain_routing_db = bgp_select_routing_db(FUNC_TYPE_BGP);
+  struct bgp_snapshot_hdr bsh;
+  struct bgp_snapshot_rec bsr;
+  struct bgp_snapshot_peer bsp;
+  struct bgp_snapshot_route bsrt;
+  struct bgp_peer_stale *peers_stale = NULL, *bps;
+  struct bgp_peer peer_local;
+  struct bgp_attr *attrs = NULL, *attrs_new;
+  u_int32_t peers_num = 0, attrs_num = 0, attrs_size = 0, idx;
+  u_int64_t routes_num = 0;
+  u_char *base, *ptr, *end;
+  struct stat st;
+  int fd, ret = ERR;
+
+  if (!bms || !inter_domain_routing_db || !filename) return ERR;
+
+  fd = open(filename, O_RDONLY);
+  if (fd == ERR) {
+    if (errno != ENOENT)
+      Log(LOG_WARNING, "WARN ( %s/%s ): [%s] Unable to open RIB snapshot: %s\n", config.name, bms->log_str, filename, strerror(errno));
+
+    return ERR;
+  }
+
+  if (fstat(fd, &st) || st.st_size < sizeof(bsh)) {
+    Log(LOG_WARNING, "WARN ( %s/%s ): [%s] Invalid RIB snapshot.\n", config.name, bms->log_str, filename);
+    close(fd);
+    return ERR;
+  }
+
+  base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (base == MAP_FAILED) {
+    Log(LOG_WARNING, "WARN ( %s/%s ): [%s] Unable to mmap() RIB snapshot: %s\n", config.name, bms->log_str, filename, strerror(errno));
+    return ERR;
+  }
+
+#ifdef MADV_SEQUENTIAL
+  madvise(base, st.st_size, MADV_SEQUENTIAL);
+#endif
+
+  end = (base + st.st_size);
+  memcpy(&bsh, base, sizeof(bsh));
+  ptr = (base + sizeof(bsh));
+
+  if (memcmp(bsh.magic, BGP_SNAPSHOT_MAGIC, sizeof(bsh.magic)) || bsh.version != BGP_SNAPSHOT_VERSION ||
+      bsh.byte_order != BGP_SNAPSHOT_BYTE_ORDER) {
+    Log(LOG_WARNING, "WARN ( %s/%s ): [%s] Invalid RIB snapshot.\n", config.name, bms->log_str, filename);
+    goto exit_lane;
+  }
+
+  peers_stale = calloc(config.nfacctd_bgp_max_peers, sizeof(struct bgp_peer_stale));
+  if (!peers_stale) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): [%s] malloc() failed (bgp_snapshot_load).\n", config.name, bms->log_str, filename);
+    goto exit_lane;
+  }
+
+  memset(&peer_local, 0, sizeof(peer_local));
+  peer_local.type = FUNC_TYPE_BGP;
+
+  while ((ptr + sizeof(bsr)) <= end) {
+    memcpy(&bsr, ptr, sizeof(bsr));
+    ptr += sizeof(bsr);
+
+    if (bsr.len > (end - ptr)) break;
+
+    switch (bsr.type) {
+    case BGP_SNAPSHOT_REC_PEER:
+      if (bsr.len != sizeof(bsp) || peers_num >= config.nfacctd_bgp_max_peers) goto corrupt;
+
+      memcpy(&bsp, ptr, sizeof(bsp));
+      bps = &peers_stale[peers_num];
+      bps->peer.type = FUNC_TYPE_BGP;
+      bps->peer.status = Established;
+      memcpy(&bps->peer.addr, &bsp.addr, sizeof(struct host_addr));
+      memcpy(&bps->peer.id, &bsp.id, sizeof(struct host_addr));
+      addr_to_str(bps->peer.addr_str, &bps->peer.addr);
+      bps->peer.as = bsp.as;
+      bps->peer.cap_add_paths = bsp.cap_add_paths;
+      peers_num++;
+      break;
+    case BGP_SNAPSHOT_REC_ATTR:
+      if (attrs_num == attrs_size) {
+	attrs_size = (attrs_size ? (attrs_size * 2) : 1024);
+	attrs_new = realloc(attrs, (attrs_size * sizeof(struct bgp_attr)));
+	if (!attrs_new) {
+	  Log(LOG_ERR, "ERROR ( %s/%s ): [%s] malloc() failed (bgp_snapshot_load).\n", config.name, bms->log_str, filename);
+	  goto exit_lane;
+	}
+
+	attrs = attrs_new;
+      }
+
+      if (bgp_snapshot_load_attr(&peer_local, &attrs[attrs_num], ptr, bsr.len)) goto corrupt;
+      attrs_num++;
+      break;
+    case BGP_SNAPSHOT_REC_ROUTE:
+      if (bsr.len != sizeof(bsrt)) goto corrupt;
+
+      memcpy(&bsrt, ptr, sizeof(bsrt));
+      if (bsrt.peer >= peers_num || bsrt.attr >= attrs_num) goto corrupt;
+
+      if (bgp_snapshot_load_route(&peers_stale[bsrt.peer], &attrs[bsrt.attr], &bsrt, bms, inter_domain_routing_db)) goto corrupt;
+      routes_num++;
+      break;
+    default:
+      goto corrupt;
+    }
+
+    ptr += bsr.len;
+  }
+
+  if (ptr != end) goto corrupt;
+
+  ret = SUCCESS;
+  Log(LOG_INFO, "INFO ( %s/%s ): [%s] RIB snapshot loaded (peers: %u, attributes: %u, routes: %llu, age: %llus)\n",
+      config.name, bms->log_str, filename, peers_num, attrs_num, (unsigned long long) routes_num,
+      (unsigned long long) (time(NULL) - bsh.tstamp));
+
+  goto exit_lane;
+
+  corrupt:
+  Log(LOG_WARNING, "WARN ( %s/%s ): [%s] RIB snapshot truncated or corrupt. Stopped at %llu routes.\n",
+      config.name, bms->log_str, filename, (unsigned long long) routes_num);
+
+  exit_lane:
+  /* drop the references taken by the parsers */
+  for (idx = 0; idx < attrs_num; idx++) {
+    if (attrs[idx].aspath) aspath_unintern(&peer_local, attrs[idx].aspath);
+    if (attrs[idx].community) community_unintern(&peer_local, attrs[idx].community);
+    if (attrs[idx].ecommunity) ecommunity_unintern(&peer_local, attrs[idx].ecommunity);
+    if (attrs[idx].lcommunity) lcommunity_unintern(&peer_local, attrs[idx].lcommunity);
+  }
+
+  free(attrs);
+  munmap(base, st.st_size);
+
+  if (routes_num) {
+    bms->peers_stale = peers_stale;
+    bms->peers_stale_deadline = (time(NULL) + config.bgp_table_snapshot_stale_time);
+    BGP_RIB_STORE(bms->peers_stale_num, peers_num);
+  }
+  else free(peers_stale);
+
+  return ret;
+}
+
+/* RIB lookups: a stale peer stands in for a live one until superseded */
+struct bgp_peer *bgp_snapshot_stale_find(struct sockaddr *sa, u_int16_t l3_proto, safi_t safi)
+{
+  struct bgp_misc_structs *bms = bgp_select_misc_db(FUNC_TYPE_BGP);
+  struct bgp_peer_stale *bps;
+  int idx, num;
+  afi_t afi;
+
+  if (!bms || !(num = BGP_RIB_LOAD(bms->peers_stale_num))) return NULL;
+
+  if (l3_proto == ETHERTYPE_IP) afi = AFI_IP;
+#if defined ENABLE_IPV6
+  else if (l3_proto == ETHERTYPE_IPV6) afi = AFI_IP6;
+#endif
+  else return NULL;
+
+  if (safi >= SAFI_MAX) return NULL;
+
+  for (idx = 0; idx < num; idx++) {
+    bps = &bms->peers_stale[idx];
+
+    if (BGP_RIB_LOAD(bps->pending[afi][safi]) &&
+	(!sa_addr_cmp(sa, &bps->peer.addr) || !sa_addr_cmp(sa, &bps->peer.id)))
+      return &bps->peer;
+  }
+
+  return NULL;
+}
+
+static void bgp_snapshot_stale_purge(struct bgp_peer_stale *bps, afi_t afi, safi_t safi)
+{
+  /* lookups move over to the live peer before the table is emptied */
+  BGP_RIB_STORE(bps->pending[afi][safi], FALSE);
+  BGP_RIB_STORE(bps->pending_afi[afi], (bps->pending_afi[afi] - 1));
+
+  bgp_lookup_cache_change_begin(&bps->peer);
+  bgp_peer_info_delete_table(&bps->peer, afi, safi);
+  bgp_lookup_cache_change_end(&bps->peer);
+}
+
+/* End-of-RIB from a live session: its stale counterpart is superseded */
+void bgp_snapshot_stale_refresh(struct bgp_peer *peer, afi_t afi, safi_t safi)
+{
+  struct bgp_misc_structs *bms = bgp_select_misc_db(FUNC_TYPE_BGP);
+  struct bgp_peer_stale *bps;
+  int idx, num;
+
+  if (!peer || peer->type != FUNC_TYPE_BGP || !bms) return;
+  if (!(num = BGP_RIB_LOAD(bms->peers_stale_num))) return;
+  if (afi >= AFI_MAX || safi >= SAFI_MAX) return;
+
+  pthread_mutex_lock(&bms->peers_mutex);
+
+  for (idx = 0; idx < num; idx++) {
+    bps = &bms->peers_stale[idx];
+
+    if (bps->pending[afi][safi] && !memcmp(&bps->peer.addr, &peer->addr, sizeof(struct host_addr))) {
+      bgp_snapshot_stale_purge(bps, afi, safi);
+
+      Log(LOG_INFO, "INFO ( %s/%s ): [%s] End-of-RIB received, stale routes dropped (afi: %u, safi: %u)\n",
+	  config.name, bms->log_str, bps->peer.addr_str, afi, safi);
+    }
+  }
+
+  pthread_mutex_unlock(&bms->peers_mutex);
+}
+
+void bgp_snapshot_stale_expire(time_t now)
+{
+  struct bgp_misc_structs *bms = bgp_select_misc_db(FUNC_TYPE_BGP);
+  struct bgp_peer_stale *bps;
+  int idx, num;
+  afi_t afi;
+  safi_t safi;
+
+  if (!bms || !(num = bms->peers_stale_num) || now < bms->peers_stale_deadline) return;
+
+  pthread_mutex_lock(&bms->peers_mutex);
+
+  for (idx = 0; idx < num; idx++) {
+    bps = &bms->peers_stale[idx];
+
+    for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+      for (safi = SAFI_UNICAST; safi < SAFI_MAX && bps->pending_afi[afi]; safi++) {
+	if (bps->pending[afi][safi]) bgp_snapshot_stale_purge(bps, afi, safi);
+      }
+    }
+  }
+
+  /* stale peers memory is kept: RIB readers may still be referencing it */
+  BGP_RIB_STORE(bms->peers_stale_num, 0);
+
+  pthread_mutex_unlock(&bms->peers_mutex);
+
+  Log(LOG_INFO, "INFO ( %s/%s ): Stale routes from RIB snapshot expired.\n", config.name, bms->log_str);
+}
@@ -0,0 +1,111 @@
+/*
+    pmacct (Promiscuous mode IP Accounting package)
+    pmacct is Copyright (C) 2003-2018 by Paolo Lucente
+*/
+
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if no, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef _BGP_SNAPSHOT_H_
+#define _BGP_SNAPSHOT_H_
+
+/* defines */
+#define BGP_SNAPSHOT_MAGIC		"PMBGPRIB"
+#define BGP_SNAPSHOT_VERSION		1
+#define BGP_SNAPSHOT_BYTE_ORDER		0x01020304
+#define BGP_SNAPSHOT_REFRESH_TIME	300 /* secs */
+#define BGP_SNAPSHOT_STALE_TIME		300 /* secs */
+
+#define BGP_SNAPSHOT_REC_PEER		1
+#define BGP_SNAPSHOT_REC_ATTR		2
+#define BGP_SNAPSHOT_REC_ROUTE		3
+
+/* structures */
+
+/*
+   A snapshot is a header followed by records, each one made of a struct
+   bgp_snapshot_rec and a payload. Peers come first; an attribute record
+   precedes the first route referencing it, routes refer to peers and
+   attributes by their order of appearance. Snapshots are meant to be read
+   back on the same host, hence data is in host byte order.
+*/
+struct bgp_snapshot_hdr {
+  char magic[8];
+  u_int32_t version;
+  u_int32_t byte_order;
+  u_int64_t tstamp;
+};
+
+struct bgp_snapshot_rec {
+  u_int8_t type;
+  u_int8_t pad[3];
+  u_int32_t len;
+};
+
+struct bgp_snapshot_peer {
+  struct host_addr addr;
+  struct host_addr id;
+  as_t as;
+  u_int8_t cap_add_paths;
+};
+
+/* followed by AS_PATH (4-bytes ASNs), communities, ext and large communities, wire format */
+struct bgp_snapshot_attr {
+  struct in_addr nexthop;
+  struct host_addr mp_nexthop;
+  u_int32_t med;
+  u_int32_t local_pref;
+  u_int32_t flag;
+  u_char origin;
+  u_int16_t aspath_len;
+  u_int16_t comm_len;
+  u_int16_t ecomm_len;
+  u_int16_t lcomm_len;
+};
+
+struct bgp_snapshot_route {
+  u_int32_t peer;
+  u_int32_t attr;
+  afi_t afi;
+  safi_t safi;
+  u_char family;
+  u_char prefixlen;
+  u_char prefix[16];
+  rd_t rd;
+  path_id_t path_id;
+  u_char label[3];
+};
+
+/* warm restart: peer restored from a snapshot, its routes being stale */
+struct bgp_peer_stale {
+  struct bgp_peer peer;
+  u_int8_t pending[AFI_MAX][SAFI_MAX]; /* routes not superseded by a live session yet */
+  u_int16_t pending_afi[AFI_MAX]; /* pending tables per afi */
+};
+
+/* prototypes */
+#if (!defined __BGP_SNAPSHOT_C)
+#define EXT extern
+#else
+#define EXT
+#endif
+EXT void bgp_handle_snapshot_event();
+EXT int bgp_snapshot_load(char *);
+EXT struct bgp_peer *bgp_snapshot_stale_find(struct sockaddr *, u_int16_t, safi_t);
+EXT void bgp_snapshot_stale_refresh(struct bgp_peer *, afi_t, safi_t);
+EXT void bgp_snapshot_stale_expire(time_t);
+#undef EXT
+#endif
@@ -37,6 +37,17 @@ static void bgp_node_free (struct bgp_node *);
 static void route_common (struct prefix *, struct prefix *, struct prefix *);
 static int check_bit (u_char *, u_char);
 static void set_link (struct bgp_node *, struct bgp_node *);
+static u_int32_t bgp_table_stride_idx (struct prefix *, u_int8_t);
+static void bgp_table_stride_set (struct bgp_table *, struct bgp_node *);
+static void bgp_table_stride_unset (struct bgp_table *, struct bgp_node *);
+static void bgp_table_stride_init (struct bgp_table *);
+static void bgp_table_stride_build (struct bgp_table *, struct bgp_node *);
+
+/* RIB readers epoch tracking */
+static u_int64_t bgp_rib_epoch = (BGP_RIB_EPOCH_OFFLINE + 1);
+static struct bgp_rib_reader bgp_rib_readers[BGP_RIB_MAX_READERS];
+static int bgp_rib_readers_num;
+static __thread struct bgp_rib_reader *bgp_rib_reader_self;
 
 struct bgp_table *
 bgp_table_init (afi_t afi, safi_t safi)
@@ -49,6 +60,11 @@ bgp_table_init (afi_t afi, safi_t safi)
 
     rt->afi = afi;
     rt->safi = safi;
+
+    if (afi == AFI_IP) rt->stride_bits = BGP_TABLE_STRIDE_BITS_IPV4;
+    else if (afi == AFI_IP6) rt->stride_bits = BGP_TABLE_STRIDE_BITS_IPV6;
+
+    pthread_mutex_init (&rt->lock, NULL);
   }
   else {
     Log(LOG_ERR, "ERROR ( %s/core/BGP ): malloc() failed (bgp_table_init). Exiting ..\n", config.name); // XXX
@@ -63,6 +79,7 @@ bgp_node_create (struct bgp_peer *peer)
 {
   struct bgp_misc_structs *bms;
   struct bgp_node *rn;
+  size_t info_size;
 
   if (!peer) return NULL;
 
@@ -70,13 +87,13 @@ bgp_node_create (struct bgp_peer *peer)
 
   if (!bms) return NULL;
 
-  rn = (struct bgp_node *) malloc (sizeof (struct bgp_node));
-  if (rn) {
-    memset (rn, 0, sizeof (struct bgp_node));
+  /* one allocation for node and paths: saves a pointer chase per node walked */
+  info_size = (sizeof(struct bgp_info *) * (bms->table_peer_buckets * bms->table_per_peer_buckets));
 
-    rn->info = (void **) malloc(sizeof(struct bgp_info *) * (bms->table_peer_buckets * bms->table_per_peer_buckets));
-    if (rn->info) memset (rn->info, 0, sizeof(struct bgp_info *) * (bms->table_peer_buckets * bms->table_per_peer_buckets));
-    else goto malloc_failed;
+  rn = (struct bgp_node *) malloc (sizeof (struct bgp_node) + info_size);
+  if (rn) {
+    memset (rn, 0, sizeof (struct bgp_node) + info_size);
+    rn->info = (void **) (rn + 1);
   }
   else goto malloc_failed;
 
@@ -106,7 +123,6 @@ bgp_node_set (struct bgp_peer *peer, struct bgp_table *table, struct prefix *pre
 static void
 bgp_node_free (struct bgp_node *node)
 {
-  free (node->info);
   free (node);
 }
 
@@ -183,8 +199,8 @@ set_link (struct bgp_node *node, struct bgp_node *new)
 
   assert (bit == 0 || bit == 1);
 
-  node->link[bit] = new;
   new->parent = node;
+  BGP_RIB_STORE(node->link[bit], new);
 }
 
 /* Lock node. */
@@ -214,7 +230,7 @@ bgp_node_match (const struct bgp_table *table, struct prefix *p, struct bgp_peer
 		struct bgp_node **result_node, struct bgp_info **result_info)
 {
   struct bgp_misc_structs *bms;
-  struct bgp_node *node, *matched_node;
+  struct bgp_node *node, *matched_node, *stride_node, **stride;
   struct bgp_info *info, *matched_info;
   u_int32_t modulo, modulo_idx, local_modulo, modulo_max;
 
@@ -231,12 +247,24 @@ bgp_node_match (const struct bgp_table *table, struct prefix *p, struct bgp_peer
 
   matched_node = NULL;
   matched_info = NULL;
-  node = table->top;
+  stride_node = NULL;
+  stride = BGP_RIB_LOAD(table->stride);
+
+  if (stride && p->prefixlen >= table->stride_bits)
+    stride_node = BGP_RIB_LOAD(stride[bgp_table_stride_idx(p, table->stride_bits)]);
+
+  if (stride_node) node = stride_node;
+  else node = BGP_RIB_LOAD(table->top);
+
+  walk_again:
 
   /* Walk down tree.  If there is matched route then store it to matched. */
   while (node && node->p.prefixlen <= p->prefixlen && prefix_match(&node->p, p)) {
+    /* second pass, from the top: stop where the first one started */
+    if (stride_node && !stride && node->p.prefixlen >= stride_node->p.prefixlen) break;
+
     for (local_modulo = modulo, modulo_idx = 0; modulo_idx < modulo_max; local_modulo++, modulo_idx++) {
-      for (info = node->info[local_modulo]; info; info = info->next) {
+      for (info = BGP_RIB_LOAD(node->info[local_modulo]); info; info = BGP_RIB_LOAD(info->next)) {
 	if (!cmp_func(info, nmct2)) {
 	  matched_node = node;
 	  matched_info = info;
@@ -245,13 +273,20 @@ bgp_node_match (const struct bgp_table *table, struct prefix *p, struct bgp_peer
       }
     }
 
-    node = node->link[check_bit(&p->u.prefix, node->p.prefixlen)];
+    node = BGP_RIB_LOAD(node->link[check_bit(&p->u.prefix, node->p.prefixlen)]);
   }
 
+  /* nothing below the stride node: go through the nodes above it */
+  if (!matched_node && stride_node && stride) {
+    stride = NULL;
+    node = BGP_RIB_LOAD(table->top);
+    goto walk_again;
+  }
+
+  /* no node lock taken: results are protected by the reader epoch */
   if (matched_node) {
     (*result_node) = matched_node;
     (*result_info) = matched_info;
-    bgp_lock_node (NULL /* XXX */, matched_node);
   }
   else {
     (*result_node) = NULL;
@@ -299,13 +334,34 @@ bgp_node_match_ipv6 (const struct bgp_table *table, struct in6_addr *addr, struc
 struct bgp_node *
 bgp_node_get (struct bgp_peer *peer, struct bgp_table *const table, struct prefix *p)
 {
-  struct bgp_misc_structs *bms = bgp_select_misc_db(peer->type);
+  return bgp_node_get_hint (peer, table, p, NULL);
+}
+
+/*
+  Same as bgp_node_get() but the descent starts from the closest
+  ancestor of hint, a node of the same table, covering p: any node
+  covering p lies on its path from the top, hence the result is the
+  same. Adjacent prefixes, ie. in a table sync, share most of it.
+*/
+struct bgp_node *
+bgp_node_get_hint (struct bgp_peer *peer, struct bgp_table *const table, struct prefix *p, struct bgp_node *hint)
+{
   struct bgp_node *new;
   struct bgp_node *node;
   struct bgp_node *match;
 
   match = NULL;
   node = table->top;
+
+  for (; hint; hint = hint->parent)
+    {
+      if (hint->p.prefixlen <= p->prefixlen && prefix_match (&hint->p, p))
+	{
+	  node = hint;
+	  break;
+	}
+    }
+
   while (node && node->p.prefixlen <= p->prefixlen && 
 	 prefix_match (&node->p, p))
     {
@@ -324,7 +380,9 @@ bgp_node_get (struct bgp_peer *peer, struct bgp_table *const table, struct prefi
       if (match)
 	set_link (match, new);
       else
-	table->top = new;
+	BGP_RIB_STORE(table->top, new);
+
+      bgp_table_stride_set (table, new);
     }
   else
     {
@@ -337,22 +395,51 @@ bgp_node_get (struct bgp_peer *peer, struct bgp_table *const table, struct prefi
       if (match)
 	set_link (match, new);
       else
-	table->top = new;
+	BGP_RIB_STORE(table->top, new);
+
+      bgp_table_stride_set (table, new);
 
       if (new->p.prefixlen != p->prefixlen)
 	{
 	  match = new;
 	  new = bgp_node_set (peer, table, p);
 	  set_link (match, new);
+	  bgp_table_stride_set (table, new);
 	  table->count++;
 	}
     }
   table->count++;
+
+  if (!table->stride && table->stride_bits && table->count >= BGP_TABLE_STRIDE_MIN_NODES)
+    bgp_table_stride_init (table);
+
   bgp_lock_node (peer, new);
   
   return new;
 }
 
+/* Lookup same prefix node; no lock is taken, writers have to be held
+   off by the caller (ie. it runs in the forked dump writer) */
+struct bgp_node *
+bgp_node_lookup (const struct bgp_table *table, struct prefix *p)
+{
+  struct bgp_node *node;
+
+  if (!table) return NULL;
+
+  node = table->top;
+  while (node && node->p.prefixlen <= p->prefixlen && 
+	 prefix_match (&node->p, p))
+    {
+      if (node->p.prefixlen == p->prefixlen)
+	return node;
+
+      node = node->link[check_bit(&p->u.prefix, node->p.prefixlen)];
+    }
+
+  return NULL;
+}
+
 /* Delete node from the routing table. */
 static void
 bgp_node_delete (struct bgp_peer *peer, struct bgp_node *node)
@@ -377,22 +464,25 @@ bgp_node_delete (struct bgp_peer *peer, struct bgp_node *node)
 
   parent = node->parent;
 
+  bgp_table_stride_unset (node->table, node);
+
   if (child)
     child->parent = parent;
 
   if (parent)
     {
       if (parent->l_left == node)
-	parent->l_left = child;
+	BGP_RIB_STORE(parent->l_left, child);
       else
-	parent->l_right = child;
+	BGP_RIB_STORE(parent->l_right, child);
     }
   else
-    node->table->top = child;
+    BGP_RIB_STORE(node->table->top, child);
   
   node->table->count--;
   
-  bgp_node_free (node);
+  /* readers may still be walking the node: free it once safe */
+  bgp_rib_retire (peer, BGP_RIB_RETIRED_NODE, node);
 
   /* If parent node is stub then delete it also. */
   if (parent && parent->lock == 0)
@@ -498,3 +588,239 @@ bgp_route_next_until (struct bgp_peer *peer, struct bgp_node *node, struct bgp_n
   bgp_unlock_node (peer, start);
   return NULL;
 }
+
+/* Mark the calling thread as a RIB reader. Nodes, routes and attributes
+   returned by lookups remain valid until bgp_rib_read_exit() is called;
+   calls can be nested, ie. by BGP and BMP lookups on the same packet. */
+void
+bgp_rib_read_enter ()
+{
+  struct bgp_rib_reader *self = bgp_rib_reader_self;
+  int idx;
+
+  if (!self)
+    {
+      idx = __atomic_fetch_add (&bgp_rib_readers_num, 1, __ATOMIC_SEQ_CST);
+      if (idx >= BGP_RIB_MAX_READERS)
+	{
+	  Log(LOG_ERR, "ERROR ( %s/core/BGP ): too many RIB reader threads (max: %u). Exiting ..\n", config.name, BGP_RIB_MAX_READERS);
+	  exit_all(1);
+	}
+
+      self = bgp_rib_reader_self = &bgp_rib_readers[idx];
+    }
+
+  if (self->epoch != BGP_RIB_EPOCH_OFFLINE)
+    return;
+
+  __atomic_store_n (&self->epoch, __atomic_load_n (&bgp_rib_epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+}
+
+/* To be called when no reference to RIB data is held anymore, and
+   certainly before blocking: a reader staying online holds back the
+   reclaim of everything retired after it entered. */
+void
+bgp_rib_read_exit ()
+{
+  struct bgp_rib_reader *self = bgp_rib_reader_self;
+
+  if (self)
+    __atomic_store_n (&self->epoch, BGP_RIB_EPOCH_OFFLINE, __ATOMIC_RELEASE);
+}
+
+static void
+bgp_rib_retired_free (struct bgp_peer *peer, u_int8_t type, void *ptr)
+{
+  switch (type)
+    {
+    case BGP_RIB_RETIRED_NODE:
+      bgp_node_free ((struct bgp_node *) ptr);
+      break;
+    case BGP_RIB_RETIRED_INFO:
+      bgp_info_free (peer, (struct bgp_info *) ptr);
+      break;
+    case BGP_RIB_RETIRED_ATTR:
+      bgp_attr_unintern (peer, (struct bgp_attr *) ptr);
+      break;
+    default:
+      break;
+    }
+}
+
+/* Called by the writer once 'ptr' has been unlinked from the RIB. */
+void
+bgp_rib_retire (struct bgp_peer *peer, u_int8_t type, void *ptr)
+{
+  struct bgp_misc_structs *bms;
+  struct bgp_rib_retired *rr;
+
+  if (!peer || !ptr) return;
+
+  bms = bgp_select_misc_db(peer->type);
+
+  if (!bms) return;
+
+  /* make the unlink visible before sampling epoch and readers */
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+  /* nobody ever looked the RIB up, ie. pmbgpd with no Looking Glass */
+  if (!__atomic_load_n (&bgp_rib_readers_num, __ATOMIC_SEQ_CST))
+    {
+      bgp_rib_retired_free (peer, type, ptr);
+      return;
+    }
+
+  rr = malloc (sizeof (struct bgp_rib_retired));
+  if (!rr)
+    {
+      Log(LOG_ERR, "ERROR ( %s/%s ): malloc() failed (bgp_rib_retire). Exiting ..\n", config.name, bms->log_str);
+      exit_all(1);
+    }
+
+  rr->type = type;
+  rr->peer = peer;
+  rr->ptr = ptr;
+  rr->next = NULL;
+
+  /* epoch is sampled under the lock so to keep the list sorted */
+  pthread_mutex_lock (&bms->rib_retired_mutex);
+  rr->epoch = __atomic_load_n (&bgp_rib_epoch, __ATOMIC_SEQ_CST);
+
+  if (bms->rib_retired_tail)
+    bms->rib_retired_tail->next = rr;
+  else
+    bms->rib_retired_head = rr;
+
+  bms->rib_retired_tail = rr;
+  bms->rib_retired_num++;
+  pthread_mutex_unlock (&bms->rib_retired_mutex);
+}
+
+/* Called periodically by the writer: frees whatever was retired in
+   an epoch that no active reader can still be part of. */
+void
+bgp_rib_reclaim (struct bgp_misc_structs *bms)
+{
+  struct bgp_rib_retired *rr, *reclaim_head = NULL, *reclaim_tail = NULL;
+  u_int64_t epoch, min_epoch;
+  int idx, readers_num;
+
+  if (!bms || !bms->rib_retired_head) return;
+
+  __atomic_add_fetch (&bgp_rib_epoch, 1, __ATOMIC_SEQ_CST);
+
+  readers_num = __atomic_load_n (&bgp_rib_readers_num, __ATOMIC_SEQ_CST);
+  if (readers_num > BGP_RIB_MAX_READERS) readers_num = BGP_RIB_MAX_READERS;
+
+  for (min_epoch = (u_int64_t) -1, idx = 0; idx < readers_num; idx++)
+    {
+      epoch = __atomic_load_n (&bgp_rib_readers[idx].epoch, __ATOMIC_SEQ_CST);
+      if (epoch != BGP_RIB_EPOCH_OFFLINE && epoch < min_epoch) min_epoch = epoch;
+    }
+
+  /* list is in retire order, hence sorted by epoch */
+  pthread_mutex_lock (&bms->rib_retired_mutex);
+  while ((rr = bms->rib_retired_head) && rr->epoch < min_epoch)
+    {
+      bms->rib_retired_head = rr->next;
+      if (!bms->rib_retired_head) bms->rib_retired_tail = NULL;
+      bms->rib_retired_num--;
+
+      rr->next = NULL;
+      if (reclaim_tail) reclaim_tail->next = rr;
+      else reclaim_head = rr;
+      reclaim_tail = rr;
+    }
+  pthread_mutex_unlock (&bms->rib_retired_mutex);
+
+  /* freeing attributes takes further locks: not under the list one */
+  while ((rr = reclaim_head))
+    {
+      reclaim_head = rr->next;
+
+      bgp_rib_retired_free (rr->peer, rr->type, rr->ptr);
+      free (rr);
+    }
+}
+
+/* Index of the stride-long prefix 'p' falls into; stride is up to 24 bits. */
+static u_int32_t
+bgp_table_stride_idx (struct prefix *p, u_int8_t bits)
+{
+  u_char *pp = (u_char *)&p->u.prefix;
+
+  return (((pp[0] << 16) | (pp[1] << 8) | pp[2]) >> (24 - bits));
+}
+
+/* New node linked in the trie: it becomes the stride node of the range
+   it covers, unless a deeper one is already there. */
+static void
+bgp_table_stride_set (struct bgp_table *table, struct bgp_node *node)
+{
+  struct bgp_node *cur;
+  u_int32_t idx, first, num;
+
+  if (!table->stride || node->p.prefixlen > table->stride_bits) return;
+
+  num = (1 << (table->stride_bits - node->p.prefixlen));
+  first = (bgp_table_stride_idx (&node->p, table->stride_bits) & ~(num - 1));
+
+  for (idx = first; idx < (first + num); idx++)
+    {
+      cur = table->stride[idx];
+      if (!cur || cur->p.prefixlen < node->p.prefixlen)
+	BGP_RIB_STORE(table->stride[idx], node);
+    }
+}
+
+/* Node about to be unlinked from the trie: its parent covers the very same
+   range and takes over. */
+static void
+bgp_table_stride_unset (struct bgp_table *table, struct bgp_node *node)
+{
+  u_int32_t idx, first, num;
+
+  if (!table->stride || node->p.prefixlen > table->stride_bits) return;
+
+  num = (1 << (table->stride_bits - node->p.prefixlen));
+  first = (bgp_table_stride_idx (&node->p, table->stride_bits) & ~(num - 1));
+
+  for (idx = first; idx < (first + num); idx++)
+    {
+      if (table->stride[idx] == node)
+	BGP_RIB_STORE(table->stride[idx], node->parent);
+    }
+}
+
+/* Index the nodes of an existing trie. Readers may use the index while it
+   is being filled: a missing entry just means walking from the top. */
+static void
+bgp_table_stride_init (struct bgp_table *table)
+{
+  struct bgp_node **stride;
+
+  stride = calloc ((1 << table->stride_bits), sizeof (struct bgp_node *));
+  if (!stride)
+    {
+      Log(LOG_WARNING, "WARN ( %s/core/BGP ): calloc() failed (bgp_table_stride_init). Lookups will walk from the top.\n", config.name);
+      table->stride_bits = 0;
+      return;
+    }
+
+  BGP_RIB_STORE(table->stride, stride);
+
+  if (table->top)
+    bgp_table_stride_build (table, table->top);
+}
+
+static void
+bgp_table_stride_build (struct bgp_table *table, struct bgp_node *node)
+{
+  if (node->p.prefixlen > table->stride_bits) return;
+
+  bgp_table_stride_set (table, node);
+
+  if (node->l_left) bgp_table_stride_build (table, node->l_left);
+  if (node->l_right) bgp_table_stride_build (table, node->l_right);
+}
@@ -29,6 +29,39 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #define DEFAULT_BGP_INFO_HASH 13
 #define DEFAULT_BGP_INFO_PER_PEER_HASH 1
 
+/*
+  RIB readers (ie. the collector thread enriching flows, the Looking Glass)
+  walk the tables without any lock while the BGP/BMP threads modify them.
+  Pointers are published with release semantics and read with acquire
+  semantics; nodes, routes and attributes unlinked by a writer are retired
+  and only freed once every active reader has moved past the epoch in
+  which they were unlinked.
+*/
+#define BGP_RIB_LOAD(x)		__atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define BGP_RIB_STORE(x, y)	__atomic_store_n(&(x), (y), __ATOMIC_RELEASE)
+
+#define BGP_RIB_MAX_READERS	64
+#define BGP_RIB_EPOCH_OFFLINE	0
+#define BGP_RIB_RECLAIM_INTERVAL	1 /* secs */
+
+#define BGP_RIB_RETIRED_NODE	1
+#define BGP_RIB_RETIRED_INFO	2
+#define BGP_RIB_RETIRED_ATTR	3
+
+/* writers, ie. BGP worker threads, are serialized per table */
+#define BGP_TABLE_LOCK(t)	pthread_mutex_lock(&(t)->lock)
+#define BGP_TABLE_UNLOCK(t)	pthread_mutex_unlock(&(t)->lock)
+
+/*
+  Multibit index on top of the trie: for every prefix of stride length,
+  the deepest node covering it. Lookups start from there instead of the
+  top of the trie; it is built once a table grows past a few thousands
+  nodes, so small tables don't pay its memory.
+*/
+#define BGP_TABLE_STRIDE_BITS_IPV4	16
+#define BGP_TABLE_STRIDE_BITS_IPV6	20
+#define BGP_TABLE_STRIDE_MIN_NODES	4096
+
 struct bgp_table
 {
   /* afi/safi of this table */
@@ -41,6 +74,12 @@ struct bgp_table
   struct bgp_node *top;
   
   unsigned long count;
+
+  struct bgp_node **stride;
+  u_int8_t stride_bits;
+
+  /* serializes writers (BGP workers); readers go lock-free */
+  pthread_mutex_t lock;
 };
 
 struct bgp_node
@@ -53,7 +92,7 @@ struct bgp_node
 #define l_left   link[0]
 #define l_right  link[1]
 
-  void **info;
+  void **info; /* allocated along with the node, right after it */
 
   unsigned int lock;
 };
@@ -81,6 +120,19 @@ struct bgp_info
   struct bgp_info_extra *extra;
 };
 
+struct bgp_rib_reader {
+  u_int64_t epoch;
+  u_int8_t pad[56]; /* one reader per cache line */
+};
+
+struct bgp_rib_retired {
+  u_int8_t type;
+  u_int64_t epoch;
+  struct bgp_peer *peer;
+  void *ptr;
+  struct bgp_rib_retired *next;
+};
+
 struct node_match_cmp_term2 {
   struct bgp_peer *peer;
   safi_t safi;
@@ -88,6 +140,8 @@ struct node_match_cmp_term2 {
   struct host_addr *peer_dst_ip;
 };
 
+struct bgp_misc_structs;
+
 /* Prototypes */
 #if (!defined __BGP_TABLE_C)
 #define EXT extern
@@ -100,6 +154,8 @@ EXT struct bgp_node *bgp_table_top (struct bgp_peer *, const struct bgp_table *c
 EXT struct bgp_node *bgp_route_next (struct bgp_peer *, struct bgp_node *);
 EXT struct bgp_node *bgp_route_next_until (struct bgp_peer *, struct bgp_node *, struct bgp_node *);
 EXT struct bgp_node *bgp_node_get (struct bgp_peer *, struct bgp_table *const, struct prefix *);
+EXT struct bgp_node *bgp_node_get_hint (struct bgp_peer *, struct bgp_table *const, struct prefix *, struct bgp_node *);
+EXT struct bgp_node *bgp_node_lookup (const struct bgp_table *, struct prefix *);
 EXT struct bgp_node *bgp_lock_node (struct bgp_peer *, struct bgp_node *node);
 EXT void bgp_node_match (const struct bgp_table *, struct prefix *, struct bgp_peer *,
 			 u_int32_t (*modulo_func)(struct bgp_peer *, path_id_t *, int),
@@ -118,5 +174,10 @@ EXT void bgp_node_match_ipv6 (const struct bgp_table *, struct in6_addr *, struc
 			      struct node_match_cmp_term2 *,
 			      struct bgp_node **result_node, struct bgp_info **result_info);
 #endif /* ENABLE_IPV6 */
+
+EXT void bgp_rib_read_enter ();
+EXT void bgp_rib_read_exit ();
+EXT void bgp_rib_retire (struct bgp_peer *, u_int8_t, void *);
+EXT void bgp_rib_reclaim (struct bgp_misc_structs *);
 #undef EXT
 #endif 
@@ -175,10 +175,76 @@ int bgp_label2str(char *str, u_char *label)
   return TRUE;
 }
 
+void bgp_pool_init(struct bgp_pool *pool, size_t size, u_int32_t max)
+{
+  memset(pool, 0, sizeof(struct bgp_pool));
+  pool->size = size;
+  pool->max = max;
+  pthread_mutex_init(&pool->mutex, NULL);
+}
+
+/* Zeroed object off the pool, malloc() if empty; no pool, plain malloc() */
+void *bgp_pool_get(struct bgp_pool *pool, size_t size)
+{
+  void *obj = NULL;
+
+  if (pool) {
+    pthread_mutex_lock(&pool->mutex);
+    if ((obj = pool->head)) {
+      pool->head = *(void **) obj;
+      pool->num--;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+  }
+
+  if (!obj) obj = malloc(size);
+  if (obj) memset(obj, 0, size);
+
+  return obj;
+}
+
+void bgp_pool_put(struct bgp_pool *pool, void *obj)
+{
+  if (!obj) return;
+
+  if (pool) {
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->num < pool->max) {
+      *(void **) obj = pool->head;
+      pool->head = obj;
+      pool->num++;
+      obj = NULL;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+  }
+
+  free(obj);
+}
+
+/* Gives cached objects back to malloc(); the pool stays usable */
+void bgp_pool_purge(struct bgp_pool *pool)
+{
+  void *obj, *next;
+
+  if (!pool) return;
+
+  pthread_mutex_lock(&pool->mutex);
+  obj = pool->head;
+  pool->head = NULL;
+  pool->num = 0;
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (; obj; obj = next) {
+    next = *(void **) obj;
+    free(obj);
+  }
+}
+
 /* Allocate bgp_info_extra */
 struct bgp_info_extra *bgp_info_extra_new(struct bgp_info *ri)
 {
   struct bgp_misc_structs *bms;
+  struct bgp_peer_pools *pools;
   struct bgp_info_extra *new;
 
   if (!ri || !ri->peer) return NULL;
@@ -187,12 +253,12 @@ struct bgp_info_extra *bgp_info_extra_new(struct bgp_info *ri)
 
   if (!bms) return NULL;
 
-  new = malloc(sizeof(struct bgp_info_extra));
+  pools = BGP_RIB_LOAD(ri->peer->pools);
+  new = bgp_pool_get(pools ? &pools->extra : NULL, sizeof(struct bgp_info_extra));
   if (!new) {
     Log(LOG_ERR, "ERROR ( %s/%s ): malloc() failed (bgp_info_extra_new). Exiting ..\n", config.name, bms->log_str);
     exit_all(1);
   }
-  else memset(new, 0, sizeof (struct bgp_info_extra));
 
   return new;
 }
@@ -206,9 +272,11 @@ void bgp_info_extra_free(struct bgp_peer *peer, struct bgp_info_extra **extra)
   if (!bms) return;
 
   if (extra && *extra) {
+    struct bgp_peer_pools *pools = BGP_RIB_LOAD(peer->pools);
+
     if ((*extra)->bmed.id && bms->bgp_extra_data_free) (*bms->bgp_extra_data_free)(&(*extra)->bmed);
 
-    free(*extra);
+    bgp_pool_put(pools ? &pools->extra : NULL, *extra);
     *extra = NULL;
   }
 }
@@ -250,6 +318,7 @@ struct bgp_info_extra *bgp_info_extra_process(struct bgp_peer *peer, struct bgp_
 struct bgp_info *bgp_info_new(struct bgp_peer *peer)
 {
   struct bgp_misc_structs *bms;
+  struct bgp_peer_pools *pools;
   struct bgp_info *new;
 
   if (!peer) return NULL;
@@ -258,13 +327,13 @@ struct bgp_info *bgp_info_new(struct bgp_peer *peer)
 
   if (!bms) return NULL;
 
-  new = malloc(sizeof(struct bgp_info));
+  pools = BGP_RIB_LOAD(peer->pools);
+  new = bgp_pool_get(pools ? &pools->info : NULL, sizeof(struct bgp_info));
   if (!new) {
     Log(LOG_ERR, "ERROR ( %s/%s ): malloc() failed (bgp_info_new). Exiting ..\n", config.name, bms->log_str);
     exit_all(1);
   }
-  else memset(new, 0, sizeof (struct bgp_info));
-  
+
   return new;
 }
 
@@ -278,7 +347,7 @@ void bgp_info_add(struct bgp_peer *peer, struct bgp_node *rn, struct bgp_info *r
   ri->prev = NULL;
   if (top)
     top->prev = ri;
-  rn->info[modulo] = ri;
+  BGP_RIB_STORE(rn->info[modulo], ri);
 
   bgp_lock_node(peer, rn);
   ri->peer->lock++;
@@ -289,11 +358,12 @@ void bgp_info_delete(struct bgp_peer *peer, struct bgp_node *rn, struct bgp_info
   if (ri->next)
     ri->next->prev = ri->prev;
   if (ri->prev)
-    ri->prev->next = ri->next;
+    BGP_RIB_STORE(ri->prev->next, ri->next);
   else
-    rn->info[modulo] = ri->next;
+    BGP_RIB_STORE(rn->info[modulo], ri->next);
 
-  bgp_info_free(peer, ri);
+  /* RIB readers may still hold a reference to it */
+  bgp_rib_retire(peer, BGP_RIB_RETIRED_INFO, ri);
 
   bgp_unlock_node(peer, rn);
 }
@@ -301,13 +371,16 @@ void bgp_info_delete(struct bgp_peer *peer, struct bgp_node *rn, struct bgp_info
 /* Free bgp route information. */
 void bgp_info_free(struct bgp_peer *peer, struct bgp_info *ri)
 {
+  struct bgp_peer_pools *pools;
+
   if (ri->attr)
     bgp_attr_unintern(peer, ri->attr);
 
-  bgp_info_extra_free(peer, &ri->extra);
+  bgp_info_extra_free(ri->peer, &ri->extra);
 
   ri->peer->lock--;
-  free(ri);
+  pools = BGP_RIB_LOAD(ri->peer->pools);
+  bgp_pool_put(pools ? &pools->info : NULL, ri);
 }
 
 /* Initialization of attributes */
@@ -318,6 +391,18 @@ void bgp_attr_init(int buckets, struct bgp_rt_structs *inter_domain_routing_db)
   community_init(buckets, &inter_domain_routing_db->comhash);
   ecommunity_init(buckets, &inter_domain_routing_db->ecomhash);
   lcommunity_init(buckets, &inter_domain_routing_db->lcomhash);
+
+  {
+    pthread_mutexattr_t attr_mutex_attr;
+
+    /* recursive: bgp_attr_intern() interns aspath and communities too */
+    pthread_mutexattr_init(&attr_mutex_attr);
+    pthread_mutexattr_settype(&attr_mutex_attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&inter_domain_routing_db->attr_mutex, &attr_mutex_attr);
+    pthread_mutexattr_destroy(&attr_mutex_attr);
+  }
+
+  bgp_pool_init(&inter_domain_routing_db->attr_pool, sizeof(struct bgp_attr), BGP_POOL_MAX);
 }
 
 unsigned int attrhash_key_make(void *p)
@@ -386,6 +471,8 @@ struct bgp_attr *bgp_attr_intern(struct bgp_peer *peer, struct bgp_attr *attr)
   inter_domain_routing_db = bgp_select_routing_db(peer->type);
 
   if (!inter_domain_routing_db) return NULL;
+
+  pthread_mutex_lock(&inter_domain_routing_db->attr_mutex);
  
   /* Intern referenced strucutre. */
   if (attr->aspath) {
@@ -413,9 +500,28 @@ struct bgp_attr *bgp_attr_intern(struct bgp_peer *peer, struct bgp_attr *attr)
     attr->lcommunity->refcnt++;
   }
  
-  find = (struct bgp_attr *) hash_get(peer, inter_domain_routing_db->attrhash, attr, bgp_attr_hash_alloc);
+  /* already interned, ie. once per UPDATE: no hashing needed */
+  if (attr->refcnt) find = attr;
+  else find = (struct bgp_attr *) hash_get(peer, inter_domain_routing_db->attrhash, attr, NULL);
+
+  if (!find) {
+    find = bgp_pool_get(&inter_domain_routing_db->attr_pool, sizeof(struct bgp_attr));
+    if (!find) {
+      Log(LOG_ERR, "ERROR ( %s/core/BGP ): malloc() failed (bgp_attr_intern). Exiting ..\n", config.name); // XXX
+      exit_all(1);
+    }
+
+    memcpy(find, attr, sizeof(struct bgp_attr));
+    find->refcnt = 0;
+    hash_get(peer, inter_domain_routing_db->attrhash, find, hash_alloc_intern);
+  }
+
   find->refcnt++;
 
+  if (find->refcnt == 1) bgp_attr_mem_add(inter_domain_routing_db, BGP_ATTR_MEM_ATTR, sizeof(struct bgp_attr));
+
+  pthread_mutex_unlock(&inter_domain_routing_db->attr_mutex);
+
   return find;
 }
 
@@ -436,6 +542,8 @@ void bgp_attr_unintern(struct bgp_peer *peer, struct bgp_attr *attr)
   bms = bgp_select_misc_db(peer->type);
 
   if (!inter_domain_routing_db || !bms) return;
+
+  pthread_mutex_lock(&inter_domain_routing_db->attr_mutex);
  
   /* Decrement attribute reference. */
   attr->refcnt--;
@@ -449,7 +557,8 @@ void bgp_attr_unintern(struct bgp_peer *peer, struct bgp_attr *attr)
     ret = (struct bgp_attr *) hash_release(inter_domain_routing_db->attrhash, attr);
     // assert (ret != NULL);
     if (!ret) Log(LOG_INFO, "INFO ( %s/%s ): bgp_attr_unintern() hash lookup failed.\n", config.name, bms->log_str);
-    free(attr);
+    bgp_attr_mem_del(inter_domain_routing_db, BGP_ATTR_MEM_ATTR, sizeof(struct bgp_attr));
+    bgp_pool_put(&inter_domain_routing_db->attr_pool, attr);
   }
 
   /* aspath refcount shoud be decrement. */
@@ -461,25 +570,157 @@ void bgp_attr_unintern(struct bgp_peer *peer, struct bgp_attr *attr)
     ecommunity_unintern(peer, ecommunity);
   if (lcommunity)
     lcommunity_unintern(peer, lcommunity);
+
+  pthread_mutex_unlock(&inter_domain_routing_db->attr_mutex);
 }
 
-void *bgp_attr_hash_alloc(void *p)
+/*
+  UPDATEs from a peer often carry the very same path attributes as the
+  previous one, ie. when a table is being sent: the interned bgp_attr is
+  then reused with no parsing. Blobs including MP_REACH_NLRI or
+  MP_UNREACH_NLRI are not cached, NLRIs being part of them.
+*/
+struct bgp_attr *bgp_attr_cache_lookup(struct bgp_peer *peer, char *blob, u_int16_t len)
 {
-  struct bgp_attr *val = (struct bgp_attr *) p;
-  struct bgp_attr *attr;
+  struct bgp_attr_cache *bac = &peer->attr_cache;
 
-  attr = malloc(sizeof (struct bgp_attr));
-  if (!attr) {
-    Log(LOG_ERR, "ERROR ( %s/core/BGP ): malloc() failed (bgp_attr_hash_alloc). Exiting ..\n", config.name); // XXX
-    exit_all(1);
+  if (bac->attr && bac->len == len && bac->cap_4as == (peer->cap_4as ? 1 : 0) && !memcmp(bac->blob, blob, len))
+    return bac->attr;
+
+  return NULL;
+}
+
+void bgp_attr_cache_update(struct bgp_peer *peer, char *blob, u_int16_t len, struct bgp_attr *attr)
+{
+  struct bgp_attr_cache *bac = &peer->attr_cache;
+  char *new_blob;
+
+  if (bac->size < len) {
+    new_blob = realloc(bac->blob, len);
+    if (!new_blob) {
+      bgp_attr_cache_flush(peer);
+      return;
+    }
+
+    bac->blob = new_blob;
+    bac->size = len;
   }
-  else {
-    memset(attr, 0, sizeof (struct bgp_attr));
-    memcpy(attr, val, sizeof (struct bgp_attr));
-    attr->refcnt = 0;
+
+  /* the cache holds a reference of its own */
+  attr = bgp_attr_intern(peer, attr);
+  if (bac->attr) bgp_attr_unintern(peer, bac->attr);
+
+  bac->attr = attr;
+  memcpy(bac->blob, blob, len);
+  bac->len = len;
+  bac->cap_4as = (peer->cap_4as ? 1 : 0);
+}
+
+void bgp_attr_cache_flush(struct bgp_peer *peer)
+{
+  struct bgp_attr_cache *bac = &peer->attr_cache;
+
+  if (bac->attr) bgp_attr_unintern(peer, bac->attr);
+  free(bac->blob);
+  memset(bac, 0, sizeof(struct bgp_attr_cache));
+}
+
+/*
+  Interned attributes are shared by all peers of a routing db; counters
+  are only ever updated by the thread owning the db, stats are a best
+  effort read from the SIGUSR1 handler.
+*/
+void bgp_attr_mem_add(struct bgp_rt_structs *inter_domain_routing_db, int type, u_int64_t bytes)
+{
+  if (!inter_domain_routing_db || type < 0 || type >= BGP_ATTR_MEM_MAX) return;
+
+  inter_domain_routing_db->attr_mem[type].num++;
+  inter_domain_routing_db->attr_mem[type].bytes += bytes;
+}
+
+void bgp_attr_mem_del(struct bgp_rt_structs *inter_domain_routing_db, int type, u_int64_t bytes)
+{
+  struct bgp_attr_mem *am;
+
+  if (!inter_domain_routing_db || type < 0 || type >= BGP_ATTR_MEM_MAX) return;
+
+  am = &inter_domain_routing_db->attr_mem[type];
+  if (am->num) am->num--;
+  if (am->bytes >= bytes) am->bytes -= bytes;
+  else am->bytes = 0;
+}
+
+void bgp_attr_mem_print_stats(time_t now)
+{
+  static const char *attr_mem_names[] = { "attr", "aspath", "comm", "ecomm", "lcomm" };
+  struct bgp_rt_structs *inter_domain_routing_db;
+  struct bgp_misc_structs *bms;
+  int peer_type, type;
+
+  for (peer_type = FUNC_TYPE_BGP; peer_type <= FUNC_TYPE_BMP; peer_type++) {
+    inter_domain_routing_db = bgp_select_routing_db(peer_type);
+    bms = bgp_select_misc_db(peer_type);
+    if (!inter_domain_routing_db || !bms || !inter_domain_routing_db->attrhash) continue;
+
+    for (type = 0; type < BGP_ATTR_MEM_MAX; type++) {
+      Log(LOG_NOTICE, "NOTICE ( %s/%s ): stats [interned attributes] time=%u type=%s entries=%llu bytes=%llu\n",
+	  config.name, bms->log_str, now, attr_mem_names[type],
+	  (unsigned long long) inter_domain_routing_db->attr_mem[type].num,
+	  (unsigned long long) inter_domain_routing_db->attr_mem[type].bytes);
+    }
   }
+}
 
-  return attr;
+void bgp_misc_locks_init(struct bgp_misc_structs *bms)
+{
+  if (!bms) return;
+
+  pthread_mutex_init(&bms->rib_retired_mutex, NULL);
+  pthread_mutex_init(&bms->peers_mutex, NULL);
+  pthread_mutex_init(&bms->msglog_mutex, NULL);
+}
+
+/*
+  Stops RIB writers at a consistent point, ie. before fork()ing a table
+  dump: the child gets a copy of the RIB with no modification half-way.
+  Locks are taken in the documented order.
+*/
+void bgp_rib_writers_pause(struct bgp_rt_structs *inter_domain_routing_db, struct bgp_misc_structs *bms)
+{
+  afi_t afi;
+  safi_t safi;
+
+  if (!inter_domain_routing_db || !bms) return;
+
+  pthread_mutex_lock(&bms->peers_mutex);
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+    for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++) {
+      if (inter_domain_routing_db->rib[afi][safi])
+	BGP_TABLE_LOCK(inter_domain_routing_db->rib[afi][safi]);
+    }
+  }
+
+  pthread_mutex_lock(&inter_domain_routing_db->attr_mutex);
+}
+
+void bgp_rib_writers_resume(struct bgp_rt_structs *inter_domain_routing_db, struct bgp_misc_structs *bms)
+{
+  afi_t afi;
+  safi_t safi;
+
+  if (!inter_domain_routing_db || !bms) return;
+
+  pthread_mutex_unlock(&inter_domain_routing_db->attr_mutex);
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+    for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++) {
+      if (inter_domain_routing_db->rib[afi][safi])
+	BGP_TABLE_UNLOCK(inter_domain_routing_db->rib[afi][safi]);
+    }
+  }
+
+  pthread_mutex_unlock(&bms->peers_mutex);
 }
 
 void bgp_peer_cache_init(struct bgp_peer_cache_bucket *cache, u_int32_t buckets)
@@ -568,15 +809,36 @@ struct bgp_peer *bgp_peer_cache_search(struct bgp_peer_cache_bucket *cache, u_in
 int bgp_peer_init(struct bgp_peer *peer, int type)
 {
   struct bgp_misc_structs *bms;
+  struct bgp_peer_pools *pools;
+  u_int64_t lookup_gen;
   int ret = TRUE;
 
   bms = bgp_select_misc_db(type);
 
   if (!peer || !bms) return ERR;
 
+  /* lookups cached against a previous user of the peer slot are voided */
+  lookup_gen = peer->lookup_gen;
+
+  /* routes of a previous user of the slot may still be returning objects */
+  pools = peer->pools;
+  if (!pools) {
+    pools = malloc(sizeof(struct bgp_peer_pools));
+    if (!pools) {
+      Log(LOG_ERR, "ERROR ( %s/%s ): malloc() failed (bgp_peer_init). Exiting ..\n", config.name, bms->log_str);
+      exit_all(1);
+    }
+
+    bgp_pool_init(&pools->info, sizeof(struct bgp_info), BGP_POOL_MAX);
+    bgp_pool_init(&pools->extra, sizeof(struct bgp_info_extra), BGP_POOL_MAX);
+  }
+
   memset(peer, 0, sizeof(struct bgp_peer));
+  peer->lookup_gen = ((lookup_gen | 1) + 1);
+  BGP_RIB_STORE(peer->pools, pools);
   peer->type = type;
   peer->status = Idle;
+  peer->journal.full = TRUE; /* never dumped so far */
   peer->buf.len = BGP_BUFFER_SIZE;
   peer->buf.base = malloc(peer->buf.len);
   if (!peer->buf.base) {
@@ -641,6 +903,14 @@ void bgp_peer_close(struct bgp_peer *peer, int type, int no_quiet, int send_noti
 
   free(peer->buf.base);
 
+  free(peer->journal.delta);
+  memset(&peer->journal, 0, sizeof(peer->journal));
+
+  if (peer->pools) {
+    bgp_pool_purge(&peer->pools->info);
+    bgp_pool_purge(&peer->pools->extra);
+  }
+
   if (bms->neighbors_file)
     write_neighbors_file(bms->neighbors_file, peer->type);
 }
@@ -739,45 +1009,65 @@ void bgp_peer_xconnect_print(struct bgp_peer *peer, char *buf, int len)
 void bgp_peer_info_delete(struct bgp_peer *peer)
 {
   struct bgp_rt_structs *inter_domain_routing_db = bgp_select_routing_db(peer->type);
-  struct bgp_misc_structs *bms = bgp_select_misc_db(peer->type);
-  struct bgp_table *table;
-  struct bgp_node *node;
   afi_t afi;
   safi_t safi;
 
   if (!inter_domain_routing_db) return;
 
+  bgp_lookup_cache_change_begin(peer);
+
   for (afi = AFI_IP; afi < AFI_MAX; afi++) {
     for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++) {
-      table = inter_domain_routing_db->rib[afi][safi];
-      node = bgp_table_top(peer, table);
-
-      while (node) {
-        u_int32_t modulo = bms->route_info_modulo(peer, NULL, bms->table_per_peer_buckets);
-        u_int32_t peer_buckets;
-        struct bgp_info *ri;
-        struct bgp_info *ri_next;
-
-        for (peer_buckets = 0; peer_buckets < bms->table_per_peer_buckets; peer_buckets++) {
-          for (ri = node->info[modulo+peer_buckets]; ri; ri = ri_next) {
-            if (ri->peer == peer) {
-	      if (bms->msglog_backend_methods) {
-		char event_type[] = "log";
-
-		bgp_peer_log_msg(node, ri, afi, safi, event_type, bms->msglog_output, NULL, BGP_LOG_TYPE_DELETE);
-	      }
-
-	      ri_next = ri->next; /* let's save pointer to next before free up */
-              bgp_info_delete(peer, node, ri, modulo+peer_buckets);
-            }
-	    else ri_next = ri->next;
-          }
-        }
+      bgp_peer_info_delete_table(peer, afi, safi);
+    }
+  }
 
-        node = bgp_route_next(peer, node);
+  bgp_lookup_cache_change_end(peer);
+
+  bgp_attr_cache_flush(peer);
+}
+
+/* callers have to wrap this into bgp_lookup_cache_change_begin()/end() */
+void bgp_peer_info_delete_table(struct bgp_peer *peer, afi_t afi, safi_t safi)
+{
+  struct bgp_rt_structs *inter_domain_routing_db = bgp_select_routing_db(peer->type);
+  struct bgp_misc_structs *bms = bgp_select_misc_db(peer->type);
+  struct bgp_table *table;
+  struct bgp_node *node;
+
+  if (!inter_domain_routing_db) return;
+
+  table = inter_domain_routing_db->rib[afi][safi];
+
+  BGP_TABLE_LOCK(table);
+  node = bgp_table_top(peer, table);
+
+  while (node) {
+    u_int32_t modulo = bms->route_info_modulo(peer, NULL, bms->table_per_peer_buckets);
+    u_int32_t peer_buckets;
+    struct bgp_info *ri;
+    struct bgp_info *ri_next;
+
+    for (peer_buckets = 0; peer_buckets < bms->table_per_peer_buckets; peer_buckets++) {
+      for (ri = node->info[modulo+peer_buckets]; ri; ri = ri_next) {
+        if (ri->peer == peer) {
+	  if (bms->msglog_backend_methods) {
+	    char event_type[] = "log";
+
+	    bgp_peer_log_msg(node, ri, afi, safi, event_type, bms->msglog_output, NULL, BGP_LOG_TYPE_DELETE);
+	  }
+
+	  ri_next = ri->next; /* let's save pointer to next before free up */
+          bgp_info_delete(peer, node, ri, modulo+peer_buckets);
+        }
+	else ri_next = ri->next;
       }
     }
+
+    node = bgp_route_next(peer, node);
   }
+
+  BGP_TABLE_UNLOCK(table);
 }
 
 int bgp_attr_munge_as4path(struct bgp_peer *peer, struct bgp_attr *attr, struct aspath *as4path)
@@ -842,72 +1132,318 @@ void load_comm_patterns(char **stdcomm, char **extcomm, char **lrgcomm, char **s
       idx++;
     }
   }
+
+  bgp_comm_matchers_compile(&std_comm_matchers, std_comm_patterns, 2, 5);
+  bgp_comm_matchers_compile(&lrg_comm_matchers, lrg_comm_patterns, 3, 10);
+  bgp_comm_matchers_compile(&std_comm_matchers_to_asn, std_comm_patterns_to_asn, 2, 5);
 } 
 
-void evaluate_comm_patterns(char *dst, char *src, char **patterns, int dstlen)
+/* substring matches one pattern against 'src', appending to 'dst'; TRUE when full */
+static int evaluate_comm_pattern(char *dst, int *j, int dstlen, char *src, char *pattern)
 {
   char *ptr, *haystack, *delim_src, *delim_ptn;
   char local_ptr[MAX_BGP_STD_COMMS], *auxptr;
-  int idx, i, j, srclen;
+  int i;
+
+  haystack = src;
+
+  find_again:
+  delim_ptn = strchr(pattern, '.');
+  if (delim_ptn) *delim_ptn = '\0';
+  ptr = strstr(haystack, pattern);
+
+  if (ptr && delim_ptn) {
+    delim_src = strchr(ptr, ' ');
+    if (delim_src) {
+      memcpy(local_ptr, ptr, delim_src-ptr);
+      local_ptr[delim_src-ptr] = '\0';
+    }
+    else memcpy(local_ptr, ptr, strlen(ptr)+1);
+    *delim_ptn = '.';
+
+    if (strlen(local_ptr) != strlen(pattern)) ptr = NULL;
+    else {
+      for (auxptr = strchr(pattern, '.'); auxptr; auxptr = strchr(auxptr, '.')) {
+	local_ptr[auxptr-pattern] = '.';
+	auxptr++;
+      }
+      if (strncmp(pattern, local_ptr, strlen(pattern))) ptr = NULL;
+    }
+  }
+  else if (delim_ptn) *delim_ptn = '.';
+
+  if (ptr) {
+    /* If we have already something on the stack, let's insert a space */
+    if ((*j) && (*j) < dstlen) {
+      dst[(*j)] = ' ';
+      (*j)++;
+    }
+
+    /* We should be able to trust this string */
+    for (i = 0; ptr[i] != ' ' && ptr[i] != '\0'; i++, (*j)++) {
+      if ((*j) < dstlen) dst[(*j)] = ptr[i];
+      else break;
+    }
+
+    haystack = &ptr[i];
+  }
+
+  /* If we don't have space anymore, let's finish it here */
+  if ((*j) >= dstlen) {
+    dst[dstlen-2] = '+';
+    dst[dstlen-1] = '\0';
+    return TRUE;
+  }
+
+  /* Trick to find multiple occurrences */
+  if (ptr) goto find_again;
+
+  return FALSE;
+}
+
+void evaluate_comm_patterns(char *dst, char *src, char **patterns, int dstlen)
+{
+  int idx, j;
 
   if (!src || !dst || !dstlen) return;
 
-  srclen = strlen(src);
   memset(dst, 0, dstlen);
 
   for (idx = 0, j = 0; patterns[idx]; idx++) {
-    haystack = src;
-
-    find_again:
-    delim_ptn = strchr(patterns[idx], '.');
-    if (delim_ptn) *delim_ptn = '\0';
-    ptr = strstr(haystack, patterns[idx]);
-
-    if (ptr && delim_ptn) {
-      delim_src = strchr(ptr, ' ');
-      if (delim_src) {
-	memcpy(local_ptr, ptr, delim_src-ptr);
-        local_ptr[delim_src-ptr] = '\0';
-      }
-      else memcpy(local_ptr, ptr, strlen(ptr)+1);
-      *delim_ptn = '.';
+    if (evaluate_comm_pattern(dst, &j, dstlen, src, patterns[idx])) break;
+  }
+}
 
-      if (strlen(local_ptr) != strlen(patterns[idx])) ptr = NULL;
-      else {
-	for (auxptr = strchr(patterns[idx], '.'); auxptr; auxptr = strchr(auxptr, '.')) {
-	  local_ptr[auxptr-patterns[idx]] = '.';
-	  auxptr++;
-	} 
-	if (strncmp(patterns[idx], local_ptr, strlen(patterns[idx]))) ptr = NULL;
+/*
+  With bgp_comm_pattern_anchored, patterns are compiled into matchers working
+  on numeric values, one per colon-separated field, anchored at the first
+  field of a community: a field matches if its decimal representation does,
+  '.' wildcarding a single digit. Patterns with no wildcards match values of
+  their last field starting with them, ie. 12345:64 matches 12345:64 and
+  12345:640 through 12345:64999; patterns with wildcards have to match the
+  whole value. A pattern that can't be compiled, ie. it refers to a
+  well-known community by name, keeps being substring matched on its own.
+*/
+static int bgp_comm_matcher_compile(struct bgp_comm_matcher *bcm, char *pattern, int max_fields, int max_digits)
+{
+  struct bgp_comm_match_field *field;
+  int wildcards = (strchr(pattern, '.') ? TRUE : FALSE);
+  char *ptr;
+
+  memset(bcm, 0, sizeof(struct bgp_comm_matcher));
+
+  if (!pattern[0]) return ERR;
+
+  field = &bcm->field[0];
+  bcm->fields = 1;
+
+  for (ptr = pattern; *ptr; ptr++) {
+    if (*ptr == ':') {
+      if (!field->len || bcm->fields == max_fields) return ERR;
+      field = &bcm->field[bcm->fields];
+      bcm->fields++;
+    }
+    else if (*ptr == '.' || isdigit((unsigned char) *ptr)) {
+      if (field->len == max_digits) return ERR;
+
+      if (*ptr == '.') {
+	field->digit[field->len] = BGP_COMM_MATCH_ANY;
+	field->wildcards = TRUE;
       }
-    } 
-    else if (delim_ptn) *delim_ptn = '.';
-
-    if (ptr) {
-      /* If we have already something on the stack, let's insert a space */
-      if (j && j < dstlen) {
-	dst[j] = ' ';
-	j++;
+      else {
+	field->digit[field->len] = (*ptr - '0');
+	field->value = ((field->value * 10) + field->digit[field->len]);
+
+	/* no decimal representation starts with a zero, but zero itself */
+	if (field->len == 1 && !field->digit[0]) field->wildcards = TRUE;
       }
 
-      /* We should be able to trust this string */
-      for (i = 0; ptr[i] != ' ' && ptr[i] != '\0'; i++, j++) {
-	if (j < dstlen) dst[j] = ptr[i];
-	else break;
-      } 
+      field->len++;
+    }
+    else return ERR;
+  }
+
+  /* with wildcards the pattern has a fixed length: all fields are needed */
+  if (wildcards) {
+    if (bcm->fields != max_fields || !field->len) return ERR;
+  }
+  else field->prefix = TRUE;
+
+  return SUCCESS;
+}
+
+void bgp_comm_matchers_compile(struct bgp_comm_matchers *bcms, char **patterns, int max_fields, int max_digits)
+{
+  int idx;
+
+  memset(bcms, 0, sizeof(struct bgp_comm_matchers));
+  bcms->patterns = patterns;
+
+  /* by default patterns are substring matched against the string form */
+  if (!config.bgp_comm_pattern_anchored) return;
+
+  bcms->compiled = TRUE;
+
+  for (idx = 0; idx < MAX_BGP_COMM_PATTERNS && patterns[idx]; idx++) {
+    if (bgp_comm_matcher_compile(&bcms->m[idx], patterns[idx], max_fields, max_digits) == ERR)
+      bcms->m[idx].substr = TRUE;
+  }
+
+  bcms->num = idx;
+}
+
+static int bgp_comm_match_field(struct bgp_comm_match_field *field, u_int32_t value)
+{
+  static const u_int32_t pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+  int digits, idx;
+
+  for (digits = 1; digits < BGP_COMM_MATCH_DIGITS && value >= pow10[digits]; digits++);
+
+  if (field->prefix ? (digits < field->len) : (digits != field->len)) return FALSE;
+  if (!field->len) return TRUE;
+
+  value /= pow10[digits - field->len];
+  if (!field->wildcards) return (value == field->value);
+
+  for (idx = (field->len - 1); idx >= 0; idx--, value /= 10) {
+    if (field->digit[idx] != BGP_COMM_MATCH_ANY && field->digit[idx] != (value % 10)) return FALSE;
+  }
+
+  return TRUE;
+}
+
+static int bgp_comm_match(struct bgp_comm_matcher *bcm, u_int32_t *values)
+{
+  int idx;
+
+  for (idx = 0; idx < bcm->fields; idx++) {
+    if (!bgp_comm_match_field(&bcm->field[idx], values[idx])) return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* renders values the way community_com2str() and lcommunity_lcom2str() do */
+static int bgp_comm_match_print(char *buf, u_int32_t *values, int fields)
+{
+  char digits[BGP_COMM_MATCH_DIGITS];
+  int idx, len, pos = 0;
+  u_int32_t value;
+
+  for (idx = 0; idx < fields; idx++) {
+    if (idx) buf[pos++] = ':';
+
+    value = values[idx];
+    len = 0;
+    do {
+      digits[len++] = ('0' + (value % 10));
+      value /= 10;
+    } while (value);
+
+    while (len) buf[pos++] = digits[--len];
+  }
+
+  return pos;
+}
+
+/* appends a token the same way evaluate_comm_patterns() does; TRUE when full */
+static int bgp_comm_match_append(char *dst, int *j, int dstlen, char *token, int len)
+{
+  int i;
+
+  /* If we have already something on the stack, let's insert a space */
+  if ((*j) && (*j) < dstlen) {
+    dst[(*j)] = ' ';
+    (*j)++;
+  }
+
+  for (i = 0; i < len; i++, (*j)++) {
+    if ((*j) < dstlen) dst[(*j)] = token[i];
+    else break;
+  }
 
-      haystack = &ptr[i];
+  /* If we don't have space anymore, let's finish it here */
+  if ((*j) >= dstlen) {
+    dst[dstlen-2] = '+';
+    dst[dstlen-1] = '\0';
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+void evaluate_std_comm_patterns(char *dst, struct community *com, struct bgp_comm_matchers *bcms, int dstlen)
+{
+  char token[BGP_COMM_MATCH_FIELDS * (BGP_COMM_MATCH_DIGITS + 1)];
+  u_int32_t comval, values[2];
+  int idx, i, j;
+
+  if (!com || !dst || !dstlen) return;
+
+  if (!bcms->compiled) {
+    evaluate_comm_patterns(dst, com->str, bcms->patterns, dstlen);
+    return;
+  }
+
+  memset(dst, 0, dstlen);
+
+  for (idx = 0, j = 0; idx < bcms->num; idx++) {
+    if (bcms->m[idx].substr) {
+      if (evaluate_comm_pattern(dst, &j, dstlen, com->str, bcms->patterns[idx])) return;
+      continue;
     }
 
-    /* If we don't have space anymore, let's finish it here */
-    if (j >= dstlen) {
-      dst[dstlen-2] = '+';
-      dst[dstlen-1] = '\0';
-      break;
+    for (i = 0; i < com->size; i++) {
+      memcpy(&comval, com_nthval(com, i), sizeof(u_int32_t));
+      comval = ntohl(comval);
+
+      /* rendered by name, hence never matched by numeric patterns */
+      if (comval == COMMUNITY_INTERNET || comval == COMMUNITY_NO_EXPORT ||
+	  comval == COMMUNITY_NO_ADVERTISE || comval == COMMUNITY_LOCAL_AS) continue;
+
+      values[0] = ((comval >> 16) & 0xFFFF);
+      values[1] = (comval & 0xFFFF);
+
+      if (bgp_comm_match(&bcms->m[idx], values)) {
+	if (bgp_comm_match_append(dst, &j, dstlen, token, bgp_comm_match_print(token, values, 2))) return;
+      }
     }
+  }
+}
+
+void evaluate_lrg_comm_patterns(char *dst, struct lcommunity *lcom, struct bgp_comm_matchers *bcms, int dstlen)
+{
+  char token[BGP_COMM_MATCH_FIELDS * (BGP_COMM_MATCH_DIGITS + 1)];
+  u_int32_t values[3];
+  u_int8_t *pnt;
+  int idx, i, j;
 
-    /* Trick to find multiple occurrences */ 
-    if (ptr) goto find_again;
+  if (!lcom || !dst || !dstlen) return;
+
+  if (!bcms->compiled) {
+    evaluate_comm_patterns(dst, lcom->str, bcms->patterns, dstlen);
+    return;
+  }
+
+  memset(dst, 0, dstlen);
+
+  for (idx = 0, j = 0; idx < bcms->num; idx++) {
+    if (bcms->m[idx].substr) {
+      if (evaluate_comm_pattern(dst, &j, dstlen, lcom->str, bcms->patterns[idx])) return;
+      continue;
+    }
+
+    for (i = 0; i < lcom->size; i++) {
+      pnt = (lcom->val + (i * LCOMMUNITY_SIZE));
+      memcpy(values, pnt, LCOMMUNITY_SIZE);
+      values[0] = ntohl(values[0]);
+      values[1] = ntohl(values[1]);
+      values[2] = ntohl(values[2]);
+
+      if (bgp_comm_match(&bcms->m[idx], values)) {
+	if (bgp_comm_match_append(dst, &j, dstlen, token, bgp_comm_match_print(token, values, 3))) return;
+      }
+    }
   }
 }
 
@@ -987,6 +1523,116 @@ void evaluate_bgp_aspath_radius(char *path, int len, int radius)
   }
 }
 
+/*
+   Renderings of interned attributes after bgp_aspath_radius trimming and
+   community pattern filtering. Both are fixed once the config is loaded,
+   hence the string is computed on first use, cached on the attribute and
+   freed along with it; concurrent readers racing to render it keep the
+   first one published.
+*/
+static char *bgp_attr_str_publish(char **cache, char *str)
+{
+  char *found = NULL;
+
+  if (!__atomic_compare_exchange_n(cache, &found, str, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    free(str);
+    return found;
+  }
+
+  return str;
+}
+
+char *bgp_attr_str_aspath(struct aspath *as)
+{
+  char *str;
+  int len;
+
+  if (!as || !as->str) return NULL;
+  if (!config.nfacctd_bgp_aspath_radius) return as->str;
+  if ((str = BGP_RIB_LOAD(as->str_radius))) return str;
+
+  len = (strlen(as->str) + 1);
+  str = strndup(as->str, len);
+  if (!str) return NULL;
+
+  evaluate_bgp_aspath_radius(str, len, config.nfacctd_bgp_aspath_radius);
+
+  return bgp_attr_str_publish(&as->str_radius, str);
+}
+
+char *bgp_attr_str_std_comms(struct community *com)
+{
+  char *str;
+  int len;
+
+  if (!com || !com->str) return NULL;
+  if (!config.nfacctd_bgp_stdcomm_pattern) return com->str;
+  if ((str = BGP_RIB_LOAD(com->str_filtered))) return str;
+
+  len = (strlen(com->str) + 1);
+  str = malloc(len);
+  if (!str) return NULL;
+
+  evaluate_std_comm_patterns(str, com, &std_comm_matchers, len);
+
+  return bgp_attr_str_publish(&com->str_filtered, str);
+}
+
+char *bgp_attr_str_ext_comms(struct ecommunity *ecom)
+{
+  char *str;
+  int len;
+
+  if (!ecom || !ecom->str) return NULL;
+  if (!config.nfacctd_bgp_extcomm_pattern) return ecom->str;
+  if ((str = BGP_RIB_LOAD(ecom->str_filtered))) return str;
+
+  len = (strlen(ecom->str) + 1);
+  str = malloc(len);
+  if (!str) return NULL;
+
+  evaluate_comm_patterns(str, ecom->str, ext_comm_patterns, len);
+
+  return bgp_attr_str_publish(&ecom->str_filtered, str);
+}
+
+char *bgp_attr_str_lrg_comms(struct lcommunity *lcom)
+{
+  char *str;
+  int len;
+
+  if (!lcom || !lcom->str) return NULL;
+  if (!config.nfacctd_bgp_lrgcomm_pattern) return lcom->str;
+  if ((str = BGP_RIB_LOAD(lcom->str_filtered))) return str;
+
+  len = (strlen(lcom->str) + 1);
+  str = malloc(len);
+  if (!str) return NULL;
+
+  evaluate_lrg_comm_patterns(str, lcom, &lrg_comm_matchers, len);
+
+  return bgp_attr_str_publish(&lcom->str_filtered, str);
+}
+
+/*
+   A cached rendering can stand in for a fixed length one only if it was
+   not truncated (truncated renderings are as long as the source and end
+   in '+') and fits 'dstlen' without being truncated there either; when
+   it can't, the fixed length handlers re-evaluate the patterns into
+   their own buffer.
+*/
+int bgp_attr_str_reusable(char *cached, char *str, int dstlen)
+{
+  int len;
+
+  if (!cached || !str) return FALSE;
+
+  len = strlen(cached);
+  if (len >= strlen(str) || (len && cached[len-1] == '+')) return FALSE;
+
+  return (len < (dstlen-2));
+}
+
 void copy_stdcomm_to_asn(char *stdcomm, as_t *asn, int is_origin)
 {
   char *delim, *delim2;
@@ -1340,7 +1986,7 @@ void bgp_link_misc_structs(struct bgp_misc_structs *bms)
   bms->bgp_lookup_find_peer = bgp_lookup_find_bgp_peer;
   bms->bgp_lookup_node_match_cmp = bgp_lookup_node_match_cmp_bgp;
 
-  if (!bms->is_thread && !bms->dump_backend_methods && !bms->has_lglass)
+  if (!bms->is_thread && !bms->dump_backend_methods && !bms->has_lglass && !config.bgp_table_snapshot_file)
     bms->skip_rib = TRUE;
 }
 
@@ -1386,7 +2032,7 @@ int bgp_peers_bintree_walk_print(const void *nodep, const pm_VISIT which, const
 int bgp_peers_bintree_walk_delete(const void *nodep, const pm_VISIT which, const int depth, void *extra)
 {
   struct bgp_misc_structs *bms;
-  char peer_str[] = "peer_ip", *saved_peer_str;
+  char peer_str[] = "peer_ip";
   struct bgp_peer *peer;
 
   peer = (*(struct bgp_peer **) nodep);
@@ -1397,10 +2043,9 @@ int bgp_peers_bintree_walk_delete(const void *nodep, const pm_VISIT which, const
 
   if (!bms) return FALSE;
 
-  saved_peer_str = bms->peer_str;
-  bms->peer_str = peer_str;
+  bgp_peer_log_str_set(peer_str);
   bgp_peer_info_delete(peer);
-  bms->peer_str = saved_peer_str;
+  bgp_peer_log_str_set(NULL);
 
   // XXX: count tree elements to index and free() later
 
@@ -35,9 +35,17 @@ EXT int bgp_label2str(char *, u_char *);
 EXT void load_comm_patterns(char **, char **, char **, char **);
 EXT void load_peer_src_as_comm_ranges(char *, char *);
 EXT void evaluate_comm_patterns(char *, char *, char **, int);
+EXT void bgp_comm_matchers_compile(struct bgp_comm_matchers *, char **, int, int);
+EXT void evaluate_std_comm_patterns(char *, struct community *, struct bgp_comm_matchers *, int);
+EXT void evaluate_lrg_comm_patterns(char *, struct lcommunity *, struct bgp_comm_matchers *, int);
 EXT as_t evaluate_last_asn(struct aspath *);
 EXT as_t evaluate_first_asn(char *);
 EXT void evaluate_bgp_aspath_radius(char *, int, int);
+EXT char *bgp_attr_str_aspath(struct aspath *);
+EXT char *bgp_attr_str_std_comms(struct community *);
+EXT char *bgp_attr_str_ext_comms(struct ecommunity *);
+EXT char *bgp_attr_str_lrg_comms(struct lcommunity *);
+EXT int bgp_attr_str_reusable(char *, char *, int);
 EXT void copy_stdcomm_to_asn(char *, as_t *, int);
 EXT void write_neighbors_file(char *, int);
 EXT struct bgp_rt_structs *bgp_select_routing_db(int);
@@ -49,6 +57,10 @@ EXT void bgp_config_checks(struct configuration *);
 EXT struct bgp_misc_structs *bgp_select_misc_db(int);
 EXT void bgp_link_misc_structs(struct bgp_misc_structs *);
 
+EXT void bgp_pool_init(struct bgp_pool *, size_t, u_int32_t);
+EXT void *bgp_pool_get(struct bgp_pool *, size_t);
+EXT void bgp_pool_put(struct bgp_pool *, void *);
+EXT void bgp_pool_purge(struct bgp_pool *);
 EXT struct bgp_info_extra *bgp_info_extra_new(struct bgp_info *);
 EXT void bgp_info_extra_free(struct bgp_peer *, struct bgp_info_extra **);
 EXT struct bgp_info_extra *bgp_info_extra_get(struct bgp_info *);
@@ -61,7 +73,15 @@ EXT void bgp_info_free(struct bgp_peer *, struct bgp_info *);
 EXT void bgp_attr_init(int, struct bgp_rt_structs *);
 EXT struct bgp_attr *bgp_attr_intern(struct bgp_peer *, struct bgp_attr *);
 EXT void bgp_attr_unintern (struct bgp_peer *, struct bgp_attr *);
-EXT void *bgp_attr_hash_alloc (void *);
+EXT struct bgp_attr *bgp_attr_cache_lookup(struct bgp_peer *, char *, u_int16_t);
+EXT void bgp_attr_cache_update(struct bgp_peer *, char *, u_int16_t, struct bgp_attr *);
+EXT void bgp_attr_cache_flush(struct bgp_peer *);
+EXT void bgp_attr_mem_add(struct bgp_rt_structs *, int, u_int64_t);
+EXT void bgp_attr_mem_del(struct bgp_rt_structs *, int, u_int64_t);
+EXT void bgp_attr_mem_print_stats(time_t);
+EXT void bgp_misc_locks_init(struct bgp_misc_structs *);
+EXT void bgp_rib_writers_pause(struct bgp_rt_structs *, struct bgp_misc_structs *);
+EXT void bgp_rib_writers_resume(struct bgp_rt_structs *, struct bgp_misc_structs *);
 EXT int bgp_attr_munge_as4path(struct bgp_peer *, struct bgp_attr *, struct aspath *);
 
 EXT int bgp_peer_init(struct bgp_peer *, int);
@@ -70,6 +90,7 @@ EXT int bgp_peer_xconnect_init(struct bgp_peer *, int);
 EXT void bgp_peer_print(struct bgp_peer *, char *, int);
 EXT void bgp_peer_xconnect_print(struct bgp_peer *, char *, int);
 EXT void bgp_peer_info_delete(struct bgp_peer *);
+EXT void bgp_peer_info_delete_table(struct bgp_peer *, afi_t, safi_t);
 EXT void bgp_peer_cache_init(struct bgp_peer_cache_bucket *, u_int32_t);
 EXT struct bgp_peer_cache *bgp_peer_cache_insert(struct bgp_peer_cache_bucket *, u_int32_t, struct bgp_peer *);
 EXT int bgp_peer_cache_delete(struct bgp_peer_cache_bucket *, u_int32_t, struct bgp_peer *);
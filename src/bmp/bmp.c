@@ -28,6 +28,9 @@
 #include "../bgp/bgp.h"
 #include "bmp.h"
 #include "thread_pool.h"
+#if defined HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #if defined WITH_RABBITMQ
 #include "amqp_common.h"
 #endif
@@ -38,6 +41,11 @@
 /* variables to be exported away */
 thread_pool_t *bmp_pool;
 
+/* BMP workers */
+static thread_pool_t *bmp_workers_pool;
+static struct bgp_worker *bmp_workers;
+static int bmp_workers_num;
+
 /* Functions */
 void nfacctd_bmp_wrapper()
 {
@@ -57,7 +65,7 @@ void nfacctd_bmp_wrapper()
 void skinny_bmp_daemon()
 {
   int slen, clen, ret, rc, peers_idx, allowed, yes=1, no=0;
-  int peers_idx_rr = 0, max_peers_idx = 0;
+  int peers_idx_rr = 0, max_peers_idx = 0, peers_locked = FALSE;
   u_int32_t pkt_remaining_len=0;
   time_t now;
   afi_t afi;
@@ -334,6 +342,12 @@ void skinny_bmp_daemon()
       }
       dump_refresh_deadline = tmp_time;
       dump_refresh_deadline += config.bmp_dump_refresh_time; /* it's a deadline not a basetime */
+
+      /* writers would overwrite each other's files otherwise */
+      if (config.bmp_dump_workers > 1 && config.bmp_dump_file && !strstr(config.bmp_dump_file, "$peer_src_ip")) {
+        Log(LOG_WARNING, "WARN ( %s/%s ): 'bmp_dump_workers' requires $peer_src_ip in 'bmp_dump_file'. Using a single writer.\n", config.name, bmp_misc_db->log_str);
+        config.bmp_dump_workers = 1;
+      }
     }
     else {
       config.bmp_dump_file = NULL;
@@ -350,6 +364,9 @@ void skinny_bmp_daemon()
 
   bmp_link_misc_structs(bmp_misc_db);
 
+  /* established sessions are handed over to BMP workers, if any */
+  if (config.nfacctd_bmp_threads) bmp_workers_init(config.nfacctd_bmp_threads);
+
   for (;;) {
     select_again:
 
@@ -381,6 +398,15 @@ void skinny_bmp_daemon()
     }
     else drt_ptr = NULL;
 
+    /* free up what RIB readers are done with; retry shortly if anything is left */
+    bgp_rib_reclaim(bmp_misc_db);
+
+    if (bmp_misc_db->rib_retired_head && (!drt_ptr || drt_ptr->tv_sec > BGP_RIB_RECLAIM_INTERVAL)) {
+      dump_refresh_timeout.tv_sec = BGP_RIB_RECLAIM_INTERVAL;
+      dump_refresh_timeout.tv_usec = 0;
+      drt_ptr = &dump_refresh_timeout;
+    }
+
     select_num = select(select_fd, &read_descs, NULL, NULL, drt_ptr);
     if (select_num < 0) goto select_again;
 
@@ -391,6 +417,9 @@ void skinny_bmp_daemon()
     }
 
     if (reload_log_bmp_thread) {
+      pthread_mutex_lock(&bmp_misc_db->peers_mutex);
+      pthread_mutex_lock(&bmp_misc_db->msglog_mutex);
+
       for (peers_idx = 0; peers_idx < config.nfacctd_bmp_max_peers; peers_idx++) {
         if (bmp_misc_db->peers_log[peers_idx].fd) {
           fclose(bmp_misc_db->peers_log[peers_idx].fd);
@@ -400,13 +429,18 @@ void skinny_bmp_daemon()
         else break;
       }
 
+      pthread_mutex_unlock(&bmp_misc_db->msglog_mutex);
+      pthread_mutex_unlock(&bmp_misc_db->peers_mutex);
+
       reload_log_bmp_thread = FALSE;
     }
 
     if (bmp_misc_db->msglog_backend_methods || bmp_misc_db->dump_backend_methods) {
+      pthread_mutex_lock(&bmp_misc_db->msglog_mutex);
       gettimeofday(&bmp_misc_db->log_tstamp, NULL);
       compose_timestamp(bmp_misc_db->log_tstamp_str, SRVBUFLEN, &bmp_misc_db->log_tstamp, TRUE,
 			config.timestamps_since_epoch, config.timestamps_rfc3339, config.timestamps_utc);
+      pthread_mutex_unlock(&bmp_misc_db->msglog_mutex);
 
       if (bmp_misc_db->dump_backend_methods) {
         while (bmp_misc_db->log_tstamp.tv_sec > dump_refresh_deadline) {
@@ -416,7 +450,16 @@ void skinny_bmp_daemon()
 			    config.timestamps_since_epoch, config.timestamps_rfc3339, config.timestamps_utc);
 	  bmp_misc_db->dump.period = config.bmp_dump_refresh_time;
 
+          /* workers are held while forking: RIB and per-router events are consistent */
+          if (bmp_workers_num) {
+	    bgp_rib_writers_pause(bmp_routing_db, bmp_misc_db);
+	    pthread_mutex_lock(&bmp_misc_db->msglog_mutex);
+	  }
           bmp_handle_dump_event();
+          if (bmp_workers_num) {
+	    pthread_mutex_unlock(&bmp_misc_db->msglog_mutex);
+	    bgp_rib_writers_resume(bmp_routing_db, bmp_misc_db);
+	  }
           dump_refresh_deadline += config.bmp_dump_refresh_time;
         }
       }
@@ -453,6 +496,10 @@ void skinny_bmp_daemon()
     if (FD_ISSET(config.bmp_sock, &read_descs)) {
       int peers_check_idx, peers_num;
 
+      /* BMP workers may be closing sessions, hence freeing slots, meanwhile */
+      pthread_mutex_lock(&bmp_misc_db->peers_mutex);
+      peers_locked = TRUE;
+
       fd = accept(config.bmp_sock, (struct sockaddr *) &client, &clen);
       if (fd == ERR) goto read_data;
 
@@ -522,7 +569,7 @@ void skinny_bmp_daemon()
       }
 
       peer->fd = fd;
-      FD_SET(peer->fd, &bkp_read_descs);
+      if (!bmp_workers_num) FD_SET(peer->fd, &bkp_read_descs);
       peer->addr.family = ((struct sockaddr *)&client)->sa_family;
       if (peer->addr.family == AF_INET) {
         peer->addr.address.ipv4.s_addr = ((struct sockaddr_in *)&client)->sin_addr.s_addr;
@@ -557,10 +604,23 @@ void skinny_bmp_daemon()
       }
 
       Log(LOG_INFO, "INFO ( %s/%s ): [%s] BMP peers usage: %u/%u\n", config.name, bmp_misc_db->log_str, peer->addr_str, peers_num, config.nfacctd_bmp_max_peers);
+
+      if (bmp_workers_num && bmp_workers_add_peer(bmpp) == ERR) {
+	bmp_peer_close(bmpp, FUNC_TYPE_BMP);
+	goto read_data;
+      }
     }
 
     read_data:
 
+    if (peers_locked) {
+      pthread_mutex_unlock(&bmp_misc_db->peers_mutex);
+      peers_locked = FALSE;
+    }
+
+    /* sessions are all read by BMP workers */
+    if (bmp_workers_num) goto select_again;
+
     /*
        We have something coming in: let's lookup which peer is that.
        FvD: To avoid starvation of the "later established" peers, we
@@ -590,6 +650,7 @@ void skinny_bmp_daemon()
       goto select_again;
     }
     else {
+      __atomic_add_fetch(&bmpp->stats.bytes, ret, __ATOMIC_RELAXED);
       pkt_remaining_len = bmp_process_packet(peer->buf.base, peer->msglen, bmpp);
 
       /* handling offset for TCP segment reassembly */
@@ -600,10 +661,170 @@ void skinny_bmp_daemon()
   }
 }
 
+int bmp_workers_init(int num)
+{
+#if defined HAVE_SYS_EPOLL_H
+  int idx;
+
+  if (num <= 0) return 0;
+
+  bmp_workers = malloc(num * sizeof(struct bgp_worker));
+  if (!bmp_workers) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): Unable to malloc() BMP workers structure. Terminating thread.\n", config.name, bmp_misc_db->log_str);
+    exit_all(1);
+  }
+  memset(bmp_workers, 0, num * sizeof(struct bgp_worker));
+
+  for (idx = 0; idx < num; idx++) {
+    bmp_workers[idx].id = idx;
+    bmp_workers[idx].epoll_fd = epoll_create(BGP_WORKER_EVENTS);
+
+    if (bmp_workers[idx].epoll_fd < 0) {
+      Log(LOG_ERR, "ERROR ( %s/%s ): epoll_create() failed for BMP worker #%d (errno: %d). Terminating thread.\n",
+	  config.name, bmp_misc_db->log_str, idx, errno);
+      exit_all(1);
+    }
+  }
+
+  bmp_workers_pool = allocate_thread_pool(num);
+  assert(bmp_workers_pool);
+
+  for (idx = 0; idx < num; idx++)
+    send_to_pool(bmp_workers_pool, bmp_worker_daemon, &bmp_workers[idx]);
+
+  bmp_workers_num = num;
+  Log(LOG_INFO, "INFO ( %s/%s ): %d BMP worker thread(s) initialized\n", config.name, bmp_misc_db->log_str, num);
+
+  return num;
+#else
+  if (num > 0)
+    Log(LOG_WARNING, "WARN ( %s/%s ): 'bmp_daemon_threads' requires epoll() support. Ignored.\n", config.name, bmp_misc_db->log_str);
+
+  return 0;
+#endif
+}
+
+/* Hands a just established session, ie. a router, to the least loaded worker */
+int bmp_workers_add_peer(struct bmp_peer *bmpp)
+{
+#if defined HAVE_SYS_EPOLL_H
+  struct bgp_worker *bw = NULL;
+  struct epoll_event ev;
+  int idx;
+
+  if (!bmpp || !bmp_workers_num) return ERR;
+
+  for (idx = 0; idx < bmp_workers_num; idx++) {
+    if (!bw || __atomic_load_n(&bmp_workers[idx].peers, __ATOMIC_RELAXED) < __atomic_load_n(&bw->peers, __ATOMIC_RELAXED))
+      bw = &bmp_workers[idx];
+  }
+
+  if (!bw) return ERR;
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = bmpp;
+
+  __atomic_add_fetch(&bw->peers, 1, __ATOMIC_RELAXED);
+  bmpp->worker = bw;
+
+  if (epoll_ctl(bw->epoll_fd, EPOLL_CTL_ADD, bmpp->self.fd, &ev) < 0) {
+    __atomic_sub_fetch(&bw->peers, 1, __ATOMIC_RELAXED);
+    bmpp->worker = NULL;
+
+    Log(LOG_ERR, "ERROR ( %s/%s ): [%s] epoll_ctl() failed for BMP worker #%d (errno: %d).\n",
+	config.name, bmp_misc_db->log_str, bmpp->self.addr_str, bw->id, errno);
+
+    return ERR;
+  }
+
+  return SUCCESS;
+#else
+  return ERR;
+#endif
+}
+
+#if defined HAVE_SYS_EPOLL_H
+static void bmp_worker_peer_close(struct bgp_worker *bw, struct bmp_peer *bmpp)
+{
+  pthread_mutex_lock(&bmp_misc_db->peers_mutex);
+
+  epoll_ctl(bw->epoll_fd, EPOLL_CTL_DEL, bmpp->self.fd, NULL);
+  bmp_peer_close(bmpp, FUNC_TYPE_BMP);
+  bmpp->worker = NULL;
+
+  pthread_mutex_unlock(&bmp_misc_db->peers_mutex);
+
+  __atomic_sub_fetch(&bw->peers, 1, __ATOMIC_RELAXED);
+}
+#endif
+
+/*
+   BMP worker: reads and processes messages of the routers it owns. Epoll
+   is level-triggered and each ready session gets one read, at most a
+   session buffer worth of data, per round: a router streaming a large
+   backlog can't hold the worker, what is left waits in its socket.
+*/
+void bmp_worker_daemon(struct bgp_worker *bw)
+{
+#if defined HAVE_SYS_EPOLL_H
+  struct epoll_event events[BGP_WORKER_EVENTS];
+  struct bmp_peer *bmpp;
+  struct bgp_peer *peer;
+  u_int32_t pkt_remaining_len;
+  int events_num, idx, ret;
+
+  if (!bw) return;
+
+  for (;;) {
+    events_num = epoll_wait(bw->epoll_fd, events, BGP_WORKER_EVENTS, ERR);
+    if (events_num < 0) {
+      if (errno != EINTR)
+	Log(LOG_WARNING, "WARN ( %s/%s ): epoll_wait() failed for BMP worker #%d (errno: %d).\n",
+	    config.name, bmp_misc_db->log_str, bw->id, errno);
+
+      continue;
+    }
+
+    if (bmp_misc_db->msglog_backend_methods) {
+      pthread_mutex_lock(&bmp_misc_db->msglog_mutex);
+      gettimeofday(&bmp_misc_db->log_tstamp, NULL);
+      compose_timestamp(bmp_misc_db->log_tstamp_str, SRVBUFLEN, &bmp_misc_db->log_tstamp, TRUE,
+			config.timestamps_since_epoch, config.timestamps_rfc3339, config.timestamps_utc);
+      pthread_mutex_unlock(&bmp_misc_db->msglog_mutex);
+    }
+
+    for (idx = 0; idx < events_num; idx++) {
+      bmpp = (struct bmp_peer *) events[idx].data.ptr;
+      peer = &bmpp->self;
+
+      ret = recv(peer->fd, &peer->buf.base[peer->buf.truncated_len], (peer->buf.len - peer->buf.truncated_len), 0);
+      peer->msglen = (ret + peer->buf.truncated_len);
+
+      if (ret <= 0) {
+	Log(LOG_INFO, "INFO ( %s/%s ): [%s] BMP connection reset by peer (%d).\n", config.name, bmp_misc_db->log_str, peer->addr_str, errno);
+
+	bmp_worker_peer_close(bw, bmpp);
+	continue;
+      }
+
+      __atomic_add_fetch(&bmpp->stats.bytes, ret, __ATOMIC_RELAXED);
+      pkt_remaining_len = bmp_process_packet(peer->buf.base, peer->msglen, bmpp);
+
+      /* handling offset for TCP segment reassembly */
+      if (pkt_remaining_len) peer->buf.truncated_len = bmp_packet_adj_offset(peer->buf.base, peer->buf.len, peer->msglen,
+									     pkt_remaining_len, peer->addr_str);
+      else peer->buf.truncated_len = 0;
+    }
+  }
+#endif
+}
+
 void bmp_prepare_thread()
 {
   bmp_misc_db = &inter_domain_misc_dbs[FUNC_TYPE_BMP];
   memset(bmp_misc_db, 0, sizeof(struct bgp_misc_structs));
+  bgp_misc_locks_init(bmp_misc_db);
 
   bmp_misc_db->is_thread = TRUE;
   bmp_misc_db->log_str = malloc(strlen("core/BMP") + 1);
@@ -614,6 +835,7 @@ void bmp_prepare_daemon()
 {
   bmp_misc_db = &inter_domain_misc_dbs[FUNC_TYPE_BMP];
   memset(bmp_misc_db, 0, sizeof(struct bgp_misc_structs));
+  bgp_misc_locks_init(bmp_misc_db);
 
  bmp_misc_db->is_thread = FALSE;
  bmp_misc_db->log_str = malloc(strlen("core") + 1);
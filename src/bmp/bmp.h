@@ -106,10 +106,20 @@ struct bmp_stats_hdr {
   u_int32_t	count;
 } __attribute__ ((packed));
 
+/* per-router counters, see bmp_peers_print_stats() */
+struct bmp_peer_stats {
+  u_int64_t msgs;
+  u_int64_t bytes;
+  u_int64_t msgs_last; /* at last print, for the rate */
+  time_t last;
+};
+
 struct bmp_peer {
   struct bgp_peer self;
   void *bgp_peers;
   struct log_notification missing_peer_up;
+  struct bmp_peer_stats stats;
+  struct bgp_worker *worker;
 };
 
 struct bgp_msg_extra_data_bmp {
@@ -189,6 +199,9 @@ EXT void nfacctd_bmp_wrapper();
 EXT void skinny_bmp_daemon();
 EXT void bmp_prepare_thread();
 EXT void bmp_prepare_daemon();
+EXT int bmp_workers_init(int);
+EXT int bmp_workers_add_peer(struct bmp_peer *);
+EXT void bmp_worker_daemon(struct bgp_worker *);
 #undef EXT
 
 /* global variables */
@@ -133,6 +133,31 @@ int bmp_log_msg(struct bgp_peer *peer, struct bmp_data *bdata, void *log_data, u
   return (ret | amqp_ret | kafka_ret);
 }
 
+/*
+  Logs an event and/or records it for the next dump. Sequence number and
+  outputs are shared among BMP workers, hence serialized.
+*/
+void bmp_log_event(struct bgp_peer *peer, struct bmp_data *bdata, void *log_data, int log_type)
+{
+  struct bgp_misc_structs *bms = bgp_select_misc_db(FUNC_TYPE_BMP);
+  char event_type[] = "log";
+
+  if (!bms || !peer) return;
+  if (!bms->msglog_backend_methods && !bms->dump_backend_methods) return;
+
+  pthread_mutex_lock(&bms->msglog_mutex);
+
+  if (bms->msglog_backend_methods)
+    bmp_log_msg(peer, bdata, log_data, bms->log_seq, event_type, config.nfacctd_bmp_msglog_output, log_type);
+
+  if (bms->dump_backend_methods)
+    bmp_dump_se_ll_append(peer, bdata, log_data, log_type);
+
+  bgp_peer_log_seq_increment(&bms->log_seq);
+
+  pthread_mutex_unlock(&bms->msglog_mutex);
+}
+
 int bmp_log_msg_stats(struct bgp_peer *peer, struct bmp_data *bdata, struct bmp_log_stats *blstats, char *event_type, int output, void *vobj)
 {
   char bmp_msg_type[] = "stats";
@@ -432,6 +457,9 @@ void bmp_handle_dump_event()
     signal(SIGHUP, SIG_IGN);
     pm_setproctitle("%s %s [%s]", config.type, "Core Process -- BMP Dump Writer", config.name);
 
+    /* peers are shared among writers; each one has its own outputs */
+    bgp_dump_writers_spawn(bms, config.bmp_dump_workers);
+
     memset(last_filename, 0, sizeof(last_filename));
     memset(current_filename, 0, sizeof(current_filename));
     fd_buf = malloc(OUTPUT_FILE_BUFSZ);
@@ -452,12 +480,13 @@ void bmp_handle_dump_event()
 #endif
 
     dumper_pid = getpid();
-    Log(LOG_INFO, "INFO ( %s/%s ): *** Dumping BMP tables - START (PID: %u) ***\n", config.name, bms->log_str, dumper_pid);
+    Log(LOG_INFO, "INFO ( %s/%s ): *** Dumping BMP tables - START (PID: %u, WRITER: %u/%u) ***\n", config.name, bms->log_str, dumper_pid,
+	bms->dump.writer.id, bms->dump.writer.num);
     start = time(NULL);
     tables_num = 0;
 
     for (peer = NULL, saved_peer = NULL, peers_idx = 0; peers_idx < config.nfacctd_bmp_max_peers; peers_idx++) {
-      if (bmp_peers[peers_idx].self.fd) {
+      if (bmp_peers[peers_idx].self.fd && bgp_dump_writer_owns(bms, peers_idx)) {
         peer = &bmp_peers[peers_idx].self;
         bmpp = &bmp_peers[peers_idx];
         peer->log = &peer_log; /* abusing struct bgp_peer a bit, but we are in a child */
@@ -532,12 +561,12 @@ void bmp_handle_dump_event()
 		  struct bmp_peer *local_bmpp = ri->peer->bmp_se;
 
                   if (local_bmpp && (&local_bmpp->self == peer)) {
-		    char peer_str[] = "peer_ip", *saved_peer_str = bms->peer_str;
+		    char peer_str[] = "peer_ip";
 
 		    ri->peer->log = peer->log;
-		    bms->peer_str = peer_str;
+		    bgp_peer_log_str_set(peer_str);
                     bgp_peer_log_msg(node, ri, afi, safi, event_type, config.bmp_dump_output, NULL, BGP_LOG_TYPE_MISC);
-		    bms->peer_str = saved_peer_str;
+		    bgp_peer_log_str_set(NULL);
                     dump_elems++;
                   }
                 }
@@ -599,8 +628,8 @@ void bmp_handle_dump_event()
     }
 
     duration = time(NULL)-start;
-    Log(LOG_INFO, "INFO ( %s/%s ): *** Dumping BMP tables - END (PID: %u, TABLES: %u ET: %u) ***\n",
-                config.name, bms->log_str, dumper_pid, tables_num, duration);
+    Log(LOG_INFO, "INFO ( %s/%s ): *** Dumping BMP tables - END (PID: %u, WRITER: %u/%u, TABLES: %u ET: %u) ***\n",
+                config.name, bms->log_str, dumper_pid, bms->dump.writer.id, bms->dump.writer.num, tables_num, duration);
 
     exit(0);
   default: /* Parent */
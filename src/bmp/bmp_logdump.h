@@ -95,6 +95,7 @@ EXT void bmp_dump_init_peer(struct bgp_peer *);
 EXT void bmp_dump_close_peer(struct bgp_peer *);
 
 EXT int bmp_log_msg(struct bgp_peer *, struct bmp_data *, void *, u_int64_t, char *, int, int);
+EXT void bmp_log_event(struct bgp_peer *, struct bmp_data *, void *, int);
 EXT int bmp_log_msg_stats(struct bgp_peer *, struct bmp_data *, struct bmp_log_stats *, char *, int, void *);
 EXT int bmp_log_msg_init(struct bgp_peer *, struct bmp_data *, struct bmp_log_init *, char *, int, void *);
 EXT int bmp_log_msg_term(struct bgp_peer *, struct bmp_data *, struct bmp_log_term *, char *, int, void *);
@@ -136,3 +136,19 @@ int bgp_lookup_node_match_cmp_bmp(struct bgp_info *info, struct node_match_cmp_t
 
   return TRUE;
 }
+
+/* lookups are performed against the BMP router, routes belong to its BGP peers */
+struct bgp_peer *bgp_lookup_cache_peer_bmp(struct bgp_peer *peer)
+{
+  struct bmp_peer *bmpp;
+
+  if (!peer) return NULL;
+
+  if (bmp_peers && peer >= &bmp_peers[0].self && peer <= &bmp_peers[config.nfacctd_bmp_max_peers - 1].self)
+    return peer;
+
+  bmpp = peer->bmp_se;
+
+  if (bmpp) return &bmpp->self;
+  else return NULL;
+}
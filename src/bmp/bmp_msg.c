@@ -106,6 +106,8 @@ u_int32_t bmp_process_packet(char *bmp_packet, u_int32_t len, struct bmp_peer *b
       /* let's jump forward: we may have been unable to parse some (sub-)element */
       bmp_jump_offset(&bmp_packet_ptr, &pkt_remaining_len, (msg_len - (msg_start_len - pkt_remaining_len)));
     }
+
+    __atomic_add_fetch(&bmpp->stats.msgs, 1, __ATOMIC_RELAXED);
   }
 
   return FALSE;
@@ -131,17 +133,7 @@ void bmp_process_msg_init(char **bmp_packet, u_int32_t *len, u_int32_t bmp_hdr_l
   gettimeofday(&bdata.tstamp, NULL);
   bmp_hdr_len -= sizeof(struct bmp_common_hdr);
 
-  if (bms->msglog_backend_methods) {
-    char event_type[] = "log";
-
-    bmp_log_msg(peer, &bdata, NULL, bms->log_seq, event_type, config.nfacctd_bmp_msglog_output, BMP_LOG_TYPE_INIT);
-  }
-
-  if (bms->dump_backend_methods)
-    bmp_dump_se_ll_append(peer, &bdata, NULL, BMP_LOG_TYPE_INIT);
-
-  if (bms->msglog_backend_methods || bms->dump_backend_methods)
-    bgp_peer_log_seq_increment(&bms->log_seq);
+  bmp_log_event(peer, &bdata, NULL, BMP_LOG_TYPE_INIT);
 
   while (bmp_hdr_len) {
     if (!(bih = (struct bmp_init_hdr *) bmp_get_and_check_length(bmp_packet, len, sizeof(struct bmp_init_hdr)))) {
@@ -165,17 +157,7 @@ void bmp_process_msg_init(char **bmp_packet, u_int32_t *len, u_int32_t bmp_hdr_l
       blinit.len = bmp_init_len;
       blinit.val = bmp_init_info;
 
-      if (bms->msglog_backend_methods) {
-        char event_type[] = "log";
-
-        bmp_log_msg(peer, &bdata, &blinit, bms->log_seq, event_type, config.nfacctd_bmp_msglog_output, BMP_LOG_TYPE_INIT);
-      }
-
-      if (bms->dump_backend_methods)
-        bmp_dump_se_ll_append(peer, &bdata, &blinit, BMP_LOG_TYPE_INIT);
-
-      if (bms->msglog_backend_methods || bms->dump_backend_methods)
-        bgp_peer_log_seq_increment(&bms->log_seq);
+      bmp_log_event(peer, &bdata, &blinit, BMP_LOG_TYPE_INIT);
     }
 
     bmp_hdr_len -= (bmp_init_len + sizeof(struct bmp_init_hdr));
@@ -202,17 +184,7 @@ void bmp_process_msg_term(char **bmp_packet, u_int32_t *len, u_int32_t bmp_hdr_l
   gettimeofday(&bdata.tstamp, NULL);
   bmp_hdr_len -= sizeof(struct bmp_common_hdr);
 
-  if (bms->msglog_backend_methods) {
-    char event_type[] = "log";
-
-    bmp_log_msg(peer, &bdata, NULL, bms->log_seq, event_type, config.nfacctd_bmp_msglog_output, BMP_LOG_TYPE_TERM);
-  }
-
-  if (bms->dump_backend_methods)
-    bmp_dump_se_ll_append(peer, &bdata, NULL, BMP_LOG_TYPE_TERM);
-
-  if (bms->msglog_backend_methods || bms->dump_backend_methods)
-    bgp_peer_log_seq_increment(&bms->log_seq);
+  bmp_log_event(peer, &bdata, NULL, BMP_LOG_TYPE_TERM);
 
   while (bmp_hdr_len) {
     if (!(bth = (struct bmp_term_hdr *) bmp_get_and_check_length(bmp_packet, len, sizeof(struct bmp_term_hdr)))) {
@@ -239,17 +211,7 @@ void bmp_process_msg_term(char **bmp_packet, u_int32_t *len, u_int32_t bmp_hdr_l
       blterm.val = bmp_term_info;
       blterm.reas_type = reason_type;
 
-      if (bms->msglog_backend_methods) {
-        char event_type[] = "log";
-
-        bmp_log_msg(peer, &bdata, &blterm, bms->log_seq, event_type, config.nfacctd_bmp_msglog_output, BMP_LOG_TYPE_TERM);
-      }
-
-      if (bms->dump_backend_methods)
-        bmp_dump_se_ll_append(peer, &bdata, &blterm, BMP_LOG_TYPE_TERM);
-
-      if (bms->msglog_backend_methods || bms->dump_backend_methods)
-        bgp_peer_log_seq_increment(&bms->log_seq);
+      bmp_log_event(peer, &bdata, &blterm, BMP_LOG_TYPE_TERM);
     }
 
     bmp_hdr_len -= (bmp_term_len + sizeof(struct bmp_term_hdr));
@@ -338,17 +300,7 @@ void bmp_process_msg_peer_up(char **bmp_packet, u_int32_t *len, struct bmp_peer
       ret = pm_tsearch(bmpp_bgp_peer, &bmpp->bgp_peers, bgp_peer_cmp, sizeof(struct bgp_peer));
       if (!ret) Log(LOG_WARNING, "WARN ( %s/%s ): [%s] [peer up] tsearch() unable to insert.\n", config.name, bms->log_str, peer->addr_str);
 
-      if (bms->msglog_backend_methods) {
-        char event_type[] = "log";
-
-        bmp_log_msg(peer, &bdata, &blpu, bms->log_seq, event_type, config.nfacctd_bmp_msglog_output, BMP_LOG_TYPE_PEER_UP);
-      }
-
-      if (bms->dump_backend_methods)
-        bmp_dump_se_ll_append(peer, &bdata, &blpu, BMP_LOG_TYPE_PEER_UP);
-
-      if (bms->msglog_backend_methods || bms->dump_backend_methods)
-        bgp_peer_log_seq_increment(&bms->log_seq);
+      bmp_log_event(peer, &bdata, &blpu, BMP_LOG_TYPE_PEER_UP);
     }
   }
 }
@@ -401,29 +353,19 @@ void bmp_process_msg_peer_down(char **bmp_packet, u_int32_t *len, struct bmp_pee
       bmp_peer_down_hdr_get_reason(bpdh, &blpd.reason);
       if (blpd.reason == BMP_PEER_DOWN_LOC_CODE) bmp_peer_down_hdr_get_loc_code(bmp_packet, len, &blpd.loc_code);
 
-      if (bms->msglog_backend_methods) {
-        char event_type[] = "log";
-
-        bmp_log_msg(peer, &bdata, &blpd, bms->log_seq, event_type, config.nfacctd_bmp_msglog_output, BMP_LOG_TYPE_PEER_DOWN);
-      }
-
-      if (bms->dump_backend_methods)
-        bmp_dump_se_ll_append(peer, &bdata, &blpd, BMP_LOG_TYPE_PEER_DOWN);
-
-      if (bms->msglog_backend_methods || bms->dump_backend_methods)
-        bgp_peer_log_seq_increment(&bms->log_seq);
+      bmp_log_event(peer, &bdata, &blpd, BMP_LOG_TYPE_PEER_DOWN);
     }
 
     ret = pm_tfind(&bdata.peer_ip, &bmpp->bgp_peers, bgp_peer_host_addr_cmp);
 
     if (ret) {
-      char peer_str[] = "peer_ip", *saved_peer_str = bms->peer_str;
+      char peer_str[] = "peer_ip";
 
       bmpp_bgp_peer = (*(struct bgp_peer **) ret);
     
-      bms->peer_str = peer_str;
+      bgp_peer_log_str_set(peer_str);
       bgp_peer_info_delete(bmpp_bgp_peer);
-      bms->peer_str = saved_peer_str;
+      bgp_peer_log_str_set(NULL);
 
       pm_tdelete(&bdata.peer_ip, &bmpp->bgp_peers, bgp_peer_host_addr_cmp);
     } 
@@ -486,7 +428,7 @@ void bmp_process_msg_route_monitor(char **bmp_packet, u_int32_t *len, struct bmp
     ret = pm_tfind(&bdata.peer_ip, &bmpp->bgp_peers, bgp_peer_host_addr_cmp);
 
     if (ret) {
-      char peer_str[] = "peer_ip", *saved_peer_str = bms->peer_str;
+      char peer_str[] = "peer_ip";
       struct bgp_msg_extra_data_bmp bmed_bmp;
       struct bgp_msg_data bmd;
 
@@ -494,7 +436,7 @@ void bmp_process_msg_route_monitor(char **bmp_packet, u_int32_t *len, struct bmp
       memset(&bmd, 0, sizeof(bmd));
       memset(&bmed_bmp, 0, sizeof(bmed_bmp));
 
-      bms->peer_str = peer_str;
+      bgp_peer_log_str_set(peer_str);
       bmd.peer = bmpp_bgp_peer;
       bmd.extra.id = BGP_MSG_EXTRA_DATA_BMP;
       bmd.extra.len = sizeof(bmed_bmp);
@@ -502,7 +444,7 @@ void bmp_process_msg_route_monitor(char **bmp_packet, u_int32_t *len, struct bmp
       bgp_msg_data_set_data_bmp(&bmed_bmp, &bdata);
       /* XXX: checks, ie. marker, message length, etc., bypassed */
       bgp_update_len = bgp_parse_update_msg(&bmd, (*bmp_packet)); 
-      bms->peer_str = saved_peer_str;
+      bgp_peer_log_str_set(NULL);
 
       bmp_get_and_check_length(bmp_packet, len, bgp_update_len);
     }
@@ -627,17 +569,7 @@ void bmp_process_msg_stats(char **bmp_packet, u_int32_t *len, struct bmp_peer *b
         blstats.cnt_data = cnt_data64;
         blstats.got_data = got_data;
 
-        if (bms->msglog_backend_methods) {
-          char event_type[] = "log";
-
-          bmp_log_msg(peer, &bdata, &blstats, bms->log_seq, event_type, config.nfacctd_bmp_msglog_output, BMP_LOG_TYPE_STATS);
-        } 
-
-        if (bms->dump_backend_methods)
-          bmp_dump_se_ll_append(peer, &bdata, &blstats, BMP_LOG_TYPE_STATS);
-
-        if (bms->msglog_backend_methods || bms->dump_backend_methods)
-          bgp_peer_log_seq_increment(&bms->log_seq);
+        bmp_log_event(peer, &bdata, &blstats, BMP_LOG_TYPE_STATS);
       }
     }
   }
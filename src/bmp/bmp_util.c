@@ -163,9 +163,11 @@ void bmp_link_misc_structs(struct bgp_misc_structs *bms)
   bms->table_per_peer_buckets = config.bmp_table_per_peer_buckets;
   bms->table_attr_hash_buckets = config.bmp_table_attr_hash_buckets;
   bms->table_per_peer_hash = config.bmp_table_per_peer_hash;
+  bms->nlri_batch = config.nfacctd_bmp_nlri_batch;
   bms->route_info_modulo = bmp_route_info_modulo;
   bms->bgp_lookup_find_peer = bgp_lookup_find_bmp_peer;
   bms->bgp_lookup_node_match_cmp = bgp_lookup_node_match_cmp_bmp;
+  bms->bgp_lookup_cache_peer = bgp_lookup_cache_peer_bmp;
 
   if (!bms->is_thread && !bms->dump_backend_methods) bms->skip_rib = TRUE;
 }
@@ -192,6 +194,10 @@ int bmp_peer_init(struct bmp_peer *bmpp, int type)
   ret = bgp_peer_init(&bmpp->self, type);
   log_notification_init(&bmpp->missing_peer_up);
 
+  memset(&bmpp->stats, 0, sizeof(struct bmp_peer_stats));
+  bmpp->stats.last = time(NULL);
+  bmpp->worker = NULL;
+
   return ret;
 }
 
@@ -217,6 +223,44 @@ void bmp_peer_close(struct bmp_peer *bmpp, int type)
   bgp_peer_close(peer, type, FALSE, FALSE, FALSE, FALSE, NULL);
 }
 
+/*
+  Per-router counters: messages and bytes received, message rate since
+  the previous print and backlog, ie. bytes received and not processed
+  yet, either partial messages in the session buffer or data queued in
+  the socket.
+*/
+void bmp_peers_print_stats(time_t now)
+{
+  struct bgp_misc_structs *bms = bgp_select_misc_db(FUNC_TYPE_BMP);
+  struct bmp_peer *bmpp;
+  u_int64_t msgs, bytes, rate, backlog;
+  int peers_idx, queued;
+
+  if (!bms || !bmp_peers) return;
+
+  for (peers_idx = 0; peers_idx < config.nfacctd_bmp_max_peers; peers_idx++) {
+    bmpp = &bmp_peers[peers_idx];
+    if (!bmpp->self.fd) continue;
+
+    msgs = __atomic_load_n(&bmpp->stats.msgs, __ATOMIC_RELAXED);
+    bytes = __atomic_load_n(&bmpp->stats.bytes, __ATOMIC_RELAXED);
+
+    if (now > bmpp->stats.last && msgs >= bmpp->stats.msgs_last)
+      rate = ((msgs - bmpp->stats.msgs_last) / (now - bmpp->stats.last));
+    else rate = 0;
+
+    backlog = bmpp->self.buf.truncated_len;
+    if (!ioctl(bmpp->self.fd, FIONREAD, &queued) && queued > 0) backlog += queued;
+
+    Log(LOG_NOTICE, "NOTICE ( %s/%s ): [%s] stats [router] time=%u worker=%d msgs=%llu bytes=%llu rate=%llu backlog=%llu\n",
+	config.name, bms->log_str, bmpp->self.addr_str, now, (bmpp->worker ? bmpp->worker->id : ERR),
+	(unsigned long long) msgs, (unsigned long long) bytes, (unsigned long long) rate, (unsigned long long) backlog);
+
+    bmpp->stats.msgs_last = msgs;
+    bmpp->stats.last = now;
+  }
+}
+
 void bgp_msg_data_set_data_bmp(struct bgp_msg_extra_data_bmp *bmed_bmp, struct bmp_data *bdata)
 {
   bmed_bmp->is_post = bdata->is_post;
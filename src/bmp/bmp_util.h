@@ -36,6 +36,7 @@ EXT void bmp_link_misc_structs(struct bgp_misc_structs *);
 EXT struct bgp_peer *bmp_sync_loc_rem_peers(struct bgp_peer *, struct bgp_peer *);
 EXT int bmp_peer_init(struct bmp_peer *, int);
 EXT void bmp_peer_close(struct bmp_peer *, int);
+EXT void bmp_peers_print_stats(time_t);
 
 EXT void bgp_peer_log_msg_extras_bmp(struct bgp_peer *, int, void *);
 EXT void bgp_peer_logdump_initclose_extras_bmp(struct bgp_peer *, int, void *);
@@ -140,8 +140,11 @@ struct configuration {
   char *sql_preprocess;
   int sql_preprocess_type;
   int sql_multi_values;
+  int sql_prepared_statements;
+  int sql_writer_connections;
   char *sql_locking_style;
   int sql_use_copy;
+  int sql_copy_upsert;
   char *sql_delimiter;
   int timestamps_rfc3339;
   int timestamps_utc;
@@ -155,6 +158,7 @@ struct configuration {
   int amqp_persistent_msg;
   u_int32_t amqp_frame_max;
   u_int32_t amqp_heartbeat_interval;
+  u_int32_t amqp_confirm_window;
   char *amqp_vhost;
   int amqp_routing_key_rr;
   char *amqp_avro_schema_routing_key;
@@ -167,12 +171,14 @@ struct configuration {
   char *kafka_avro_schema_topic;
   int kafka_avro_schema_refresh_time;
   char *kafka_config_file;
+  char *kafka_compression;
   int print_cache_entries;
   int print_markers;
   int print_output;
   int print_output_file_append;
   char *print_output_lock_file;
   char *print_output_separator;
+  int print_output_compression;
   char *print_output_file;
   char *print_latest_file;
   int nfacctd_port;
@@ -223,6 +229,8 @@ struct configuration {
   char *telemetry_allow_file;
   int telemetry_pipe_size;
   int telemetry_ipprec;
+  int telemetry_threads;
+  int telemetry_queue_size;
   char *telemetry_msglog_file;
   int telemetry_msglog_output;
   char *telemetry_msglog_amqp_host;
@@ -241,6 +249,7 @@ struct configuration {
   char *telemetry_dump_latest_file;
   int telemetry_dump_output;
   int telemetry_dump_refresh_time;
+  int telemetry_dump_workers;
   char *telemetry_dump_amqp_host;
   char *telemetry_dump_amqp_vhost;
   char *telemetry_dump_amqp_user;
@@ -306,6 +315,7 @@ struct configuration {
   char *nfacctd_bgp_extcomm_pattern;
   char *nfacctd_bgp_lrgcomm_pattern;
   char *nfacctd_bgp_stdcomm_pattern_to_asn;
+  int bgp_comm_pattern_anchored;
   int nfacctd_bgp_peer_as_src_type;
   int nfacctd_bgp_src_std_comm_type;
   int nfacctd_bgp_src_ext_comm_type;
@@ -316,6 +326,7 @@ struct configuration {
   int nfacctd_bgp_peer_as_skip_subas;
   int nfacctd_bgp_batch;
   int nfacctd_bgp_batch_interval;
+  int nfacctd_bgp_threads;
   char *nfacctd_bgp_peer_as_src_map;
   char *nfacctd_bgp_src_local_pref_map;
   char *nfacctd_bgp_src_med_map;
@@ -330,10 +341,16 @@ struct configuration {
   int bgp_table_per_peer_buckets;
   int bgp_table_attr_hash_buckets;
   int bgp_table_per_peer_hash;
+  int bgp_lookup_cache_entries;
   int bgp_table_dump_output;
   char *bgp_table_dump_file;
   char *bgp_table_dump_latest_file;
   int bgp_table_dump_refresh_time;
+  int bgp_table_dump_checkpoint;
+  int bgp_table_dump_workers;
+  char *bgp_table_snapshot_file;
+  int bgp_table_snapshot_refresh_time;
+  int bgp_table_snapshot_stale_time;
   char *bgp_table_dump_amqp_host;
   char *bgp_table_dump_amqp_vhost;
   char *bgp_table_dump_amqp_user;
@@ -370,6 +387,8 @@ struct configuration {
   int nfacctd_bmp_ipprec;
   int nfacctd_bmp_batch;
   int nfacctd_bmp_batch_interval;
+  int nfacctd_bmp_threads;
+  int nfacctd_bmp_nlri_batch;
   int nfacctd_bmp_msglog_output;
   char *nfacctd_bmp_msglog_file;
   char *nfacctd_bmp_msglog_amqp_host;
@@ -401,6 +420,7 @@ struct configuration {
   char *bmp_dump_file;
   char *bmp_dump_latest_file;
   int bmp_dump_refresh_time;
+  int bmp_dump_workers;
   char *bmp_dump_amqp_host;
   char *bmp_dump_amqp_vhost;
   char *bmp_dump_amqp_user;
@@ -473,6 +493,7 @@ struct configuration {
   struct pretag_label_filter ptlf;
   int maps_refresh;
   int maps_index;
+  int maps_refresh_background;
   int maps_entries;
   int maps_row_len;
   char *pre_tag_map;
@@ -1758,6 +1758,32 @@ int cfg_key_amqp_heartbeat_interval(char *filename, char *name, char *value_ptr)
   return changes;
 }
 
+int cfg_key_amqp_confirm_window(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  u_int32_t value, changes = 0;
+  char *endptr;
+
+  value = strtoul(value_ptr, &endptr, 10);
+  if (*endptr || value > 1000000) {
+    Log(LOG_WARNING, "WARN: [%s] 'amqp_confirm_window' has to be in the range 0-1000000.\n", filename);
+    return ERR;
+  }
+
+  if (!name) for (; list; list = list->next, changes++) list->cfg.amqp_confirm_window = value;
+  else {
+    for (; list; list = list->next) {
+      if (!strcmp(name, list->name)) {
+        list->cfg.amqp_confirm_window = value;
+        changes++;
+        break;
+      }
+    }
+  }
+
+  return changes;
+}
+
 int cfg_key_amqp_vhost(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -2009,6 +2035,32 @@ int cfg_key_kafka_config_file(char *filename, char *name, char *value_ptr)
   return changes;
 }
 
+int cfg_key_kafka_compression(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int changes = 0;
+
+  lower_string(value_ptr);
+  if (strcmp(value_ptr, "none") && strcmp(value_ptr, "gzip") && strcmp(value_ptr, "snappy") &&
+      strcmp(value_ptr, "lz4") && strcmp(value_ptr, "zstd")) {
+    Log(LOG_WARNING, "WARN: [%s] Invalid 'kafka_compression' value '%s'\n", filename, value_ptr);
+    return ERR;
+  }
+
+  if (!name) for (; list; list = list->next, changes++) list->cfg.kafka_compression = value_ptr;
+  else {
+    for (; list; list = list->next) {
+      if (!strcmp(name, list->name)) {
+        list->cfg.kafka_compression = value_ptr;
+        changes++;
+        break;
+      }
+    }
+  }
+
+  return changes;
+}
+
 int cfg_key_sql_locking_style(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -2052,6 +2104,75 @@ int cfg_key_sql_use_copy(char *filename, char *name, char *value_ptr)
   return changes;
 }
 
+int cfg_key_sql_copy_upsert(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = parse_truefalse(value_ptr);
+  if (value < 0) return ERR;
+
+  if (!name) for (; list; list = list->next, changes++) list->cfg.sql_copy_upsert = value;
+  else {
+    for (; list; list = list->next) {
+      if (!strcmp(name, list->name)) {
+        list->cfg.sql_copy_upsert = value;
+	changes++;
+	break;
+      }
+    }
+  }
+
+  return changes;
+}
+
+int cfg_key_sql_prepared_statements(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = parse_truefalse(value_ptr);
+  if (value < 0) return ERR;
+
+  if (!name) for (; list; list = list->next, changes++) list->cfg.sql_prepared_statements = value;
+  else {
+    for (; list; list = list->next) {
+      if (!strcmp(name, list->name)) {
+        list->cfg.sql_prepared_statements = value;
+	changes++;
+	break;
+      }
+    }
+  }
+
+  return changes;
+}
+
+int cfg_key_sql_writer_connections(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if (value < 1 || value >= 100) {
+    Log(LOG_WARNING, "WARN: [%s] invalid 'sql_writer_connections' value. Allowed values are: 1 <= sql_writer_connections < 100.\n", filename);
+    return ERR;
+  }
+
+  if (!name) for (; list; list = list->next, changes++) list->cfg.sql_writer_connections = value;
+  else {
+    for (; list; list = list->next) {
+      if (!strcmp(name, list->name)) {
+        list->cfg.sql_writer_connections = value;
+        changes++;
+        break;
+      }
+    }
+  }
+
+  return changes;
+}
+
 int cfg_key_sql_delimiter(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -2677,6 +2798,14 @@ int cfg_key_print_output(char *filename, char *name, char *value_ptr)
 #else
     value = PRINT_OUTPUT_AVRO;
     Log(LOG_WARNING, "WARN: [%s] print_output set to avro but will produce no output (missing --enable-avro).\n", filename);
+#endif
+  }
+  else if (!strcmp(value_ptr, "parquet")) {
+#ifdef WITH_PARQUET
+    value = PRINT_OUTPUT_PARQUET;
+#else
+    value = PRINT_OUTPUT_PARQUET;
+    Log(LOG_WARNING, "WARN: [%s] print_output set to parquet but will produce no output (missing --enable-parquet).\n", filename);
 #endif
   }
   else {
@@ -2722,6 +2851,41 @@ int cfg_key_print_output_separator(char *filename, char *name, char *value_ptr)
   return changes;
 }
 
+int cfg_key_print_output_compression(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  lower_string(value_ptr);
+  if (!strcmp(value_ptr, "none"))
+    value = PRINT_COMPRESSION_NONE;
+  else if (!strcmp(value_ptr, "gzip")) {
+#if defined (HAVE_ZLIB)
+    value = PRINT_COMPRESSION_GZIP;
+#else
+    value = PRINT_COMPRESSION_NONE;
+    Log(LOG_WARNING, "WARN: [%s] print_output_compression set to gzip but zlib is not available; output will not be compressed.\n", filename);
+#endif
+  }
+  else {
+    Log(LOG_WARNING, "WARN: [%s] Invalid print_output_compression value '%s'\n", filename, value_ptr);
+    return ERR;
+  }
+
+  if (!name) for (; list; list = list->next, changes++) list->cfg.print_output_compression = value;
+  else {
+    for (; list; list = list->next) {
+      if (!strcmp(name, list->name)) {
+        list->cfg.print_output_compression = value;
+        changes++;
+        break;
+      }
+    }
+  }
+
+  return changes;
+}
+
 int cfg_key_num_protos(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -2998,6 +3162,20 @@ int cfg_key_maps_index(char *filename, char *name, char *value_ptr)
   return changes;
 }
 
+int cfg_key_maps_refresh_background(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = parse_truefalse(value_ptr);
+  if (value < 0) return ERR;
+
+  for (; list; list = list->next, changes++) list->cfg.maps_refresh_background = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'maps_refresh_background'. Globalized.\n", filename);
+
+  return changes;
+}
+
 int cfg_key_nfacctd_time_secs(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -3154,6 +3332,20 @@ int cfg_key_nfacctd_bgp_stdcomm_pattern_to_asn(char *filename, char *name, char
   return changes;
 }
 
+int cfg_key_nfacctd_bgp_comm_pattern_anchored(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = parse_truefalse(value_ptr);
+  if (value < 0) return ERR;
+
+  for (; list; list = list->next, changes++) list->cfg.bgp_comm_pattern_anchored = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'bgp_comm_pattern_anchored'. Globalized.\n", filename);
+
+  return changes;
+}
+
 int cfg_key_nfacctd_bgp_peer_src_as_type(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -3632,6 +3824,23 @@ int cfg_key_nfacctd_bgp_table_attr_hash_buckets(char *filename, char *name, char
   return changes;
 }
 
+int cfg_key_nfacctd_bgp_lookup_cache_entries(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if ((value < 0) || (value > 16777216)) {
+    Log(LOG_ERR, "WARN: [%s] 'bgp_lookup_cache_entries' has to be in the range 0-16777216.\n", filename);
+    return ERR;
+  }
+
+  for (; list; list = list->next, changes++) list->cfg.bgp_lookup_cache_entries = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'bgp_lookup_cache_entries'. Globalized.\n", filename);
+
+  return changes;
+}
+
 int cfg_key_nfacctd_bgp_table_per_peer_hash(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -3681,6 +3890,23 @@ int cfg_key_nfacctd_bgp_batch(char *filename, char *name, char *value_ptr)
   return changes;
 }
 
+int cfg_key_nfacctd_bgp_threads(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if ((value < 0) || (value > 64)) {
+    Log(LOG_ERR, "WARN: [%s] 'bgp_daemon_threads' has to be in the range 0-64.\n", filename);
+    return ERR;
+  }
+
+  for (; list; list = list->next, changes++) list->cfg.nfacctd_bgp_threads = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'bgp_daemon_threads'. Globalized.\n", filename);
+
+  return changes;
+}
+
 int cfg_key_nfacctd_bmp(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -3803,6 +4029,40 @@ int cfg_key_nfacctd_bmp_batch_interval(char *filename, char *name, char *value_p
   return changes;
 }
 
+int cfg_key_nfacctd_bmp_threads(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if ((value < 0) || (value > 64)) {
+    Log(LOG_ERR, "WARN: [%s] 'bmp_daemon_threads' has to be in the range 0-64.\n", filename);
+    return ERR;
+  }
+
+  for (; list; list = list->next, changes++) list->cfg.nfacctd_bmp_threads = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'bmp_daemon_threads'. Globalized.\n", filename);
+
+  return changes;
+}
+
+int cfg_key_nfacctd_bmp_nlri_batch(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if ((value < 0) || (value > 65535)) {
+    Log(LOG_ERR, "WARN: [%s] 'bmp_daemon_nlri_batch' has to be in the range 0-65535.\n", filename);
+    return ERR;
+  }
+
+  for (; list; list = list->next, changes++) list->cfg.nfacctd_bmp_nlri_batch = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'bmp_daemon_nlri_batch'. Globalized.\n", filename);
+
+  return changes;
+}
+
 int cfg_key_nfacctd_bmp_batch(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -4150,6 +4410,23 @@ int cfg_key_nfacctd_bmp_dump_refresh_time(char *filename, char *name, char *valu
   return changes;
 }
 
+int cfg_key_nfacctd_bmp_dump_workers(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if ((value < 1) || (value > 64)) {
+    Log(LOG_ERR, "WARN: [%s] 'bmp_dump_workers' has to be in the range 1-64.\n", filename);
+    return ERR;
+  }
+
+  for (; list; list = list->next, changes++) list->cfg.bmp_dump_workers = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'bmp_dump_workers'. Globalized.\n", filename);
+
+  return changes;
+}
+
 int cfg_key_nfacctd_bmp_dump_amqp_host(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -6076,6 +6353,85 @@ int cfg_key_nfacctd_bgp_table_dump_refresh_time(char *filename, char *name, char
   return changes;
 }
 
+int cfg_key_nfacctd_bgp_table_dump_workers(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if ((value < 1) || (value > 64)) {
+    Log(LOG_ERR, "WARN: [%s] 'bgp_table_dump_workers' has to be in the range 1-64.\n", filename);
+    return ERR;
+  }
+
+  for (; list; list = list->next, changes++) list->cfg.bgp_table_dump_workers = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'bgp_table_dump_workers'. Globalized.\n", filename);
+
+  return changes;
+}
+
+int cfg_key_nfacctd_bgp_table_dump_checkpoint(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if (value < 0 || value > 1440) {
+    Log(LOG_ERR, "WARN: [%s] 'bgp_table_dump_checkpoint' value has to be >= 0 and <= 1440.\n", filename);
+    return ERR;
+  }
+
+  for (; list; list = list->next, changes++) list->cfg.bgp_table_dump_checkpoint = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'bgp_table_dump_checkpoint'. Globalized.\n", filename);
+
+  return changes;
+}
+
+int cfg_key_nfacctd_bgp_table_snapshot_file(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int changes = 0;
+
+  for (; list; list = list->next, changes++) list->cfg.bgp_table_snapshot_file = value_ptr;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'bgp_table_snapshot_file'. Globalized.\n", filename);
+
+  return changes;
+}
+
+int cfg_key_nfacctd_bgp_table_snapshot_refresh_time(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if (value < 60 || value > 86400) {
+    Log(LOG_ERR, "WARN: [%s] 'bgp_table_snapshot_refresh_time' value has to be >= 60 and <= 86400 secs.\n", filename);
+    return ERR;
+  }
+
+  for (; list; list = list->next, changes++) list->cfg.bgp_table_snapshot_refresh_time = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'bgp_table_snapshot_refresh_time'. Globalized.\n", filename);
+
+  return changes;
+}
+
+int cfg_key_nfacctd_bgp_table_snapshot_stale_time(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if (value < 1 || value > 86400) {
+    Log(LOG_ERR, "WARN: [%s] 'bgp_table_snapshot_stale_time' value has to be >= 1 and <= 86400 secs.\n", filename);
+    return ERR;
+  }
+
+  for (; list; list = list->next, changes++) list->cfg.bgp_table_snapshot_stale_time = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'bgp_table_snapshot_stale_time'. Globalized.\n", filename);
+
+  return changes;
+}
+
 int cfg_key_nfacctd_bgp_table_dump_amqp_host(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -6788,6 +7144,40 @@ int cfg_key_telemetry_pipe_size(char *filename, char *name, char *value_ptr)
   return changes;
 }
 
+int cfg_key_telemetry_threads(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if ((value < 0) || (value > 64)) {
+    Log(LOG_ERR, "WARN: [%s] 'telemetry_daemon_threads' has to be in the range 0-64.\n", filename);
+    return ERR;
+  }
+
+  for (; list; list = list->next, changes++) list->cfg.telemetry_threads = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'telemetry_daemon_threads'. Globalized.\n", filename);
+
+  return changes;
+}
+
+int cfg_key_telemetry_queue_size(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if ((value < 1) || (value > 1048576)) {
+    Log(LOG_ERR, "WARN: [%s] 'telemetry_daemon_queue_size' has to be in the range 1-1048576.\n", filename);
+    return ERR;
+  }
+
+  for (; list; list = list->next, changes++) list->cfg.telemetry_queue_size = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'telemetry_daemon_queue_size'. Globalized.\n", filename);
+
+  return changes;
+}
+
 int cfg_key_telemetry_ip_precedence(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -7103,6 +7493,23 @@ int cfg_key_telemetry_dump_refresh_time(char *filename, char *name, char *value_
   return changes;
 }
 
+int cfg_key_telemetry_dump_workers(char *filename, char *name, char *value_ptr)
+{
+  struct plugins_list_entry *list = plugins_list;
+  int value, changes = 0;
+
+  value = atoi(value_ptr);
+  if ((value < 1) || (value > 64)) {
+    Log(LOG_ERR, "WARN: [%s] 'telemetry_dump_workers' has to be in the range 1-64.\n", filename);
+    return ERR;
+  }
+
+  for (; list; list = list->next, changes++) list->cfg.telemetry_dump_workers = value;
+  if (name) Log(LOG_WARNING, "WARN: [%s] plugin name not supported for key 'telemetry_dump_workers'. Globalized.\n", filename);
+
+  return changes;
+}
+
 int cfg_key_telemetry_dump_amqp_host(char *filename, char *name, char *value_ptr)
 {
   struct plugins_list_entry *list = plugins_list;
@@ -89,6 +89,9 @@ EXT int cfg_key_sql_preprocess_type(char *, char *, char *);
 EXT int cfg_key_sql_multi_values(char *, char *, char *);
 EXT int cfg_key_sql_locking_style(char *, char *, char *);
 EXT int cfg_key_sql_use_copy(char *, char *, char *);
+EXT int cfg_key_sql_copy_upsert(char *, char *, char *);
+EXT int cfg_key_sql_prepared_statements(char *, char *, char *);
+EXT int cfg_key_sql_writer_connections(char *, char *, char *);
 EXT int cfg_key_sql_delimiter(char *, char *, char *);
 EXT int cfg_key_timestamps_rfc3339(char *, char *, char *);
 EXT int cfg_key_timestamps_utc(char *, char *, char *);
@@ -102,6 +105,7 @@ EXT int cfg_key_amqp_exchange_type(char *, char *, char *);
 EXT int cfg_key_amqp_persistent_msg(char *, char *, char *);
 EXT int cfg_key_amqp_frame_max(char *, char *, char *);
 EXT int cfg_key_amqp_heartbeat_interval(char *, char *, char *);
+EXT int cfg_key_amqp_confirm_window(char *, char *, char *);
 EXT int cfg_key_amqp_vhost(char *, char *, char *);
 EXT int cfg_key_amqp_routing_key_rr(char *, char *, char *);
 EXT int cfg_key_amqp_avro_schema_routing_key(char *, char *, char *);
@@ -113,6 +117,7 @@ EXT int cfg_key_kafka_partition_key(char *, char *, char *);
 EXT int cfg_key_kafka_avro_schema_topic(char *, char *, char *);
 EXT int cfg_key_kafka_avro_schema_refresh_time(char *, char *, char *);
 EXT int cfg_key_kafka_config_file(char *, char *, char *);
+EXT int cfg_key_kafka_compression(char *, char *, char *);
 EXT int cfg_key_plugin_pipe_size(char *, char *, char *);
 EXT int cfg_key_plugin_buffer_size(char *, char *, char *);
 EXT int cfg_key_plugin_pipe_check_core_pid(char *, char *, char *);
@@ -134,6 +139,7 @@ EXT int cfg_key_print_output_file(char *, char *, char *);
 EXT int cfg_key_print_output_file_append(char *, char *, char *);
 EXT int cfg_key_print_output_lock_file(char *, char *, char *);
 EXT int cfg_key_print_output_separator(char *, char *, char *);
+EXT int cfg_key_print_output_compression(char *, char *, char *);
 EXT int cfg_key_print_latest_file(char *, char *, char *);
 EXT int cfg_key_nfacctd_port(char *, char *, char *);
 EXT int cfg_key_nfacctd_ip(char *, char *, char *);
@@ -189,6 +195,8 @@ EXT int cfg_key_telemetry_max_peers(char *, char *, char *);
 EXT int cfg_key_telemetry_udp_timeout(char *, char *, char *);
 EXT int cfg_key_telemetry_allow_file(char *, char *, char *);
 EXT int cfg_key_telemetry_pipe_size(char *, char *, char *);
+EXT int cfg_key_telemetry_threads(char *, char *, char *);
+EXT int cfg_key_telemetry_queue_size(char *, char *, char *);
 EXT int cfg_key_telemetry_ip_precedence(char *, char *, char *);
 EXT int cfg_key_telemetry_msglog_output(char *, char *, char *);
 EXT int cfg_key_telemetry_msglog_file(char *, char *, char *);
@@ -216,6 +224,7 @@ EXT int cfg_key_telemetry_dump_output(char *, char *, char *);
 EXT int cfg_key_telemetry_dump_file(char *, char *, char *);
 EXT int cfg_key_telemetry_dump_latest_file(char *, char *, char *);
 EXT int cfg_key_telemetry_dump_refresh_time(char *, char *, char *);
+EXT int cfg_key_telemetry_dump_workers(char *, char *, char *);
 EXT int cfg_key_telemetry_dump_amqp_host(char *, char *, char *);
 EXT int cfg_key_telemetry_dump_amqp_vhost(char *, char *, char *);
 EXT int cfg_key_telemetry_dump_amqp_user(char *, char *, char *);
@@ -236,6 +245,7 @@ EXT int cfg_key_telemetry_dump_kafka_partition_key(char *, char *, char *);
 EXT int cfg_key_telemetry_dump_kafka_config_file(char *, char *, char *);
 EXT int cfg_key_maps_refresh(char *, char *, char *);
 EXT int cfg_key_maps_index(char *, char *, char *);
+EXT int cfg_key_maps_refresh_background(char *, char *, char *);
 EXT int cfg_key_maps_entries(char *, char *, char *);
 EXT int cfg_key_maps_row_len(char *, char *, char *);
 EXT int cfg_key_pre_tag_map(char *, char *, char *);
@@ -315,6 +325,7 @@ EXT int cfg_key_nfacctd_bgp_stdcomm_pattern(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_extcomm_pattern(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_lrgcomm_pattern(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_stdcomm_pattern_to_asn(char *, char *, char *);
+EXT int cfg_key_nfacctd_bgp_comm_pattern_anchored(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_peer_src_as_type(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_src_std_comm_type(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_src_ext_comm_type(char *, char *, char *);
@@ -335,11 +346,17 @@ EXT int cfg_key_nfacctd_bgp_md5_file(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_table_peer_buckets(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_table_per_peer_buckets(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_table_attr_hash_buckets(char *, char *, char *);
+EXT int cfg_key_nfacctd_bgp_lookup_cache_entries(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_table_per_peer_hash(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_table_dump_output(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_table_dump_file(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_table_dump_latest_file(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_table_dump_refresh_time(char *, char *, char *);
+EXT int cfg_key_nfacctd_bgp_table_dump_workers(char *, char *, char *);
+EXT int cfg_key_nfacctd_bgp_table_dump_checkpoint(char *, char *, char *);
+EXT int cfg_key_nfacctd_bgp_table_snapshot_file(char *, char *, char *);
+EXT int cfg_key_nfacctd_bgp_table_snapshot_refresh_time(char *, char *, char *);
+EXT int cfg_key_nfacctd_bgp_table_snapshot_stale_time(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_table_dump_amqp_host(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_table_dump_amqp_vhost(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_table_dump_amqp_user(char *, char *, char *);
@@ -360,6 +377,7 @@ EXT int cfg_key_nfacctd_bgp_table_dump_kafka_partition_key(char *, char *, char
 EXT int cfg_key_nfacctd_bgp_table_dump_kafka_config_file(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_batch(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_batch_interval(char *, char *, char *);
+EXT int cfg_key_nfacctd_bgp_threads(char *, char *, char *);
 EXT int cfg_key_nfacctd_bgp_pipe_size(char *, char *, char *);
 EXT int cfg_key_bgp_lg(char *, char *, char *);
 EXT int cfg_key_bgp_lg_ip(char *, char *, char *);
@@ -377,6 +395,8 @@ EXT int cfg_key_nfacctd_bmp_allow_file(char *, char *, char *);
 EXT int cfg_key_nfacctd_bmp_ip_precedence(char *, char *, char *);
 EXT int cfg_key_nfacctd_bmp_batch(char *, char *, char *);
 EXT int cfg_key_nfacctd_bmp_batch_interval(char *, char *, char *);
+EXT int cfg_key_nfacctd_bmp_threads(char *, char *, char *);
+EXT int cfg_key_nfacctd_bmp_nlri_batch(char *, char *, char *);
 EXT int cfg_key_nfacctd_bmp_msglog_output(char *, char *, char *);
 EXT int cfg_key_nfacctd_bmp_msglog_file(char *, char *, char *);
 EXT int cfg_key_nfacctd_bmp_msglog_amqp_host(char *, char *, char *);
@@ -407,6 +427,7 @@ EXT int cfg_key_nfacctd_bmp_dump_output(char *, char *, char *);
 EXT int cfg_key_nfacctd_bmp_dump_file(char *, char *, char *);
 EXT int cfg_key_nfacctd_bmp_dump_latest_file(char *, char *, char *);
 EXT int cfg_key_nfacctd_bmp_dump_refresh_time(char *, char *, char *);
+EXT int cfg_key_nfacctd_bmp_dump_workers(char *, char *, char *);
 EXT int cfg_key_nfacctd_bmp_dump_amqp_host(char *, char *, char *);
 EXT int cfg_key_nfacctd_bmp_dump_amqp_vhost(char *, char *, char *);
 EXT int cfg_key_nfacctd_bmp_dump_amqp_user(char *, char *, char *);
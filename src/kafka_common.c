@@ -25,6 +25,7 @@
 #include "pmacct.h"
 #include "pmacct-data.h"
 #include "kafka_common.h"
+#include "jhash.h"
 
 /* Functions */
 void p_kafka_init_host(struct p_kafka_host *kafka_host, char *config_file)
@@ -65,8 +66,10 @@ void p_kafka_unset_topic(struct p_kafka_host *kafka_host)
   }
 }
 
-void p_kafka_set_topic(struct p_kafka_host *kafka_host, char *topic)
+static rd_kafka_topic_t *p_kafka_topic_new(struct p_kafka_host *kafka_host, char *topic)
 {
+  rd_kafka_topic_t *rkt = NULL;
+
   if (kafka_host) {
     kafka_host->topic_cfg = rd_kafka_topic_conf_new();
     p_kafka_apply_topic_config(kafka_host);
@@ -87,14 +90,23 @@ void p_kafka_set_topic(struct p_kafka_host *kafka_host, char *topic)
     if (config.kafka_partition_dynamic && kafka_host->topic_cfg)
       p_kafka_set_dynamic_partitioner(kafka_host);
 
-    /* destroy current allocation before making a new one */
-    if (kafka_host->topic) p_kafka_unset_topic(kafka_host);
-
     if (kafka_host->rk && kafka_host->topic_cfg) {
-      kafka_host->topic = rd_kafka_topic_new(kafka_host->rk, topic, kafka_host->topic_cfg);
+      rkt = rd_kafka_topic_new(kafka_host->rk, topic, kafka_host->topic_cfg);
       kafka_host->topic_cfg = NULL; /* rd_kafka_topic_new() destroys conf as per rdkafka.h */
     }
   }
+
+  return rkt;
+}
+
+void p_kafka_set_topic(struct p_kafka_host *kafka_host, char *topic)
+{
+  if (kafka_host) {
+    /* destroy current allocation before making a new one */
+    if (kafka_host->topic) p_kafka_unset_topic(kafka_host);
+
+    kafka_host->topic = p_kafka_topic_new(kafka_host, topic);
+  }
 }
 
 char *p_kafka_get_topic(struct p_kafka_host *kafka_host)
@@ -197,6 +209,16 @@ void p_kafka_set_config_file(struct p_kafka_host *kafka_host, char *config_file)
   }
 }
 
+void p_kafka_set_compression(struct p_kafka_host *kafka_host, char *codec)
+{
+  char errstr[SRVBUFLEN];
+
+  if (kafka_host && kafka_host->cfg && codec) {
+    if (rd_kafka_conf_set(kafka_host->cfg, "compression.codec", codec, errstr, sizeof(errstr)) != RD_KAFKA_CONF_OK)
+      Log(LOG_WARNING, "WARN ( %s/%s ): Unable to set Kafka compression codec '%s': %s\n", config.name, config.type, codec, errstr);
+  }
+}
+
 void p_kafka_get_version()
 {
   printf("rdkafka %s\n", rd_kafka_version_str());
@@ -327,11 +349,27 @@ void p_kafka_logger(const rd_kafka_t *rk, int level, const char *fac, const char
 void p_kafka_msg_delivered(rd_kafka_t *rk, void *payload, size_t len, int error_code, void *opaque, void *msg_opaque)
 {
   struct p_kafka_host *kafka_host = (struct p_kafka_host *) opaque; 
+  struct timeval *produced = (struct timeval *) msg_opaque, now;
+  u_int64_t latency;
 
   if (error_code) {
     Log(LOG_ERR, "ERROR ( %s/%s ): Kafka message delivery failed: %s\n", config.name, config.type, rd_kafka_err2str(error_code));
+    kafka_host->stats.msgs_failed++;
   }
   else {
+    kafka_host->stats.msgs_delivered++;
+    kafka_host->stats.bytes_delivered += len;
+
+    /* only batches carry their production time */
+    if (produced) {
+      gettimeofday(&now, NULL);
+      latency = ((now.tv_sec - produced->tv_sec) * 1000000ULL) + now.tv_usec - produced->tv_usec;
+
+      kafka_host->stats.latency_num++;
+      kafka_host->stats.latency_sum += latency;
+      if (latency > kafka_host->stats.latency_max) kafka_host->stats.latency_max = latency;
+    }
+
     if (config.debug) {
       if (p_kafka_get_content_type(kafka_host) == PM_KAFKA_CNT_TYPE_STR) {
         char *payload_str = (char *) payload;
@@ -346,6 +384,8 @@ void p_kafka_msg_delivered(rd_kafka_t *rk, void *payload, size_t len, int error_
       }
     }
   }
+
+  if (produced) free(produced);
 }
 
 void p_kafka_msg_error(rd_kafka_t *rk, int err, const char *reason, void *opaque)
@@ -453,11 +493,179 @@ int p_kafka_check_outq_len(struct p_kafka_host *kafka_host)
   return SUCCESS;
 }
 
-#if defined WITH_JANSSON
-int write_and_free_json_kafka(void *kafka_log, void *obj)
+void p_kafka_batches_init(struct p_kafka_batches *batches, int num, u_int32_t size)
+{
+  memset(batches, 0, sizeof(struct p_kafka_batches));
+
+  batches->slot = pm_malloc(num * sizeof(struct p_kafka_batch));
+  memset(batches->slot, 0, num * sizeof(struct p_kafka_batch));
+  batches->num = num;
+  batches->size = size;
+}
+
+/* The batch buffer is handed over to librdkafka, which frees it once
+   delivered; a new one is allocated by the next p_kafka_batch_add() */
+int p_kafka_produce_batch(struct p_kafka_host *kafka_host, struct p_kafka_batch *batch)
+{
+  rd_kafka_topic_t *rkt = (batch->rkt ? batch->rkt : kafka_host->topic);
+  struct timeval *produced;
+  int ret;
+
+  if (!batch->len) return SUCCESS;
+
+  kafkap_ret_err_cb = FALSE;
+
+  if (!kafka_host->rk || !rkt) return ERR;
+
+  produced = malloc(sizeof(struct timeval));
+  if (produced) gettimeofday(produced, NULL);
+
+  ret = rd_kafka_produce(rkt, kafka_host->partition, RD_KAFKA_MSG_F_FREE, batch->buf, batch->len,
+			 (batch->key_len ? batch->key : NULL), batch->key_len, produced);
+
+  if (ret == ERR) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): Failed to produce to topic %s partition %i: %s\n", config.name, config.type,
+	rd_kafka_topic_name(rkt), kafka_host->partition, rd_kafka_err2str(rd_kafka_errno2err(errno)));
+
+    if (produced) free(produced);
+    free(batch->buf);
+  }
+
+  batch->buf = NULL;
+  batch->len = 0;
+  batch->num = 0;
+
+  rd_kafka_poll(kafka_host->rk, 0);
+
+  return ret;
+}
+
+static int p_kafka_batch_flush(struct p_kafka_host *kafka_host, struct p_kafka_batch *batch)
+{
+  int num = batch->num;
+
+  if (p_kafka_produce_batch(kafka_host, batch) == ERR) return ERR;
+
+  return num;
+}
+
+/* Appends a record to the batch of its destination, ie. topic (NULL for
+   the one set on kafka_host) and partition key; returns the number of
+   records produced along the way or ERR. On ERR the caller is expected
+   to release batches before closing kafka_host */
+int p_kafka_batch_add(struct p_kafka_host *kafka_host, struct p_kafka_batches *batches, char *topic,
+		      char *key, int key_len, char *data, u_int32_t data_len)
+{
+  struct p_kafka_batch *batch;
+  u_int32_t hash;
+  int ret, flushed = 0;
+
+  if (!topic) topic = "";
+  if (!key) key_len = 0;
+  if (key_len >= SRVBUFLEN) key_len = (SRVBUFLEN - 1);
+  if ((data_len + 1) > batches->size) return ERR;
+
+  hash = jhash(topic, strlen(topic), 0);
+  if (key_len) hash = jhash(key, key_len, hash);
+
+  batch = &batches->slot[hash % batches->num];
+
+  /* slot taken by another destination: flush it and take it over */
+  if (batch->used && (batch->hash != hash || batch->key_len != key_len || strcmp(batch->topic, topic) ||
+		      (key_len && memcmp(batch->key, key, key_len)))) {
+    if ((ret = p_kafka_batch_flush(kafka_host, batch)) == ERR) return ERR;
+    flushed += ret;
+
+    if (batch->rkt && strcmp(batch->topic, topic)) {
+      rd_kafka_topic_destroy(batch->rkt);
+      batch->rkt = NULL;
+    }
+
+    batch->used = FALSE;
+  }
+
+  if (!batch->used) {
+    strlcpy(batch->topic, topic, SRVBUFLEN);
+    if (key_len) memcpy(batch->key, key, key_len);
+    batch->key_len = key_len;
+    batch->hash = hash;
+    batch->used = TRUE;
+
+    if (strlen(topic) && !batch->rkt) {
+      batch->rkt = p_kafka_topic_new(kafka_host, topic);
+      if (!batch->rkt) return ERR;
+    }
+  }
+
+  if ((batch->len + data_len + 1) > batches->size) {
+    if ((ret = p_kafka_batch_flush(kafka_host, batch)) == ERR) return ERR;
+    flushed += ret;
+  }
+
+  /* one extra byte, room for the debug output of p_kafka_msg_delivered() */
+  if (!batch->buf) batch->buf = pm_malloc(batches->size + 1);
+
+  memcpy(&batch->buf[batch->len], data, data_len);
+  batch->len += data_len;
+  batch->buf[batch->len] = '\n';
+  batch->len++;
+  batch->num++;
+
+  return flushed;
+}
+
+int p_kafka_batches_flush(struct p_kafka_host *kafka_host, struct p_kafka_batches *batches)
+{
+  int idx, ret, flushed = 0;
+
+  for (idx = 0; idx < batches->num; idx++) {
+    if (batches->slot[idx].used) {
+      if ((ret = p_kafka_batch_flush(kafka_host, &batches->slot[idx])) == ERR) return ERR;
+      flushed += ret;
+    }
+  }
+
+  return flushed;
+}
+
+/* To be called before kafka_host is closed, as it holds topic handles */
+void p_kafka_batches_free(struct p_kafka_batches *batches)
+{
+  int idx;
+
+  if (!batches->slot) return;
+
+  for (idx = 0; idx < batches->num; idx++) {
+    if (batches->slot[idx].rkt) rd_kafka_topic_destroy(batches->slot[idx].rkt);
+    if (batches->slot[idx].buf) free(batches->slot[idx].buf);
+  }
+
+  free(batches->slot);
+  memset(batches, 0, sizeof(struct p_kafka_batches));
+}
+
+int write_string_kafka(void *kafka_log, char *str, u_int32_t len)
 {
   char *orig_kafka_topic = NULL, dyn_kafka_topic[SRVBUFLEN];
   struct p_kafka_host *alog = (struct p_kafka_host *) kafka_log;
+  int ret;
+
+  if (alog->topic_rr.max) {
+    orig_kafka_topic = p_kafka_get_topic(alog);
+    P_handle_table_dyn_rr(dyn_kafka_topic, SRVBUFLEN, orig_kafka_topic, &alog->topic_rr);
+    p_kafka_set_topic(alog, dyn_kafka_topic);
+  }
+
+  ret = p_kafka_produce_data(alog, str, len);
+
+  if (alog->topic_rr.max) p_kafka_set_topic(alog, orig_kafka_topic);
+
+  return ret;
+}
+
+#if defined WITH_JANSSON
+int write_and_free_json_kafka(void *kafka_log, void *obj)
+{
   int ret = ERR;
 
   char *tmpbuf = NULL;
@@ -467,16 +675,8 @@ int write_and_free_json_kafka(void *kafka_log, void *obj)
   json_decref(json_obj);
 
   if (tmpbuf) {
-    if (alog->topic_rr.max) {
-      orig_kafka_topic = p_kafka_get_topic(alog);
-      P_handle_table_dyn_rr(dyn_kafka_topic, SRVBUFLEN, orig_kafka_topic, &alog->topic_rr);
-      p_kafka_set_topic(alog, dyn_kafka_topic);
-    }
-
-    ret = p_kafka_produce_data(alog, tmpbuf, strlen(tmpbuf));
+    ret = write_string_kafka(kafka_log, tmpbuf, strlen(tmpbuf));
     free(tmpbuf);
-
-    if (alog->topic_rr.max) p_kafka_set_topic(alog, orig_kafka_topic);
   }
 
   return ret;
@@ -33,7 +33,38 @@
 #define PM_KAFKA_CNT_TYPE_STR	1
 #define PM_KAFKA_CNT_TYPE_BIN	2
 
+#define PM_KAFKA_BATCH_SLOTS	64
+
 /* structures */
+struct p_kafka_stats {
+  u_int64_t msgs_delivered;
+  u_int64_t msgs_failed;
+  u_int64_t bytes_delivered;
+  u_int64_t latency_num;
+  u_int64_t latency_sum;	/* usecs */
+  u_int64_t latency_max;	/* usecs */
+};
+
+/* records bound to the same topic and partition key, newline separated */
+struct p_kafka_batch {
+  char topic[SRVBUFLEN];
+  char key[SRVBUFLEN];
+  int key_len;
+  u_int32_t hash;
+  int used;
+
+  rd_kafka_topic_t *rkt;
+  char *buf;
+  u_int32_t len;
+  u_int32_t num;
+};
+
+struct p_kafka_batches {
+  struct p_kafka_batch *slot;
+  int num;
+  u_int32_t size;
+};
+
 struct p_kafka_host {
   char broker[SRVBUFLEN];
   char errstr[PM_KAFKA_ERRSTR_LEN];
@@ -50,6 +81,7 @@ struct p_kafka_host {
   struct p_table_rr topic_rr;
 
   struct p_broker_timers btimers;
+  struct p_kafka_stats stats;
 };
 
 /* prototypes */
@@ -68,6 +100,7 @@ EXT void p_kafka_set_content_type(struct p_kafka_host *, int);
 EXT void p_kafka_set_partition(struct p_kafka_host *, int);
 EXT void p_kafka_set_key(struct p_kafka_host *, char *, int);
 EXT void p_kafka_set_config_file(struct p_kafka_host *, char *);
+EXT void p_kafka_set_compression(struct p_kafka_host *, char *);
 
 EXT char *p_kafka_get_topic(struct p_kafka_host *);
 EXT int p_kafka_get_topic_rr(struct p_kafka_host *);
@@ -94,6 +127,13 @@ EXT int p_kafka_produce_data_to_part(struct p_kafka_host *, void *, u_int32_t, i
 EXT void p_kafka_close(struct p_kafka_host *, int);
 EXT int p_kafka_check_outq_len(struct p_kafka_host *);
 
+EXT void p_kafka_batches_init(struct p_kafka_batches *, int, u_int32_t);
+EXT int p_kafka_batch_add(struct p_kafka_host *, struct p_kafka_batches *, char *, char *, int, char *, u_int32_t);
+EXT int p_kafka_batches_flush(struct p_kafka_host *, struct p_kafka_batches *);
+EXT void p_kafka_batches_free(struct p_kafka_batches *);
+EXT int p_kafka_produce_batch(struct p_kafka_host *, struct p_kafka_batch *);
+
+EXT int write_string_kafka(void *, char *, u_int32_t);
 EXT int write_and_free_json_kafka(void *, void *);
 
 /* global vars */
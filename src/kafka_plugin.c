@@ -332,16 +332,20 @@ void kafka_cache_purge(struct chained_cache *queue[], int index, int safe_action
   struct pkt_data dummy_data;
   pid_t writer_pid = getpid();
 
-  char *json_buf = NULL;
-  int json_buf_off = 0;
+  struct pm_json_buf json_enc;
+  struct p_kafka_batches kafka_batches;
+  int batch_ret = SUCCESS;
 
 #ifdef WITH_AVRO
   avro_writer_t avro_writer;
+  avro_value_iface_t *avro_iface = NULL;
+  avro_value_t avro_value;
   char *avro_buf = NULL;
   int avro_buffer_full = FALSE;
 #endif
 
   p_kafka_init_host(&kafkap_kafka_host, config.kafka_config_file);
+  if (config.kafka_compression) p_kafka_set_compression(&kafkap_kafka_host, config.kafka_compression);
 
   /* setting some defaults */
   if (!config.sql_host) config.sql_host = default_kafka_broker_host;
@@ -373,6 +377,8 @@ void kafka_cache_purge(struct chained_cache *queue[], int index, int safe_action
   memset(empty_pcust, 0, config.cpptrs.len);
   memset(&prim_ptrs, 0, sizeof(prim_ptrs));
   memset(&dummy_data, 0, sizeof(dummy_data));
+  memset(&json_enc, 0, sizeof(json_enc));
+  memset(&kafka_batches, 0, sizeof(kafka_batches));
   memset(tmpbuf, 0, sizeof(tmpbuf));
 
   p_kafka_connect_to_produce(&kafkap_kafka_host);
@@ -431,15 +437,12 @@ void kafka_cache_purge(struct chained_cache *queue[], int index, int safe_action
   }
 
   if (config.message_broker_output & PRINT_OUTPUT_JSON) {
-    if (config.sql_multi_values) {
-      json_buf = malloc(config.sql_multi_values);
+    if (config.sql_multi_values)
+      p_kafka_batches_init(&kafka_batches, PM_KAFKA_BATCH_SLOTS, config.sql_multi_values);
 
-      if (!json_buf) {
-	Log(LOG_ERR, "ERROR ( %s/%s ): malloc() failed (json_buf). Exiting ..\n", config.name, config.type);
-	exit_plugin(1);
-      }
-      else memset(json_buf, 0, config.sql_multi_values);
-    }
+#ifdef WITH_JANSSON
+    pm_json_buf_init(&json_enc, 0);
+#endif
   }
   else if (config.message_broker_output & PRINT_OUTPUT_AVRO) {
 #ifdef WITH_AVRO
@@ -454,12 +457,15 @@ void kafka_cache_purge(struct chained_cache *queue[], int index, int safe_action
     else memset(avro_buf, 0, config.avro_buffer_size);
 
     avro_writer = avro_writer_memory(avro_buf, config.avro_buffer_size);
+
+    /* class and value are built once and reused for all records */
+    avro_iface = avro_generic_class_from_schema(avro_acct_schema);
+    check_i(avro_generic_value_new(avro_iface, &avro_value));
 #endif
   }
 
   for (j = 0; j < index; j++) {
-    void *json_obj;
-    char *json_str;
+    char *json_str = NULL;
 
     if (queue[j]->valid != PRINT_CACHE_COMMITTED) continue;
 
@@ -494,24 +500,25 @@ void kafka_cache_purge(struct chained_cache *queue[], int index, int safe_action
 
     if (config.message_broker_output & PRINT_OUTPUT_JSON) {
 #ifdef WITH_JANSSON
-      json_t *json_obj = json_object();
       int idx;
 
-      for (idx = 0; idx < N_PRIMITIVES && cjhandler[idx]; idx++) cjhandler[idx](json_obj, queue[j]);
-      add_writer_name_and_pid_json(json_obj, config.name, writer_pid);
+      /* serialized in place, json_str is not to be freed */
+      pm_json_buf_begin(&json_enc);
+      for (idx = 0; idx < N_PRIMITIVES && cjhandler[idx]; idx++) cjhandler[idx](&json_enc, queue[j]);
+      pm_json_buf_add_writer_id(&json_enc, config.name, writer_pid);
+      pm_json_buf_end(&json_enc);
 
-      json_str = compose_json_str(json_obj);
+      json_str = json_enc.base;
 #endif
     }
     else if (config.message_broker_output & PRINT_OUTPUT_AVRO) {
 #ifdef WITH_AVRO
-      avro_value_iface_t *avro_iface = avro_generic_class_from_schema(avro_acct_schema);
-      avro_value_t avro_value = compose_avro(config.what_to_count, config.what_to_count_2, queue[j]->flow_type,
-                           &queue[j]->primitives, pbgp, pnat, pmpls, ptun, pcust, pvlen, queue[j]->bytes_counter,
-                           queue[j]->packet_counter, queue[j]->flow_counter, queue[j]->tcp_flags,
-                           &queue[j]->basetime, queue[j]->stitch, avro_iface);
       size_t avro_value_size;
 
+      compose_avro(config.what_to_count, config.what_to_count_2, queue[j]->flow_type,
+                   &queue[j]->primitives, pbgp, pnat, pmpls, ptun, pcust, pvlen, queue[j]->bytes_counter,
+                   queue[j]->packet_counter, queue[j]->flow_counter, queue[j]->tcp_flags,
+                   &queue[j]->basetime, queue[j]->stitch, &avro_value);
       add_writer_name_and_pid_avro(avro_value, config.name, writer_pid);
       avro_value_sizeof(&avro_value, &avro_value_size);
 
@@ -534,77 +541,58 @@ void kafka_cache_purge(struct chained_cache *queue[], int index, int safe_action
       else {
         mv_num++;
       }
-
-      avro_value_decref(&avro_value);
-      avro_value_iface_decref(avro_iface);
 #else
       if (config.debug) Log(LOG_DEBUG, "DEBUG ( %s/%s ): compose_avro(): AVRO object not created due to missing --enable-avro\n", config.name, config.type);
 #endif
     }
 
     if (config.message_broker_output & PRINT_OUTPUT_JSON) {
-      char *tmp_str = NULL;
-
-      if (json_str && config.sql_multi_values) {
-        int json_strlen = (strlen(json_str) ? (strlen(json_str) + 1) : 0);
-
-	if (json_strlen >= (config.sql_multi_values - json_buf_off)) {
-	  if (json_strlen >= config.sql_multi_values) {
-	    Log(LOG_ERR, "ERROR ( %s/%s ): kafka_multi_values not large enough to store JSON elements. Exiting ..\n", config.name, config.type); 
-	    exit(1);
-	  }
-
-	  tmp_str = json_str;
-	  json_str = json_buf;
-	}
-	else {
-	  strcat(json_buf, json_str);
-	  mv_num++;
-
-	  string_add_newline(json_buf);
-	  json_buf_off = strlen(json_buf);
-
-	  free(json_str);
-	  json_str = NULL;
-	}
-      }
-
       if (json_str) {
+        char *batch_topic = NULL, *batch_key = config.kafka_partition_key;
+        int batch_key_len = config.kafka_partition_keylen;
+
         if (is_topic_dyn) {
           prim_ptrs.data = &dummy_data;
           primptrs_set_all_from_chained_cache(&prim_ptrs, queue[j]);
 
 	  handle_dynname_internal_strings(dyn_kafka_topic, SRVBUFLEN, orig_kafka_topic, &prim_ptrs, DYN_STR_KAFKA_TOPIC);
-          p_kafka_set_topic(&kafkap_kafka_host, dyn_kafka_topic);
+	  if (!config.sql_multi_values) p_kafka_set_topic(&kafkap_kafka_host, dyn_kafka_topic);
+	  else batch_topic = dyn_kafka_topic;
         }
 
         if (config.amqp_routing_key_rr) {
           P_handle_table_dyn_rr(dyn_kafka_topic, SRVBUFLEN, orig_kafka_topic, &kafkap_kafka_host.topic_rr);
-          p_kafka_set_topic(&kafkap_kafka_host, dyn_kafka_topic);
+	  if (!config.sql_multi_values) p_kafka_set_topic(&kafkap_kafka_host, dyn_kafka_topic);
+	  else batch_topic = dyn_kafka_topic;
         }
 
         Log(LOG_DEBUG, "DEBUG ( %s/%s ): %s\n\n", config.name, config.type, json_str);
-        ret = p_kafka_produce_data(&kafkap_kafka_host, json_str, strlen(json_str));
 
 	if (config.sql_multi_values) {
-	  json_str = tmp_str;
-	  strcpy(json_buf, json_str);
+	  if ((json_enc.len + 1) >= config.sql_multi_values) {
+	    Log(LOG_ERR, "ERROR ( %s/%s ): kafka_multi_values not large enough to store JSON elements. Exiting ..\n", config.name, config.type); 
+	    exit(1);
+	  }
 
-	  mv_num_save = mv_num;
-	  mv_num = 1;
+	  if (dyn_partition_key) {
+	    batch_key = elem_part_key;
+	    batch_key_len = strlen(elem_part_key);
+	  }
 
-          string_add_newline(json_buf);
-          json_buf_off = strlen(json_buf);
-        }
+	  /* records are batched per destination topic and partition key */
+	  batch_ret = p_kafka_batch_add(&kafkap_kafka_host, &kafka_batches, batch_topic, batch_key, batch_key_len,
+					json_str, json_enc.len);
+	  if (batch_ret == ERR) break;
+	  else qn += batch_ret;
+	}
+	else {
+          ret = p_kafka_produce_data(&kafkap_kafka_host, json_str, json_enc.len);
 
-        free(json_str);
-        json_str = NULL;
+          if (!ret) qn++;
+          else break;
+	}
 
-        if (!ret) {
-          if (!config.sql_multi_values) qn++;
-          else qn += mv_num_save;
-        }
-        else break;
+        json_str = NULL;
       }
     }
     else if (config.message_broker_output & PRINT_OUTPUT_AVRO) {
@@ -638,13 +626,14 @@ void kafka_cache_purge(struct chained_cache *queue[], int index, int safe_action
 
   if (config.sql_multi_values) {
     if (config.message_broker_output & PRINT_OUTPUT_JSON) {
-      if (json_buf && json_buf_off) {
-	/* no handling of dyn routing keys here: not compatible */
-	Log(LOG_DEBUG, "DEBUG ( %s/%s ): %s\n\n", config.name, config.type, json_buf);
-	ret = p_kafka_produce_data(&kafkap_kafka_host, json_buf, strlen(json_buf));
-
-	if (!ret) qn += mv_num;
+      if (batch_ret != ERR) {
+	batch_ret = p_kafka_batches_flush(&kafkap_kafka_host, &kafka_batches);
+	if (batch_ret != ERR) qn += batch_ret;
       }
+
+      /* topic handles of the batches go before the producer is closed */
+      p_kafka_batches_free(&kafka_batches);
+      if (batch_ret == ERR) p_kafka_close(&kafkap_kafka_host, TRUE);
     }
     else if (config.message_broker_output & PRINT_OUTPUT_AVRO) {
 #ifdef WITH_AVRO
@@ -682,6 +671,16 @@ void kafka_cache_purge(struct chained_cache *queue[], int index, int safe_action
 
   p_kafka_close(&kafkap_kafka_host, FALSE);
 
+  if (kafkap_kafka_host.stats.msgs_delivered || kafkap_kafka_host.stats.msgs_failed) {
+    struct p_kafka_stats *stats = &kafkap_kafka_host.stats;
+
+    Log(LOG_INFO, "INFO ( %s/%s ): Kafka delivery (PID: %u, MSGS: %llu, FAILED: %llu, BYTES: %llu, LAT avg/max: %llu/%llu ms)\n",
+	config.name, config.type, writer_pid, (unsigned long long)stats->msgs_delivered, (unsigned long long)stats->msgs_failed,
+	(unsigned long long)stats->bytes_delivered,
+	(unsigned long long)(stats->latency_num ? ((stats->latency_sum / stats->latency_num) / 1000) : 0),
+	(unsigned long long)(stats->latency_max / 1000));
+  }
+
   Log(LOG_INFO, "INFO ( %s/%s ): *** Purging cache - END (PID: %u, QN: %u/%u, ET: %u) ***\n",
 		config.name, config.type, writer_pid, qn, saved_index, duration);
 
@@ -689,9 +688,14 @@ void kafka_cache_purge(struct chained_cache *queue[], int index, int safe_action
 
   if (empty_pcust) free(empty_pcust);
 
-  if (json_buf) free(json_buf);
+  if (json_enc.base) free(json_enc.base);
 
 #ifdef WITH_AVRO
+  if (avro_iface) {
+    avro_value_decref(&avro_value);
+    avro_value_iface_decref(avro_iface);
+  }
+
   if (avro_buf) free(avro_buf);
 #endif
 }
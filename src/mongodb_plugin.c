@@ -23,6 +23,7 @@
 
 /* includes */
 #include "pmacct.h"
+#include "addr.h"
 #include "pmacct-data.h"
 #include "plugin_hooks.h"
 #include "plugin_common.h"
@@ -94,6 +95,8 @@ void mongodb_plugin(int pipe_fd, struct configuration *cfgptr, void *ptr)
   if (!config.mongo_insert_batch)
     config.mongo_insert_batch = DEFAULT_MONGO_INSERT_BATCH;
 
+  MongoDB_compose_bson(config.what_to_count, config.what_to_count_2);
+
   timeout = config.sql_refresh_time*1000;
 
   /* setting function pointers */
@@ -276,31 +279,25 @@ void mongodb_plugin(int pipe_fd, struct configuration *cfgptr, void *ptr)
 
 void MongoDB_cache_purge(struct chained_cache *queue[], int index, int safe_action)
 {
-  struct pkt_primitives *data = NULL;
-  struct pkt_bgp_primitives *pbgp = NULL;
-  struct pkt_nat_primitives *pnat = NULL;
-  struct pkt_mpls_primitives *pmpls = NULL;
-  struct pkt_tunnel_primitives *ptun = NULL;
-  char *pcust = NULL;
-  struct pkt_vlen_hdr_primitives *pvlen = NULL;
   struct pkt_bgp_primitives empty_pbgp;
   struct pkt_nat_primitives empty_pnat;
   struct pkt_mpls_primitives empty_pmpls;
   struct pkt_tunnel_primitives empty_ptun;
+  struct chained_cache cc_elem;
   char *empty_pcust = NULL;
-  char src_mac[18], dst_mac[18], src_host[INET6_ADDRSTRLEN], dst_host[INET6_ADDRSTRLEN], ip_address[INET6_ADDRSTRLEN];
-  char rd_str[SRVBUFLEN], misc_str[SRVBUFLEN], tmpbuf[SRVBUFLEN], mongo_database[SRVBUFLEN];
-  char *str_ptr, *as_path, *bgp_comm, default_table[] = "test.acct", ndpi_class[SUPERSHORTBUFLEN];
+  char tmpbuf[SRVBUFLEN], mongo_database[SRVBUFLEN];
+  char default_table[] = "test.acct";
   char default_user[] = "pmacct", default_passwd[] = "arealsmartpwd";
-  int qn = 0, i, j, stop, db_status, batch_idx, go_to_pending, saved_index = index;
+  int qn = 0, idx, j, stop, db_status, batch_idx, batch_max, go_to_pending, saved_index = index;
+  int batch_size = 0, elem_size, elem_size_hint = MONGO_BSON_INIT_SIZE;
   time_t stamp, start, duration;
   char current_table[SRVBUFLEN], elem_table[SRVBUFLEN];
   struct primitives_ptrs prim_ptrs;
   struct pkt_data dummy_data;
   pid_t writer_pid = getpid();
 
-  const bson **bson_batch;
-  bson *bson_elem;
+  const bson **bson_batch, *bson_swap;
+  bson *bson_elems, *bson_elem;
 
   if (!index) {
     Log(LOG_INFO, "INFO ( %s/%s ): *** Purging cache - START (PID: %u) ***\n", config.name, config.type, writer_pid);
@@ -364,12 +361,16 @@ void MongoDB_cache_purge(struct chained_cache *queue[], int index, int safe_acti
     dyn_table_time_only = FALSE;
   }
 
-  bson_batch = (bson **) malloc(sizeof(bson *) * index);
-  if (!bson_batch) {
+  batch_max = MIN(index, config.mongo_insert_batch);
+  bson_elems = (bson *) malloc(sizeof(bson) * batch_max);
+  bson_batch = (const bson **) malloc(sizeof(bson *) * batch_max);
+  if (!bson_elems || !bson_batch) {
     Log(LOG_ERR, "ERROR ( %s/%s ): malloc() failed: bson_batch\n", config.name, config.type);
     return;
   }
 
+  for (idx = 0; idx < batch_max; idx++) bson_batch[idx] = &bson_elems[idx];
+
   /* If there is any signs of auth in the config, then try to auth */
   if (config.sql_user || config.sql_passwd) {
     if (!config.sql_user) config.sql_user = default_user;
@@ -430,483 +431,71 @@ void MongoDB_cache_purge(struct chained_cache *queue[], int index, int safe_acti
     }
 
     if (!go_to_pending) {
-      bson_elem = (bson *) malloc(sizeof(bson));
-      if (!bson_elem) {
-        Log(LOG_ERR, "ERROR ( %s/%s ): malloc() failed: bson_elem (elem# %u batch# %u\n", config.name, config.type, j, batch_idx);
-        return;
-      }
-
-      bson_init(bson_elem);
-      bson_append_new_oid(bson_elem, "_id" );
-
-      data = &queue[j]->primitives;
-      if (queue[j]->pbgp) pbgp = queue[j]->pbgp;
-      else pbgp = &empty_pbgp;
-
-      if (queue[j]->pnat) pnat = queue[j]->pnat;
-      else pnat = &empty_pnat;
-  
-      if (queue[j]->pmpls) pmpls = queue[j]->pmpls;
-      else pmpls = &empty_pmpls;
-
-      if (queue[j]->ptun) ptun = queue[j]->ptun;
-      else ptun = &empty_ptun;
-  
-      if (queue[j]->pcust) pcust = queue[j]->pcust;
-      else pcust = empty_pcust;
-
-      if (queue[j]->pvlen) pvlen = queue[j]->pvlen;
-      else pvlen = NULL;
-  
-      if (queue[j]->valid == PRINT_CACHE_FREE) continue;
-  
-      if (config.what_to_count & COUNT_TAG) bson_append_long(bson_elem, "tag", data->tag);
-      if (config.what_to_count & COUNT_TAG2) bson_append_long(bson_elem, "tag2", data->tag2);
-      if (config.what_to_count_2 & COUNT_LABEL) MongoDB_append_string(bson_elem, "label", pvlen, COUNT_INT_LABEL); 
-
-      if (config.what_to_count & COUNT_CLASS) bson_append_string(bson_elem, "class", ((data->class && class[(data->class)-1].id) ? class[(data->class)-1].protocol : "unknown" ));
-
-  #if defined (WITH_NDPI)
-      if (config.what_to_count_2 & COUNT_NDPI_CLASS) {
-	snprintf(ndpi_class, SUPERSHORTBUFLEN, "%s/%s",
-		ndpi_get_proto_name(pm_ndpi_wfl->ndpi_struct, data->ndpi_class.master_protocol),
-		ndpi_get_proto_name(pm_ndpi_wfl->ndpi_struct, data->ndpi_class.app_protocol));
-
-	bson_append_string(bson_elem, "class", ndpi_class);
-      }
-  #endif
-
-  #if defined (HAVE_L2)
-      if (config.what_to_count & (COUNT_SRC_MAC|COUNT_SUM_MAC)) {
-        etheraddr_string(data->eth_shost, src_mac);
-        bson_append_string(bson_elem, "mac_src", src_mac);
-      }
-      if (config.what_to_count & COUNT_DST_MAC) {
-        etheraddr_string(data->eth_dhost, dst_mac);
-        bson_append_string(bson_elem, "mac_dst", dst_mac);
-      }
-  
-      if (config.what_to_count & COUNT_VLAN) bson_append_int(bson_elem, "vlan_id", data->vlan_id);
-      if (config.what_to_count & COUNT_COS) bson_append_int(bson_elem, "cos", data->cos);
-      if (config.what_to_count & COUNT_ETHERTYPE) {
-        sprintf(misc_str, "%x", data->etype); 
-        bson_append_string(bson_elem, "etype", misc_str);
-      }
-  #endif
-      if (config.what_to_count & (COUNT_SRC_AS|COUNT_SUM_AS)) bson_append_int(bson_elem, "as_src", data->src_as);
-      if (config.what_to_count & COUNT_DST_AS) bson_append_int(bson_elem, "as_dst", data->dst_as);
-  
-      if (config.what_to_count & COUNT_STD_COMM) {
-        vlen_prims_get(pvlen, COUNT_INT_STD_COMM, &str_ptr);
-        if (str_ptr) {
-          bgp_comm = str_ptr;
-          while (bgp_comm) {
-            bgp_comm = strchr(str_ptr, ' ');
-            if (bgp_comm) *bgp_comm = '_';
-          }
-        }
-
-        MongoDB_append_string(bson_elem, "comms", pvlen, COUNT_INT_STD_COMM);
-      }
-
-      if (config.what_to_count & COUNT_EXT_COMM) {
-        vlen_prims_get(pvlen, COUNT_INT_EXT_COMM, &str_ptr);
-        if (str_ptr) {
-          bgp_comm = str_ptr;
-          while (bgp_comm) {
-            bgp_comm = strchr(str_ptr, ' ');
-            if (bgp_comm) *bgp_comm = '_';
-          }
-        }
-
-	MongoDB_append_string(bson_elem, "ecomms", pvlen, COUNT_INT_EXT_COMM);
-      }
-
-      if (config.what_to_count_2 & COUNT_LRG_COMM) {
-        vlen_prims_get(pvlen, COUNT_INT_LRG_COMM, &str_ptr);
-        if (str_ptr) {
-          bgp_comm = str_ptr;
-          while (bgp_comm) {
-            bgp_comm = strchr(str_ptr, ' ');
-            if (bgp_comm) *bgp_comm = '_';
-          }
-        }
-
-        MongoDB_append_string(bson_elem, "lcomms", pvlen, COUNT_INT_LRG_COMM);
-      }
-  
-      if (config.what_to_count & COUNT_AS_PATH) {
-	vlen_prims_get(pvlen, COUNT_INT_AS_PATH, &str_ptr);
-	if (str_ptr) {
-	  as_path = str_ptr;
-	  while (as_path) {
-	    as_path = strchr(str_ptr, ' ');
-	    if (as_path) *as_path = '_';
-	  }
-	}
-
-	MongoDB_append_string(bson_elem, "as_path", pvlen, COUNT_INT_AS_PATH);
-      }
-  
-      if (config.what_to_count & COUNT_LOCAL_PREF) bson_append_int(bson_elem, "local_pref", pbgp->local_pref);
-      if (config.what_to_count & COUNT_MED) bson_append_int(bson_elem, "med", pbgp->med);
-      if (config.what_to_count & COUNT_PEER_SRC_AS) bson_append_int(bson_elem, "peer_as_src", pbgp->peer_src_as);
-      if (config.what_to_count & COUNT_PEER_DST_AS) bson_append_int(bson_elem, "peer_as_dst", pbgp->peer_dst_as);
-  
-      if (config.what_to_count & COUNT_PEER_SRC_IP) {
-        addr_to_str(ip_address, &pbgp->peer_src_ip);
-        bson_append_string(bson_elem, "peer_ip_src", ip_address);
-      }
-      if (config.what_to_count & COUNT_PEER_DST_IP) {
-        addr_to_str(ip_address, &pbgp->peer_dst_ip);
-        bson_append_string(bson_elem, "peer_ip_dst", ip_address);
-      }
-
-      if (config.what_to_count & COUNT_SRC_STD_COMM) {
-        vlen_prims_get(pvlen, COUNT_INT_SRC_STD_COMM, &str_ptr);
-        if (str_ptr) {
-          bgp_comm = str_ptr;
-          while (bgp_comm) {
-            bgp_comm = strchr(str_ptr, ' ');
-            if (bgp_comm) *bgp_comm = '_';
-          }
-        }
-
-        MongoDB_append_string(bson_elem, "src_comms", pvlen, COUNT_INT_SRC_STD_COMM);
-      }
-
-      if (config.what_to_count & COUNT_SRC_EXT_COMM) {
-        vlen_prims_get(pvlen, COUNT_INT_SRC_EXT_COMM, &str_ptr);
-        if (str_ptr) {
-          bgp_comm = str_ptr;
-          while (bgp_comm) {
-            bgp_comm = strchr(str_ptr, ' ');
-            if (bgp_comm) *bgp_comm = '_';
-          }
-        }
-
-        MongoDB_append_string(bson_elem, "src_ecomms", pvlen, COUNT_INT_SRC_EXT_COMM);
-      }
-
-      if (config.what_to_count_2 & COUNT_SRC_LRG_COMM) {
-        vlen_prims_get(pvlen, COUNT_INT_SRC_LRG_COMM, &str_ptr);
-        if (str_ptr) {
-          bgp_comm = str_ptr;
-          while (bgp_comm) {
-            bgp_comm = strchr(str_ptr, ' ');
-            if (bgp_comm) *bgp_comm = '_';
-          }
-        }
-
-        MongoDB_append_string(bson_elem, "src_lcomms", pvlen, COUNT_INT_SRC_LRG_COMM);
-      }
-
-      if (config.what_to_count & COUNT_SRC_AS_PATH) {
-        vlen_prims_get(pvlen, COUNT_INT_SRC_AS_PATH, &str_ptr);
-        if (str_ptr) {
-          as_path = str_ptr;
-          while (as_path) {
-            as_path = strchr(str_ptr, ' ');
-            if (as_path) *as_path = '_';
-          }
-        }
-
-        MongoDB_append_string(bson_elem, "src_as_path", pvlen, COUNT_INT_SRC_AS_PATH);
-      }
-
-      if (config.what_to_count & COUNT_LOCAL_PREF) bson_append_int(bson_elem, "src_local_pref", pbgp->src_local_pref);
-      if (config.what_to_count & COUNT_MED) bson_append_int(bson_elem, "src_med", pbgp->src_med);
-  
-      if (config.what_to_count & COUNT_IN_IFACE) bson_append_int(bson_elem, "iface_in", data->ifindex_in);
-      if (config.what_to_count & COUNT_OUT_IFACE) bson_append_int(bson_elem, "iface_out", data->ifindex_out);
-  
-      if (config.what_to_count & COUNT_MPLS_VPN_RD) {
-        bgp_rd2str(rd_str, &pbgp->mpls_vpn_rd);
-        bson_append_string(bson_elem, "mpls_vpn_rd", rd_str);
-      }
-  
-      if (config.what_to_count & (COUNT_SRC_HOST|COUNT_SUM_HOST)) {
-        addr_to_str(src_host, &data->src_ip);
-        bson_append_string(bson_elem, "ip_src", src_host);
-      }
-
-      if (config.what_to_count & (COUNT_SRC_NET|COUNT_SUM_NET)) {
-        addr_to_str(src_host, &data->src_net);
-        bson_append_string(bson_elem, "net_src", src_host);
-      }
-
-      if (config.what_to_count & COUNT_DST_HOST) {
-        addr_to_str(dst_host, &data->dst_ip);
-        bson_append_string(bson_elem, "ip_dst", dst_host);
-      }
-
-      if (config.what_to_count & COUNT_DST_NET) {
-        addr_to_str(dst_host, &data->dst_net);
-        bson_append_string(bson_elem, "net_dst", dst_host);
-      }
-  
-      if (config.what_to_count & COUNT_SRC_NMASK) bson_append_int(bson_elem, "mask_src", data->src_nmask);
-      if (config.what_to_count & COUNT_DST_NMASK) bson_append_int(bson_elem, "mask_dst", data->dst_nmask);
-      if (config.what_to_count & (COUNT_SRC_PORT|COUNT_SUM_PORT)) bson_append_int(bson_elem, "port_src", data->src_port);
-      if (config.what_to_count & COUNT_DST_PORT) bson_append_int(bson_elem, "port_dst", data->dst_port);
-
-  #if defined (WITH_GEOIP)
-      if (config.what_to_count_2 & COUNT_SRC_HOST_COUNTRY) {
-        if (data->src_ip_country.id > 0)
-  	  bson_append_string(bson_elem, "country_ip_src", GeoIP_code_by_id(data->src_ip_country.id));
-        else
-  	  bson_append_null(bson_elem, "country_ip_src");
-      }
-      if (config.what_to_count_2 & COUNT_DST_HOST_COUNTRY) {
-        if (data->dst_ip_country.id > 0)
-  	  bson_append_string(bson_elem, "country_ip_dst", GeoIP_code_by_id(data->dst_ip_country.id));
-        else
-  	  bson_append_null(bson_elem, "country_ip_dst");
-      }
-  #endif
-  #if defined (WITH_GEOIPV2)
-      if (config.what_to_count_2 & COUNT_SRC_HOST_COUNTRY) {
-        if (strlen(data->src_ip_country.str))
-          bson_append_string(bson_elem, "country_ip_src", data->src_ip_country.str);
-        else
-          bson_append_null(bson_elem, "country_ip_src");
-      }
-      if (config.what_to_count_2 & COUNT_DST_HOST_COUNTRY) {
-        if (strlen(data->dst_ip_country.str))
-          bson_append_string(bson_elem, "country_ip_dst", data->dst_ip_country.str);
-        else
-          bson_append_null(bson_elem, "country_ip_dst");
-      }
+      memcpy(&cc_elem, queue[j], sizeof(struct chained_cache));
+      if (!cc_elem.pbgp) cc_elem.pbgp = &empty_pbgp;
+      if (!cc_elem.pnat) cc_elem.pnat = &empty_pnat;
+      if (!cc_elem.pmpls) cc_elem.pmpls = &empty_pmpls;
+      if (!cc_elem.ptun) cc_elem.ptun = &empty_ptun;
+      if (!cc_elem.pcust) cc_elem.pcust = empty_pcust;
 
-      if (config.what_to_count_2 & COUNT_SRC_HOST_POCODE) {
-        if (strlen(data->src_ip_pocode.str))
-          bson_append_string(bson_elem, "pocode_ip_src", data->src_ip_pocode.str);
-        else
-          bson_append_null(bson_elem, "pocode_ip_src");
-      }
-      if (config.what_to_count_2 & COUNT_DST_HOST_POCODE) {
-        if (strlen(data->dst_ip_pocode.str))
-          bson_append_string(bson_elem, "pocode_ip_dst", data->dst_ip_pocode.str);
-        else
-          bson_append_null(bson_elem, "pocode_ip_dst");
-      }
-  #endif
+      /* documents of a purge have similar sizes: pre-size the buffer
+	 after the largest seen so far to avoid re-allocations */
+      bson_elem = (bson *) bson_batch[batch_idx];
+      bson_init_size(bson_elem, elem_size_hint);
+      bson_append_new_oid(bson_elem, "_id");
 
-      if (config.what_to_count & COUNT_TCPFLAGS) {
-        sprintf(misc_str, "%u", queue[j]->tcp_flags);
-        bson_append_string(bson_elem, "tcp_flags", misc_str);
-      }
-  
-      if (config.what_to_count & COUNT_IP_PROTO) {
-        if (!config.num_protos && (data->proto < protocols_number))
-	  bson_append_string(bson_elem, "ip_proto", _protocols[data->proto].name);
-        else {
-          sprintf(misc_str, "%u", data->proto);
-          bson_append_string(bson_elem, "ip_proto", misc_str);
-        }
-      }
-  
-      if (config.what_to_count & COUNT_IP_TOS) bson_append_int(bson_elem, "tos", data->tos);
-      if (config.what_to_count_2 & COUNT_SAMPLING_RATE) bson_append_int(bson_elem, "sampling_rate", data->sampling_rate);
-  
-      if (config.what_to_count_2 & COUNT_POST_NAT_SRC_HOST) {
-        addr_to_str(src_host, &pnat->post_nat_src_ip);
-        bson_append_string(bson_elem, "post_nat_ip_src", src_host);
-      }
-      if (config.what_to_count_2 & COUNT_POST_NAT_DST_HOST) {
-        addr_to_str(dst_host, &pnat->post_nat_dst_ip);
-        bson_append_string(bson_elem, "post_nat_ip_dst", dst_host);
-      }
-      if (config.what_to_count_2 & COUNT_POST_NAT_SRC_PORT) bson_append_int(bson_elem, "post_nat_port_src", pnat->post_nat_src_port);
-      if (config.what_to_count_2 & COUNT_POST_NAT_DST_PORT) bson_append_int(bson_elem, "post_nat_port_dst", pnat->post_nat_dst_port);
-      if (config.what_to_count_2 & COUNT_NAT_EVENT) bson_append_int(bson_elem, "nat_event", pnat->nat_event);
-      if (config.what_to_count_2 & COUNT_MPLS_LABEL_TOP) bson_append_int(bson_elem, "mpls_label_top", pmpls->mpls_label_top);
-      if (config.what_to_count_2 & COUNT_MPLS_LABEL_BOTTOM) bson_append_int(bson_elem, "mpls_label_bottom", pmpls->mpls_label_bottom);
-      if (config.what_to_count_2 & COUNT_MPLS_STACK_DEPTH) bson_append_int(bson_elem, "mpls_stack_depth", pmpls->mpls_stack_depth);
-
-      if (config.what_to_count_2 & COUNT_TUNNEL_SRC_HOST) {
-        addr_to_str(src_host, &ptun->tunnel_src_ip);
-        bson_append_string(bson_elem, "tunnel_ip_src", src_host);
-      }
-      if (config.what_to_count_2 & COUNT_TUNNEL_DST_HOST) {
-        addr_to_str(dst_host, &ptun->tunnel_dst_ip);
-        bson_append_string(bson_elem, "tunnel_ip_dst", dst_host);
-      }
-      if (config.what_to_count_2 & COUNT_TUNNEL_IP_PROTO) {
-        if (!config.num_protos && (ptun->tunnel_proto < protocols_number))
-	  bson_append_string(bson_elem, "tunnel_ip_proto", _protocols[ptun->tunnel_proto].name);
-        else {
-          sprintf(misc_str, "%u", ptun->tunnel_proto);
-          bson_append_string(bson_elem, "tunnel_ip_proto", misc_str);
-        }
-      }
-      if (config.what_to_count_2 & COUNT_TUNNEL_IP_TOS) bson_append_int(bson_elem, "tunnel_tos", ptun->tunnel_tos);
-  
-      if (config.what_to_count_2 & COUNT_TIMESTAMP_START) {
-	if (config.timestamps_since_epoch) {
-	  char tstamp_str[SRVBUFLEN];
-
-	  compose_timestamp(tstamp_str, SRVBUFLEN, &pnat->timestamp_start, TRUE,
-			    config.timestamps_since_epoch, config.timestamps_rfc3339,
-			    config.timestamps_utc);
-	  bson_append_string(bson_elem, "timestamp_start", tstamp_str);
-	}
-	else {
-          bson_date_t bdate;
-  
-	  bdate = 1000*pnat->timestamp_start.tv_sec;
-	  if (pnat->timestamp_start.tv_usec) bdate += (pnat->timestamp_start.tv_usec/1000);
+      for (idx = 0; idx < N_PRIMITIVES && mbhandler[idx]; idx++) mbhandler[idx](bson_elem, &cc_elem);
 
-	  bson_append_date(bson_elem, "timestamp_start", bdate);
-	}
-      }
-      if (config.what_to_count_2 & COUNT_TIMESTAMP_END) {
-        if (config.timestamps_since_epoch) {
-          char tstamp_str[SRVBUFLEN];
-
-          compose_timestamp(tstamp_str, SRVBUFLEN, &pnat->timestamp_end, TRUE,
-			    config.timestamps_since_epoch, config.timestamps_rfc3339,
-			    config.timestamps_utc);
-          bson_append_string(bson_elem, "timestamp_end", tstamp_str);
-        }
-        else {
-          bson_date_t bdate;
+      bson_finish(bson_elem);
+      if (config.debug) bson_print(bson_elem);
 
-          bdate = 1000*pnat->timestamp_end.tv_sec;
-          if (pnat->timestamp_end.tv_usec) bdate += (pnat->timestamp_end.tv_usec/1000);
+      elem_size = bson_size(bson_elem);
+      if (elem_size > elem_size_hint) elem_size_hint = elem_size;
 
-          bson_append_date(bson_elem, "timestamp_end", bdate);
+      /* a batch can't exceed the server max BSON size: ship what we have
+	 and rotate the current document on top of the next batch; bson
+	 structs may point into themselves, hence never copy them around */
+      if (batch_idx && (batch_size + elem_size) > db_conn.max_bson_size) {
+	db_status = MongoDB_insert_batch(dyn_table ? current_table : config.sql_table, bson_batch, batch_idx);
+	if (db_status != MONGO_OK) {
+	  Log(LOG_ERR, "ERROR ( %s/%s ): Unable to insert all elements in batch.\n", config.name, config.type);
+	  Log(LOG_ERR, "ERROR ( %s/%s ): Server error: %s. (PID: %u, QN: %u/%u)\n", config.name, config.type, db_conn.lasterrstr, writer_pid, qn, saved_index);
 	}
-      }
-      if (config.what_to_count_2 & COUNT_TIMESTAMP_ARRIVAL) {
-        if (config.timestamps_since_epoch) {
-          char tstamp_str[SRVBUFLEN];
-
-          compose_timestamp(tstamp_str, SRVBUFLEN, &pnat->timestamp_arrival, TRUE,
-			    config.timestamps_since_epoch, config.timestamps_rfc3339,
-			    config.timestamps_utc);
-          bson_append_string(bson_elem, "timestamp_arrival", tstamp_str);
-        }
-        else {
-          bson_date_t bdate;
 
-          bdate = 1000*pnat->timestamp_arrival.tv_sec;
-          if (pnat->timestamp_arrival.tv_usec) bdate += (pnat->timestamp_arrival.tv_usec/1000);
-
-          bson_append_date(bson_elem, "timestamp_arrival", bdate);
-        }
-      }
-
-      if (config.nfacctd_stitching && queue[j]->stitch) {
-        if (config.timestamps_since_epoch) {
-          char tstamp_str[SRVBUFLEN];
-
-          compose_timestamp(tstamp_str, SRVBUFLEN, &queue[j]->stitch->timestamp_min, TRUE,
-			    config.timestamps_since_epoch, config.timestamps_rfc3339,
-			    config.timestamps_utc);
-          bson_append_string(bson_elem, "timestamp_min", tstamp_str);
-
-          compose_timestamp(tstamp_str, SRVBUFLEN, &queue[j]->stitch->timestamp_max, TRUE,
-			    config.timestamps_since_epoch, config.timestamps_rfc3339,
-			    config.timestamps_utc);
-          bson_append_string(bson_elem, "timestamp_max", tstamp_str);
-        }
-	else {
-          bson_date_t bdate_min, bdate_max;
-
-          bdate_min = 1000*queue[j]->stitch->timestamp_min.tv_sec;
-          if (queue[j]->stitch->timestamp_min.tv_usec) bdate_min += (queue[j]->stitch->timestamp_min.tv_usec/1000);
-          bson_append_date(bson_elem, "timestamp_min", bdate_min);
-
-          bdate_max = 1000*queue[j]->stitch->timestamp_max.tv_sec;
-          if (queue[j]->stitch->timestamp_max.tv_usec) bdate_max += (queue[j]->stitch->timestamp_max.tv_usec/1000);
-          bson_append_date(bson_elem, "timestamp_max", bdate_max);
-	}
+	bson_swap = bson_batch[0];
+	bson_batch[0] = bson_batch[batch_idx];
+	bson_batch[batch_idx] = bson_swap;
+	batch_idx = 0;
+	batch_size = 0;
       }
 
-      if (config.what_to_count_2 & COUNT_EXPORT_PROTO_SEQNO) bson_append_int(bson_elem, "export_proto_seqno", data->export_proto_seqno);
-      if (config.what_to_count_2 & COUNT_EXPORT_PROTO_VERSION) bson_append_int(bson_elem, "export_proto_version", data->export_proto_version);
-  
-      /* all custom primitives printed here */
-      {
-        int cp_idx;
-  
-        for (cp_idx = 0; cp_idx < config.cpptrs.num; cp_idx++) {
-	  if (config.cpptrs.primitive[cp_idx].ptr->len != PM_VARIABLE_LENGTH) {
-	    char cp_str[SRVBUFLEN];
-
-	    custom_primitive_value_print(cp_str, SRVBUFLEN, pcust, &config.cpptrs.primitive[cp_idx], FALSE);
-	    bson_append_string(bson_elem, config.cpptrs.primitive[cp_idx].name, cp_str);
-	  }
-	  else {
-	    char *label_ptr = NULL;
-
-	    vlen_prims_get(pvlen, config.cpptrs.primitive[cp_idx].ptr->type, &label_ptr);
-	    if (!label_ptr) bson_append_null(bson_elem, config.cpptrs.primitive[cp_idx].name);
-	    else bson_append_string(bson_elem, config.cpptrs.primitive[cp_idx].name, label_ptr);
-	  }
-        }
-      }
-  
-      if (config.sql_history) {
-        bson_append_date(bson_elem, "stamp_inserted", (bson_date_t) 1000*queue[j]->basetime.tv_sec);
-        bson_append_date(bson_elem, "stamp_updated", (bson_date_t) 1000*time(NULL));
-      }
-  
-      if (queue[j]->flow_type != NF9_FTYPE_EVENT && queue[j]->flow_type != NF9_FTYPE_OPTION) {
-  #if defined HAVE_64BIT_COUNTERS
-        bson_append_long(bson_elem, "packets", queue[j]->packet_counter);
-        if (config.what_to_count & COUNT_FLOWS) bson_append_long(bson_elem, "flows", queue[j]->flow_counter);
-        bson_append_long(bson_elem, "bytes", queue[j]->bytes_counter);
-  #else
-        bson_append_int(bson_elem, "packets", queue[j]->packet_counter);
-        if (config.what_to_count & COUNT_FLOWS) bson_append_int(bson_elem, "flows", queue[j]->flow_counter);
-        bson_append_int(bson_elem, "bytes", queue[j]->bytes_counter);
-  #endif
-      }
-  
-      bson_finish(bson_elem);
-      bson_batch[batch_idx] = bson_elem;
       batch_idx++;
+      batch_size += elem_size;
       qn++;
-  
-      if (config.debug) bson_print(bson_elem);
-  
-      if (batch_idx == config.mongo_insert_batch) {
-	if (dyn_table) db_status = mongo_insert_batch(&db_conn, current_table, bson_batch, batch_idx, NULL, MONGO_CONTINUE_ON_ERROR);
-	else db_status = mongo_insert_batch(&db_conn, config.sql_table, bson_batch, batch_idx, NULL, MONGO_CONTINUE_ON_ERROR);
+
+      if (batch_idx == batch_max) {
+	db_status = MongoDB_insert_batch(dyn_table ? current_table : config.sql_table, bson_batch, batch_idx);
 	if (db_status != MONGO_OK) {
-   	  Log(LOG_ERR, "ERROR ( %s/%s ): Unable to insert all elements in batch: try a smaller mongo_insert_batch value.\n", config.name, config.type);
+	  Log(LOG_ERR, "ERROR ( %s/%s ): Unable to insert all elements in batch.\n", config.name, config.type);
 	  Log(LOG_ERR, "ERROR ( %s/%s ): Server error: %s. (PID: %u, QN: %u/%u)\n", config.name, config.type, db_conn.lasterrstr, writer_pid, qn, saved_index);
 	}
-  
-        for (i = 0; i < batch_idx; i++) {
-          bson_elem = (bson *) bson_batch[i];
-          bson_destroy(bson_elem);
-          free(bson_elem);
-        }
-  
+
         batch_idx = 0;
+	batch_size = 0;
       }
     }
   }
 
   /* last round on the lollipop */
   if (batch_idx) {
-    if (dyn_table) db_status = mongo_insert_batch(&db_conn, current_table, bson_batch, batch_idx, NULL, MONGO_CONTINUE_ON_ERROR);
-    else db_status = mongo_insert_batch(&db_conn, config.sql_table, bson_batch, batch_idx, NULL, MONGO_CONTINUE_ON_ERROR);
+    db_status = MongoDB_insert_batch(dyn_table ? current_table : config.sql_table, bson_batch, batch_idx);
     if (db_status != MONGO_OK) {
-      Log(LOG_ERR, "ERROR ( %s/%s ): Unable to insert all elements in batch: try a smaller mongo_insert_batch value.\n", config.name, config.type);
+      Log(LOG_ERR, "ERROR ( %s/%s ): Unable to insert all elements in batch.\n", config.name, config.type);
       Log(LOG_ERR, "ERROR ( %s/%s ): Server error: %s. (PID: %u, QN: %u/%u)\n", config.name, config.type, db_conn.lasterrstr, writer_pid, qn, saved_index);
     }
 
-    for (i = 0; i < batch_idx; i++) {
-      bson_elem = (bson *) bson_batch[i];
-      bson_destroy(bson_elem);
-      free(bson_elem);
-    }
-
     batch_idx = 0;
+    batch_size = 0;
   }
 
   /* If we have pending queries then start again */
@@ -919,6 +508,8 @@ void MongoDB_cache_purge(struct chained_cache *queue[], int index, int safe_acti
   if (config.sql_trigger_exec && !safe_action) P_trigger_exec(config.sql_trigger_exec); 
 
   if (empty_pcust) free(empty_pcust);
+  free(bson_elems);
+  free(bson_batch);
 }
 
 int MongoDB_get_database(char *db, int dblen, char *db_table)
@@ -986,3 +577,853 @@ int MongoDB_oid_fuzz()
 
   return rand();
 }
+
+void MongoDB_compose_bson(u_int64_t wtc, u_int64_t wtc_2)
+{
+  int idx = 0;
+
+  Log(LOG_INFO, "INFO ( %s/%s ): BSON: setting object handlers.\n", config.name, config.type);
+
+  memset(&mbhandler, 0, sizeof(mbhandler));
+
+  if (wtc & COUNT_TAG) {
+    mbhandler[idx] = MongoDB_bson_tag;
+    idx++;
+  }
+
+  if (wtc & COUNT_TAG2) {
+    mbhandler[idx] = MongoDB_bson_tag2;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_LABEL) {
+    mbhandler[idx] = MongoDB_bson_label;
+    idx++;
+  }
+
+  if (wtc & COUNT_CLASS) {
+    mbhandler[idx] = MongoDB_bson_class;
+    idx++;
+  }
+
+#if defined (WITH_NDPI)
+  if (wtc_2 & COUNT_NDPI_CLASS) {
+    mbhandler[idx] = MongoDB_bson_ndpi_class;
+    idx++;
+  }
+#endif
+
+#if defined (HAVE_L2)
+  if (wtc & (COUNT_SRC_MAC|COUNT_SUM_MAC)) {
+    mbhandler[idx] = MongoDB_bson_src_mac;
+    idx++;
+  }
+
+  if (wtc & COUNT_DST_MAC) {
+    mbhandler[idx] = MongoDB_bson_dst_mac;
+    idx++;
+  }
+
+  if (wtc & COUNT_VLAN) {
+    mbhandler[idx] = MongoDB_bson_vlan;
+    idx++;
+  }
+
+  if (wtc & COUNT_COS) {
+    mbhandler[idx] = MongoDB_bson_cos;
+    idx++;
+  }
+
+  if (wtc & COUNT_ETHERTYPE) {
+    mbhandler[idx] = MongoDB_bson_etype;
+    idx++;
+  }
+#endif
+
+  if (wtc & (COUNT_SRC_AS|COUNT_SUM_AS)) {
+    mbhandler[idx] = MongoDB_bson_src_as;
+    idx++;
+  }
+
+  if (wtc & COUNT_DST_AS) {
+    mbhandler[idx] = MongoDB_bson_dst_as;
+    idx++;
+  }
+
+  if (wtc & COUNT_STD_COMM) {
+    mbhandler[idx] = MongoDB_bson_std_comm;
+    idx++;
+  }
+
+  if (wtc & COUNT_EXT_COMM) {
+    mbhandler[idx] = MongoDB_bson_ext_comm;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_LRG_COMM) {
+    mbhandler[idx] = MongoDB_bson_lrg_comm;
+    idx++;
+  }
+
+  if (wtc & COUNT_AS_PATH) {
+    mbhandler[idx] = MongoDB_bson_as_path;
+    idx++;
+  }
+
+  if (wtc & COUNT_LOCAL_PREF) {
+    mbhandler[idx] = MongoDB_bson_local_pref;
+    idx++;
+  }
+
+  if (wtc & COUNT_MED) {
+    mbhandler[idx] = MongoDB_bson_med;
+    idx++;
+  }
+
+  if (wtc & COUNT_PEER_SRC_AS) {
+    mbhandler[idx] = MongoDB_bson_peer_src_as;
+    idx++;
+  }
+
+  if (wtc & COUNT_PEER_DST_AS) {
+    mbhandler[idx] = MongoDB_bson_peer_dst_as;
+    idx++;
+  }
+
+  if (wtc & COUNT_PEER_SRC_IP) {
+    mbhandler[idx] = MongoDB_bson_peer_src_ip;
+    idx++;
+  }
+
+  if (wtc & COUNT_PEER_DST_IP) {
+    mbhandler[idx] = MongoDB_bson_peer_dst_ip;
+    idx++;
+  }
+
+  if (wtc & COUNT_SRC_STD_COMM) {
+    mbhandler[idx] = MongoDB_bson_src_std_comm;
+    idx++;
+  }
+
+  if (wtc & COUNT_SRC_EXT_COMM) {
+    mbhandler[idx] = MongoDB_bson_src_ext_comm;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_SRC_LRG_COMM) {
+    mbhandler[idx] = MongoDB_bson_src_lrg_comm;
+    idx++;
+  }
+
+  if (wtc & COUNT_SRC_AS_PATH) {
+    mbhandler[idx] = MongoDB_bson_src_as_path;
+    idx++;
+  }
+
+  if (wtc & COUNT_LOCAL_PREF) {
+    mbhandler[idx] = MongoDB_bson_src_local_pref;
+    idx++;
+  }
+
+  if (wtc & COUNT_MED) {
+    mbhandler[idx] = MongoDB_bson_src_med;
+    idx++;
+  }
+
+  if (wtc & COUNT_IN_IFACE) {
+    mbhandler[idx] = MongoDB_bson_in_iface;
+    idx++;
+  }
+
+  if (wtc & COUNT_OUT_IFACE) {
+    mbhandler[idx] = MongoDB_bson_out_iface;
+    idx++;
+  }
+
+  if (wtc & COUNT_MPLS_VPN_RD) {
+    mbhandler[idx] = MongoDB_bson_mpls_vpn_rd;
+    idx++;
+  }
+
+  if (wtc & (COUNT_SRC_HOST|COUNT_SUM_HOST)) {
+    mbhandler[idx] = MongoDB_bson_src_host;
+    idx++;
+  }
+
+  if (wtc & (COUNT_SRC_NET|COUNT_SUM_NET)) {
+    mbhandler[idx] = MongoDB_bson_src_net;
+    idx++;
+  }
+
+  if (wtc & COUNT_DST_HOST) {
+    mbhandler[idx] = MongoDB_bson_dst_host;
+    idx++;
+  }
+
+  if (wtc & COUNT_DST_NET) {
+    mbhandler[idx] = MongoDB_bson_dst_net;
+    idx++;
+  }
+
+  if (wtc & COUNT_SRC_NMASK) {
+    mbhandler[idx] = MongoDB_bson_src_mask;
+    idx++;
+  }
+
+  if (wtc & COUNT_DST_NMASK) {
+    mbhandler[idx] = MongoDB_bson_dst_mask;
+    idx++;
+  }
+
+  if (wtc & (COUNT_SRC_PORT|COUNT_SUM_PORT)) {
+    mbhandler[idx] = MongoDB_bson_src_port;
+    idx++;
+  }
+
+  if (wtc & COUNT_DST_PORT) {
+    mbhandler[idx] = MongoDB_bson_dst_port;
+    idx++;
+  }
+
+#if defined (WITH_GEOIP) || defined (WITH_GEOIPV2)
+  if (wtc_2 & COUNT_SRC_HOST_COUNTRY) {
+    mbhandler[idx] = MongoDB_bson_src_host_country;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_DST_HOST_COUNTRY) {
+    mbhandler[idx] = MongoDB_bson_dst_host_country;
+    idx++;
+  }
+#endif
+
+#if defined (WITH_GEOIPV2)
+  if (wtc_2 & COUNT_SRC_HOST_POCODE) {
+    mbhandler[idx] = MongoDB_bson_src_host_pocode;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_DST_HOST_POCODE) {
+    mbhandler[idx] = MongoDB_bson_dst_host_pocode;
+    idx++;
+  }
+#endif
+
+  if (wtc & COUNT_TCPFLAGS) {
+    mbhandler[idx] = MongoDB_bson_tcp_flags;
+    idx++;
+  }
+
+  if (wtc & COUNT_IP_PROTO) {
+    mbhandler[idx] = MongoDB_bson_proto;
+    idx++;
+  }
+
+  if (wtc & COUNT_IP_TOS) {
+    mbhandler[idx] = MongoDB_bson_tos;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_SAMPLING_RATE) {
+    mbhandler[idx] = MongoDB_bson_sampling_rate;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_POST_NAT_SRC_HOST) {
+    mbhandler[idx] = MongoDB_bson_post_nat_src_host;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_POST_NAT_DST_HOST) {
+    mbhandler[idx] = MongoDB_bson_post_nat_dst_host;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_POST_NAT_SRC_PORT) {
+    mbhandler[idx] = MongoDB_bson_post_nat_src_port;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_POST_NAT_DST_PORT) {
+    mbhandler[idx] = MongoDB_bson_post_nat_dst_port;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_NAT_EVENT) {
+    mbhandler[idx] = MongoDB_bson_nat_event;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_MPLS_LABEL_TOP) {
+    mbhandler[idx] = MongoDB_bson_mpls_label_top;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_MPLS_LABEL_BOTTOM) {
+    mbhandler[idx] = MongoDB_bson_mpls_label_bottom;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_MPLS_STACK_DEPTH) {
+    mbhandler[idx] = MongoDB_bson_mpls_stack_depth;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_TUNNEL_SRC_HOST) {
+    mbhandler[idx] = MongoDB_bson_tunnel_src_host;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_TUNNEL_DST_HOST) {
+    mbhandler[idx] = MongoDB_bson_tunnel_dst_host;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_TUNNEL_IP_PROTO) {
+    mbhandler[idx] = MongoDB_bson_tunnel_proto;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_TUNNEL_IP_TOS) {
+    mbhandler[idx] = MongoDB_bson_tunnel_tos;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_TIMESTAMP_START) {
+    mbhandler[idx] = MongoDB_bson_timestamp_start;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_TIMESTAMP_END) {
+    mbhandler[idx] = MongoDB_bson_timestamp_end;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_TIMESTAMP_ARRIVAL) {
+    mbhandler[idx] = MongoDB_bson_timestamp_arrival;
+    idx++;
+  }
+
+  if (config.nfacctd_stitching) {
+    mbhandler[idx] = MongoDB_bson_timestamp_stitching;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_EXPORT_PROTO_SEQNO) {
+    mbhandler[idx] = MongoDB_bson_export_proto_seqno;
+    idx++;
+  }
+
+  if (wtc_2 & COUNT_EXPORT_PROTO_VERSION) {
+    mbhandler[idx] = MongoDB_bson_export_proto_version;
+    idx++;
+  }
+
+  if (config.cpptrs.num) {
+    mbhandler[idx] = MongoDB_bson_custom_primitives;
+    idx++;
+  }
+
+  if (config.sql_history) {
+    mbhandler[idx] = MongoDB_bson_history;
+    idx++;
+  }
+
+  mbhandler[idx] = MongoDB_bson_counters;
+}
+
+int MongoDB_insert_batch(const char *table, const bson **batch, int num)
+{
+  int ret, idx;
+
+  ret = mongo_insert_batch(&db_conn, table, batch, num, NULL, MONGO_CONTINUE_ON_ERROR);
+
+  for (idx = 0; idx < num; idx++) bson_destroy((bson *) batch[idx]);
+
+  return ret;
+}
+
+void MongoDB_append_comm(bson *bson_elem, char *name, struct pkt_vlen_hdr_primitives *pvlen, pm_cfgreg_t wtc)
+{
+  char *str_ptr = NULL, *sep;
+
+  vlen_prims_get(pvlen, wtc, &str_ptr);
+  if (str_ptr) {
+    sep = str_ptr;
+    while (sep) {
+      sep = strchr(str_ptr, ' ');
+      if (sep) *sep = '_';
+    }
+  }
+
+  MongoDB_append_string(bson_elem, name, pvlen, wtc);
+}
+
+void MongoDB_append_timestamp(bson *bson_elem, char *name, struct timeval *tv)
+{
+  if (config.timestamps_since_epoch) {
+    char tstamp_str[SRVBUFLEN];
+
+    compose_timestamp(tstamp_str, SRVBUFLEN, tv, TRUE,
+		      config.timestamps_since_epoch, config.timestamps_rfc3339,
+		      config.timestamps_utc);
+    bson_append_string(bson_elem, name, tstamp_str);
+  }
+  else {
+    bson_date_t bdate;
+
+    bdate = 1000*tv->tv_sec;
+    if (tv->tv_usec) bdate += (tv->tv_usec/1000);
+
+    bson_append_date(bson_elem, name, bdate);
+  }
+}
+
+void MongoDB_append_proto(bson *bson_elem, char *name, u_int8_t proto)
+{
+  char misc_str[SUPERSHORTBUFLEN];
+
+  if (!config.num_protos && (proto < protocols_number))
+    bson_append_string(bson_elem, name, _protocols[proto].name);
+  else {
+    snprintf(misc_str, sizeof(misc_str), "%u", proto);
+    bson_append_string(bson_elem, name, misc_str);
+  }
+}
+
+void MongoDB_append_addr(bson *bson_elem, char *name, struct host_addr *addr)
+{
+  char ip_address[INET6_ADDRSTRLEN];
+
+  addr_to_str(ip_address, addr);
+  bson_append_string(bson_elem, name, ip_address);
+}
+
+void MongoDB_bson_tag(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_long(bson_elem, "tag", cc->primitives.tag);
+}
+
+void MongoDB_bson_tag2(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_long(bson_elem, "tag2", cc->primitives.tag2);
+}
+
+void MongoDB_bson_label(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_string(bson_elem, "label", cc->pvlen, COUNT_INT_LABEL);
+}
+
+void MongoDB_bson_class(bson *bson_elem, struct chained_cache *cc)
+{
+  pm_class_t class_id = cc->primitives.class;
+
+  bson_append_string(bson_elem, "class", ((class_id && class[class_id-1].id) ? class[class_id-1].protocol : "unknown"));
+}
+
+#if defined (WITH_NDPI)
+void MongoDB_bson_ndpi_class(bson *bson_elem, struct chained_cache *cc)
+{
+  char ndpi_class[SUPERSHORTBUFLEN];
+
+  snprintf(ndpi_class, SUPERSHORTBUFLEN, "%s/%s",
+	ndpi_get_proto_name(pm_ndpi_wfl->ndpi_struct, cc->primitives.ndpi_class.master_protocol),
+	ndpi_get_proto_name(pm_ndpi_wfl->ndpi_struct, cc->primitives.ndpi_class.app_protocol));
+
+  bson_append_string(bson_elem, "class", ndpi_class);
+}
+#endif
+
+#if defined (HAVE_L2)
+void MongoDB_bson_src_mac(bson *bson_elem, struct chained_cache *cc)
+{
+  char mac[18];
+
+  etheraddr_string(cc->primitives.eth_shost, mac);
+  bson_append_string(bson_elem, "mac_src", mac);
+}
+
+void MongoDB_bson_dst_mac(bson *bson_elem, struct chained_cache *cc)
+{
+  char mac[18];
+
+  etheraddr_string(cc->primitives.eth_dhost, mac);
+  bson_append_string(bson_elem, "mac_dst", mac);
+}
+
+void MongoDB_bson_vlan(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "vlan_id", cc->primitives.vlan_id);
+}
+
+void MongoDB_bson_cos(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "cos", cc->primitives.cos);
+}
+
+void MongoDB_bson_etype(bson *bson_elem, struct chained_cache *cc)
+{
+  char misc_str[SUPERSHORTBUFLEN];
+
+  snprintf(misc_str, sizeof(misc_str), "%x", cc->primitives.etype);
+  bson_append_string(bson_elem, "etype", misc_str);
+}
+#endif
+
+void MongoDB_bson_src_as(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "as_src", cc->primitives.src_as);
+}
+
+void MongoDB_bson_dst_as(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "as_dst", cc->primitives.dst_as);
+}
+
+void MongoDB_bson_std_comm(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_comm(bson_elem, "comms", cc->pvlen, COUNT_INT_STD_COMM);
+}
+
+void MongoDB_bson_ext_comm(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_comm(bson_elem, "ecomms", cc->pvlen, COUNT_INT_EXT_COMM);
+}
+
+void MongoDB_bson_lrg_comm(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_comm(bson_elem, "lcomms", cc->pvlen, COUNT_INT_LRG_COMM);
+}
+
+void MongoDB_bson_as_path(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_comm(bson_elem, "as_path", cc->pvlen, COUNT_INT_AS_PATH);
+}
+
+void MongoDB_bson_local_pref(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "local_pref", cc->pbgp->local_pref);
+}
+
+void MongoDB_bson_med(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "med", cc->pbgp->med);
+}
+
+void MongoDB_bson_peer_src_as(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "peer_as_src", cc->pbgp->peer_src_as);
+}
+
+void MongoDB_bson_peer_dst_as(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "peer_as_dst", cc->pbgp->peer_dst_as);
+}
+
+void MongoDB_bson_peer_src_ip(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_addr(bson_elem, "peer_ip_src", &cc->pbgp->peer_src_ip);
+}
+
+void MongoDB_bson_peer_dst_ip(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_addr(bson_elem, "peer_ip_dst", &cc->pbgp->peer_dst_ip);
+}
+
+void MongoDB_bson_src_std_comm(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_comm(bson_elem, "src_comms", cc->pvlen, COUNT_INT_SRC_STD_COMM);
+}
+
+void MongoDB_bson_src_ext_comm(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_comm(bson_elem, "src_ecomms", cc->pvlen, COUNT_INT_SRC_EXT_COMM);
+}
+
+void MongoDB_bson_src_lrg_comm(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_comm(bson_elem, "src_lcomms", cc->pvlen, COUNT_INT_SRC_LRG_COMM);
+}
+
+void MongoDB_bson_src_as_path(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_comm(bson_elem, "src_as_path", cc->pvlen, COUNT_INT_SRC_AS_PATH);
+}
+
+void MongoDB_bson_src_local_pref(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "src_local_pref", cc->pbgp->src_local_pref);
+}
+
+void MongoDB_bson_src_med(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "src_med", cc->pbgp->src_med);
+}
+
+void MongoDB_bson_in_iface(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "iface_in", cc->primitives.ifindex_in);
+}
+
+void MongoDB_bson_out_iface(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "iface_out", cc->primitives.ifindex_out);
+}
+
+void MongoDB_bson_mpls_vpn_rd(bson *bson_elem, struct chained_cache *cc)
+{
+  char rd_str[SRVBUFLEN];
+
+  bgp_rd2str(rd_str, &cc->pbgp->mpls_vpn_rd);
+  bson_append_string(bson_elem, "mpls_vpn_rd", rd_str);
+}
+
+void MongoDB_bson_src_host(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_addr(bson_elem, "ip_src", &cc->primitives.src_ip);
+}
+
+void MongoDB_bson_src_net(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_addr(bson_elem, "net_src", &cc->primitives.src_net);
+}
+
+void MongoDB_bson_dst_host(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_addr(bson_elem, "ip_dst", &cc->primitives.dst_ip);
+}
+
+void MongoDB_bson_dst_net(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_addr(bson_elem, "net_dst", &cc->primitives.dst_net);
+}
+
+void MongoDB_bson_src_mask(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "mask_src", cc->primitives.src_nmask);
+}
+
+void MongoDB_bson_dst_mask(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "mask_dst", cc->primitives.dst_nmask);
+}
+
+void MongoDB_bson_src_port(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "port_src", cc->primitives.src_port);
+}
+
+void MongoDB_bson_dst_port(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "port_dst", cc->primitives.dst_port);
+}
+
+#if defined (WITH_GEOIP)
+void MongoDB_bson_src_host_country(bson *bson_elem, struct chained_cache *cc)
+{
+  if (cc->primitives.src_ip_country.id > 0)
+    bson_append_string(bson_elem, "country_ip_src", GeoIP_code_by_id(cc->primitives.src_ip_country.id));
+  else
+    bson_append_null(bson_elem, "country_ip_src");
+}
+
+void MongoDB_bson_dst_host_country(bson *bson_elem, struct chained_cache *cc)
+{
+  if (cc->primitives.dst_ip_country.id > 0)
+    bson_append_string(bson_elem, "country_ip_dst", GeoIP_code_by_id(cc->primitives.dst_ip_country.id));
+  else
+    bson_append_null(bson_elem, "country_ip_dst");
+}
+#endif
+
+#if defined (WITH_GEOIPV2)
+void MongoDB_bson_src_host_country(bson *bson_elem, struct chained_cache *cc)
+{
+  if (strlen(cc->primitives.src_ip_country.str))
+    bson_append_string(bson_elem, "country_ip_src", cc->primitives.src_ip_country.str);
+  else
+    bson_append_null(bson_elem, "country_ip_src");
+}
+
+void MongoDB_bson_dst_host_country(bson *bson_elem, struct chained_cache *cc)
+{
+  if (strlen(cc->primitives.dst_ip_country.str))
+    bson_append_string(bson_elem, "country_ip_dst", cc->primitives.dst_ip_country.str);
+  else
+    bson_append_null(bson_elem, "country_ip_dst");
+}
+
+void MongoDB_bson_src_host_pocode(bson *bson_elem, struct chained_cache *cc)
+{
+  if (strlen(cc->primitives.src_ip_pocode.str))
+    bson_append_string(bson_elem, "pocode_ip_src", cc->primitives.src_ip_pocode.str);
+  else
+    bson_append_null(bson_elem, "pocode_ip_src");
+}
+
+void MongoDB_bson_dst_host_pocode(bson *bson_elem, struct chained_cache *cc)
+{
+  if (strlen(cc->primitives.dst_ip_pocode.str))
+    bson_append_string(bson_elem, "pocode_ip_dst", cc->primitives.dst_ip_pocode.str);
+  else
+    bson_append_null(bson_elem, "pocode_ip_dst");
+}
+#endif
+
+void MongoDB_bson_tcp_flags(bson *bson_elem, struct chained_cache *cc)
+{
+  char misc_str[SUPERSHORTBUFLEN];
+
+  snprintf(misc_str, sizeof(misc_str), "%u", cc->tcp_flags);
+  bson_append_string(bson_elem, "tcp_flags", misc_str);
+}
+
+void MongoDB_bson_proto(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_proto(bson_elem, "ip_proto", cc->primitives.proto);
+}
+
+void MongoDB_bson_tos(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "tos", cc->primitives.tos);
+}
+
+void MongoDB_bson_sampling_rate(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "sampling_rate", cc->primitives.sampling_rate);
+}
+
+void MongoDB_bson_post_nat_src_host(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_addr(bson_elem, "post_nat_ip_src", &cc->pnat->post_nat_src_ip);
+}
+
+void MongoDB_bson_post_nat_dst_host(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_addr(bson_elem, "post_nat_ip_dst", &cc->pnat->post_nat_dst_ip);
+}
+
+void MongoDB_bson_post_nat_src_port(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "post_nat_port_src", cc->pnat->post_nat_src_port);
+}
+
+void MongoDB_bson_post_nat_dst_port(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "post_nat_port_dst", cc->pnat->post_nat_dst_port);
+}
+
+void MongoDB_bson_nat_event(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "nat_event", cc->pnat->nat_event);
+}
+
+void MongoDB_bson_mpls_label_top(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "mpls_label_top", cc->pmpls->mpls_label_top);
+}
+
+void MongoDB_bson_mpls_label_bottom(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "mpls_label_bottom", cc->pmpls->mpls_label_bottom);
+}
+
+void MongoDB_bson_mpls_stack_depth(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "mpls_stack_depth", cc->pmpls->mpls_stack_depth);
+}
+
+void MongoDB_bson_tunnel_src_host(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_addr(bson_elem, "tunnel_ip_src", &cc->ptun->tunnel_src_ip);
+}
+
+void MongoDB_bson_tunnel_dst_host(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_addr(bson_elem, "tunnel_ip_dst", &cc->ptun->tunnel_dst_ip);
+}
+
+void MongoDB_bson_tunnel_proto(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_proto(bson_elem, "tunnel_ip_proto", cc->ptun->tunnel_proto);
+}
+
+void MongoDB_bson_tunnel_tos(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "tunnel_tos", cc->ptun->tunnel_tos);
+}
+
+void MongoDB_bson_timestamp_start(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_timestamp(bson_elem, "timestamp_start", &cc->pnat->timestamp_start);
+}
+
+void MongoDB_bson_timestamp_end(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_timestamp(bson_elem, "timestamp_end", &cc->pnat->timestamp_end);
+}
+
+void MongoDB_bson_timestamp_arrival(bson *bson_elem, struct chained_cache *cc)
+{
+  MongoDB_append_timestamp(bson_elem, "timestamp_arrival", &cc->pnat->timestamp_arrival);
+}
+
+void MongoDB_bson_timestamp_stitching(bson *bson_elem, struct chained_cache *cc)
+{
+  if (cc->stitch) {
+    MongoDB_append_timestamp(bson_elem, "timestamp_min", &cc->stitch->timestamp_min);
+    MongoDB_append_timestamp(bson_elem, "timestamp_max", &cc->stitch->timestamp_max);
+  }
+}
+
+void MongoDB_bson_export_proto_seqno(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "export_proto_seqno", cc->primitives.export_proto_seqno);
+}
+
+void MongoDB_bson_export_proto_version(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_int(bson_elem, "export_proto_version", cc->primitives.export_proto_version);
+}
+
+void MongoDB_bson_custom_primitives(bson *bson_elem, struct chained_cache *cc)
+{
+  int cp_idx;
+
+  for (cp_idx = 0; cp_idx < config.cpptrs.num; cp_idx++) {
+    if (config.cpptrs.primitive[cp_idx].ptr->len != PM_VARIABLE_LENGTH) {
+      char cp_str[SRVBUFLEN];
+
+      custom_primitive_value_print(cp_str, SRVBUFLEN, cc->pcust, &config.cpptrs.primitive[cp_idx], FALSE);
+      bson_append_string(bson_elem, config.cpptrs.primitive[cp_idx].name, cp_str);
+    }
+    else {
+      char *label_ptr = NULL;
+
+      vlen_prims_get(cc->pvlen, config.cpptrs.primitive[cp_idx].ptr->type, &label_ptr);
+      if (!label_ptr) bson_append_null(bson_elem, config.cpptrs.primitive[cp_idx].name);
+      else bson_append_string(bson_elem, config.cpptrs.primitive[cp_idx].name, label_ptr);
+    }
+  }
+}
+
+void MongoDB_bson_history(bson *bson_elem, struct chained_cache *cc)
+{
+  bson_append_date(bson_elem, "stamp_inserted", (bson_date_t) 1000*cc->basetime.tv_sec);
+  bson_append_date(bson_elem, "stamp_updated", (bson_date_t) 1000*time(NULL));
+}
+
+void MongoDB_bson_counters(bson *bson_elem, struct chained_cache *cc)
+{
+  if (cc->flow_type == NF9_FTYPE_EVENT || cc->flow_type == NF9_FTYPE_OPTION) return;
+
+#if defined HAVE_64BIT_COUNTERS
+  bson_append_long(bson_elem, "packets", cc->packet_counter);
+  if (config.what_to_count & COUNT_FLOWS) bson_append_long(bson_elem, "flows", cc->flow_counter);
+  bson_append_long(bson_elem, "bytes", cc->bytes_counter);
+#else
+  bson_append_int(bson_elem, "packets", cc->packet_counter);
+  if (config.what_to_count & COUNT_FLOWS) bson_append_int(bson_elem, "flows", cc->flow_counter);
+  bson_append_int(bson_elem, "bytes", cc->bytes_counter);
+#endif
+}
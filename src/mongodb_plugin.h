@@ -31,8 +31,10 @@
 #include <mongo.h>
 
 #define DEFAULT_MONGO_INSERT_BATCH 10000
+#define MONGO_BSON_INIT_SIZE 128
 
 /* structures */
+typedef void (*MongoDB_bson_handler)(bson *, struct chained_cache *);
 
 /* prototypes */
 #if (!defined __MONGODB_PLUGIN_C)
@@ -47,7 +49,90 @@ EXT void MongoDB_create_indexes(mongo *, const char *);
 EXT int MongoDB_get_database(char *, int, char *);
 EXT void MongoDB_append_string(bson *, char *, struct pkt_vlen_hdr_primitives *, pm_cfgreg_t);
 EXT int MongoDB_oid_fuzz();
+EXT void MongoDB_compose_bson(u_int64_t, u_int64_t);
+EXT int MongoDB_insert_batch(const char *, const bson **, int);
+EXT void MongoDB_append_comm(bson *, char *, struct pkt_vlen_hdr_primitives *, pm_cfgreg_t);
+EXT void MongoDB_append_timestamp(bson *, char *, struct timeval *);
+EXT void MongoDB_append_proto(bson *, char *, u_int8_t);
+EXT void MongoDB_append_addr(bson *, char *, struct host_addr *);
+EXT void MongoDB_bson_tag(bson *, struct chained_cache *);
+EXT void MongoDB_bson_tag2(bson *, struct chained_cache *);
+EXT void MongoDB_bson_label(bson *, struct chained_cache *);
+EXT void MongoDB_bson_class(bson *, struct chained_cache *);
+#if defined (WITH_NDPI)
+EXT void MongoDB_bson_ndpi_class(bson *, struct chained_cache *);
+#endif
+#if defined (HAVE_L2)
+EXT void MongoDB_bson_src_mac(bson *, struct chained_cache *);
+EXT void MongoDB_bson_dst_mac(bson *, struct chained_cache *);
+EXT void MongoDB_bson_vlan(bson *, struct chained_cache *);
+EXT void MongoDB_bson_cos(bson *, struct chained_cache *);
+EXT void MongoDB_bson_etype(bson *, struct chained_cache *);
+#endif
+EXT void MongoDB_bson_src_as(bson *, struct chained_cache *);
+EXT void MongoDB_bson_dst_as(bson *, struct chained_cache *);
+EXT void MongoDB_bson_std_comm(bson *, struct chained_cache *);
+EXT void MongoDB_bson_ext_comm(bson *, struct chained_cache *);
+EXT void MongoDB_bson_lrg_comm(bson *, struct chained_cache *);
+EXT void MongoDB_bson_as_path(bson *, struct chained_cache *);
+EXT void MongoDB_bson_local_pref(bson *, struct chained_cache *);
+EXT void MongoDB_bson_med(bson *, struct chained_cache *);
+EXT void MongoDB_bson_peer_src_as(bson *, struct chained_cache *);
+EXT void MongoDB_bson_peer_dst_as(bson *, struct chained_cache *);
+EXT void MongoDB_bson_peer_src_ip(bson *, struct chained_cache *);
+EXT void MongoDB_bson_peer_dst_ip(bson *, struct chained_cache *);
+EXT void MongoDB_bson_src_std_comm(bson *, struct chained_cache *);
+EXT void MongoDB_bson_src_ext_comm(bson *, struct chained_cache *);
+EXT void MongoDB_bson_src_lrg_comm(bson *, struct chained_cache *);
+EXT void MongoDB_bson_src_as_path(bson *, struct chained_cache *);
+EXT void MongoDB_bson_src_local_pref(bson *, struct chained_cache *);
+EXT void MongoDB_bson_src_med(bson *, struct chained_cache *);
+EXT void MongoDB_bson_in_iface(bson *, struct chained_cache *);
+EXT void MongoDB_bson_out_iface(bson *, struct chained_cache *);
+EXT void MongoDB_bson_mpls_vpn_rd(bson *, struct chained_cache *);
+EXT void MongoDB_bson_src_host(bson *, struct chained_cache *);
+EXT void MongoDB_bson_src_net(bson *, struct chained_cache *);
+EXT void MongoDB_bson_dst_host(bson *, struct chained_cache *);
+EXT void MongoDB_bson_dst_net(bson *, struct chained_cache *);
+EXT void MongoDB_bson_src_mask(bson *, struct chained_cache *);
+EXT void MongoDB_bson_dst_mask(bson *, struct chained_cache *);
+EXT void MongoDB_bson_src_port(bson *, struct chained_cache *);
+EXT void MongoDB_bson_dst_port(bson *, struct chained_cache *);
+#if defined (WITH_GEOIP) || defined (WITH_GEOIPV2)
+EXT void MongoDB_bson_src_host_country(bson *, struct chained_cache *);
+EXT void MongoDB_bson_dst_host_country(bson *, struct chained_cache *);
+#endif
+#if defined (WITH_GEOIPV2)
+EXT void MongoDB_bson_src_host_pocode(bson *, struct chained_cache *);
+EXT void MongoDB_bson_dst_host_pocode(bson *, struct chained_cache *);
+#endif
+EXT void MongoDB_bson_tcp_flags(bson *, struct chained_cache *);
+EXT void MongoDB_bson_proto(bson *, struct chained_cache *);
+EXT void MongoDB_bson_tos(bson *, struct chained_cache *);
+EXT void MongoDB_bson_sampling_rate(bson *, struct chained_cache *);
+EXT void MongoDB_bson_post_nat_src_host(bson *, struct chained_cache *);
+EXT void MongoDB_bson_post_nat_dst_host(bson *, struct chained_cache *);
+EXT void MongoDB_bson_post_nat_src_port(bson *, struct chained_cache *);
+EXT void MongoDB_bson_post_nat_dst_port(bson *, struct chained_cache *);
+EXT void MongoDB_bson_nat_event(bson *, struct chained_cache *);
+EXT void MongoDB_bson_mpls_label_top(bson *, struct chained_cache *);
+EXT void MongoDB_bson_mpls_label_bottom(bson *, struct chained_cache *);
+EXT void MongoDB_bson_mpls_stack_depth(bson *, struct chained_cache *);
+EXT void MongoDB_bson_tunnel_src_host(bson *, struct chained_cache *);
+EXT void MongoDB_bson_tunnel_dst_host(bson *, struct chained_cache *);
+EXT void MongoDB_bson_tunnel_proto(bson *, struct chained_cache *);
+EXT void MongoDB_bson_tunnel_tos(bson *, struct chained_cache *);
+EXT void MongoDB_bson_timestamp_start(bson *, struct chained_cache *);
+EXT void MongoDB_bson_timestamp_end(bson *, struct chained_cache *);
+EXT void MongoDB_bson_timestamp_arrival(bson *, struct chained_cache *);
+EXT void MongoDB_bson_timestamp_stitching(bson *, struct chained_cache *);
+EXT void MongoDB_bson_export_proto_seqno(bson *, struct chained_cache *);
+EXT void MongoDB_bson_export_proto_version(bson *, struct chained_cache *);
+EXT void MongoDB_bson_custom_primitives(bson *, struct chained_cache *);
+EXT void MongoDB_bson_history(bson *, struct chained_cache *);
+EXT void MongoDB_bson_counters(bson *, struct chained_cache *);
 
 /* global vars */
 EXT mongo db_conn;
+EXT MongoDB_bson_handler mbhandler[N_PRIMITIVES];
 #undef EXT
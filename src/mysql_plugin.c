@@ -418,6 +418,145 @@ int MY_cache_dbop(struct DBdesc *db, struct db_cache *cache_elem, struct insert_
   else return ret;
 }
 
+int MY_cache_dbop_prepared(struct DBdesc *db, struct db_cache *cache_elem, struct insert_data *idata)
+{
+  struct sql_bind_param bvalues[SQL_BIND_MAX], bwhere[SQL_BIND_MAX], bset[SQL_BIND_MAX];
+  MYSQL_BIND binds[(SQL_BIND_MAX*2)+3];
+  unsigned long long ints[(SQL_BIND_MAX*2)+3];
+  MYSQL_STMT *stmt = NULL;
+  char *ptr_values, *ptr_where, *ptr_set;
+  int num=0, num_set=0, nvalues, nwhere, nset=0, event=FALSE;
+
+  if (cache_elem->flow_type == NF9_FTYPE_EVENT || cache_elem->flow_type == NF9_FTYPE_OPTION) event = TRUE;
+
+  /* collecting values to bind; frags print them out raw */
+  ptr_where = where_clause;
+  ptr_values = values_clause;
+  ptr_set = set_clause;
+  where_clause[0] = '\0';
+  values_clause[0] = '\0';
+  set_clause[0] = '\0';
+
+  for (num = 0; num < idata->num_primitives; num++)
+    (*where[num].handler)(cache_elem, idata, num, &ptr_values, &ptr_where);
+
+  if (event) {
+    for (num_set = 0; set_event[num_set].type; num_set++)
+      (*set_event[num_set].handler)(cache_elem, idata, num_set, &ptr_set, NULL);
+  }
+  else {
+    for (num_set = 0; set[num_set].type; num_set++)
+      (*set[num_set].handler)(cache_elem, idata, num_set, &ptr_set, NULL);
+  }
+
+  nvalues = sql_bind_parse(values_clause, &bind_values, bvalues);
+  nwhere = sql_bind_parse(where_clause, &bind_where, bwhere);
+  if (num_set) nset = sql_bind_parse(set_clause, event ? &bind_set_event : &bind_set, bset);
+
+  if (nvalues < 0 || nwhere < 0 || nset < 0) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): Unable to bind values to prepared statements.\n", config.name, config.type);
+    return TRUE;
+  }
+
+  if (!config.sql_dont_try_update && num_set) {
+    stmt = MY_get_stmt(db, event ? SQL_STMT_UPDATE_EVENT : SQL_STMT_UPDATE);
+    if (!stmt) goto signal_error;
+
+    memset(binds, 0, (nset+nwhere)*sizeof(MYSQL_BIND));
+    MY_bind_params(binds, ints, bset, nset);
+    MY_bind_params(&binds[nset], &ints[nset], bwhere, nwhere);
+    if (mysql_stmt_bind_param(stmt, binds) || mysql_stmt_execute(stmt)) goto signal_error;
+  }
+
+  if (config.sql_dont_try_update || !num_set || (mysql_stmt_affected_rows(stmt) == 0)) {
+    /* UPDATE failed, trying with an INSERT query */
+    stmt = MY_get_stmt(db, event ? SQL_STMT_INSERT_EVENT : SQL_STMT_INSERT);
+    if (!stmt) goto signal_error;
+
+    memset(binds, 0, (nvalues+3)*sizeof(MYSQL_BIND));
+    MY_bind_params(binds, ints, bvalues, nvalues);
+    if (!event) {
+      ints[nvalues] = cache_elem->packet_counter;
+      ints[nvalues+1] = cache_elem->bytes_counter;
+      ints[nvalues+2] = cache_elem->flows_counter;
+
+      for (num = nvalues; num < (nvalues + ((config.what_to_count & COUNT_FLOWS) ? 3 : 2)); num++) {
+        binds[num].buffer_type = MYSQL_TYPE_LONGLONG;
+        binds[num].buffer = &ints[num];
+        binds[num].is_unsigned = TRUE;
+      }
+    }
+
+    if (mysql_stmt_bind_param(stmt, binds) || mysql_stmt_execute(stmt)) goto signal_error;
+    idata->iqn++;
+  }
+  else idata->uqn++;
+
+  idata->een++;
+
+  return FALSE;
+
+  signal_error:
+  if (stmt) db->errmsg = (char *) mysql_stmt_error(stmt);
+  else MY_get_errmsg(db);
+  if (db->errmsg) Log(LOG_ERR, "ERROR ( %s/%s ): %s\n\n", config.name, config.type, db->errmsg);
+
+  return TRUE;
+}
+
+static MYSQL_STMT *MY_get_stmt(struct DBdesc *db, int type)
+{
+  MYSQL_STMT **stmt = &mysql_stmts[db->type == BE_TYPE_BACKUP ? BE_TYPE_BACKUP : BE_TYPE_PRIMARY][type];
+
+  if (!(*stmt)) {
+    sql_bind_compose_stmt(type, sql_data, sizeof(sql_data));
+    *stmt = mysql_stmt_init(db->desc);
+    if (*stmt && mysql_stmt_prepare(*stmt, sql_data, strlen(sql_data))) {
+      Log(LOG_DEBUG, "DEBUG ( %s/%s ): FAILED query follows:\n%s\n", config.name, config.type, sql_data);
+      Log(LOG_ERR, "ERROR ( %s/%s ): %s\n\n", config.name, config.type, mysql_stmt_error(*stmt));
+      mysql_stmt_close(*stmt);
+      *stmt = NULL;
+    }
+    else if (*stmt) Log(LOG_DEBUG, "DEBUG ( %s/%s ): prepared: %s\n", config.name, config.type, sql_data);
+  }
+
+  return *stmt;
+}
+
+static void MY_bind_params(MYSQL_BIND *binds, unsigned long long *ints, struct sql_bind_param *params, int num)
+{
+  int idx;
+
+  for (idx = 0; idx < num; idx++) {
+    if (params[idx].type == SQL_BIND_INT) {
+      ints[idx] = strtoull(params[idx].value, NULL, 10);
+      binds[idx].buffer_type = MYSQL_TYPE_LONGLONG;
+      binds[idx].buffer = &ints[idx];
+      binds[idx].is_unsigned = TRUE;
+    }
+    else {
+      binds[idx].buffer_type = MYSQL_TYPE_STRING;
+      binds[idx].buffer = params[idx].value;
+      binds[idx].buffer_length = params[idx].len;
+    }
+  }
+}
+
+/* statements embed the (possibly dynamic) table name: they are re-prepared
+   on each purge pass */
+void MY_close_stmts(struct DBdesc *db)
+{
+  MYSQL_STMT **stmts = mysql_stmts[db->type == BE_TYPE_BACKUP ? BE_TYPE_BACKUP : BE_TYPE_PRIMARY];
+  int idx;
+
+  for (idx = 0; idx < SQL_STMT_MAX; idx++) {
+    if (stmts[idx]) {
+      mysql_stmt_close(stmts[idx]);
+      stmts[idx] = NULL;
+    }
+  }
+}
+
 void MY_cache_purge(struct db_cache *queue[], int index, struct insert_data *idata)
 {
   struct db_cache *LastElemCommitted = NULL;
@@ -489,6 +628,12 @@ void MY_cache_purge(struct db_cache *queue[], int index, struct insert_data *ida
     if (config.sql_table_schema) sql_create_table(bed.p, &stamp, &prim_ptrs);
   }
 
+  /* statements are bound to the table name, possibly just changed */
+  if (config.sql_prepared_statements) {
+    MY_close_stmts(bed.p);
+    MY_close_stmts(bed.b);
+  }
+
   if (idata->locks == PM_LOCK_EXCLUSIVE) (*sqlfunc_cbr.lock)(bed.p); 
 
   for (idata->current_queue_elem = 0; idata->current_queue_elem < index; idata->current_queue_elem++) {
@@ -644,6 +789,8 @@ int MY_compose_static_queries()
     }
   }
 
+
+  if (config.sql_prepared_statements) sql_bind_compose_static(primitives);
   return primitives;
 }
 
@@ -683,8 +830,14 @@ void MY_DB_Connect(struct DBdesc *db, char *host)
 
 void MY_DB_Close(struct BE_descs *bed)
 {
-  if (bed->p->connected) mysql_close(bed->p->desc);
-  if (bed->b->connected) mysql_close(bed->b->desc);
+  if (bed->p->connected) {
+    MY_close_stmts(bed->p);
+    mysql_close(bed->p->desc);
+  }
+  if (bed->b->connected) {
+    MY_close_stmts(bed->b);
+    mysql_close(bed->b->desc);
+  }
 }
 
 void MY_create_dyn_table(struct DBdesc *db, char *buf)
@@ -723,7 +876,8 @@ void MY_set_callbacks(struct sqlfunc_cb_registry *cbr)
   cbr->close = MY_DB_Close;
   cbr->lock = MY_Lock;
   cbr->unlock = MY_Unlock;
-  cbr->op = MY_cache_dbop;
+  if (!config.sql_prepared_statements) cbr->op = MY_cache_dbop;
+  else cbr->op = MY_cache_dbop_prepared;
   cbr->create_table = MY_create_dyn_table;
   cbr->purge = MY_cache_purge;
   cbr->create_backend = MY_create_backend;
@@ -756,6 +910,17 @@ void MY_init_default_values(struct insert_data *idata)
 
   if (config.sql_backup_host) idata->recover = TRUE;
 
+  if (config.sql_prepared_statements) {
+    if (config.num_hosts) {
+      Log(LOG_WARNING, "WARN ( %s/%s ): sql_prepared_statements is not compatible with sql_num_hosts. Disabled.\n", config.name, config.type);
+      config.sql_prepared_statements = FALSE;
+    }
+    else if (config.sql_multi_values) {
+      Log(LOG_WARNING, "WARN ( %s/%s ): sql_multi_values is superseded by sql_prepared_statements. Ignored.\n", config.name, config.type);
+      config.sql_multi_values = FALSE;
+    }
+  }
+
   if (config.sql_multi_values) {
     multi_values_buffer = malloc(config.sql_multi_values);
     if (!multi_values_buffer) {
@@ -767,6 +932,9 @@ void MY_init_default_values(struct insert_data *idata)
   }
 
   if (config.sql_locking_style) idata->locks = sql_select_locking_style(config.sql_locking_style);
+
+  if (config.sql_writer_connections > 1 && idata->locks == PM_LOCK_EXCLUSIVE)
+    Log(LOG_WARNING, "WARN ( %s/%s ): table locking serializes sql_writer_connections. Consider sql_locking_style set to 'row' or 'none'.\n", config.name, config.type);
 }
 
 void MY_mysql_get_version()
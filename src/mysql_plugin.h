@@ -29,6 +29,10 @@
 /* prototypes */
 void mysql_plugin(int, struct configuration *, void *);
 int MY_cache_dbop(struct DBdesc *, struct db_cache *, struct insert_data *);
+int MY_cache_dbop_prepared(struct DBdesc *, struct db_cache *, struct insert_data *);
+static MYSQL_STMT *MY_get_stmt(struct DBdesc *, int);
+static void MY_bind_params(MYSQL_BIND *, unsigned long long *, struct sql_bind_param *, int);
+void MY_close_stmts(struct DBdesc *);
 void MY_cache_purge(struct db_cache *[], int, struct insert_data *);
 int MY_evaluate_history(int);
 int MY_compose_static_queries();
@@ -57,3 +61,4 @@ static char mysql_table_v6[] = "acct_v6";
 static char mysql_table_v7[] = "acct_v7";
 static char mysql_table_v8[] = "acct_v8";
 static char mysql_table_bgp[] = "acct_bgp";
+static MYSQL_STMT *mysql_stmts[BE_TYPE_BACKUP+1][SQL_STMT_MAX];
@@ -940,6 +940,9 @@ int main(int argc,char **argv, char **envp)
 
   /* Main loop */
   for (;;) {
+    /* done with BGP/BMP lookup results of the previous packet */
+    if (config.nfacctd_bgp || config.nfacctd_bmp) bgp_rib_read_exit();
+
     if (!config.pcap_savefile) {
       ret = recvfrom(config.sock, netflow_packet, NETFLOW_MSG_SIZE, 0, (struct sockaddr *) &client, &clen);
     }
@@ -960,8 +963,6 @@ int main(int argc,char **argv, char **envp)
     if (!allowed) continue;
 
     if (reload_map) {
-      bta_map_caching = TRUE;
-      sampling_map_caching = TRUE;
       req.key_value_table = NULL;
 
       if (config.nfacctd_allow_file) load_allow_file(config.nfacctd_allow_file, &allow);
@@ -969,17 +970,17 @@ int main(int argc,char **argv, char **envp)
       load_networks(config.networks_file, &nt, &nc);
 
       if (config.nfacctd_bgp && config.nfacctd_bgp_peer_as_src_map) 
-        load_id_file(MAP_BGP_PEER_AS_SRC, config.nfacctd_bgp_peer_as_src_map, &bpas_table, &req, &bpas_map_allocated); 
+        load_id_file_bg(MAP_BGP_PEER_AS_SRC, config.nfacctd_bgp_peer_as_src_map, &bpas_table, &req, &bpas_map_allocated); 
       if (config.nfacctd_bgp && config.nfacctd_bgp_src_local_pref_map) 
-        load_id_file(MAP_BGP_SRC_LOCAL_PREF, config.nfacctd_bgp_src_local_pref_map, &blp_table, &req, &blp_map_allocated); 
+        load_id_file_bg(MAP_BGP_SRC_LOCAL_PREF, config.nfacctd_bgp_src_local_pref_map, &blp_table, &req, &blp_map_allocated); 
       if (config.nfacctd_bgp && config.nfacctd_bgp_src_med_map) 
-        load_id_file(MAP_BGP_SRC_MED, config.nfacctd_bgp_src_med_map, &bmed_table, &req, &bmed_map_allocated); 
+        load_id_file_bg(MAP_BGP_SRC_MED, config.nfacctd_bgp_src_med_map, &bmed_table, &req, &bmed_map_allocated); 
       if (config.nfacctd_bgp && config.nfacctd_bgp_to_agent_map)
-        load_id_file(MAP_BGP_TO_XFLOW_AGENT, config.nfacctd_bgp_to_agent_map, &bta_table, &req, &bta_map_allocated);
+        load_id_file_bg(MAP_BGP_TO_XFLOW_AGENT, config.nfacctd_bgp_to_agent_map, &bta_table, &req, &bta_map_allocated);
       if (config.nfacctd_flow_to_rd_map)
-        load_id_file(MAP_FLOW_TO_RD, config.nfacctd_flow_to_rd_map, &bitr_table, &req, &bitr_map_allocated);
+        load_id_file_bg(MAP_FLOW_TO_RD, config.nfacctd_flow_to_rd_map, &bitr_table, &req, &bitr_map_allocated);
       if (config.sampling_map) {
-        load_id_file(MAP_SAMPLING, config.sampling_map, &sampling_table, &req, &sampling_map_allocated);
+        load_id_file_bg(MAP_SAMPLING, config.sampling_map, &sampling_table, &req, &sampling_map_allocated);
         set_sampling_table(&pptrs, (u_char *) &sampling_table);
       }
 
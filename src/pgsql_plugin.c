@@ -264,62 +264,139 @@ void pgsql_plugin(int pipe_fd, struct configuration *cfgptr, void *ptr)
 
 int PG_cache_dbop_copy(struct DBdesc *db, struct db_cache *cache_elem, struct insert_data *idata)
 {
-  PGresult *ret;
+  struct PG_copy_buffer *cb = PG_copy_buffer_get(db);
   char *ptr_values, *ptr_where;
-  char default_delim[] = ",", delim_buf[SRVBUFLEN];
-  int num=0, have_flows=0;
+  char default_delim[] = ",", *delim;
+  int num=0, have_flows=0, row_len;
 
   if (config.what_to_count & COUNT_FLOWS) have_flows = TRUE;
 
-  if (!config.sql_delimiter)
-    snprintf(delim_buf, SRVBUFLEN, "%s", default_delim);
-  else
-    snprintf(delim_buf, SRVBUFLEN, "%s", config.sql_delimiter);
+  if (!config.sql_delimiter) delim = default_delim;
+  else delim = config.sql_delimiter;
 
-  /* constructing SQL query */
+  /* constructing COPY row; values[] already hold the COPY formats */
   ptr_where = where_clause;
   ptr_values = values_clause;
-  memset(where_clause, 0, sizeof(where_clause));
-  memset(values_clause, 0, sizeof(values_clause));
+  where_clause[0] = '\0';
+  values_clause[0] = '\0';
 
-  memcpy(&values, &copy_values, sizeof(values));
   while (num < idata->num_primitives) {
     (*where[num].handler)(cache_elem, idata, num, &ptr_values, &ptr_where);
     num++;
   }
 
 #if defined HAVE_64BIT_COUNTERS
-  if (have_flows) snprintf(ptr_values, SPACELEFT(values_clause), "%s%llu%s%llu%s%llu\n", delim_buf, cache_elem->packet_counter,
-											delim_buf, cache_elem->bytes_counter,
-											delim_buf, cache_elem->flows_counter);
-  else snprintf(ptr_values, SPACELEFT(values_clause), "%s%llu%s%llu\n", delim_buf, cache_elem->packet_counter,
-									delim_buf, cache_elem->bytes_counter);
+  if (have_flows) row_len = snprintf(ptr_values, SPACELEFT(values_clause), "%s%llu%s%llu%s%llu\n", delim, cache_elem->packet_counter,
+											delim, cache_elem->bytes_counter,
+											delim, cache_elem->flows_counter);
+  else row_len = snprintf(ptr_values, SPACELEFT(values_clause), "%s%llu%s%llu\n", delim, cache_elem->packet_counter,
+									delim, cache_elem->bytes_counter);
 #else
-  if (have_flows) snprintf(ptr_values, SPACELEFT(values_clause), "%s%lu%s%lu%s%lu\n", delim_buf, cache_elem->packet_counter,
-											delim_buf, cache_elem->bytes_counter,
-											delim_buf, cache_elem->flows_counter);
-  else snprintf(ptr_values, SPACELEFT(values_clause), "%s%lu%s%lu\n", delim_buf, cache_elem->packet_counter,
-									delim_buf, cache_elem->bytes_counter);
+  if (have_flows) row_len = snprintf(ptr_values, SPACELEFT(values_clause), "%s%lu%s%lu%s%lu\n", delim, cache_elem->packet_counter,
+											delim, cache_elem->bytes_counter,
+											delim, cache_elem->flows_counter);
+  else row_len = snprintf(ptr_values, SPACELEFT(values_clause), "%s%lu%s%lu\n", delim, cache_elem->packet_counter,
+									delim, cache_elem->bytes_counter);
 #endif
 
-  strncpy(sql_data, values_clause, SPACELEFT(sql_data));
+  row_len += (ptr_values - values_clause);
+  if (row_len >= sizeof(values_clause)) row_len = strlen(values_clause);
 
-  if (PQputCopyData(db->desc, sql_data, strlen(sql_data)) < 0) { // avoid strlen() 
-    db->errmsg = PQerrorMessage(db->desc);
-    Log(LOG_DEBUG, "DEBUG ( %s/%s ): FAILED query follows:\n%s\n", config.name, config.type, sql_data);
-    if (db->errmsg) Log(LOG_ERR, "ERROR ( %s/%s ): %s\n", config.name, config.type, db->errmsg);
-    sql_db_fail(db);
-
-    return TRUE;
+  /* rows are shipped to the server in PG_COPY_BUFLEN chunks */
+  if ((cb->len + row_len) > PG_COPY_BUFLEN) {
+    if (PG_copy_flush(db)) return TRUE;
   }
+
+  memcpy(cb->base + cb->len, values_clause, row_len);
+  cb->len += row_len;
+
   idata->iqn++;
   idata->een++;
 
-  Log(LOG_DEBUG, "DEBUG ( %s/%s ): %s\n", config.name, config.type, sql_data);
+  if (config.debug) Log(LOG_DEBUG, "DEBUG ( %s/%s ): %s", config.name, config.type, values_clause);
 
   return FALSE;
 }
 
+static struct PG_copy_buffer *PG_copy_buffer_get(struct DBdesc *db)
+{
+  struct PG_copy_buffer *cb = &copy_buf[db->type == BE_TYPE_BACKUP ? BE_TYPE_BACKUP : BE_TYPE_PRIMARY];
+
+  if (!cb->base) {
+    cb->base = malloc(PG_COPY_BUFLEN);
+    if (!cb->base) {
+      Log(LOG_ERR, "ERROR ( %s/%s ): malloc() failed (PG_copy_buffer_get). Exiting ..\n", config.name, config.type);
+      exit_plugin(1);
+    }
+    cb->len = 0;
+  }
+
+  return cb;
+}
+
+int PG_copy_flush(struct DBdesc *db)
+{
+  struct PG_copy_buffer *cb = PG_copy_buffer_get(db);
+  int ret = FALSE;
+
+  if (cb->len) {
+    if (PQputCopyData(db->desc, cb->base, cb->len) < 0) {
+      db->errmsg = PQerrorMessage(db->desc);
+      sql_db_errmsg(db);
+      sql_db_fail(db);
+      ret = TRUE;
+    }
+
+    cb->len = 0;
+  }
+
+  return ret;
+}
+
+/* flushes pending rows and terminates the COPY; unlike PQputCopyEnd() alone,
+   this also collects the COPY outcome so that rejected rows are not silently
+   lost at COMMIT time. In upsert mode, it then merges the staging table into
+   the target table */
+int PG_copy_end(struct DBdesc *db)
+{
+  PGresult *PGret;
+  int ret = FALSE;
+
+  if (PG_copy_flush(db)) return TRUE;
+
+  if (PQputCopyEnd(db->desc, NULL) < 0) {
+    db->errmsg = PQerrorMessage(db->desc);
+    sql_db_errmsg(db);
+    sql_db_fail(db);
+    return TRUE;
+  }
+
+  while ((PGret = PQgetResult(db->desc))) {
+    if (PQresultStatus(PGret) != PGRES_COMMAND_OK && !ret) {
+      db->errmsg = PQresultErrorMessage(PGret);
+      sql_db_errmsg(db);
+      ret = TRUE;
+    }
+    PQclear(PGret);
+  }
+
+  if (!ret && config.sql_copy_upsert) {
+    PGret = PQexec(db->desc, upsert_clause);
+    if (PQresultStatus(PGret) != PGRES_COMMAND_OK) {
+      db->errmsg = PQresultErrorMessage(PGret);
+      Log(LOG_DEBUG, "DEBUG ( %s/%s ): FAILED query follows:\n%s\n", config.name, config.type, upsert_clause);
+      sql_db_errmsg(db);
+      ret = TRUE;
+    }
+    else Log(LOG_DEBUG, "DEBUG ( %s/%s ): %s [%s]\n", config.name, config.type, upsert_clause, PQcmdTuples(PGret));
+    PQclear(PGret);
+  }
+
+  if (ret) sql_db_fail(db);
+
+  return ret;
+}
+
 int PG_cache_dbop(struct DBdesc *db, struct db_cache *cache_elem, struct insert_data *idata)
 {
   PGresult *ret;
@@ -418,6 +495,7 @@ void PG_cache_purge(struct db_cache *queue[], int index, struct insert_data *ida
   struct db_cache **reprocess_queries_queue, **bulk_reprocess_queries_queue;
   char orig_insert_clause[LONGSRVBUFLEN], orig_update_clause[LONGSRVBUFLEN], orig_lock_clause[LONGSRVBUFLEN];
   char orig_copy_clause[LONGSRVBUFLEN], tmpbuf[LONGLONGSRVBUFLEN], tmptable[SRVBUFLEN];
+  char orig_staging_clause[LONGSRVBUFLEN], orig_upsert_clause[LONGLONGSRVBUFLEN];
   time_t start;
   int j, r, reprocess = 0, stop, go_to_pending, reprocess_idx, bulk_reprocess_idx, saved_index = index;
   struct primitives_ptrs prim_ptrs;
@@ -459,6 +537,8 @@ void PG_cache_purge(struct db_cache *queue[], int index, struct insert_data *ida
   strlcpy(orig_insert_clause, insert_clause, LONGSRVBUFLEN);
   strlcpy(orig_update_clause, update_clause, LONGSRVBUFLEN);
   strlcpy(orig_lock_clause, lock_clause, LONGSRVBUFLEN);
+  strlcpy(orig_staging_clause, staging_clause, LONGSRVBUFLEN);
+  strlcpy(orig_upsert_clause, upsert_clause, LONGLONGSRVBUFLEN);
 
   start:
   memcpy(queue, pending_queries_queue, pqq_ptr*sizeof(struct db_cache *));
@@ -479,17 +559,23 @@ void PG_cache_purge(struct db_cache *queue[], int index, struct insert_data *ida
     strlcpy(insert_clause, orig_insert_clause, LONGSRVBUFLEN);
     strlcpy(update_clause, orig_update_clause, LONGSRVBUFLEN);
     strlcpy(lock_clause, orig_lock_clause, LONGSRVBUFLEN);
+    strlcpy(staging_clause, orig_staging_clause, LONGSRVBUFLEN);
+    strlcpy(upsert_clause, orig_upsert_clause, LONGLONGSRVBUFLEN);
 
     handle_dynname_internal_strings_same(copy_clause, LONGSRVBUFLEN, tmpbuf, &prim_ptrs, DYN_STR_SQL_TABLE);
     handle_dynname_internal_strings_same(insert_clause, LONGSRVBUFLEN, tmpbuf, &prim_ptrs, DYN_STR_SQL_TABLE);
     handle_dynname_internal_strings_same(update_clause, LONGSRVBUFLEN, tmpbuf, &prim_ptrs, DYN_STR_SQL_TABLE);
     handle_dynname_internal_strings_same(lock_clause, LONGSRVBUFLEN, tmpbuf, &prim_ptrs, DYN_STR_SQL_TABLE);
+    handle_dynname_internal_strings_same(staging_clause, LONGSRVBUFLEN, tmpbuf, &prim_ptrs, DYN_STR_SQL_TABLE);
+    handle_dynname_internal_strings_same(upsert_clause, LONGLONGSRVBUFLEN, tmpbuf, &prim_ptrs, DYN_STR_SQL_TABLE);
     handle_dynname_internal_strings_same(idata->dyn_table_name, LONGSRVBUFLEN, tmpbuf, &prim_ptrs, DYN_STR_SQL_TABLE);
 
     pm_strftime_same(copy_clause, LONGSRVBUFLEN, tmpbuf, &stamp, config.timestamps_utc);
     pm_strftime_same(insert_clause, LONGSRVBUFLEN, tmpbuf, &stamp, config.timestamps_utc);
     pm_strftime_same(update_clause, LONGSRVBUFLEN, tmpbuf, &stamp, config.timestamps_utc);
     pm_strftime_same(lock_clause, LONGSRVBUFLEN, tmpbuf, &stamp, config.timestamps_utc);
+    pm_strftime_same(staging_clause, LONGSRVBUFLEN, tmpbuf, &stamp, config.timestamps_utc);
+    pm_strftime_same(upsert_clause, LONGLONGSRVBUFLEN, tmpbuf, &stamp, config.timestamps_utc);
     pm_strftime_same(idata->dyn_table_name, LONGSRVBUFLEN, tmpbuf, &stamp, config.timestamps_utc);
 
     if (config.sql_table_schema) sql_create_table(bed.p, &stamp, &prim_ptrs); 
@@ -550,18 +636,20 @@ void PG_cache_purge(struct db_cache *queue[], int index, struct insert_data *ida
     }
   }
 
+  /* a failed COPY aborts the whole transaction, rows sent before the failure included */
+  if (config.sql_use_copy && reprocess == REPROCESS_SPECIFIC) reprocess = REPROCESS_BULK;
+
   /* Finalizing DB transaction */
   if (!p.fail) {
-    if (config.sql_use_copy) {
-      if (PQputCopyEnd(p.desc, NULL) < 0) Log(LOG_ERR, "ERROR ( %s/%s ): COPY failed!\n\n", config.name, config.type); 
-    }
-
-    ret = PQexec(p.desc, "COMMIT");
-    if (PQresultStatus(ret) != PGRES_COMMAND_OK) {
-      if (!reprocess) sql_db_fail(&p);
-      reprocess = REPROCESS_BULK;
+    if (config.sql_use_copy && PG_copy_end(&p)) reprocess = REPROCESS_BULK;
+    else {
+      ret = PQexec(p.desc, "COMMIT");
+      if (PQresultStatus(ret) != PGRES_COMMAND_OK) {
+        if (!reprocess) sql_db_fail(&p);
+        reprocess = REPROCESS_BULK;
+      }
+      PQclear(ret);
     }
-    PQclear(ret);
   }
 
   /* don't reprocess free (SQL_CACHE_FREE) and already recovered (SQL_CACHE_ERROR) elements */
@@ -579,9 +667,7 @@ void PG_cache_purge(struct db_cache *queue[], int index, struct insert_data *ida
   }
 
   if (b.connected) {
-    if (config.sql_use_copy) {
-      if (PQputCopyEnd(b.desc, NULL) < 0) Log(LOG_ERR, "ERROR ( %s/%s ): COPY failed!\n\n", config.name, config.type);
-    }
+    if (config.sql_use_copy && !b.fail) PG_copy_end(&b);
     ret = PQexec(b.desc, "COMMIT");
     if (PQresultStatus(ret) != PGRES_COMMAND_OK) sql_db_fail(&b);
     PQclear(ret);
@@ -681,6 +767,7 @@ int PG_compose_static_queries()
 
   strncat(copy_clause, ", packets, bytes", SPACELEFT(copy_clause));
   if (have_flows) strncat(copy_clause, ", flows", SPACELEFT(copy_clause));
+  if (config.sql_copy_upsert) PG_compose_copy_upsert(have_flows);
 
   if (!config.sql_delimiter || !config.sql_use_copy)
     snprintf(delim_buf, SRVBUFLEN, ") FROM STDIN DELIMITER \'%s\'", default_delim);
@@ -771,9 +858,50 @@ int PG_compose_static_queries()
     }
   }
 
+  /* COPY is the only write path in use: install its formats once rather than per row */
+  if (config.sql_use_copy) memcpy(&values, &copy_values, sizeof(values));
+
   return primitives;
 }
 
+/* Rewrites copy_clause to load a staging table and composes the statements to
+   create it and merge it into the target table. Columns not accumulated on
+   conflict make up the key: they are expected to be covered by a PRIMARY KEY
+   or UNIQUE constraint on the target table */
+void PG_compose_copy_upsert(int have_flows)
+{
+  char columns[LONGSRVBUFLEN], keys[LONGSRVBUFLEN], *ptr, *token;
+
+  ptr = strchr(copy_clause, '(');
+  strlcpy(columns, ++ptr, sizeof(columns));
+  snprintf(copy_clause, sizeof(copy_clause), "COPY %s (%s", PG_COPY_STAGING_TABLE, columns);
+
+  snprintf(staging_clause, sizeof(staging_clause), "CREATE TEMP TABLE %s (LIKE %s INCLUDING DEFAULTS) ON COMMIT DROP;",
+	   PG_COPY_STAGING_TABLE, config.sql_table);
+
+  memset(keys, 0, sizeof(keys));
+  ptr = columns;
+  while ((token = strsep(&ptr, ","))) {
+    while (*token == ' ') token++;
+    if (!strcmp(token, "packets") || !strcmp(token, "bytes") || !strcmp(token, "flows") ||
+	!strcmp(token, "tcp_flags") || !strcmp(token, "stamp_updated")) continue;
+
+    if (strlen(keys)) strncat(keys, ", ", SPACELEFT(keys));
+    strncat(keys, token, SPACELEFT(keys));
+  }
+
+  snprintf(upsert_clause, sizeof(upsert_clause), "INSERT INTO %s AS dst SELECT * FROM %s ON CONFLICT (%s) DO UPDATE SET "
+	   "packets=dst.packets+EXCLUDED.packets, bytes=dst.bytes+EXCLUDED.bytes", config.sql_table, PG_COPY_STAGING_TABLE, keys);
+  if (have_flows) strncat(upsert_clause, ", flows=dst.flows+EXCLUDED.flows", SPACELEFT(upsert_clause));
+  if (config.what_to_count & COUNT_TCPFLAGS) strncat(upsert_clause, ", tcp_flags=dst.tcp_flags|EXCLUDED.tcp_flags", SPACELEFT(upsert_clause));
+  if (config.sql_history) strncat(upsert_clause, ", stamp_updated=EXCLUDED.stamp_updated", SPACELEFT(upsert_clause));
+
+  if (strlen(upsert_clause) == (sizeof(upsert_clause) - 1)) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): sql_copy_upsert: upsert statement too long. Exiting.\n", config.name, config.type);
+    exit_plugin(1);
+  }
+}
+
 void PG_compose_conn_string(struct DBdesc *db, char *host, int port)
 {
   char *string;
@@ -809,8 +937,20 @@ void PG_Lock(struct DBdesc *db)
     }
     PQclear(PGret);
     
+    /* In upsert mode, COPY goes through a transaction-scoped staging table */
+    if (config.sql_copy_upsert && !db->fail) {
+      PGret = PQexec(db->desc, staging_clause);
+      if (PQresultStatus(PGret) != PGRES_COMMAND_OK) {
+	db->errmsg = PQresultErrorMessage(PGret);
+	sql_db_errmsg(db);
+	sql_db_fail(db);
+      }
+      else Log(LOG_DEBUG, "DEBUG ( %s/%s ): %s\n", config.name, config.type, staging_clause);
+      PQclear(PGret);
+    }
+
     /* If using COPY, let's initialize it */
-    if (config.sql_use_copy) {
+    if (config.sql_use_copy && !db->fail) {
       PGret = PQexec(db->desc, copy_clause);
       if (PQresultStatus(PGret) != PGRES_COPY_IN) {
 	db->errmsg = PQresultErrorMessage(PGret);
@@ -970,9 +1110,13 @@ void PG_init_default_values(struct insert_data *idata)
   glob_dyn_table_time_only = idata->dyn_table_time_only;
 
   if (config.sql_backup_host) idata->recover = TRUE;
-  if (!config.sql_dont_try_update && config.sql_use_copy) config.sql_use_copy = FALSE; 
+  if (config.sql_copy_upsert) config.sql_use_copy = TRUE;
+  else if (!config.sql_dont_try_update && config.sql_use_copy) config.sql_use_copy = FALSE; 
 
   if (config.sql_locking_style) idata->locks = sql_select_locking_style(config.sql_locking_style);
+
+  if (config.sql_writer_connections > 1 && !config.sql_dont_try_update && idata->locks == PM_LOCK_EXCLUSIVE)
+    Log(LOG_WARNING, "WARN ( %s/%s ): table locking serializes sql_writer_connections. Consider sql_locking_style set to 'row' or 'none'.\n", config.name, config.type);
 }
 
 void PG_postgresql_get_version()
@@ -25,6 +25,13 @@
 /* defines */
 #define REPROCESS_SPECIFIC	1
 #define REPROCESS_BULK		2
+#define PG_COPY_BUFLEN		65536
+#define PG_COPY_STAGING_TABLE	"pmacct_copy_staging"
+
+struct PG_copy_buffer {
+  char *base;
+  int len;
+};
 
 /* prototypes */
 void pgsql_plugin(int, struct configuration *, void *);
@@ -33,6 +40,10 @@ int PG_cache_dbop_copy(struct DBdesc *, struct db_cache *, struct insert_data *)
 void PG_cache_purge(struct db_cache *[], int, struct insert_data *);
 int PG_evaluate_history(int);
 int PG_compose_static_queries();
+void PG_compose_copy_upsert(int);
+static struct PG_copy_buffer *PG_copy_buffer_get(struct DBdesc *);
+int PG_copy_flush(struct DBdesc *);
+int PG_copy_end(struct DBdesc *);
 void PG_compose_conn_string(struct DBdesc *, char *, int);
 void PG_Lock(struct DBdesc *);
 void PG_DB_Connect(struct DBdesc *, char *);
@@ -46,6 +57,8 @@ void PG_postgresql_get_version();
 
 /* global vars */
 int typed = TRUE;
+char staging_clause[LONGSRVBUFLEN];
+char upsert_clause[LONGLONGSRVBUFLEN];
 
 /* variables */
 static char pgsql_user[] = "pmacct";
@@ -71,4 +84,5 @@ static char pgsql_table_as_v3[] = "acct_as_v3";
 static char pgsql_table_as_v4[] = "acct_as_v4";
 static char pgsql_table_as_v5[] = "acct_as_v5";
 static char typed_str[] = "typed"; 
-static char unified_str[] = "unified"; 
+static char unified_str[] = "unified";
+static struct PG_copy_buffer copy_buf[BE_TYPE_BACKUP+1]; 
@@ -3891,7 +3891,7 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
 	    char tmp_stdcomms[MAX_BGP_STD_COMMS];
 
 	    if (info->attr->community && info->attr->community->str) {
-	      evaluate_comm_patterns(tmp_stdcomms, info->attr->community->str, std_comm_patterns_to_asn, MAX_BGP_STD_COMMS);
+	      evaluate_std_comm_patterns(tmp_stdcomms, info->attr->community, &std_comm_matchers_to_asn, MAX_BGP_STD_COMMS);
 	      copy_stdcomm_to_asn(tmp_stdcomms, &pdata->primitives.src_as, TRUE);
 	    }
 	  }
@@ -3902,19 +3902,9 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
           len = strlen(info->attr->aspath->str);
 
           if (len && (config.nfacctd_bgp_src_as_path_type & BGP_SRC_PRIMITIVES_BGP)) {
-            len++;
-
-            if (config.nfacctd_bgp_aspath_radius) {
-              ptr = strndup(info->attr->aspath->str, len);
-
-              if (ptr) {
-                evaluate_bgp_aspath_radius(ptr, len, config.nfacctd_bgp_aspath_radius);
-                len = strlen(ptr);
-                len++;
-              }
-              else len = 0;
-            }
-            else ptr = info->attr->aspath->str;
+            ptr = bgp_attr_str_aspath(info->attr->aspath);
+            if (ptr) len = (strlen(ptr) + 1);
+            else len = 0;
           }
           else ptr = &empty_str;
 
@@ -3923,19 +3913,24 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
             return;
           }
           else vlen_prims_insert(pvlen, COUNT_INT_SRC_AS_PATH, len, ptr, PM_MSG_STR_COPY);
-
-          if (config.nfacctd_bgp_aspath_radius && ptr && len) free(ptr);
         }
         /* fallback to legacy fixed length behaviour */
         else {
 	  if (config.nfacctd_bgp_src_as_path_type & BGP_SRC_PRIMITIVES_BGP) { 
-            strlcpy(plbgp->src_as_path, info->attr->aspath->str, MAX_BGP_ASPATH);
-            if (strlen(info->attr->aspath->str) >= MAX_BGP_ASPATH) {
-              plbgp->src_as_path[MAX_BGP_ASPATH-2] = '+';
-              plbgp->src_as_path[MAX_BGP_ASPATH-1] = '\0';
+            ptr = bgp_attr_str_aspath(info->attr->aspath);
+
+            /* trimmed before or after truncation, same result if it fits */
+            if (config.nfacctd_bgp_aspath_radius && ptr && strlen(ptr) < (MAX_BGP_ASPATH-2))
+              strlcpy(plbgp->src_as_path, ptr, MAX_BGP_ASPATH);
+            else {
+              strlcpy(plbgp->src_as_path, info->attr->aspath->str, MAX_BGP_ASPATH);
+              if (strlen(info->attr->aspath->str) >= MAX_BGP_ASPATH) {
+                plbgp->src_as_path[MAX_BGP_ASPATH-2] = '+';
+                plbgp->src_as_path[MAX_BGP_ASPATH-1] = '\0';
+              }
+              if (config.nfacctd_bgp_aspath_radius)
+                evaluate_bgp_aspath_radius(plbgp->src_as_path, MAX_BGP_ASPATH, config.nfacctd_bgp_aspath_radius);
             }
-            if (config.nfacctd_bgp_aspath_radius)
-              evaluate_bgp_aspath_radius(plbgp->src_as_path, MAX_BGP_ASPATH, config.nfacctd_bgp_aspath_radius);
 	  }
 	  else plbgp->src_as_path[0] = '\0';
         }
@@ -3945,19 +3940,9 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
           len = strlen(info->attr->community->str);
 
           if (len && (config.nfacctd_bgp_src_std_comm_type & BGP_SRC_PRIMITIVES_BGP)) {
-            len++;
-
-            if (config.nfacctd_bgp_stdcomm_pattern) {
-              ptr = malloc(len);
-
-              if (ptr) {
-                evaluate_comm_patterns(ptr, info->attr->community->str, std_comm_patterns, len);
-                len = strlen(ptr);
-                len++;
-              }
-              else len = 0;
-            }
-            else ptr = info->attr->community->str;
+            ptr = bgp_attr_str_std_comms(info->attr->community);
+            if (ptr) len = (strlen(ptr) + 1);
+            else len = 0;
           }
           else ptr = &empty_str;
 
@@ -3965,16 +3950,18 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
             vlen_prims_init(pvlen, 0);
             return;
           }
-          else {
-            vlen_prims_insert(pvlen, COUNT_INT_SRC_STD_COMM, len, ptr, PM_MSG_STR_COPY);
-            if (config.nfacctd_bgp_stdcomm_pattern && ptr && len) free(ptr);
-          }
+          else vlen_prims_insert(pvlen, COUNT_INT_SRC_STD_COMM, len, ptr, PM_MSG_STR_COPY);
         }
         /* fallback to legacy fixed length behaviour */
         else {
 	  if (config.nfacctd_bgp_src_std_comm_type & BGP_SRC_PRIMITIVES_BGP) {
-            if (config.nfacctd_bgp_stdcomm_pattern)
-              evaluate_comm_patterns(plbgp->src_std_comms, info->attr->community->str, std_comm_patterns, MAX_BGP_STD_COMMS);
+            if (config.nfacctd_bgp_stdcomm_pattern) {
+              ptr = bgp_attr_str_std_comms(info->attr->community);
+
+              if (bgp_attr_str_reusable(ptr, info->attr->community->str, MAX_BGP_STD_COMMS))
+                strlcpy(plbgp->src_std_comms, ptr, MAX_BGP_STD_COMMS);
+              else evaluate_std_comm_patterns(plbgp->src_std_comms, info->attr->community, &std_comm_matchers, MAX_BGP_STD_COMMS);
+            }
             else {
               strlcpy(plbgp->src_std_comms, info->attr->community->str, MAX_BGP_STD_COMMS);
               if (strlen(info->attr->community->str) >= MAX_BGP_STD_COMMS) {
@@ -3991,19 +3978,9 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
           len = strlen(info->attr->ecommunity->str);
 
           if (len && (config.nfacctd_bgp_src_ext_comm_type & BGP_SRC_PRIMITIVES_BGP)) {
-            len++;
-
-            if (config.nfacctd_bgp_extcomm_pattern) {
-              ptr = malloc(len);
-
-              if (ptr) {
-                evaluate_comm_patterns(ptr, info->attr->ecommunity->str, ext_comm_patterns, len);
-                len = strlen(ptr);
-                len++;
-              }
-              else len = 0;
-            }
-            else ptr = info->attr->ecommunity->str;
+            ptr = bgp_attr_str_ext_comms(info->attr->ecommunity);
+            if (ptr) len = (strlen(ptr) + 1);
+            else len = 0;
           }
           else ptr = &empty_str;
 
@@ -4011,16 +3988,18 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
             vlen_prims_init(pvlen, 0);
             return;
           }
-          else {
-            vlen_prims_insert(pvlen, COUNT_INT_SRC_EXT_COMM, len, ptr, PM_MSG_STR_COPY);
-            if (config.nfacctd_bgp_extcomm_pattern && ptr && len) free(ptr);
-          }
+          else vlen_prims_insert(pvlen, COUNT_INT_SRC_EXT_COMM, len, ptr, PM_MSG_STR_COPY);
         }
         /* fallback to legacy fixed length behaviour */
         else {
 	  if (config.nfacctd_bgp_src_ext_comm_type & BGP_SRC_PRIMITIVES_BGP) {
-            if (config.nfacctd_bgp_extcomm_pattern)
-              evaluate_comm_patterns(plbgp->src_ext_comms, info->attr->ecommunity->str, ext_comm_patterns, MAX_BGP_EXT_COMMS);
+            if (config.nfacctd_bgp_extcomm_pattern) {
+              ptr = bgp_attr_str_ext_comms(info->attr->ecommunity);
+
+              if (bgp_attr_str_reusable(ptr, info->attr->ecommunity->str, MAX_BGP_EXT_COMMS))
+                strlcpy(plbgp->src_ext_comms, ptr, MAX_BGP_EXT_COMMS);
+              else evaluate_comm_patterns(plbgp->src_ext_comms, info->attr->ecommunity->str, ext_comm_patterns, MAX_BGP_EXT_COMMS);
+            }
             else {
               strlcpy(plbgp->src_ext_comms, info->attr->ecommunity->str, MAX_BGP_EXT_COMMS);
               if (strlen(info->attr->ecommunity->str) >= MAX_BGP_EXT_COMMS) {
@@ -4037,19 +4016,9 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
           len = strlen(info->attr->lcommunity->str);
 
           if (len && (config.nfacctd_bgp_src_lrg_comm_type & BGP_SRC_PRIMITIVES_BGP)) {
-            len++;
-
-            if (config.nfacctd_bgp_lrgcomm_pattern) {
-              ptr = malloc(len);
-
-              if (ptr) {
-                evaluate_comm_patterns(ptr, info->attr->lcommunity->str, lrg_comm_patterns, len);
-                len = strlen(ptr);
-                len++;
-              }
-              else len = 0;
-            }
-            else ptr = info->attr->lcommunity->str;
+            ptr = bgp_attr_str_lrg_comms(info->attr->lcommunity);
+            if (ptr) len = (strlen(ptr) + 1);
+            else len = 0;
           }
           else ptr = &empty_str;
 
@@ -4057,15 +4026,17 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
             vlen_prims_init(pvlen, 0);
             return;
           }
-          else {
-            vlen_prims_insert(pvlen, COUNT_INT_SRC_LRG_COMM, len, ptr, PM_MSG_STR_COPY);
-            if (config.nfacctd_bgp_lrgcomm_pattern && ptr && len) free(ptr);
-          }
+          else vlen_prims_insert(pvlen, COUNT_INT_SRC_LRG_COMM, len, ptr, PM_MSG_STR_COPY);
         }
         else {
 	  if (config.nfacctd_bgp_src_lrg_comm_type & BGP_SRC_PRIMITIVES_BGP) {
-            if (config.nfacctd_bgp_lrgcomm_pattern)
-              evaluate_comm_patterns(plbgp->src_lrg_comms, info->attr->lcommunity->str, lrg_comm_patterns, MAX_BGP_LRG_COMMS);
+            if (config.nfacctd_bgp_lrgcomm_pattern) {
+              ptr = bgp_attr_str_lrg_comms(info->attr->lcommunity);
+
+              if (bgp_attr_str_reusable(ptr, info->attr->lcommunity->str, MAX_BGP_LRG_COMMS))
+                strlcpy(plbgp->src_lrg_comms, ptr, MAX_BGP_LRG_COMMS);
+              else evaluate_lrg_comm_patterns(plbgp->src_lrg_comms, info->attr->lcommunity, &lrg_comm_matchers, MAX_BGP_LRG_COMMS);
+            }
             else {
               strlcpy(plbgp->src_lrg_comms, info->attr->lcommunity->str, MAX_BGP_LRG_COMMS);
               if (strlen(info->attr->lcommunity->str) >= MAX_BGP_LRG_COMMS) {
@@ -4090,7 +4061,7 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
           char tmp_stdcomms[MAX_BGP_STD_COMMS];
 
           if (info->attr->community && info->attr->community->str) {
-            evaluate_comm_patterns(tmp_stdcomms, info->attr->community->str, std_comm_patterns_to_asn, MAX_BGP_STD_COMMS);
+            evaluate_std_comm_patterns(tmp_stdcomms, info->attr->community, &std_comm_matchers_to_asn, MAX_BGP_STD_COMMS);
             copy_stdcomm_to_asn(tmp_stdcomms, &pbgp->peer_src_as, FALSE);
           }
         }
@@ -4154,19 +4125,9 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
           len = strlen(info->attr->community->str);
             
           if (len) { 
-	    len++;
-
-            if (config.nfacctd_bgp_stdcomm_pattern) {
-              ptr = malloc(len);
-
-              if (ptr) {
-                evaluate_comm_patterns(ptr, info->attr->community->str, std_comm_patterns, len);
-                len = strlen(ptr);
-		len++;
-              }
-              else len = 0;
-            }
-            else ptr = info->attr->community->str; 
+            ptr = bgp_attr_str_std_comms(info->attr->community);
+            if (ptr) len = (strlen(ptr) + 1);
+            else len = 0;
           }
           else ptr = &empty_str;
         
@@ -4174,15 +4135,17 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
             vlen_prims_init(pvlen, 0);
             return;
           }
-          else {
-            vlen_prims_insert(pvlen, COUNT_INT_STD_COMM, len, ptr, PM_MSG_STR_COPY);
-            if (config.nfacctd_bgp_stdcomm_pattern && ptr && len) free(ptr);
-          }
+          else vlen_prims_insert(pvlen, COUNT_INT_STD_COMM, len, ptr, PM_MSG_STR_COPY);
         }
         /* fallback to legacy fixed length behaviour */
 	else {
-	  if (config.nfacctd_bgp_stdcomm_pattern)
-	    evaluate_comm_patterns(plbgp->std_comms, info->attr->community->str, std_comm_patterns, MAX_BGP_STD_COMMS);
+	  if (config.nfacctd_bgp_stdcomm_pattern) {
+	    ptr = bgp_attr_str_std_comms(info->attr->community);
+
+	    if (bgp_attr_str_reusable(ptr, info->attr->community->str, MAX_BGP_STD_COMMS))
+	      strlcpy(plbgp->std_comms, ptr, MAX_BGP_STD_COMMS);
+	    else evaluate_std_comm_patterns(plbgp->std_comms, info->attr->community, &std_comm_matchers, MAX_BGP_STD_COMMS);
+	  }
 	  else {
             strlcpy(plbgp->std_comms, info->attr->community->str, MAX_BGP_STD_COMMS);
 	    if (strlen(info->attr->community->str) >= MAX_BGP_STD_COMMS) {
@@ -4197,19 +4160,9 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
           len = strlen(info->attr->ecommunity->str);
 
           if (len) {
-	    len++;
-
-            if (config.nfacctd_bgp_extcomm_pattern) {
-              ptr = malloc(len);
-
-              if (ptr) {
-                evaluate_comm_patterns(ptr, info->attr->ecommunity->str, ext_comm_patterns, len);
-                len = strlen(ptr);
-		len++;
-              }
-              else len = 0;
-            }
-            else ptr = info->attr->ecommunity->str;
+            ptr = bgp_attr_str_ext_comms(info->attr->ecommunity);
+            if (ptr) len = (strlen(ptr) + 1);
+            else len = 0;
           }
           else ptr = &empty_str;
 
@@ -4217,15 +4170,17 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
             vlen_prims_init(pvlen, 0);
             return;
           }
-          else {
-            vlen_prims_insert(pvlen, COUNT_INT_EXT_COMM, len, ptr, PM_MSG_STR_COPY);
-            if (config.nfacctd_bgp_extcomm_pattern && ptr && len) free(ptr);
-          }
+          else vlen_prims_insert(pvlen, COUNT_INT_EXT_COMM, len, ptr, PM_MSG_STR_COPY);
         }
         /* fallback to legacy fixed length behaviour */
         else {
-	  if (config.nfacctd_bgp_extcomm_pattern)
-	    evaluate_comm_patterns(plbgp->ext_comms, info->attr->ecommunity->str, ext_comm_patterns, MAX_BGP_EXT_COMMS);
+	  if (config.nfacctd_bgp_extcomm_pattern) {
+	    ptr = bgp_attr_str_ext_comms(info->attr->ecommunity);
+
+	    if (bgp_attr_str_reusable(ptr, info->attr->ecommunity->str, MAX_BGP_EXT_COMMS))
+	      strlcpy(plbgp->ext_comms, ptr, MAX_BGP_EXT_COMMS);
+	    else evaluate_comm_patterns(plbgp->ext_comms, info->attr->ecommunity->str, ext_comm_patterns, MAX_BGP_EXT_COMMS);
+	  }
 	  else {
             strlcpy(plbgp->ext_comms, info->attr->ecommunity->str, MAX_BGP_EXT_COMMS);
 	    if (strlen(info->attr->ecommunity->str) >= MAX_BGP_EXT_COMMS) {
@@ -4240,19 +4195,9 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
           len = strlen(info->attr->lcommunity->str);
 
           if (len) {
-            len++;
-
-            if (config.nfacctd_bgp_lrgcomm_pattern) {
-              ptr = malloc(len);
-
-              if (ptr) {
-                evaluate_comm_patterns(ptr, info->attr->lcommunity->str, lrg_comm_patterns, len);
-                len = strlen(ptr);
-                len++;
-              }
-              else len = 0;
-            }
-            else ptr = info->attr->lcommunity->str;
+            ptr = bgp_attr_str_lrg_comms(info->attr->lcommunity);
+            if (ptr) len = (strlen(ptr) + 1);
+            else len = 0;
           }
           else ptr = &empty_str;
 
@@ -4260,15 +4205,17 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
             vlen_prims_init(pvlen, 0);
             return;
           }
-          else {
-            vlen_prims_insert(pvlen, COUNT_INT_LRG_COMM, len, ptr, PM_MSG_STR_COPY);
-            if (config.nfacctd_bgp_lrgcomm_pattern && ptr && len) free(ptr);
-          }
+          else vlen_prims_insert(pvlen, COUNT_INT_LRG_COMM, len, ptr, PM_MSG_STR_COPY);
         }
         /* fallback to legacy fixed length behaviour */
         else {
-          if (config.nfacctd_bgp_lrgcomm_pattern)
-            evaluate_comm_patterns(plbgp->lrg_comms, info->attr->lcommunity->str, lrg_comm_patterns, MAX_BGP_LRG_COMMS);
+          if (config.nfacctd_bgp_lrgcomm_pattern) {
+            ptr = bgp_attr_str_lrg_comms(info->attr->lcommunity);
+
+            if (bgp_attr_str_reusable(ptr, info->attr->lcommunity->str, MAX_BGP_LRG_COMMS))
+              strlcpy(plbgp->lrg_comms, ptr, MAX_BGP_LRG_COMMS);
+            else evaluate_lrg_comm_patterns(plbgp->lrg_comms, info->attr->lcommunity, &lrg_comm_matchers, MAX_BGP_LRG_COMMS);
+          }
           else {
             strlcpy(plbgp->lrg_comms, info->attr->lcommunity->str, MAX_BGP_LRG_COMMS);
             if (strlen(info->attr->lcommunity->str) >= MAX_BGP_LRG_COMMS) {
@@ -4283,19 +4230,9 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
           len = strlen(info->attr->aspath->str);
 
           if (len) {
-	    len++;
-
-            if (config.nfacctd_bgp_aspath_radius) {
-              ptr = strndup(info->attr->aspath->str, len);
-
-              if (ptr) {
-                evaluate_bgp_aspath_radius(ptr, len, config.nfacctd_bgp_aspath_radius);
-                len = strlen(ptr);
-		len++;
-              }
-              else len = 0;
-            }
-            else ptr = info->attr->aspath->str;
+            ptr = bgp_attr_str_aspath(info->attr->aspath);
+            if (ptr) len = (strlen(ptr) + 1);
+            else len = 0;
           }
           else ptr = &empty_str;
 
@@ -4304,18 +4241,23 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
             return;
           }
           else vlen_prims_insert(pvlen, COUNT_INT_AS_PATH, len, ptr, PM_MSG_STR_COPY);
-
-          if (config.nfacctd_bgp_aspath_radius && ptr && len) free(ptr);
 	}
 	/* fallback to legacy fixed length behaviour */
 	else {
-	  strlcpy(plbgp->as_path, info->attr->aspath->str, MAX_BGP_ASPATH);
-	  if (strlen(info->attr->aspath->str) >= MAX_BGP_ASPATH) {
-	    plbgp->as_path[MAX_BGP_ASPATH-2] = '+';
-	    plbgp->as_path[MAX_BGP_ASPATH-1] = '\0';
+	  ptr = bgp_attr_str_aspath(info->attr->aspath);
+
+	  /* trimmed before or after truncation, same result if it fits */
+	  if (config.nfacctd_bgp_aspath_radius && ptr && strlen(ptr) < (MAX_BGP_ASPATH-2))
+	    strlcpy(plbgp->as_path, ptr, MAX_BGP_ASPATH);
+	  else {
+	    strlcpy(plbgp->as_path, info->attr->aspath->str, MAX_BGP_ASPATH);
+	    if (strlen(info->attr->aspath->str) >= MAX_BGP_ASPATH) {
+	      plbgp->as_path[MAX_BGP_ASPATH-2] = '+';
+	      plbgp->as_path[MAX_BGP_ASPATH-1] = '\0';
+	    }
+	    if (config.nfacctd_bgp_aspath_radius)
+	      evaluate_bgp_aspath_radius(plbgp->as_path, MAX_BGP_ASPATH, config.nfacctd_bgp_aspath_radius);
 	  }
-	  if (config.nfacctd_bgp_aspath_radius)
-	    evaluate_bgp_aspath_radius(plbgp->as_path, MAX_BGP_ASPATH, config.nfacctd_bgp_aspath_radius);
 	}
       }
       if (config.nfacctd_as & NF_AS_BGP) {
@@ -4326,7 +4268,7 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
             char tmp_stdcomms[MAX_BGP_STD_COMMS];
 
             if (info->attr->community && info->attr->community->str) {
-              evaluate_comm_patterns(tmp_stdcomms, info->attr->community->str, std_comm_patterns_to_asn, MAX_BGP_STD_COMMS);
+              evaluate_std_comm_patterns(tmp_stdcomms, info->attr->community, &std_comm_matchers_to_asn, MAX_BGP_STD_COMMS);
               copy_stdcomm_to_asn(tmp_stdcomms, &pdata->primitives.dst_as, TRUE);
             }
 	  }
@@ -4344,7 +4286,7 @@ void bgp_ext_handler(struct channels_list_entry *chptr, struct packet_ptrs *pptr
           char tmp_stdcomms[MAX_BGP_STD_COMMS];
 
           if (info->attr->community && info->attr->community->str) {
-            evaluate_comm_patterns(tmp_stdcomms, info->attr->community->str, std_comm_patterns_to_asn, MAX_BGP_STD_COMMS);
+            evaluate_std_comm_patterns(tmp_stdcomms, info->attr->community, &std_comm_matchers_to_asn, MAX_BGP_STD_COMMS);
             copy_stdcomm_to_asn(tmp_stdcomms, &pbgp->peer_dst_as, FALSE);
           }
         }
@@ -4494,7 +4436,7 @@ void bgp_peer_src_as_frommap_handler(struct channels_list_entry *chptr, struct p
       info = (struct bgp_info *) pptrs->bgp_src_info;
 
       if (info && info->attr && info->attr->community && info->attr->community->str) {
-        evaluate_comm_patterns(tmp_stdcomms, info->attr->community->str, std_comm_patterns_to_asn, MAX_BGP_STD_COMMS);
+        evaluate_std_comm_patterns(tmp_stdcomms, info->attr->community, &std_comm_matchers_to_asn, MAX_BGP_STD_COMMS);
         copy_stdcomm_to_asn(tmp_stdcomms, &pbgp->peer_src_as, FALSE);
       }
     }
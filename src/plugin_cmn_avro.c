@@ -279,28 +279,29 @@ void avro_schema_add_writer_id(avro_schema_t schema)
   avro_schema_record_field_append(schema, "writer_id", avro_schema_string());
 }
 
-avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, struct pkt_primitives *pbase,
+void compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, struct pkt_primitives *pbase,
   struct pkt_bgp_primitives *pbgp, struct pkt_nat_primitives *pnat, struct pkt_mpls_primitives *pmpls,
   struct pkt_tunnel_primitives *ptun, char *pcust, struct pkt_vlen_hdr_primitives *pvlen,
   pm_counter_t bytes_counter, pm_counter_t packet_counter, pm_counter_t flow_counter, u_int32_t tcp_flags,
-  struct timeval *basetime, struct pkt_stitching *stitch, avro_value_iface_t *iface)
+  struct timeval *basetime, struct pkt_stitching *stitch, avro_value_t *value)
 {
   char src_mac[18], dst_mac[18], src_host[INET6_ADDRSTRLEN], dst_host[INET6_ADDRSTRLEN], ip_address[INET6_ADDRSTRLEN];
   char rd_str[SRVBUFLEN], misc_str[SRVBUFLEN], *as_path, *bgp_comm, empty_string[] = "", *str_ptr;
   char tstamp_str[SRVBUFLEN];
 
-  avro_value_t value;
   avro_value_t field;
   avro_value_t branch;
-  check_i(avro_generic_value_new(iface, &value));
+
+  /* value is reused across records: every field is set below */
+  check_i(avro_value_reset(value));
 
   if (wtc & COUNT_TAG) {
-    check_i(avro_value_get_by_name(&value, "tag", &field, NULL));
+    check_i(avro_value_get_by_name(value, "tag", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->tag));
   }
 
   if (wtc & COUNT_TAG2) {
-    check_i(avro_value_get_by_name(&value, "tag2", &field, NULL));
+    check_i(avro_value_get_by_name(value, "tag2", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->tag2));
   }
 
@@ -308,12 +309,12 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     vlen_prims_get(pvlen, COUNT_INT_LABEL, &str_ptr);
     if (!str_ptr) str_ptr = empty_string;
 
-    check_i(avro_value_get_by_name(&value, "label", &field, NULL));
+    check_i(avro_value_get_by_name(value, "label", &field, NULL));
     check_i(avro_value_set_string(&field, str_ptr));
   }
 
   if (wtc & COUNT_CLASS) {
-    check_i(avro_value_get_by_name(&value, "class", &field, NULL));
+    check_i(avro_value_get_by_name(value, "class", &field, NULL));
     check_i(avro_value_set_string(&field, ((pbase->class && class[(pbase->class)-1].id) ? class[(pbase->class)-1].protocol : "unknown" )));
   }
 
@@ -325,7 +326,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
 	ndpi_get_proto_name(pm_ndpi_wfl->ndpi_struct, pbase->ndpi_class.master_protocol),
 	ndpi_get_proto_name(pm_ndpi_wfl->ndpi_struct, pbase->ndpi_class.app_protocol));
 
-    check_i(avro_value_get_by_name(&value, "class", &field, NULL));
+    check_i(avro_value_get_by_name(value, "class", &field, NULL));
     check_i(avro_value_set_string(&field, ndpi_class));
   }
 #endif
@@ -333,40 +334,40 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
 #if defined (HAVE_L2)
   if (wtc & (COUNT_SRC_MAC|COUNT_SUM_MAC)) {
     etheraddr_string(pbase->eth_shost, src_mac);
-    check_i(avro_value_get_by_name(&value, "mac_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "mac_src", &field, NULL));
     check_i(avro_value_set_string(&field, src_mac));
   }
 
   if (wtc & COUNT_DST_MAC) {
     etheraddr_string(pbase->eth_dhost, dst_mac);
-    check_i(avro_value_get_by_name(&value, "mac_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "mac_dst", &field, NULL));
     check_i(avro_value_set_string(&field, dst_mac));
   }
 
   if (wtc & COUNT_VLAN) {
-    check_i(avro_value_get_by_name(&value, "vlan", &field, NULL));
+    check_i(avro_value_get_by_name(value, "vlan", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->vlan_id));
   }
 
   if (wtc & COUNT_COS) {
-    check_i(avro_value_get_by_name(&value, "cos", &field, NULL));
+    check_i(avro_value_get_by_name(value, "cos", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->cos));
   }
 
   if (wtc & COUNT_ETHERTYPE) {
     sprintf(misc_str, "%x", pbase->etype);
-    check_i(avro_value_get_by_name(&value, "etype", &field, NULL));
+    check_i(avro_value_get_by_name(value, "etype", &field, NULL));
     check_i(avro_value_set_string(&field, misc_str));
   }
 #endif
 
   if (wtc & (COUNT_SRC_AS|COUNT_SUM_AS)) {
-    check_i(avro_value_get_by_name(&value, "as_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "as_src", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->src_as));
   }
 
   if (wtc & COUNT_DST_AS) {
-    check_i(avro_value_get_by_name(&value, "as_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "as_dst", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->dst_as));
   }
 
@@ -381,7 +382,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     }
     else str_ptr = empty_string;
 
-    check_i(avro_value_get_by_name(&value, "comms", &field, NULL));
+    check_i(avro_value_get_by_name(value, "comms", &field, NULL));
     check_i(avro_value_set_string(&field, str_ptr));
   }
 
@@ -396,7 +397,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     }
     else str_ptr = empty_string;
 
-    check_i(avro_value_get_by_name(&value, "ecomms", &field, NULL));
+    check_i(avro_value_get_by_name(value, "ecomms", &field, NULL));
     check_i(avro_value_set_string(&field, str_ptr));
   }
 
@@ -411,7 +412,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     }
     else str_ptr = empty_string;
 
-    check_i(avro_value_get_by_name(&value, "lcomms", &field, NULL));
+    check_i(avro_value_get_by_name(value, "lcomms", &field, NULL));
     check_i(avro_value_set_string(&field, str_ptr));
   }
 
@@ -426,38 +427,38 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     }
     else str_ptr = empty_string;
 
-    check_i(avro_value_get_by_name(&value, "as_path", &field, NULL));
+    check_i(avro_value_get_by_name(value, "as_path", &field, NULL));
     check_i(avro_value_set_string(&field, str_ptr));
   }
 
   if (wtc & COUNT_LOCAL_PREF) {
-    check_i(avro_value_get_by_name(&value, "local_pref", &field, NULL));
+    check_i(avro_value_get_by_name(value, "local_pref", &field, NULL));
     check_i(avro_value_set_long(&field, pbgp->local_pref));
   }
 
   if (wtc & COUNT_MED) {
-    check_i(avro_value_get_by_name(&value, "med", &field, NULL));
+    check_i(avro_value_get_by_name(value, "med", &field, NULL));
     check_i(avro_value_set_long(&field, pbgp->med));
   }
 
   if (wtc & COUNT_PEER_SRC_AS) {
-    check_i(avro_value_get_by_name(&value, "peer_as_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "peer_as_src", &field, NULL));
     check_i(avro_value_set_long(&field, pbgp->peer_src_as));
   }
 
   if (wtc & COUNT_PEER_DST_AS) {
-    check_i(avro_value_get_by_name(&value, "peer_as_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "peer_as_dst", &field, NULL));
     check_i(avro_value_set_long(&field, pbgp->peer_dst_as));
   }
 
   if (wtc & COUNT_PEER_SRC_IP) {
-    check_i(avro_value_get_by_name(&value, "peer_ip_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "peer_ip_src", &field, NULL));
     addr_to_str(ip_address, &pbgp->peer_src_ip);
     check_i(avro_value_set_string(&field, ip_address));
   }
 
   if (wtc & COUNT_PEER_DST_IP) {
-    check_i(avro_value_get_by_name(&value, "peer_ip_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "peer_ip_dst", &field, NULL));
     addr_to_str(ip_address, &pbgp->peer_dst_ip);
     check_i(avro_value_set_string(&field, ip_address));
   }
@@ -473,7 +474,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     }
     else str_ptr = empty_string;
 
-    check_i(avro_value_get_by_name(&value, "src_comms", &field, NULL));
+    check_i(avro_value_get_by_name(value, "src_comms", &field, NULL));
     check_i(avro_value_set_string(&field, str_ptr));
   }
 
@@ -488,7 +489,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     }
     else str_ptr = empty_string;
 
-    check_i(avro_value_get_by_name(&value, "src_ecomms", &field, NULL));
+    check_i(avro_value_get_by_name(value, "src_ecomms", &field, NULL));
     check_i(avro_value_set_string(&field, str_ptr));
   }
 
@@ -503,7 +504,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     }
     else str_ptr = empty_string;
 
-    check_i(avro_value_get_by_name(&value, "src_lcomms", &field, NULL));
+    check_i(avro_value_get_by_name(value, "src_lcomms", &field, NULL));
     check_i(avro_value_set_string(&field, str_ptr));
   }
 
@@ -518,83 +519,83 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     }
     else str_ptr = empty_string;
 
-    check_i(avro_value_get_by_name(&value, "src_as_path", &field, NULL));
+    check_i(avro_value_get_by_name(value, "src_as_path", &field, NULL));
     check_i(avro_value_set_string(&field, str_ptr));
   }
 
   if (wtc & COUNT_SRC_LOCAL_PREF) {
-    check_i(avro_value_get_by_name(&value, "src_local_pref", &field, NULL));
+    check_i(avro_value_get_by_name(value, "src_local_pref", &field, NULL));
     check_i(avro_value_set_long(&field, pbgp->src_local_pref));
   }
 
   if (wtc & COUNT_SRC_MED) {
-    check_i(avro_value_get_by_name(&value, "src_med", &field, NULL));
+    check_i(avro_value_get_by_name(value, "src_med", &field, NULL));
     check_i(avro_value_set_long(&field, pbgp->src_med));
   }
 
   if (wtc & COUNT_IN_IFACE) {
-    check_i(avro_value_get_by_name(&value, "iface_in", &field, NULL));
+    check_i(avro_value_get_by_name(value, "iface_in", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->ifindex_in));
   }
 
   if (wtc & COUNT_OUT_IFACE) {
-    check_i(avro_value_get_by_name(&value, "iface_out", &field, NULL));
+    check_i(avro_value_get_by_name(value, "iface_out", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->ifindex_out));
   }
 
   if (wtc & COUNT_MPLS_VPN_RD) {
     bgp_rd2str(rd_str, &pbgp->mpls_vpn_rd);
-    check_i(avro_value_get_by_name(&value, "mpls_vpn_rd", &field, NULL));
+    check_i(avro_value_get_by_name(value, "mpls_vpn_rd", &field, NULL));
     check_i(avro_value_set_string(&field, rd_str));
   }
 
   if (wtc & (COUNT_SRC_HOST|COUNT_SUM_HOST)) {
     addr_to_str(src_host, &pbase->src_ip);
-    check_i(avro_value_get_by_name(&value, "ip_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "ip_src", &field, NULL));
     check_i(avro_value_set_string(&field, src_host));
   }
 
   if (wtc & (COUNT_SRC_NET|COUNT_SUM_NET)) {
     addr_to_str(src_host, &pbase->src_net);
-    check_i(avro_value_get_by_name(&value, "net_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "net_src", &field, NULL));
     check_i(avro_value_set_string(&field, src_host));
   }
 
   if (wtc & COUNT_DST_HOST) {
     addr_to_str(dst_host, &pbase->dst_ip);
-    check_i(avro_value_get_by_name(&value, "ip_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "ip_dst", &field, NULL));
     check_i(avro_value_set_string(&field, dst_host));
   }
 
   if (wtc & COUNT_DST_NET) {
     addr_to_str(dst_host, &pbase->dst_net);
-    check_i(avro_value_get_by_name(&value, "net_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "net_dst", &field, NULL));
     check_i(avro_value_set_string(&field, dst_host));
   }
 
   if (wtc & COUNT_SRC_NMASK) {
-    check_i(avro_value_get_by_name(&value, "mask_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "mask_src", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->src_nmask));
   }
 
   if (wtc & COUNT_DST_NMASK) {
-    check_i(avro_value_get_by_name(&value, "mask_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "mask_dst", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->dst_nmask));
   }
 
   if (wtc & (COUNT_SRC_PORT|COUNT_SUM_PORT)) {
-    check_i(avro_value_get_by_name(&value, "port_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "port_src", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->src_port));
   }
 
   if (wtc & COUNT_DST_PORT) {
-    check_i(avro_value_get_by_name(&value, "port_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "port_dst", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->dst_port));
   }
 
 #if defined (WITH_GEOIP)
   if (wtc_2 & COUNT_SRC_HOST_COUNTRY) {
-    check_i(avro_value_get_by_name(&value, "country_ip_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "country_ip_src", &field, NULL));
     if (pbase->src_ip_country.id > 0)
       check_i(avro_value_set_string(&field, GeoIP_code_by_id(pbase->src_ip_country.id)));
     else
@@ -602,7 +603,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
   }
 
   if (wtc_2 & COUNT_DST_HOST_COUNTRY) {
-    check_i(avro_value_get_by_name(&value, "country_ip_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "country_ip_dst", &field, NULL));
     if (pbase->dst_ip_country.id > 0)
       check_i(avro_value_set_string(&field, GeoIP_code_by_id(pbase->dst_ip_country.id)));
     else
@@ -611,7 +612,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
 #endif
 #if defined (WITH_GEOIPV2)
   if (wtc_2 & COUNT_SRC_HOST_COUNTRY) {
-    check_i(avro_value_get_by_name(&value, "country_ip_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "country_ip_src", &field, NULL));
     if (strlen(pbase->src_ip_country.str))
       check_i(avro_value_set_string(&field, pbase->src_ip_country.str));
     else
@@ -619,7 +620,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
   }
 
   if (wtc_2 & COUNT_DST_HOST_COUNTRY) {
-    check_i(avro_value_get_by_name(&value, "country_ip_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "country_ip_dst", &field, NULL));
     if (strlen(pbase->dst_ip_country.str))
       check_i(avro_value_set_string(&field, pbase->dst_ip_country.str));
     else
@@ -627,7 +628,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
   }
 
   if (wtc_2 & COUNT_SRC_HOST_POCODE) {
-    check_i(avro_value_get_by_name(&value, "pocode_ip_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "pocode_ip_src", &field, NULL));
     if (strlen(pbase->src_ip_pocode.str))
       check_i(avro_value_set_string(&field, pbase->src_ip_pocode.str));
     else
@@ -635,7 +636,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
   }
 
   if (wtc_2 & COUNT_DST_HOST_POCODE) {
-    check_i(avro_value_get_by_name(&value, "pocode_ip_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "pocode_ip_dst", &field, NULL));
     if (strlen(pbase->dst_ip_pocode.str))
       check_i(avro_value_set_string(&field, pbase->dst_ip_pocode.str));
     else
@@ -645,12 +646,12 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
 
   if (wtc & COUNT_TCPFLAGS) {
     sprintf(misc_str, "%u", tcp_flags);
-    check_i(avro_value_get_by_name(&value, "tcp_flags", &field, NULL));
+    check_i(avro_value_get_by_name(value, "tcp_flags", &field, NULL));
     check_i(avro_value_set_string(&field, misc_str));
   }
 
   if (wtc & COUNT_IP_PROTO) {
-    check_i(avro_value_get_by_name(&value, "ip_proto", &field, NULL));
+    check_i(avro_value_get_by_name(value, "ip_proto", &field, NULL));
     if (!config.num_protos && (pbase->proto < protocols_number))
       check_i(avro_value_set_string(&field, _protocols[pbase->proto].name));
     else {
@@ -661,71 +662,71 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
   }
 
   if (wtc & COUNT_IP_TOS) {
-    check_i(avro_value_get_by_name(&value, "tos", &field, NULL));
+    check_i(avro_value_get_by_name(value, "tos", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->tos));
   }
 
   if (wtc_2 & COUNT_SAMPLING_RATE) {
-    check_i(avro_value_get_by_name(&value, "sampling_rate", &field, NULL));
+    check_i(avro_value_get_by_name(value, "sampling_rate", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->sampling_rate));
   }
 
   if (wtc_2 & COUNT_POST_NAT_SRC_HOST) {
     addr_to_str(src_host, &pnat->post_nat_src_ip);
-    check_i(avro_value_get_by_name(&value, "post_nat_ip_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "post_nat_ip_src", &field, NULL));
     check_i(avro_value_set_string(&field, src_host));
   }
 
   if (wtc_2 & COUNT_POST_NAT_DST_HOST) {
     addr_to_str(dst_host, &pnat->post_nat_dst_ip);
-    check_i(avro_value_get_by_name(&value, "post_nat_ip_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "post_nat_ip_dst", &field, NULL));
     check_i(avro_value_set_string(&field, dst_host));
   }
 
   if (wtc_2 & COUNT_POST_NAT_SRC_PORT) {
-    check_i(avro_value_get_by_name(&value, "post_nat_port_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "post_nat_port_src", &field, NULL));
     check_i(avro_value_set_long(&field, pnat->post_nat_src_port));
   }
 
   if (wtc_2 & COUNT_POST_NAT_DST_PORT) {
-    check_i(avro_value_get_by_name(&value, "post_nat_port_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "post_nat_port_dst", &field, NULL));
     check_i(avro_value_set_long(&field, pnat->post_nat_dst_port));
   }
 
   if (wtc_2 & COUNT_NAT_EVENT) {
-    check_i(avro_value_get_by_name(&value, "nat_event", &field, NULL));
+    check_i(avro_value_get_by_name(value, "nat_event", &field, NULL));
     check_i(avro_value_set_long(&field, pnat->nat_event));
   }
 
   if (wtc_2 & COUNT_MPLS_LABEL_TOP) {
-    check_i(avro_value_get_by_name(&value, "mpls_label_top", &field, NULL));
+    check_i(avro_value_get_by_name(value, "mpls_label_top", &field, NULL));
     check_i(avro_value_set_long(&field, pmpls->mpls_label_top));
   }
 
   if (wtc_2 & COUNT_MPLS_LABEL_BOTTOM) {
-    check_i(avro_value_get_by_name(&value, "mpls_label_bottom", &field, NULL));
+    check_i(avro_value_get_by_name(value, "mpls_label_bottom", &field, NULL));
     check_i(avro_value_set_long(&field, pmpls->mpls_label_bottom));
   }
 
   if (wtc_2 & COUNT_MPLS_STACK_DEPTH) {
-    check_i(avro_value_get_by_name(&value, "mpls_stack_depth", &field, NULL));
+    check_i(avro_value_get_by_name(value, "mpls_stack_depth", &field, NULL));
     check_i(avro_value_set_long(&field, pmpls->mpls_stack_depth));
   }
 
   if (wtc_2 & COUNT_TUNNEL_SRC_HOST) {
     addr_to_str(src_host, &ptun->tunnel_src_ip);
-    check_i(avro_value_get_by_name(&value, "tunnel_ip_src", &field, NULL));
+    check_i(avro_value_get_by_name(value, "tunnel_ip_src", &field, NULL));
     check_i(avro_value_set_string(&field, src_host));
   }
 
   if (wtc_2 & COUNT_TUNNEL_DST_HOST) {
     addr_to_str(dst_host, &ptun->tunnel_dst_ip);
-    check_i(avro_value_get_by_name(&value, "tunnel_ip_dst", &field, NULL));
+    check_i(avro_value_get_by_name(value, "tunnel_ip_dst", &field, NULL));
     check_i(avro_value_set_string(&field, dst_host));
   }
 
   if (wtc_2 & COUNT_TUNNEL_IP_PROTO) {
-    check_i(avro_value_get_by_name(&value, "tunnel_ip_proto", &field, NULL));
+    check_i(avro_value_get_by_name(value, "tunnel_ip_proto", &field, NULL));
     if (!config.num_protos && (ptun->tunnel_proto < protocols_number))
       check_i(avro_value_set_string(&field, _protocols[ptun->tunnel_proto].name));
     else {
@@ -736,7 +737,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
   }
 
   if (wtc_2 & COUNT_TUNNEL_IP_TOS) {
-    check_i(avro_value_get_by_name(&value, "tunnel_tos", &field, NULL));
+    check_i(avro_value_get_by_name(value, "tunnel_tos", &field, NULL));
     check_i(avro_value_set_long(&field, ptun->tunnel_tos));
   }
 
@@ -744,7 +745,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     compose_timestamp(tstamp_str, SRVBUFLEN, &pnat->timestamp_start, TRUE,
 		      config.timestamps_since_epoch, config.timestamps_rfc3339,
 		      config.timestamps_utc);
-    check_i(avro_value_get_by_name(&value, "timestamp_start", &field, NULL));
+    check_i(avro_value_get_by_name(value, "timestamp_start", &field, NULL));
     check_i(avro_value_set_string(&field, tstamp_str));
   }
 
@@ -752,7 +753,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     compose_timestamp(tstamp_str, SRVBUFLEN, &pnat->timestamp_end, TRUE,
 		      config.timestamps_since_epoch, config.timestamps_rfc3339,
 		      config.timestamps_utc);
-    check_i(avro_value_get_by_name(&value, "timestamp_end", &field, NULL));
+    check_i(avro_value_get_by_name(value, "timestamp_end", &field, NULL));
     check_i(avro_value_set_string(&field, tstamp_str));
   }
 
@@ -760,7 +761,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     compose_timestamp(tstamp_str, SRVBUFLEN, &pnat->timestamp_arrival, TRUE,
 		      config.timestamps_since_epoch, config.timestamps_rfc3339,
 		      config.timestamps_utc);
-    check_i(avro_value_get_by_name(&value, "timestamp_arrival", &field, NULL));
+    check_i(avro_value_get_by_name(value, "timestamp_arrival", &field, NULL));
     check_i(avro_value_set_string(&field, tstamp_str));
   }
 
@@ -769,39 +770,39 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
       compose_timestamp(tstamp_str, SRVBUFLEN, &stitch->timestamp_min, TRUE,
 			config.timestamps_since_epoch, config.timestamps_rfc3339,
 			config.timestamps_utc);
-      check_i(avro_value_get_by_name(&value, "timestamp_min", &field, NULL));
+      check_i(avro_value_get_by_name(value, "timestamp_min", &field, NULL));
       check_i(avro_value_set_branch(&field, 1, &branch));
       check_i(avro_value_set_string(&branch, tstamp_str));
 
       compose_timestamp(tstamp_str, SRVBUFLEN, &stitch->timestamp_max, TRUE,
 			config.timestamps_since_epoch, config.timestamps_rfc3339,
 			config.timestamps_utc);
-      check_i(avro_value_get_by_name(&value, "timestamp_max", &field, NULL));
+      check_i(avro_value_get_by_name(value, "timestamp_max", &field, NULL));
       check_i(avro_value_set_branch(&field, 1, &branch));
       check_i(avro_value_set_string(&branch, tstamp_str));
     }
     else {
-      check_i(avro_value_get_by_name(&value, "timestamp_min", &field, NULL));
+      check_i(avro_value_get_by_name(value, "timestamp_min", &field, NULL));
       check_i(avro_value_set_branch(&field, 0, &branch));
-      check_i(avro_value_get_by_name(&value, "timestamp_max", &field, NULL));
+      check_i(avro_value_get_by_name(value, "timestamp_max", &field, NULL));
       check_i(avro_value_set_branch(&field, 0, &branch));
     }
   }
 
   if (wtc_2 & COUNT_EXPORT_PROTO_SEQNO) {
-    check_i(avro_value_get_by_name(&value, "export_proto_seqno", &field, NULL));
+    check_i(avro_value_get_by_name(value, "export_proto_seqno", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->export_proto_seqno));
   }
 
   if (wtc_2 & COUNT_EXPORT_PROTO_VERSION) {
-    check_i(avro_value_get_by_name(&value, "export_proto_version", &field, NULL));
+    check_i(avro_value_get_by_name(value, "export_proto_version", &field, NULL));
     check_i(avro_value_set_long(&field, pbase->export_proto_version));
   }
 
   /* all custom primitives printed here */
   {
     if (config.cpptrs.num > 0)
-      check_i(avro_value_get_by_name(&value, "custom_primitives", &field, NULL));
+      check_i(avro_value_get_by_name(value, "custom_primitives", &field, NULL));
 
     int cp_idx;
     for (cp_idx = 0; cp_idx < config.cpptrs.num; cp_idx++) {
@@ -830,7 +831,7 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
       compose_timestamp(tstamp_str, SRVBUFLEN, &tv, FALSE,
 			config.timestamps_since_epoch, config.timestamps_rfc3339,
 			config.timestamps_utc);
-      check_i(avro_value_get_by_name(&value, "stamp_inserted", &field, NULL));
+      check_i(avro_value_get_by_name(value, "stamp_inserted", &field, NULL));
       check_i(avro_value_set_branch(&field, 1, &branch));
       check_i(avro_value_set_string(&branch, tstamp_str));
 
@@ -839,24 +840,24 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
       compose_timestamp(tstamp_str, SRVBUFLEN, &tv, FALSE,
 			config.timestamps_since_epoch, config.timestamps_rfc3339,
 			config.timestamps_utc);
-      check_i(avro_value_get_by_name(&value, "stamp_updated", &field, NULL));
+      check_i(avro_value_get_by_name(value, "stamp_updated", &field, NULL));
       check_i(avro_value_set_branch(&field, 1, &branch));
       check_i(avro_value_set_string(&branch, tstamp_str));
     }
     else {
-      check_i(avro_value_get_by_name(&value, "stamp_inserted", &field, NULL));
+      check_i(avro_value_get_by_name(value, "stamp_inserted", &field, NULL));
       check_i(avro_value_set_branch(&field, 0, &branch));
-      check_i(avro_value_get_by_name(&value, "stamp_updated", &field, NULL));
+      check_i(avro_value_get_by_name(value, "stamp_updated", &field, NULL));
       check_i(avro_value_set_branch(&field, 0, &branch));
     }
   }
 
   if (flow_type != NF9_FTYPE_EVENT && flow_type != NF9_FTYPE_OPTION) {
-    check_i(avro_value_get_by_name(&value, "packets", &field, NULL));
+    check_i(avro_value_get_by_name(value, "packets", &field, NULL));
     check_i(avro_value_set_branch(&field, 1, &branch));
     check_i(avro_value_set_long(&branch, packet_counter));
 
-    check_i(avro_value_get_by_name(&value, "flows", &field, NULL));
+    check_i(avro_value_get_by_name(value, "flows", &field, NULL));
     if (wtc & COUNT_FLOWS) {
       check_i(avro_value_set_branch(&field, 1, &branch));
       check_i(avro_value_set_long(&branch, flow_counter));
@@ -864,20 +865,18 @@ avro_value_t compose_avro(u_int64_t wtc, u_int64_t wtc_2, u_int8_t flow_type, st
     else {
       check_i(avro_value_set_branch(&field, 0, &branch));
     }
-    check_i(avro_value_get_by_name(&value, "bytes", &field, NULL));
+    check_i(avro_value_get_by_name(value, "bytes", &field, NULL));
     check_i(avro_value_set_branch(&field, 1, &branch));
     check_i(avro_value_set_long(&branch, bytes_counter));
   }
   else {
-    check_i(avro_value_get_by_name(&value, "packets", &field, NULL));
+    check_i(avro_value_get_by_name(value, "packets", &field, NULL));
     check_i(avro_value_set_branch(&field, 0, &branch));
-    check_i(avro_value_get_by_name(&value, "flows", &field, NULL));
+    check_i(avro_value_get_by_name(value, "flows", &field, NULL));
     check_i(avro_value_set_branch(&field, 0, &branch));
-    check_i(avro_value_get_by_name(&value, "bytes", &field, NULL));
+    check_i(avro_value_get_by_name(value, "bytes", &field, NULL));
     check_i(avro_value_set_branch(&field, 0, &branch));
   }
-
-  return value;
 }
 
 void add_writer_name_and_pid_avro(avro_value_t value, char *name, pid_t writer_pid)
@@ -35,6 +35,36 @@
 
 /* Functions */
 #ifdef WITH_JANSSON
+/* keys emitted by the compose_json_*() handlers, custom primitives can't reuse them */
+static const char *pm_json_builtin_keys[] = {
+  "as_dst", "as_path", "as_src", "bytes", "class", "comms", "cos",
+  "country_ip_dst", "country_ip_src", "ecomms", "etype", "event_type",
+  "export_proto_seqno", "export_proto_version", "flows", "iface_in",
+  "iface_out", "ip_dst", "ip_proto", "ip_src", "label", "lcomms", "local_pref",
+  "mac_dst", "mac_src", "mask_dst", "mask_src", "med", "mpls_label_bottom",
+  "mpls_label_top", "mpls_stack_depth", "mpls_vpn_rd", "nat_event", "net_dst",
+  "net_src", "packets", "peer_as_dst", "peer_as_src", "peer_ip_dst",
+  "peer_ip_src", "pocode_ip_dst", "pocode_ip_src", "port_dst", "port_src",
+  "post_nat_ip_dst", "post_nat_ip_src", "post_nat_port_dst",
+  "post_nat_port_src", "sampling_rate", "src_as_path", "src_comms",
+  "src_ecomms", "src_lcomms", "src_local_pref", "src_med", "stamp_inserted",
+  "stamp_updated", "tag", "tag2", "tcp_flags", "timestamp_arrival",
+  "timestamp_end", "timestamp_max", "timestamp_min", "timestamp_start", "tos",
+  "tunnel_ip_dst", "tunnel_ip_proto", "tunnel_ip_src", "tunnel_tos", "vlan",
+  "writer_id", NULL
+};
+
+static int pm_json_key_is_builtin(const char *key)
+{
+  int idx;
+
+  for (idx = 0; pm_json_builtin_keys[idx]; idx++) {
+    if (!strcmp(pm_json_builtin_keys[idx], key)) return TRUE;
+  }
+
+  return FALSE;
+}
+
 void compose_json(u_int64_t wtc, u_int64_t wtc_2)
 {
   int idx = 0;
@@ -404,45 +434,263 @@ void compose_json(u_int64_t wtc, u_int64_t wtc_2)
   }
 
   cjhandler[idx] = compose_json_counters;
+
+  /* key fragments of custom primitives are escaped once here */
+  memset(&cjcpkey, 0, sizeof(cjcpkey));
+
+  if (config.cpptrs.num) {
+    struct pm_json_buf jb;
+    int cp_idx;
+
+    for (cp_idx = 0; cp_idx < config.cpptrs.num; cp_idx++) {
+      /* the streaming encoder does not dedup keys: a clash would be written twice */
+      if (pm_json_key_is_builtin(config.cpptrs.primitive[cp_idx].name)) {
+	Log(LOG_WARNING, "WARN ( %s/%s ): JSON: custom primitive '%s' clashes with a built-in field. Skipped.\n",
+	    config.name, config.type, config.cpptrs.primitive[cp_idx].name);
+	continue;
+      }
+
+      pm_json_buf_init(&jb, 0);
+
+      if (pm_json_buf_escape(&jb, config.cpptrs.primitive[cp_idx].name) == ERR) {
+	Log(LOG_WARNING, "WARN ( %s/%s ): JSON: custom primitive '%s' is not valid UTF-8. Skipped.\n",
+	    config.name, config.type, config.cpptrs.primitive[cp_idx].name);
+	pm_json_buf_free(&jb);
+	continue;
+      }
+
+      pm_json_buf_append(&jb, ": ", 2);
+
+      cjcpkey[cp_idx].str = jb.base;
+      cjcpkey[cp_idx].len = jb.len;
+    }
+  }
+}
+
+void pm_json_buf_init(struct pm_json_buf *jb, size_t size)
+{
+  if (!size) size = SRVBUFLEN;
+
+  jb->base = pm_malloc(size);
+  jb->size = size;
+  jb->len = 0;
+  jb->num = 0;
 }
 
-void compose_json_event_type(json_t *obj, struct chained_cache *null)
+void pm_json_buf_free(struct pm_json_buf *jb)
+{
+  free(jb->base);
+  memset(jb, 0, sizeof(struct pm_json_buf));
+}
+
+void pm_json_buf_reserve(struct pm_json_buf *jb, size_t len)
+{
+  size_t new_size;
+  char *new_base;
+
+  /* always leave room for the string terminator */
+  if ((jb->len + len) < jb->size) return;
+
+  for (new_size = jb->size; new_size <= (jb->len + len); new_size <<= 1);
+
+  new_base = realloc(jb->base, new_size);
+  if (!new_base) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): Unable to grab enough memory (requested: %llu bytes). Exiting ...\n",
+	config.name, config.type, (unsigned long long)new_size);
+    exit_plugin(1);
+  }
+
+  jb->base = new_base;
+  jb->size = new_size;
+}
+
+void pm_json_buf_append(struct pm_json_buf *jb, const char *str, size_t len)
+{
+  pm_json_buf_reserve(jb, len);
+  memcpy(&jb->base[jb->len], str, len);
+  jb->len += len;
+  jb->base[jb->len] = '\0';
+}
+
+/* Same escaping and UTF-8 validation as the jansson dumper, returns ERR
+   on strings json_string() would reject, leaving the buffer untouched */
+int pm_json_buf_escape(struct pm_json_buf *jb, const char *str)
+{
+  const unsigned char *ptr = (const unsigned char *) str;
+  size_t len = strlen(str), cp_len, idx;
+  u_int32_t cp;
+  char *out;
+
+  pm_json_buf_reserve(jb, ((len * 6) + 2));
+  out = &jb->base[jb->len];
+
+  *out++ = '"';
+
+  while (*ptr) {
+    if (*ptr < 0x80) {
+      switch (*ptr) {
+      case '"':
+	*out++ = '\\'; *out++ = '"';
+	break;
+      case '\\':
+	*out++ = '\\'; *out++ = '\\';
+	break;
+      case '\b':
+	*out++ = '\\'; *out++ = 'b';
+	break;
+      case '\f':
+	*out++ = '\\'; *out++ = 'f';
+	break;
+      case '\n':
+	*out++ = '\\'; *out++ = 'n';
+	break;
+      case '\r':
+	*out++ = '\\'; *out++ = 'r';
+	break;
+      case '\t':
+	*out++ = '\\'; *out++ = 't';
+	break;
+      default:
+	if (*ptr < 0x20) out += sprintf(out, "\\u%04X", *ptr);
+	else *out++ = *ptr;
+	break;
+      }
+
+      ptr++;
+      continue;
+    }
+
+    if (*ptr >= 0xC2 && *ptr <= 0xDF) {
+      cp_len = 2;
+      cp = (*ptr & 0x1F);
+    }
+    else if (*ptr >= 0xE0 && *ptr <= 0xEF) {
+      cp_len = 3;
+      cp = (*ptr & 0x0F);
+    }
+    else if (*ptr >= 0xF0 && *ptr <= 0xF4) {
+      cp_len = 4;
+      cp = (*ptr & 0x07);
+    }
+    else return ERR;
+
+    for (idx = 1; idx < cp_len; idx++) {
+      if (ptr[idx] < 0x80 || ptr[idx] > 0xBF) return ERR;
+      cp = ((cp << 6) | (ptr[idx] & 0x3F));
+    }
+
+    if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return ERR;
+    if ((cp_len == 3 && cp < 0x800) || (cp_len == 4 && cp < 0x10000)) return ERR;
+
+    memcpy(out, ptr, cp_len);
+    out += cp_len;
+    ptr += cp_len;
+  }
+
+  *out++ = '"';
+  *out = '\0';
+  jb->len = (out - jb->base);
+
+  return SUCCESS;
+}
+
+void pm_json_buf_begin(struct pm_json_buf *jb)
+{
+  jb->len = 0;
+  jb->num = 0;
+  pm_json_buf_append(jb, "{", 1);
+}
+
+void pm_json_buf_end(struct pm_json_buf *jb)
+{
+  pm_json_buf_append(jb, "}", 1);
+}
+
+static void pm_json_buf_add_key(struct pm_json_buf *jb, const char *key, size_t key_len)
+{
+  if (jb->num) pm_json_buf_append(jb, ", ", 2);
+  pm_json_buf_append(jb, key, key_len);
+  jb->num++;
+}
+
+void pm_json_buf_add_int(struct pm_json_buf *jb, const char *key, size_t key_len, long long value)
+{
+  char digits[24], *ptr = &digits[sizeof(digits)];
+  unsigned long long uvalue = (value < 0) ? (0ULL - (unsigned long long) value) : (unsigned long long) value;
+
+  do {
+    *--ptr = ('0' + (uvalue % 10));
+    uvalue /= 10;
+  } while (uvalue);
+
+  if (value < 0) *--ptr = '-';
+
+  pm_json_buf_add_key(jb, key, key_len);
+  pm_json_buf_append(jb, ptr, (&digits[sizeof(digits)] - ptr));
+}
+
+void pm_json_buf_add_str(struct pm_json_buf *jb, const char *key, size_t key_len, const char *str)
+{
+  size_t len = jb->len;
+  int num = jb->num;
+
+  /* as json_string(NULL), the field is just not there */
+  if (!str) return;
+
+  pm_json_buf_add_key(jb, key, key_len);
+
+  if (pm_json_buf_escape(jb, str) == ERR) {
+    jb->len = len;
+    jb->num = num;
+    jb->base[jb->len] = '\0';
+  }
+}
+
+void pm_json_buf_add_writer_id(struct pm_json_buf *jb, char *name, pid_t writer_pid)
+{
+  char wid[SHORTSHORTBUFLEN];
+
+  snprintf(wid, SHORTSHORTBUFLEN, "%s/%u", name, writer_pid);
+  pm_json_buf_add_str(jb, PM_JSON_KEY("writer_id"), wid);
+}
+
+void compose_json_event_type(struct pm_json_buf *jb, struct chained_cache *null)
 {
   char event_type[] = "purge";
 
-  json_object_set_new_nocheck(obj, "event_type", json_string(event_type));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("event_type"), event_type);
 }
 
-void compose_json_tag(json_t *obj, struct chained_cache *cc)
+void compose_json_tag(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "tag", json_integer((json_int_t)cc->primitives.tag));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("tag"), cc->primitives.tag);
 }
 
-void compose_json_tag2(json_t *obj, struct chained_cache *cc)
+void compose_json_tag2(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "tag2", json_integer((json_int_t)cc->primitives.tag2));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("tag2"), cc->primitives.tag2);
 }
 
-void compose_json_label(json_t *obj, struct chained_cache *cc)
+void compose_json_label(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char empty_string[] = "", *str_ptr;
 
   vlen_prims_get(cc->pvlen, COUNT_INT_LABEL, &str_ptr);
   if (!str_ptr) str_ptr = empty_string;
 
-  json_object_set_new_nocheck(obj, "label", json_string(str_ptr));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("label"), str_ptr);
 }
 
-void compose_json_class(json_t *obj, struct chained_cache *cc)
+void compose_json_class(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char empty_string[] = "", *str_ptr;
   struct pkt_primitives *pbase = &cc->primitives;
 
-  json_object_set_new_nocheck(obj, "class", json_string((pbase->class && class[(pbase->class)-1].id) ? class[(pbase->class)-1].protocol : "unknown"));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("class"), (pbase->class && class[(pbase->class)-1].id) ? class[(pbase->class)-1].protocol : "unknown");
 }
 
 #if defined (WITH_NDPI)
-void compose_json_ndpi_class(json_t *obj, struct chained_cache *cc)
+void compose_json_ndpi_class(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char ndpi_class[SUPERSHORTBUFLEN];
   struct pkt_primitives *pbase = &cc->primitives;
@@ -451,55 +699,55 @@ void compose_json_ndpi_class(json_t *obj, struct chained_cache *cc)
 	ndpi_get_proto_name(pm_ndpi_wfl->ndpi_struct, pbase->ndpi_class.master_protocol),
 	ndpi_get_proto_name(pm_ndpi_wfl->ndpi_struct, pbase->ndpi_class.app_protocol));
 
-  json_object_set_new_nocheck(obj, "class", json_string(ndpi_class));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("class"), ndpi_class);
 }
 #endif
 
-void compose_json_src_mac(json_t *obj, struct chained_cache *cc)
+void compose_json_src_mac(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char mac[18];
 
   etheraddr_string(cc->primitives.eth_shost, mac);
-  json_object_set_new_nocheck(obj, "mac_src", json_string(mac));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("mac_src"), mac);
 }
 
-void compose_json_dst_mac(json_t *obj, struct chained_cache *cc)
+void compose_json_dst_mac(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char mac[18];
   
   etheraddr_string(cc->primitives.eth_dhost, mac);
-  json_object_set_new_nocheck(obj, "mac_dst", json_string(mac));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("mac_dst"), mac);
 }
 
-void compose_json_vlan(json_t *obj, struct chained_cache *cc)
+void compose_json_vlan(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "vlan", json_integer((json_int_t)cc->primitives.vlan_id));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("vlan"), cc->primitives.vlan_id);
 }
 
-void compose_json_cos(json_t *obj, struct chained_cache *cc)
+void compose_json_cos(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "cos", json_integer((json_int_t)cc->primitives.cos));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("cos"), cc->primitives.cos);
 }
 
-void compose_json_etype(json_t *obj, struct chained_cache *cc)
+void compose_json_etype(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char misc_str[VERYSHORTBUFLEN];
 
   sprintf(misc_str, "%x", cc->primitives.etype);
-  json_object_set_new_nocheck(obj, "etype", json_string(misc_str));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("etype"), misc_str);
 }
 
-void compose_json_src_as(json_t *obj, struct chained_cache *cc)
+void compose_json_src_as(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "as_src", json_integer((json_int_t)cc->primitives.src_as));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("as_src"), cc->primitives.src_as);
 }
 
-void compose_json_dst_as(json_t *obj, struct chained_cache *cc)
+void compose_json_dst_as(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "as_dst", json_integer((json_int_t)cc->primitives.dst_as));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("as_dst"), cc->primitives.dst_as);
 }
 
-void compose_json_std_comm(json_t *obj, struct chained_cache *cc)
+void compose_json_std_comm(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char *str_ptr = NULL, *bgp_comm, empty_string[] = "";
 
@@ -513,10 +761,10 @@ void compose_json_std_comm(json_t *obj, struct chained_cache *cc)
   }
   else str_ptr = empty_string;
 
-  json_object_set_new_nocheck(obj, "comms", json_string(str_ptr));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("comms"), str_ptr);
 }
 
-void compose_json_ext_comm(json_t *obj, struct chained_cache *cc)
+void compose_json_ext_comm(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char *str_ptr = NULL, *bgp_comm, empty_string[] = "";
 
@@ -530,10 +778,10 @@ void compose_json_ext_comm(json_t *obj, struct chained_cache *cc)
   }
   else str_ptr = empty_string;
 
-  json_object_set_new_nocheck(obj, "ecomms", json_string(str_ptr));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("ecomms"), str_ptr);
 }
 
-void compose_json_lrg_comm(json_t *obj, struct chained_cache *cc)
+void compose_json_lrg_comm(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char *str_ptr = NULL, *bgp_comm, empty_string[] = "";
 
@@ -547,10 +795,10 @@ void compose_json_lrg_comm(json_t *obj, struct chained_cache *cc)
   }
   else str_ptr = empty_string;
 
-  json_object_set_new_nocheck(obj, "lcomms", json_string(str_ptr));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("lcomms"), str_ptr);
 }
 
-void compose_json_as_path(json_t *obj, struct chained_cache *cc)
+void compose_json_as_path(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char *str_ptr = NULL, *as_path, empty_string[] = "";
 
@@ -564,46 +812,46 @@ void compose_json_as_path(json_t *obj, struct chained_cache *cc)
   }
   else str_ptr = empty_string;
 
-  json_object_set_new_nocheck(obj, "as_path", json_string(str_ptr));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("as_path"), str_ptr);
 }
 
-void compose_json_local_pref(json_t *obj, struct chained_cache *cc)
+void compose_json_local_pref(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "local_pref", json_integer((json_int_t)cc->pbgp->local_pref));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("local_pref"), cc->pbgp->local_pref);
 }
 
-void compose_json_med(json_t *obj, struct chained_cache *cc)
+void compose_json_med(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "med", json_integer((json_int_t)cc->pbgp->med));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("med"), cc->pbgp->med);
 }
 
-void compose_json_peer_src_as(json_t *obj, struct chained_cache *cc)
+void compose_json_peer_src_as(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "peer_as_src", json_integer((json_int_t)cc->pbgp->peer_src_as));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("peer_as_src"), cc->pbgp->peer_src_as);
 }
 
-void compose_json_peer_dst_as(json_t *obj, struct chained_cache *cc)
+void compose_json_peer_dst_as(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "peer_as_dst", json_integer((json_int_t)cc->pbgp->peer_dst_as));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("peer_as_dst"), cc->pbgp->peer_dst_as);
 }
 
-void compose_json_peer_src_ip(json_t *obj, struct chained_cache *cc)
+void compose_json_peer_src_ip(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char ip_address[INET6_ADDRSTRLEN];
 
   addr_to_str(ip_address, &cc->pbgp->peer_src_ip);
-  json_object_set_new_nocheck(obj, "peer_ip_src", json_string(ip_address));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("peer_ip_src"), ip_address);
 }
 
-void compose_json_peer_dst_ip(json_t *obj, struct chained_cache *cc)
+void compose_json_peer_dst_ip(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char ip_address[INET6_ADDRSTRLEN];
 
   addr_to_str(ip_address, &cc->pbgp->peer_dst_ip);
-  json_object_set_new_nocheck(obj, "peer_ip_dst", json_string(ip_address));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("peer_ip_dst"), ip_address);
 }
 
-void compose_json_src_std_comm(json_t *obj, struct chained_cache *cc)
+void compose_json_src_std_comm(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char *str_ptr = NULL, *bgp_comm, empty_string[] = "";
 
@@ -617,10 +865,10 @@ void compose_json_src_std_comm(json_t *obj, struct chained_cache *cc)
   }
   else str_ptr = empty_string;
 
-  json_object_set_new_nocheck(obj, "src_comms", json_string(str_ptr));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("src_comms"), str_ptr);
 }
 
-void compose_json_src_ext_comm(json_t *obj, struct chained_cache *cc)
+void compose_json_src_ext_comm(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char *str_ptr = NULL, *bgp_comm, empty_string[] = "";
 
@@ -634,10 +882,10 @@ void compose_json_src_ext_comm(json_t *obj, struct chained_cache *cc)
   }
   else str_ptr = empty_string;
 
-  json_object_set_new_nocheck(obj, "src_ecomms", json_string(str_ptr));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("src_ecomms"), str_ptr);
 }
 
-void compose_json_src_lrg_comm(json_t *obj, struct chained_cache *cc)
+void compose_json_src_lrg_comm(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char *str_ptr = NULL, *bgp_comm, empty_string[] = "";
 
@@ -651,10 +899,10 @@ void compose_json_src_lrg_comm(json_t *obj, struct chained_cache *cc)
   }
   else str_ptr = empty_string;
 
-  json_object_set_new_nocheck(obj, "src_lcomms", json_string(str_ptr));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("src_lcomms"), str_ptr);
 }
 
-void compose_json_src_as_path(json_t *obj, struct chained_cache *cc)
+void compose_json_src_as_path(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char *str_ptr = NULL, *as_path, empty_string[] = "";
 
@@ -668,335 +916,337 @@ void compose_json_src_as_path(json_t *obj, struct chained_cache *cc)
   }
   else str_ptr = empty_string;
 
-  json_object_set_new_nocheck(obj, "src_as_path", json_string(str_ptr));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("src_as_path"), str_ptr);
 }
 
-void compose_json_src_local_pref(json_t *obj, struct chained_cache *cc)
+void compose_json_src_local_pref(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "src_local_pref", json_integer((json_int_t)cc->pbgp->src_local_pref));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("src_local_pref"), cc->pbgp->src_local_pref);
 }
 
-void compose_json_src_med(json_t *obj, struct chained_cache *cc)
+void compose_json_src_med(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "src_med", json_integer((json_int_t)cc->pbgp->src_med));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("src_med"), cc->pbgp->src_med);
 }
 
-void compose_json_in_iface(json_t *obj, struct chained_cache *cc)
+void compose_json_in_iface(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "iface_in", json_integer((json_int_t)cc->primitives.ifindex_in));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("iface_in"), cc->primitives.ifindex_in);
 }
 
-void compose_json_out_iface(json_t *obj, struct chained_cache *cc)
+void compose_json_out_iface(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "iface_out", json_integer((json_int_t)cc->primitives.ifindex_out));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("iface_out"), cc->primitives.ifindex_out);
 }
 
-void compose_json_mpls_vpn_rd(json_t *obj, struct chained_cache *cc)
+void compose_json_mpls_vpn_rd(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char rd_str[VERYSHORTBUFLEN];
 
   bgp_rd2str(rd_str, &cc->pbgp->mpls_vpn_rd);
-  json_object_set_new_nocheck(obj, "mpls_vpn_rd", json_string(rd_str));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("mpls_vpn_rd"), rd_str);
 }
 
-void compose_json_src_host(json_t *obj, struct chained_cache *cc)
+void compose_json_src_host(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char ip_address[INET6_ADDRSTRLEN];
 
   addr_to_str(ip_address, &cc->primitives.src_ip);
-  json_object_set_new_nocheck(obj, "ip_src", json_string(ip_address));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("ip_src"), ip_address);
 }
 
-void compose_json_src_net(json_t *obj, struct chained_cache *cc)
+void compose_json_src_net(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char ip_address[INET6_ADDRSTRLEN];
 
   addr_to_str(ip_address, &cc->primitives.src_net);
-  json_object_set_new_nocheck(obj, "net_src", json_string(ip_address));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("net_src"), ip_address);
 }
 
-void compose_json_dst_host(json_t *obj, struct chained_cache *cc)
+void compose_json_dst_host(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char ip_address[INET6_ADDRSTRLEN];
 
   addr_to_str(ip_address, &cc->primitives.dst_ip);
-  json_object_set_new_nocheck(obj, "ip_dst", json_string(ip_address));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("ip_dst"), ip_address);
 }
 
-void compose_json_dst_net(json_t *obj, struct chained_cache *cc)
+void compose_json_dst_net(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char ip_address[INET6_ADDRSTRLEN];
 
   addr_to_str(ip_address, &cc->primitives.dst_net);
-  json_object_set_new_nocheck(obj, "net_dst", json_string(ip_address));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("net_dst"), ip_address);
 }
 
-void compose_json_src_mask(json_t *obj, struct chained_cache *cc)
+void compose_json_src_mask(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "mask_src", json_integer((json_int_t)cc->primitives.src_nmask));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("mask_src"), cc->primitives.src_nmask);
 }
 
-void compose_json_dst_mask(json_t *obj, struct chained_cache *cc)
+void compose_json_dst_mask(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "mask_dst", json_integer((json_int_t)cc->primitives.dst_nmask));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("mask_dst"), cc->primitives.dst_nmask);
 }
 
-void compose_json_src_port(json_t *obj, struct chained_cache *cc)
+void compose_json_src_port(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "port_src", json_integer((json_int_t)cc->primitives.src_port));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("port_src"), cc->primitives.src_port);
 }
 
-void compose_json_dst_port(json_t *obj, struct chained_cache *cc)
+void compose_json_dst_port(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "port_dst", json_integer((json_int_t)cc->primitives.dst_port));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("port_dst"), cc->primitives.dst_port);
 }
 
 #if defined (WITH_GEOIP)
-void compose_json_src_host_country(json_t *obj, struct chained_cache *cc)
+void compose_json_src_host_country(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char empty_string[] = "";
  
   if (cc->primitives.src_ip_country.id > 0)
-    json_object_set_new_nocheck(obj, "country_ip_src", json_string(GeoIP_code_by_id(cc->primitives.src_ip_country.id)));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("country_ip_src"), GeoIP_code_by_id(cc->primitives.src_ip_country.id));
   else
-    json_object_set_new_nocheck(obj, "country_ip_src", json_string(empty_string));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("country_ip_src"), empty_string);
 }
 
-void compose_json_dst_host_country(json_t *obj, struct chained_cache *cc)
+void compose_json_dst_host_country(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char empty_string[] = "";
 
   if (cc->primitives.dst_ip_country.id > 0)
-    json_object_set_new_nocheck(obj, "country_ip_dst", json_string(GeoIP_code_by_id(cc->primitives.dst_ip_country.id)));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("country_ip_dst"), GeoIP_code_by_id(cc->primitives.dst_ip_country.id));
   else
-    json_object_set_new_nocheck(obj, "country_ip_dst", json_string(empty_string));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("country_ip_dst"), empty_string);
 }
 #endif
 #if defined (WITH_GEOIPV2)
-void compose_json_src_host_country(json_t *obj, struct chained_cache *cc)
+void compose_json_src_host_country(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char empty_string[] = "";
 
   if (strlen(cc->primitives.src_ip_country.str))
-    json_object_set_new_nocheck(obj, "country_ip_src", json_string(cc->primitives.src_ip_country.str));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("country_ip_src"), cc->primitives.src_ip_country.str);
   else
-    json_object_set_new_nocheck(obj, "country_ip_src", json_string(empty_string));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("country_ip_src"), empty_string);
 }
 
-void compose_json_dst_host_country(json_t *obj, struct chained_cache *cc)
+void compose_json_dst_host_country(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char empty_string[] = "";
 
   if (strlen(cc->primitives.dst_ip_country.str))
-    json_object_set_new_nocheck(obj, "country_ip_dst", json_string(cc->primitives.dst_ip_country.str));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("country_ip_dst"), cc->primitives.dst_ip_country.str);
   else
-    json_object_set_new_nocheck(obj, "country_ip_dst", json_string(empty_string));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("country_ip_dst"), empty_string);
 }
 
-void compose_json_src_host_pocode(json_t *obj, struct chained_cache *cc)
+void compose_json_src_host_pocode(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char empty_string[] = "";
 
   if (strlen(cc->primitives.src_ip_pocode.str))
-    json_object_set_new_nocheck(obj, "pocode_ip_src", json_string(cc->primitives.src_ip_pocode.str));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("pocode_ip_src"), cc->primitives.src_ip_pocode.str);
   else
-    json_object_set_new_nocheck(obj, "pocode_ip_src", json_string(empty_string));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("pocode_ip_src"), empty_string);
 }
 
-void compose_json_dst_host_pocode(json_t *obj, struct chained_cache *cc)
+void compose_json_dst_host_pocode(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char empty_string[] = "";
 
   if (strlen(cc->primitives.dst_ip_pocode.str))
-    json_object_set_new_nocheck(obj, "pocode_ip_dst", json_string(cc->primitives.dst_ip_pocode.str));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("pocode_ip_dst"), cc->primitives.dst_ip_pocode.str);
   else
-    json_object_set_new_nocheck(obj, "pocode_ip_dst", json_string(empty_string));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("pocode_ip_dst"), empty_string);
 }
 #endif
 
-void compose_json_tcp_flags(json_t *obj, struct chained_cache *cc)
+void compose_json_tcp_flags(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char misc_str[VERYSHORTBUFLEN];
 
   sprintf(misc_str, "%u", cc->tcp_flags);
-  json_object_set_new_nocheck(obj, "tcp_flags", json_string(misc_str));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("tcp_flags"), misc_str);
 }
 
-void compose_json_proto(json_t *obj, struct chained_cache *cc)
+void compose_json_proto(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char misc_str[VERYSHORTBUFLEN];
 
   if (!config.num_protos && (cc->primitives.proto < protocols_number))
-    json_object_set_new_nocheck(obj, "ip_proto", json_string(_protocols[cc->primitives.proto].name));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("ip_proto"), _protocols[cc->primitives.proto].name);
   else
-    json_object_set_new_nocheck(obj, "ip_proto", json_integer((json_int_t)cc->primitives.proto));
+    pm_json_buf_add_int(jb, PM_JSON_KEY("ip_proto"), cc->primitives.proto);
 }
 
-void compose_json_tos(json_t *obj, struct chained_cache *cc)
+void compose_json_tos(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "tos", json_integer((json_int_t)cc->primitives.tos));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("tos"), cc->primitives.tos);
 }
 
-void compose_json_sampling_rate(json_t *obj, struct chained_cache *cc)
+void compose_json_sampling_rate(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "sampling_rate", json_integer((json_int_t)cc->primitives.sampling_rate));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("sampling_rate"), cc->primitives.sampling_rate);
 }
 
-void compose_json_post_nat_src_host(json_t *obj, struct chained_cache *cc)
+void compose_json_post_nat_src_host(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char ip_address[INET6_ADDRSTRLEN];
 
   addr_to_str(ip_address, &cc->pnat->post_nat_src_ip);
-  json_object_set_new_nocheck(obj, "post_nat_ip_src", json_string(ip_address));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("post_nat_ip_src"), ip_address);
 }
 
-void compose_json_post_nat_dst_host(json_t *obj, struct chained_cache *cc)
+void compose_json_post_nat_dst_host(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char ip_address[INET6_ADDRSTRLEN];
 
   addr_to_str(ip_address, &cc->pnat->post_nat_dst_ip);
-  json_object_set_new_nocheck(obj, "post_nat_ip_dst", json_string(ip_address));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("post_nat_ip_dst"), ip_address);
 }
 
-void compose_json_post_nat_src_port(json_t *obj, struct chained_cache *cc)
+void compose_json_post_nat_src_port(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "post_nat_port_src", json_integer((json_int_t)cc->pnat->post_nat_src_port));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("post_nat_port_src"), cc->pnat->post_nat_src_port);
 }
 
-void compose_json_post_nat_dst_port(json_t *obj, struct chained_cache *cc)
+void compose_json_post_nat_dst_port(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "post_nat_port_dst", json_integer((json_int_t)cc->pnat->post_nat_dst_port));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("post_nat_port_dst"), cc->pnat->post_nat_dst_port);
 }
 
-void compose_json_nat_event(json_t *obj, struct chained_cache *cc)
+void compose_json_nat_event(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "nat_event", json_integer((json_int_t)cc->pnat->nat_event));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("nat_event"), cc->pnat->nat_event);
 }
 
-void compose_json_mpls_label_top(json_t *obj, struct chained_cache *cc)
+void compose_json_mpls_label_top(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "mpls_label_top", json_integer((json_int_t)cc->pmpls->mpls_label_top));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("mpls_label_top"), cc->pmpls->mpls_label_top);
 }
 
-void compose_json_mpls_label_bottom(json_t *obj, struct chained_cache *cc)
+void compose_json_mpls_label_bottom(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "mpls_label_bottom", json_integer((json_int_t)cc->pmpls->mpls_label_bottom));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("mpls_label_bottom"), cc->pmpls->mpls_label_bottom);
 }
 
-void compose_json_mpls_stack_depth(json_t *obj, struct chained_cache *cc)
+void compose_json_mpls_stack_depth(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "mpls_stack_depth", json_integer((json_int_t)cc->pmpls->mpls_stack_depth));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("mpls_stack_depth"), cc->pmpls->mpls_stack_depth);
 }
 
-void compose_json_tunnel_src_host(json_t *obj, struct chained_cache *cc)
+void compose_json_tunnel_src_host(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char ip_address[INET6_ADDRSTRLEN];
 
   addr_to_str(ip_address, &cc->ptun->tunnel_src_ip);
-  json_object_set_new_nocheck(obj, "tunnel_ip_src", json_string(ip_address));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("tunnel_ip_src"), ip_address);
 }
 
-void compose_json_tunnel_dst_host(json_t *obj, struct chained_cache *cc)
+void compose_json_tunnel_dst_host(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char ip_address[INET6_ADDRSTRLEN];
 
   addr_to_str(ip_address, &cc->ptun->tunnel_dst_ip);
-  json_object_set_new_nocheck(obj, "tunnel_ip_dst", json_string(ip_address));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("tunnel_ip_dst"), ip_address);
 }
 
-void compose_json_tunnel_proto(json_t *obj, struct chained_cache *cc)
+void compose_json_tunnel_proto(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char misc_str[VERYSHORTBUFLEN];
 
   if (!config.num_protos && (cc->ptun->tunnel_proto < protocols_number))
-    json_object_set_new_nocheck(obj, "tunnel_ip_proto", json_string(_protocols[cc->ptun->tunnel_proto].name));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("tunnel_ip_proto"), _protocols[cc->ptun->tunnel_proto].name);
   else
-    json_object_set_new_nocheck(obj, "tunnel_ip_proto", json_integer((json_int_t)cc->ptun->tunnel_proto));
+    pm_json_buf_add_int(jb, PM_JSON_KEY("tunnel_ip_proto"), cc->ptun->tunnel_proto);
 }
 
-void compose_json_tunnel_tos(json_t *obj, struct chained_cache *cc)
+void compose_json_tunnel_tos(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "tunnel_tos", json_integer((json_int_t)cc->ptun->tunnel_tos));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("tunnel_tos"), cc->ptun->tunnel_tos);
 }
 
-void compose_json_timestamp_start(json_t *obj, struct chained_cache *cc)
+void compose_json_timestamp_start(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char tstamp_str[VERYSHORTBUFLEN];
 
   compose_timestamp(tstamp_str, VERYSHORTBUFLEN, &cc->pnat->timestamp_start, TRUE,
 		    config.timestamps_since_epoch, config.timestamps_rfc3339,
 		    config.timestamps_utc);
-  json_object_set_new_nocheck(obj, "timestamp_start", json_string(tstamp_str));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("timestamp_start"), tstamp_str);
 }
 
-void compose_json_timestamp_end(json_t *obj, struct chained_cache *cc)
+void compose_json_timestamp_end(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char tstamp_str[VERYSHORTBUFLEN];
 
   compose_timestamp(tstamp_str, VERYSHORTBUFLEN, &cc->pnat->timestamp_end, TRUE,
 		    config.timestamps_since_epoch, config.timestamps_rfc3339,
 		    config.timestamps_utc);
-  json_object_set_new_nocheck(obj, "timestamp_end", json_string(tstamp_str));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("timestamp_end"), tstamp_str);
 }
 
-void compose_json_timestamp_arrival(json_t *obj, struct chained_cache *cc)
+void compose_json_timestamp_arrival(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char tstamp_str[VERYSHORTBUFLEN];
 
   compose_timestamp(tstamp_str, VERYSHORTBUFLEN, &cc->pnat->timestamp_arrival, TRUE,
 		    config.timestamps_since_epoch, config.timestamps_rfc3339,
 		    config.timestamps_utc);
-  json_object_set_new_nocheck(obj, "timestamp_arrival", json_string(tstamp_str));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("timestamp_arrival"), tstamp_str);
 }
 
-void compose_json_timestamp_stitching(json_t *obj, struct chained_cache *cc)
+void compose_json_timestamp_stitching(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char tstamp_str[VERYSHORTBUFLEN];
 
   compose_timestamp(tstamp_str, VERYSHORTBUFLEN, &cc->stitch->timestamp_min, TRUE,
 		    config.timestamps_since_epoch, config.timestamps_rfc3339,
 		    config.timestamps_utc);
-  json_object_set_new_nocheck(obj, "timestamp_min", json_string(tstamp_str));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("timestamp_min"), tstamp_str);
 
   compose_timestamp(tstamp_str, VERYSHORTBUFLEN, &cc->stitch->timestamp_max, TRUE,
 		    config.timestamps_since_epoch, config.timestamps_rfc3339,
 		    config.timestamps_utc);
-  json_object_set_new_nocheck(obj, "timestamp_max", json_string(tstamp_str));
+  pm_json_buf_add_str(jb, PM_JSON_KEY("timestamp_max"), tstamp_str);
 }
 
-void compose_json_export_proto_seqno(json_t *obj, struct chained_cache *cc)
+void compose_json_export_proto_seqno(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "export_proto_seqno", json_integer((json_int_t)cc->primitives.export_proto_seqno));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("export_proto_seqno"), cc->primitives.export_proto_seqno);
 }
 
-void compose_json_export_proto_version(json_t *obj, struct chained_cache *cc)
+void compose_json_export_proto_version(struct pm_json_buf *jb, struct chained_cache *cc)
 {
-  json_object_set_new_nocheck(obj, "export_proto_version", json_integer((json_int_t)cc->primitives.export_proto_version));
+  pm_json_buf_add_int(jb, PM_JSON_KEY("export_proto_version"), cc->primitives.export_proto_version);
 }
 
-void compose_json_custom_primitives(json_t *obj, struct chained_cache *cc)
+void compose_json_custom_primitives(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   char empty_string[] = "";
   int cp_idx;
 
   for (cp_idx = 0; cp_idx < config.cpptrs.num; cp_idx++) {
+    if (!cjcpkey[cp_idx].str) continue;
+
     if (config.cpptrs.primitive[cp_idx].ptr->len != PM_VARIABLE_LENGTH) {
       char cp_str[VERYSHORTBUFLEN];
 
       custom_primitive_value_print(cp_str, VERYSHORTBUFLEN, cc->pcust, &config.cpptrs.primitive[cp_idx], FALSE);
-      json_object_set_new_nocheck(obj, config.cpptrs.primitive[cp_idx].name, json_string(cp_str));
+      pm_json_buf_add_str(jb, cjcpkey[cp_idx].str, cjcpkey[cp_idx].len, cp_str);
     }
     else {
       char *label_ptr = NULL;
 
       vlen_prims_get(cc->pvlen, config.cpptrs.primitive[cp_idx].ptr->type, &label_ptr);
       if (!label_ptr) label_ptr = empty_string;
-      json_object_set_new_nocheck(obj, config.cpptrs.primitive[cp_idx].name, json_string(label_ptr));
+      pm_json_buf_add_str(jb, cjcpkey[cp_idx].str, cjcpkey[cp_idx].len, label_ptr);
     }
   }
 }
 
-void compose_json_history(json_t *obj, struct chained_cache *cc)
+void compose_json_history(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   if (cc->basetime.tv_sec) {
     char tstamp_str[VERYSHORTBUFLEN];
@@ -1007,28 +1257,28 @@ void compose_json_history(json_t *obj, struct chained_cache *cc)
     compose_timestamp(tstamp_str, VERYSHORTBUFLEN, &tv, FALSE,
 		      config.timestamps_since_epoch, config.timestamps_rfc3339,
 		      config.timestamps_utc);
-    json_object_set_new_nocheck(obj, "stamp_inserted", json_string(tstamp_str));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("stamp_inserted"), tstamp_str);
 
     tv.tv_sec = time(NULL);
     tv.tv_usec = 0;
     compose_timestamp(tstamp_str, VERYSHORTBUFLEN, &tv, FALSE,
 		      config.timestamps_since_epoch, config.timestamps_rfc3339,
 		      config.timestamps_utc);
-    json_object_set_new_nocheck(obj, "stamp_updated", json_string(tstamp_str));
+    pm_json_buf_add_str(jb, PM_JSON_KEY("stamp_updated"), tstamp_str);
   }
 }
 
-void compose_json_flows(json_t *obj, struct chained_cache *cc)
+void compose_json_flows(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   if (cc->flow_type != NF9_FTYPE_EVENT && cc->flow_type != NF9_FTYPE_OPTION)
-    json_object_set_new_nocheck(obj, "flows", json_integer((json_int_t)cc->flow_counter));
+    pm_json_buf_add_int(jb, PM_JSON_KEY("flows"), cc->flow_counter);
 }
 
-void compose_json_counters(json_t *obj, struct chained_cache *cc)
+void compose_json_counters(struct pm_json_buf *jb, struct chained_cache *cc)
 {
   if (cc->flow_type != NF9_FTYPE_EVENT && cc->flow_type != NF9_FTYPE_OPTION) {
-    json_object_set_new_nocheck(obj, "packets", json_integer((json_int_t)cc->packet_counter));
-    json_object_set_new_nocheck(obj, "bytes", json_integer((json_int_t)cc->bytes_counter));
+    pm_json_buf_add_int(jb, PM_JSON_KEY("packets"), cc->packet_counter);
+    pm_json_buf_add_int(jb, PM_JSON_KEY("bytes"), cc->bytes_counter);
   }
 }
 
@@ -19,9 +19,26 @@
     Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 */
 
+/* defines */
+/* precomputed key fragment, ie. "key": , and its length */
+#define PM_JSON_KEY(key)	"\"" key "\": ", (sizeof("\"" key "\": ") - 1)
+
+/* structures */
+struct pm_json_buf {
+  char *base;
+  size_t len;
+  size_t size;
+  int num;
+};
+
+struct pm_json_key {
+  char *str;
+  size_t len;
+};
+
 /* typedefs */
 #ifdef WITH_JANSSON
-typedef void (*compose_json_handler)(json_t *, struct chained_cache *);
+typedef void (*compose_json_handler)(struct pm_json_buf *, struct chained_cache *);
 #endif
 
 #if (!defined __PLUGIN_CMN_JSON_C)
@@ -33,86 +50,98 @@ typedef void (*compose_json_handler)(json_t *, struct chained_cache *);
 #ifdef WITH_JANSSON
 /* global vars */
 EXT compose_json_handler cjhandler[N_PRIMITIVES];
+EXT struct pm_json_key cjcpkey[MAX_CUSTOM_PRIMITIVES];
 
 /* prototypes */
-EXT void compose_json_event_type(json_t *, struct chained_cache *);
-EXT void compose_json_tag(json_t *, struct chained_cache *);
-EXT void compose_json_tag2(json_t *, struct chained_cache *);
-EXT void compose_json_label(json_t *, struct chained_cache *);
-EXT void compose_json_class(json_t *, struct chained_cache *);
+EXT void pm_json_buf_init(struct pm_json_buf *, size_t);
+EXT void pm_json_buf_free(struct pm_json_buf *);
+EXT void pm_json_buf_reserve(struct pm_json_buf *, size_t);
+EXT void pm_json_buf_append(struct pm_json_buf *, const char *, size_t);
+EXT int pm_json_buf_escape(struct pm_json_buf *, const char *);
+EXT void pm_json_buf_begin(struct pm_json_buf *);
+EXT void pm_json_buf_end(struct pm_json_buf *);
+EXT void pm_json_buf_add_int(struct pm_json_buf *, const char *, size_t, long long);
+EXT void pm_json_buf_add_str(struct pm_json_buf *, const char *, size_t, const char *);
+EXT void pm_json_buf_add_writer_id(struct pm_json_buf *, char *, pid_t);
+
+EXT void compose_json_event_type(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_tag(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_tag2(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_label(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_class(struct pm_json_buf *, struct chained_cache *);
 #if defined (WITH_NDPI)
-EXT void compose_json_ndpi_class(json_t *, struct chained_cache *);
+EXT void compose_json_ndpi_class(struct pm_json_buf *, struct chained_cache *);
 #endif
-EXT void compose_json_src_mac(json_t *, struct chained_cache *);
-EXT void compose_json_dst_mac(json_t *, struct chained_cache *);
-EXT void compose_json_vlan(json_t *, struct chained_cache *);
-EXT void compose_json_cos(json_t *, struct chained_cache *);
-EXT void compose_json_etype(json_t *, struct chained_cache *);
-EXT void compose_json_src_as(json_t *, struct chained_cache *);
-EXT void compose_json_dst_as(json_t *, struct chained_cache *);
-EXT void compose_json_std_comm(json_t *, struct chained_cache *);
-EXT void compose_json_ext_comm(json_t *, struct chained_cache *);
-EXT void compose_json_lrg_comm(json_t *, struct chained_cache *);
-EXT void compose_json_as_path(json_t *, struct chained_cache *);
-EXT void compose_json_local_pref(json_t *, struct chained_cache *);
-EXT void compose_json_med(json_t *, struct chained_cache *);
-EXT void compose_json_peer_src_as(json_t *, struct chained_cache *);
-EXT void compose_json_peer_dst_as(json_t *, struct chained_cache *);
-EXT void compose_json_peer_src_ip(json_t *, struct chained_cache *);
-EXT void compose_json_peer_dst_ip(json_t *, struct chained_cache *);
-EXT void compose_json_src_std_comm(json_t *, struct chained_cache *);
-EXT void compose_json_src_ext_comm(json_t *, struct chained_cache *);
-EXT void compose_json_src_lrg_comm(json_t *, struct chained_cache *);
-EXT void compose_json_src_as_path(json_t *, struct chained_cache *);
-EXT void compose_json_src_local_pref(json_t *, struct chained_cache *);
-EXT void compose_json_src_med(json_t *, struct chained_cache *);
-EXT void compose_json_in_iface(json_t *, struct chained_cache *);
-EXT void compose_json_out_iface(json_t *, struct chained_cache *);
-EXT void compose_json_mpls_vpn_rd(json_t *, struct chained_cache *);
-EXT void compose_json_src_host(json_t *, struct chained_cache *);
-EXT void compose_json_src_net(json_t *, struct chained_cache *);
-EXT void compose_json_dst_host(json_t *, struct chained_cache *);
-EXT void compose_json_dst_net(json_t *, struct chained_cache *);
-EXT void compose_json_src_mask(json_t *, struct chained_cache *);
-EXT void compose_json_dst_mask(json_t *, struct chained_cache *);
-EXT void compose_json_src_port(json_t *, struct chained_cache *);
-EXT void compose_json_dst_port(json_t *, struct chained_cache *);
+EXT void compose_json_src_mac(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_dst_mac(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_vlan(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_cos(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_etype(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_src_as(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_dst_as(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_std_comm(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_ext_comm(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_lrg_comm(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_as_path(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_local_pref(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_med(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_peer_src_as(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_peer_dst_as(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_peer_src_ip(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_peer_dst_ip(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_src_std_comm(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_src_ext_comm(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_src_lrg_comm(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_src_as_path(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_src_local_pref(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_src_med(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_in_iface(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_out_iface(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_mpls_vpn_rd(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_src_host(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_src_net(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_dst_host(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_dst_net(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_src_mask(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_dst_mask(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_src_port(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_dst_port(struct pm_json_buf *, struct chained_cache *);
 #if defined (WITH_GEOIP)
-EXT void compose_json_src_host_country(json_t *, struct chained_cache *);
-EXT void compose_json_dst_host_country(json_t *, struct chained_cache *);
+EXT void compose_json_src_host_country(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_dst_host_country(struct pm_json_buf *, struct chained_cache *);
 #endif
 #if defined (WITH_GEOIPV2)
-EXT void compose_json_src_host_country(json_t *, struct chained_cache *);
-EXT void compose_json_dst_host_country(json_t *, struct chained_cache *);
-EXT void compose_json_src_host_pocode(json_t *, struct chained_cache *);
-EXT void compose_json_dst_host_pocode(json_t *, struct chained_cache *);
+EXT void compose_json_src_host_country(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_dst_host_country(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_src_host_pocode(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_dst_host_pocode(struct pm_json_buf *, struct chained_cache *);
 #endif
-EXT void compose_json_tcp_flags(json_t *, struct chained_cache *);
-EXT void compose_json_proto(json_t *, struct chained_cache *);
-EXT void compose_json_tos(json_t *, struct chained_cache *);
-EXT void compose_json_sampling_rate(json_t *, struct chained_cache *);
-EXT void compose_json_post_nat_src_host(json_t *, struct chained_cache *);
-EXT void compose_json_post_nat_dst_host(json_t *, struct chained_cache *);
-EXT void compose_json_post_nat_src_port(json_t *, struct chained_cache *);
-EXT void compose_json_post_nat_dst_port(json_t *, struct chained_cache *);
-EXT void compose_json_nat_event(json_t *, struct chained_cache *);
-EXT void compose_json_mpls_label_top(json_t *, struct chained_cache *);
-EXT void compose_json_mpls_label_bottom(json_t *, struct chained_cache *);
-EXT void compose_json_mpls_stack_depth(json_t *, struct chained_cache *);
-EXT void compose_json_tunnel_src_host(json_t *, struct chained_cache *);
-EXT void compose_json_tunnel_dst_host(json_t *, struct chained_cache *);
-EXT void compose_json_tunnel_proto(json_t *, struct chained_cache *);
-EXT void compose_json_tunnel_tos(json_t *, struct chained_cache *);
-EXT void compose_json_timestamp_start(json_t *, struct chained_cache *);
-EXT void compose_json_timestamp_end(json_t *, struct chained_cache *);
-EXT void compose_json_timestamp_arrival(json_t *, struct chained_cache *);
-EXT void compose_json_timestamp_stitching(json_t *, struct chained_cache *);
-EXT void compose_json_export_proto_seqno(json_t *, struct chained_cache *);
-EXT void compose_json_export_proto_version(json_t *, struct chained_cache *);
-EXT void compose_json_custom_primitives(json_t *, struct chained_cache *);
-EXT void compose_json_history(json_t *, struct chained_cache *);
-EXT void compose_json_flows(json_t *, struct chained_cache *);
-EXT void compose_json_counters(json_t *, struct chained_cache *);
+EXT void compose_json_tcp_flags(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_proto(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_tos(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_sampling_rate(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_post_nat_src_host(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_post_nat_dst_host(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_post_nat_src_port(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_post_nat_dst_port(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_nat_event(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_mpls_label_top(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_mpls_label_bottom(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_mpls_stack_depth(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_tunnel_src_host(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_tunnel_dst_host(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_tunnel_proto(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_tunnel_tos(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_timestamp_start(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_timestamp_end(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_timestamp_arrival(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_timestamp_stitching(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_export_proto_seqno(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_export_proto_version(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_custom_primitives(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_history(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_flows(struct pm_json_buf *, struct chained_cache *);
+EXT void compose_json_counters(struct pm_json_buf *, struct chained_cache *);
 #endif
 EXT void compose_json(u_int64_t, u_int64_t);
 EXT void *compose_purge_init_json(char *, pid_t);
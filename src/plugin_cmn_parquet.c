@@ -0,0 +1,362 @@
+/*
+    pmacct (Promiscuous mode IP Accounting package)
+    pmacct is Copyright (C) 2003-2018 by Paolo Lucente
+*/
+
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+
+#define __PLUGIN_CMN_PARQUET_C
+
+/* includes */
+#include "pmacct.h"
+#include "addr.h"
+#include "pmacct-data.h"
+#include "plugin_common.h"
+#include "plugin_cmn_parquet.h"
+
+#ifdef WITH_PARQUET
+/* primitives that have a column; anything else is not written out */
+#define PM_PARQUET_WTC	(COUNT_TAG|COUNT_TAG2|COUNT_SRC_MAC|COUNT_SUM_MAC|COUNT_DST_MAC|	\
+			 COUNT_VLAN|COUNT_SRC_AS|COUNT_SUM_AS|COUNT_DST_AS|COUNT_PEER_SRC_AS|	\
+			 COUNT_PEER_DST_AS|COUNT_PEER_SRC_IP|COUNT_PEER_DST_IP|COUNT_IN_IFACE|	\
+			 COUNT_OUT_IFACE|COUNT_SRC_HOST|COUNT_SUM_HOST|COUNT_SRC_NET|		\
+			 COUNT_SUM_NET|COUNT_DST_HOST|COUNT_DST_NET|COUNT_SRC_NMASK|		\
+			 COUNT_DST_NMASK|COUNT_SRC_PORT|COUNT_SUM_PORT|COUNT_DST_PORT|		\
+			 COUNT_TCPFLAGS|COUNT_IP_PROTO|COUNT_IP_TOS|COUNT_FLOWS|COUNT_NONE|	\
+			 TIMESTAMP)
+
+/* functions */
+static GArrowArrayBuilder *pm_parquet_builder_new(u_int8_t type)
+{
+  switch (type) {
+  case PM_PARQUET_UINT8:
+    return GARROW_ARRAY_BUILDER(garrow_uint8_array_builder_new());
+  case PM_PARQUET_UINT16:
+    return GARROW_ARRAY_BUILDER(garrow_uint16_array_builder_new());
+  case PM_PARQUET_UINT32:
+    return GARROW_ARRAY_BUILDER(garrow_uint32_array_builder_new());
+  case PM_PARQUET_UINT64:
+    return GARROW_ARRAY_BUILDER(garrow_uint64_array_builder_new());
+  case PM_PARQUET_STRING:
+  default:
+    return GARROW_ARRAY_BUILDER(garrow_string_array_builder_new());
+  }
+}
+
+static void pm_parquet_add_column(struct pm_parquet_table *t, const char *name, u_int8_t type, u_int8_t dictionary)
+{
+  struct pm_parquet_column *col;
+
+  if (t->num >= PM_PARQUET_MAX_COLUMNS) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): PARQUET: too many columns. Exiting.\n", config.name, config.type);
+    exit_plugin(1);
+  }
+
+  col = &t->col[t->num];
+  col->name = name;
+  col->type = type;
+  col->dictionary = dictionary;
+  col->builder = pm_parquet_builder_new(type);
+
+  t->num++;
+}
+
+/* empties a builder, replacing it if it can't be finished */
+static void pm_parquet_builder_discard(struct pm_parquet_column *col)
+{
+  GArrowArray *array;
+
+  array = garrow_array_builder_finish(col->builder, NULL);
+  if (array) g_object_unref(array);
+  else {
+    g_object_unref(col->builder);
+    col->builder = pm_parquet_builder_new(col->type);
+  }
+}
+
+static void pm_parquet_append_uint(struct pm_parquet_table *t, int *idx, u_int64_t value)
+{
+  struct pm_parquet_column *col = &t->col[*idx];
+  GError *error = NULL;
+  gboolean ret = FALSE;
+
+  switch (col->type) {
+  case PM_PARQUET_UINT8:
+    ret = garrow_uint8_array_builder_append_value(GARROW_UINT8_ARRAY_BUILDER(col->builder), value, &error);
+    break;
+  case PM_PARQUET_UINT16:
+    ret = garrow_uint16_array_builder_append_value(GARROW_UINT16_ARRAY_BUILDER(col->builder), value, &error);
+    break;
+  case PM_PARQUET_UINT32:
+    ret = garrow_uint32_array_builder_append_value(GARROW_UINT32_ARRAY_BUILDER(col->builder), value, &error);
+    break;
+  case PM_PARQUET_UINT64:
+    ret = garrow_uint64_array_builder_append_value(GARROW_UINT64_ARRAY_BUILDER(col->builder), value, &error);
+    break;
+  }
+
+  if (!ret) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): PARQUET: failed appending to column '%s': %s\n", config.name, config.type,
+	col->name, error ? error->message : "unknown error");
+    exit_plugin(1);
+  }
+
+  (*idx)++;
+}
+
+static void pm_parquet_append_str(struct pm_parquet_table *t, int *idx, const char *value)
+{
+  struct pm_parquet_column *col = &t->col[*idx];
+  GError *error = NULL;
+
+  if (!garrow_string_array_builder_append_string(GARROW_STRING_ARRAY_BUILDER(col->builder), value, &error)) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): PARQUET: failed appending to column '%s': %s\n", config.name, config.type,
+	col->name, error->message);
+    exit_plugin(1);
+  }
+
+  (*idx)++;
+}
+
+static GArrowDataType *pm_parquet_data_type(u_int8_t type)
+{
+  switch (type) {
+  case PM_PARQUET_UINT8:
+    return GARROW_DATA_TYPE(garrow_uint8_data_type_new());
+  case PM_PARQUET_UINT16:
+    return GARROW_DATA_TYPE(garrow_uint16_data_type_new());
+  case PM_PARQUET_UINT32:
+    return GARROW_DATA_TYPE(garrow_uint32_data_type_new());
+  case PM_PARQUET_UINT64:
+    return GARROW_DATA_TYPE(garrow_uint64_data_type_new());
+  default:
+    return GARROW_DATA_TYPE(garrow_string_data_type_new());
+  }
+}
+
+/*
+   Columns follow the naming of the JSON and Avro encodings. Low-cardinality
+   columns (tags, ASNs, interfaces, masks, protocol, etc.) are dictionary
+   encoded; addresses, ports and counters are not, as their dictionary would
+   be as large as the column itself.
+*/
+void pm_parquet_table_init(struct pm_parquet_table *t, u_int64_t wtc, u_int64_t wtc_2)
+{
+  GList *fields = NULL;
+  int idx;
+
+  memset(t, 0, sizeof(struct pm_parquet_table));
+
+  Log(LOG_INFO, "INFO ( %s/%s ): PARQUET: building schema.\n", config.name, config.type);
+
+  if ((wtc & ~PM_PARQUET_WTC) || wtc_2)
+    Log(LOG_WARNING, "WARN ( %s/%s ): PARQUET: some of the aggregation primitives are not supported and will not be written.\n",
+	config.name, config.type);
+
+  if (wtc & COUNT_TAG) pm_parquet_add_column(t, "tag", PM_PARQUET_UINT64, TRUE);
+  if (wtc & COUNT_TAG2) pm_parquet_add_column(t, "tag2", PM_PARQUET_UINT64, TRUE);
+#if defined (HAVE_L2)
+  if (wtc & (COUNT_SRC_MAC|COUNT_SUM_MAC)) pm_parquet_add_column(t, "mac_src", PM_PARQUET_STRING, FALSE);
+  if (wtc & COUNT_DST_MAC) pm_parquet_add_column(t, "mac_dst", PM_PARQUET_STRING, FALSE);
+  if (wtc & COUNT_VLAN) pm_parquet_add_column(t, "vlan", PM_PARQUET_UINT16, TRUE);
+#endif
+  if (wtc & (COUNT_SRC_AS|COUNT_SUM_AS)) pm_parquet_add_column(t, "as_src", PM_PARQUET_UINT32, TRUE);
+  if (wtc & COUNT_DST_AS) pm_parquet_add_column(t, "as_dst", PM_PARQUET_UINT32, TRUE);
+  if (wtc & COUNT_PEER_SRC_AS) pm_parquet_add_column(t, "peer_as_src", PM_PARQUET_UINT32, TRUE);
+  if (wtc & COUNT_PEER_DST_AS) pm_parquet_add_column(t, "peer_as_dst", PM_PARQUET_UINT32, TRUE);
+  if (wtc & COUNT_PEER_SRC_IP) pm_parquet_add_column(t, "peer_ip_src", PM_PARQUET_STRING, TRUE);
+  if (wtc & COUNT_PEER_DST_IP) pm_parquet_add_column(t, "peer_ip_dst", PM_PARQUET_STRING, TRUE);
+  if (wtc & COUNT_IN_IFACE) pm_parquet_add_column(t, "iface_in", PM_PARQUET_UINT32, TRUE);
+  if (wtc & COUNT_OUT_IFACE) pm_parquet_add_column(t, "iface_out", PM_PARQUET_UINT32, TRUE);
+  if (wtc & (COUNT_SRC_HOST|COUNT_SUM_HOST)) pm_parquet_add_column(t, "ip_src", PM_PARQUET_STRING, FALSE);
+  if (wtc & (COUNT_SRC_NET|COUNT_SUM_NET)) pm_parquet_add_column(t, "net_src", PM_PARQUET_STRING, FALSE);
+  if (wtc & COUNT_DST_HOST) pm_parquet_add_column(t, "ip_dst", PM_PARQUET_STRING, FALSE);
+  if (wtc & COUNT_DST_NET) pm_parquet_add_column(t, "net_dst", PM_PARQUET_STRING, FALSE);
+  if (wtc & COUNT_SRC_NMASK) pm_parquet_add_column(t, "mask_src", PM_PARQUET_UINT8, TRUE);
+  if (wtc & COUNT_DST_NMASK) pm_parquet_add_column(t, "mask_dst", PM_PARQUET_UINT8, TRUE);
+  if (wtc & (COUNT_SRC_PORT|COUNT_SUM_PORT)) pm_parquet_add_column(t, "port_src", PM_PARQUET_UINT16, FALSE);
+  if (wtc & COUNT_DST_PORT) pm_parquet_add_column(t, "port_dst", PM_PARQUET_UINT16, FALSE);
+  if (wtc & COUNT_TCPFLAGS) pm_parquet_add_column(t, "tcp_flags", PM_PARQUET_UINT32, TRUE);
+  if (wtc & COUNT_IP_PROTO) pm_parquet_add_column(t, "ip_proto", PM_PARQUET_STRING, TRUE);
+  if (wtc & COUNT_IP_TOS) pm_parquet_add_column(t, "tos", PM_PARQUET_UINT8, TRUE);
+
+  if (config.sql_history) {
+    pm_parquet_add_column(t, "stamp_inserted", PM_PARQUET_UINT64, TRUE);
+    pm_parquet_add_column(t, "stamp_updated", PM_PARQUET_UINT64, TRUE);
+  }
+
+  pm_parquet_add_column(t, "packets", PM_PARQUET_UINT64, FALSE);
+  if (wtc & COUNT_FLOWS) pm_parquet_add_column(t, "flows", PM_PARQUET_UINT64, FALSE);
+  pm_parquet_add_column(t, "bytes", PM_PARQUET_UINT64, FALSE);
+
+  t->props = gparquet_writer_properties_new();
+  gparquet_writer_properties_set_compression(t->props, GARROW_COMPRESSION_TYPE_SNAPPY, NULL);
+
+  for (idx = 0; idx < t->num; idx++) {
+    GArrowDataType *type = pm_parquet_data_type(t->col[idx].type);
+
+    fields = g_list_append(fields, garrow_field_new(t->col[idx].name, type));
+    g_object_unref(type);
+
+    if (t->col[idx].dictionary) gparquet_writer_properties_enable_dictionary(t->props, t->col[idx].name);
+    else gparquet_writer_properties_disable_dictionary(t->props, t->col[idx].name);
+  }
+
+  t->schema = garrow_schema_new(fields);
+  g_list_free_full(fields, g_object_unref);
+}
+
+void pm_parquet_table_append(struct pm_parquet_table *t, u_int64_t wtc, u_int8_t flow_type,
+  struct pkt_primitives *pbase, struct pkt_bgp_primitives *pbgp, pm_counter_t bytes_counter,
+  pm_counter_t packet_counter, pm_counter_t flow_counter, u_int32_t tcp_flags, struct timeval *basetime)
+{
+  char misc_str[INET6_ADDRSTRLEN];
+  int idx = 0;
+
+  if (wtc & COUNT_TAG) pm_parquet_append_uint(t, &idx, pbase->tag);
+  if (wtc & COUNT_TAG2) pm_parquet_append_uint(t, &idx, pbase->tag2);
+#if defined (HAVE_L2)
+  if (wtc & (COUNT_SRC_MAC|COUNT_SUM_MAC)) {
+    etheraddr_string(pbase->eth_shost, misc_str);
+    pm_parquet_append_str(t, &idx, misc_str);
+  }
+  if (wtc & COUNT_DST_MAC) {
+    etheraddr_string(pbase->eth_dhost, misc_str);
+    pm_parquet_append_str(t, &idx, misc_str);
+  }
+  if (wtc & COUNT_VLAN) pm_parquet_append_uint(t, &idx, pbase->vlan_id);
+#endif
+  if (wtc & (COUNT_SRC_AS|COUNT_SUM_AS)) pm_parquet_append_uint(t, &idx, pbase->src_as);
+  if (wtc & COUNT_DST_AS) pm_parquet_append_uint(t, &idx, pbase->dst_as);
+  if (wtc & COUNT_PEER_SRC_AS) pm_parquet_append_uint(t, &idx, pbgp->peer_src_as);
+  if (wtc & COUNT_PEER_DST_AS) pm_parquet_append_uint(t, &idx, pbgp->peer_dst_as);
+  if (wtc & COUNT_PEER_SRC_IP) {
+    addr_to_str(misc_str, &pbgp->peer_src_ip);
+    pm_parquet_append_str(t, &idx, misc_str);
+  }
+  if (wtc & COUNT_PEER_DST_IP) {
+    addr_to_str(misc_str, &pbgp->peer_dst_ip);
+    pm_parquet_append_str(t, &idx, misc_str);
+  }
+  if (wtc & COUNT_IN_IFACE) pm_parquet_append_uint(t, &idx, pbase->ifindex_in);
+  if (wtc & COUNT_OUT_IFACE) pm_parquet_append_uint(t, &idx, pbase->ifindex_out);
+  if (wtc & (COUNT_SRC_HOST|COUNT_SUM_HOST)) {
+    addr_to_str(misc_str, &pbase->src_ip);
+    pm_parquet_append_str(t, &idx, misc_str);
+  }
+  if (wtc & (COUNT_SRC_NET|COUNT_SUM_NET)) {
+    addr_to_str(misc_str, &pbase->src_net);
+    pm_parquet_append_str(t, &idx, misc_str);
+  }
+  if (wtc & COUNT_DST_HOST) {
+    addr_to_str(misc_str, &pbase->dst_ip);
+    pm_parquet_append_str(t, &idx, misc_str);
+  }
+  if (wtc & COUNT_DST_NET) {
+    addr_to_str(misc_str, &pbase->dst_net);
+    pm_parquet_append_str(t, &idx, misc_str);
+  }
+  if (wtc & COUNT_SRC_NMASK) pm_parquet_append_uint(t, &idx, pbase->src_nmask);
+  if (wtc & COUNT_DST_NMASK) pm_parquet_append_uint(t, &idx, pbase->dst_nmask);
+  if (wtc & (COUNT_SRC_PORT|COUNT_SUM_PORT)) pm_parquet_append_uint(t, &idx, pbase->src_port);
+  if (wtc & COUNT_DST_PORT) pm_parquet_append_uint(t, &idx, pbase->dst_port);
+  if (wtc & COUNT_TCPFLAGS) pm_parquet_append_uint(t, &idx, tcp_flags);
+  if (wtc & COUNT_IP_PROTO) {
+    if (!config.num_protos && (pbase->proto < protocols_number))
+      pm_parquet_append_str(t, &idx, _protocols[pbase->proto].name);
+    else {
+      snprintf(misc_str, sizeof(misc_str), "%u", pbase->proto);
+      pm_parquet_append_str(t, &idx, misc_str);
+    }
+  }
+  if (wtc & COUNT_IP_TOS) pm_parquet_append_uint(t, &idx, pbase->tos);
+
+  if (config.sql_history) {
+    pm_parquet_append_uint(t, &idx, basetime ? basetime->tv_sec : 0);
+    pm_parquet_append_uint(t, &idx, time(NULL));
+  }
+
+  if (flow_type == NF9_FTYPE_EVENT || flow_type == NF9_FTYPE_OPTION)
+    bytes_counter = packet_counter = flow_counter = 0;
+
+  pm_parquet_append_uint(t, &idx, packet_counter);
+  if (wtc & COUNT_FLOWS) pm_parquet_append_uint(t, &idx, flow_counter);
+  pm_parquet_append_uint(t, &idx, bytes_counter);
+
+  t->rows++;
+}
+
+/*
+   Finishes the column builders (which leaves them empty and ready for the
+   next file) and writes the resulting table to 'filename'.
+*/
+int pm_parquet_table_write(struct pm_parquet_table *t, char *filename)
+{
+  GArrowArray *arrays[PM_PARQUET_MAX_COLUMNS];
+  GArrowTable *table = NULL;
+  GParquetArrowFileWriter *writer = NULL;
+  GError *error = NULL;
+  int idx, num = 0, ret = ERR;
+
+  for (idx = 0; idx < t->num; idx++, num++) {
+    arrays[idx] = garrow_array_builder_finish(t->col[idx].builder, &error);
+    if (!arrays[idx]) goto exit_lane;
+  }
+
+  table = garrow_table_new_arrays(t->schema, arrays, num, &error);
+  if (!table) goto exit_lane;
+
+  writer = gparquet_arrow_file_writer_new_path(t->schema, filename, t->props, &error);
+  if (!writer) goto exit_lane;
+
+  if (!gparquet_arrow_file_writer_write_table(writer, table, PM_PARQUET_ROW_GROUP, &error)) goto exit_lane;
+  if (!gparquet_arrow_file_writer_close(writer, &error)) goto exit_lane;
+
+  ret = SUCCESS;
+
+  exit_lane:
+  if (ret == ERR) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): PARQUET: failed writing %s: %s\n", config.name, config.type,
+	filename, error ? error->message : "unknown error");
+    if (error) g_error_free(error);
+  }
+
+  if (writer) g_object_unref(writer);
+  if (table) g_object_unref(table);
+  for (idx = 0; idx < num; idx++) {
+    if (arrays[idx]) g_object_unref(arrays[idx]);
+  }
+
+  /* builders not finished above still hold rows: drop them too */
+  for (idx = num; idx < t->num; idx++) pm_parquet_builder_discard(&t->col[idx]);
+  t->rows = 0;
+
+  return ret;
+}
+
+void pm_parquet_table_free(struct pm_parquet_table *t)
+{
+  int idx;
+
+  for (idx = 0; idx < t->num; idx++) g_object_unref(t->col[idx].builder);
+  if (t->schema) g_object_unref(t->schema);
+  if (t->props) g_object_unref(t->props);
+
+  memset(t, 0, sizeof(struct pm_parquet_table));
+}
+#endif
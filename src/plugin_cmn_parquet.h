@@ -0,0 +1,65 @@
+/*
+    pmacct (Promiscuous mode IP Accounting package)
+    pmacct is Copyright (C) 2003-2018 by Paolo Lucente
+*/
+
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+
+/* defines */
+#define PM_PARQUET_UINT8		1
+#define PM_PARQUET_UINT16		2
+#define PM_PARQUET_UINT32		3
+#define PM_PARQUET_UINT64		4
+#define PM_PARQUET_STRING		5
+
+#define PM_PARQUET_MAX_COLUMNS		48
+#define PM_PARQUET_ROW_GROUP		1048576
+
+#ifdef WITH_PARQUET
+struct pm_parquet_column {
+  const char *name;
+  u_int8_t type;
+  u_int8_t dictionary;
+  GArrowArrayBuilder *builder;
+};
+
+struct pm_parquet_table {
+  struct pm_parquet_column col[PM_PARQUET_MAX_COLUMNS];
+  int num;
+  u_int64_t rows;
+  GArrowSchema *schema;
+  GParquetWriterProperties *props;
+};
+#endif
+
+/* prototypes */
+#if (!defined __PLUGIN_CMN_PARQUET_C)
+#define EXT extern
+#else
+#define EXT
+#endif
+
+#ifdef WITH_PARQUET
+EXT void pm_parquet_table_init(struct pm_parquet_table *, u_int64_t, u_int64_t);
+EXT void pm_parquet_table_append(struct pm_parquet_table *, u_int64_t, u_int8_t,
+  struct pkt_primitives *, struct pkt_bgp_primitives *, pm_counter_t,
+  pm_counter_t, pm_counter_t, u_int32_t, struct timeval *);
+EXT int pm_parquet_table_write(struct pm_parquet_table *, char *);
+EXT void pm_parquet_table_free(struct pm_parquet_table *);
+#endif
+#undef EXT
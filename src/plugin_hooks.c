@@ -526,19 +526,23 @@ reprocess:
         if (p->cfg.type_id == PLUGIN_ID_TEE) {
           req->ptm_c.load_ptm_plugin = p->cfg.type_id;
           req->ptm_c.load_ptm_res = FALSE;
-        }
 
-        load_pre_tag_map(config.acct_type, p->cfg.pre_tag_map, &p->cfg.ptm, req, &p->cfg.ptm_alloc,
-                         p->cfg.maps_entries, p->cfg.maps_row_len);
+          /* ptm_complex must be in sync with exec_ptm_dissect: no background reload */
+          load_pre_tag_map(config.acct_type, p->cfg.pre_tag_map, &p->cfg.ptm, req, &p->cfg.ptm_alloc,
+                           p->cfg.maps_entries, p->cfg.maps_row_len);
 
-        if (p->cfg.type_id == PLUGIN_ID_TEE) {
           p->cfg.ptm_complex = req->ptm_c.load_ptm_res;
           if (req->ptm_c.load_ptm_res) req->ptm_c.exec_ptm_dissect = TRUE;
         }
+        else load_pre_tag_map_bg(config.acct_type, p->cfg.pre_tag_map, &p->cfg.ptm, req, &p->cfg.ptm_alloc,
+                                 p->cfg.maps_entries, p->cfg.maps_row_len);
       }
     }
   }
 
+  /* swapping in maps reloaded in background, if any */
+  if (id_file_bg_done) load_id_file_bg_commit();
+
   /* cleanups */
   reload_map_exec_plugins = FALSE;
   pretag_free_label(&saved_label);
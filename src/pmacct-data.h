@@ -393,6 +393,9 @@ static const struct _dictionary_line dictionary[] = {
   {"sql_multi_values", cfg_key_sql_multi_values},
   {"sql_locking_style", cfg_key_sql_locking_style},
   {"sql_use_copy", cfg_key_sql_use_copy},
+  {"sql_copy_upsert", cfg_key_sql_copy_upsert},
+  {"sql_prepared_statements", cfg_key_sql_prepared_statements},
+  {"sql_writer_connections", cfg_key_sql_writer_connections},
   {"sql_num_protos", cfg_key_num_protos},
   {"sql_num_hosts", cfg_key_num_hosts},
   {"print_refresh_time", cfg_key_sql_refresh_time},
@@ -403,6 +406,7 @@ static const struct _dictionary_line dictionary[] = {
   {"print_output_file_append", cfg_key_print_output_file_append},
   {"print_output_lock_file", cfg_key_print_output_lock_file},
   {"print_output_separator", cfg_key_print_output_separator},
+  {"print_output_compression", cfg_key_print_output_compression},
   {"print_latest_file", cfg_key_print_latest_file},
   {"print_num_protos", cfg_key_num_protos},
   {"print_trigger_exec", cfg_key_sql_trigger_exec},
@@ -453,6 +457,7 @@ static const struct _dictionary_line dictionary[] = {
   {"amqp_preprocess_type", cfg_key_sql_preprocess_type},
   {"amqp_startup_delay", cfg_key_sql_startup_delay},
   {"amqp_heartbeat_interval", cfg_key_amqp_heartbeat_interval},
+  {"amqp_confirm_window", cfg_key_amqp_confirm_window},
   {"amqp_multi_values", cfg_key_sql_multi_values},
   {"amqp_num_protos", cfg_key_num_protos},
   {"amqp_vhost", cfg_key_amqp_vhost},
@@ -484,6 +489,7 @@ static const struct _dictionary_line dictionary[] = {
   {"kafka_avro_schema_topic", cfg_key_kafka_avro_schema_topic},
   {"kafka_avro_schema_refresh_time", cfg_key_kafka_avro_schema_refresh_time},
   {"kafka_config_file", cfg_key_kafka_config_file},
+  {"kafka_compression", cfg_key_kafka_compression},
   {"kafka_trigger_exec", cfg_key_sql_trigger_exec},
   {"nfacctd_proc_name", cfg_key_proc_name},
   {"nfacctd_port", cfg_key_nfacctd_port},
@@ -540,6 +546,8 @@ static const struct _dictionary_line dictionary[] = {
   {"telemetry_daemon_allow_file", cfg_key_telemetry_allow_file},
   {"telemetry_daemon_pipe_size", cfg_key_telemetry_pipe_size},
   {"telemetry_daemon_ipprec", cfg_key_telemetry_ip_precedence},
+  {"telemetry_daemon_threads", cfg_key_telemetry_threads},
+  {"telemetry_daemon_queue_size", cfg_key_telemetry_queue_size},
   {"telemetry_daemon_msglog_output", cfg_key_telemetry_msglog_output},
   {"telemetry_daemon_msglog_file", cfg_key_telemetry_msglog_file},
   {"telemetry_daemon_msglog_amqp_host", cfg_key_telemetry_msglog_amqp_host},
@@ -566,6 +574,7 @@ static const struct _dictionary_line dictionary[] = {
   {"telemetry_dump_file", cfg_key_telemetry_dump_file},
   {"telemetry_dump_latest_file", cfg_key_telemetry_dump_latest_file},
   {"telemetry_dump_refresh_time", cfg_key_telemetry_dump_refresh_time},
+  {"telemetry_dump_workers", cfg_key_telemetry_dump_workers},
   {"telemetry_dump_amqp_host", cfg_key_telemetry_dump_amqp_host},
   {"telemetry_dump_amqp_vhost", cfg_key_telemetry_dump_amqp_vhost},
   {"telemetry_dump_amqp_user", cfg_key_telemetry_dump_amqp_user},
@@ -587,6 +596,7 @@ static const struct _dictionary_line dictionary[] = {
   {"refresh_maps", cfg_key_maps_refresh}, // legacy
   {"maps_refresh", cfg_key_maps_refresh},
   {"maps_index", cfg_key_maps_index},
+  {"maps_refresh_background", cfg_key_maps_refresh_background},
   {"maps_entries", cfg_key_maps_entries},
   {"maps_row_len", cfg_key_maps_row_len},
   {"pre_tag_map", cfg_key_pre_tag_map},	
@@ -710,10 +720,12 @@ static const struct _dictionary_line dictionary[] = {
   {"bgp_daemon_md5_file", cfg_key_nfacctd_bgp_md5_file},
   {"bgp_daemon_batch", cfg_key_nfacctd_bgp_batch},
   {"bgp_daemon_batch_interval", cfg_key_nfacctd_bgp_batch_interval},
+  {"bgp_daemon_threads", cfg_key_nfacctd_bgp_threads},
   {"bgp_aspath_radius", cfg_key_nfacctd_bgp_aspath_radius},
   {"bgp_stdcomm_pattern", cfg_key_nfacctd_bgp_stdcomm_pattern},
   {"bgp_extcomm_pattern", cfg_key_nfacctd_bgp_extcomm_pattern},
   {"bgp_stdcomm_pattern_to_asn", cfg_key_nfacctd_bgp_stdcomm_pattern_to_asn},
+  {"bgp_comm_pattern_anchored", cfg_key_nfacctd_bgp_comm_pattern_anchored},
   {"bgp_peer_as_skip_subas", cfg_key_nfacctd_bgp_peer_as_skip_subas},
   {"bgp_peer_src_as_map", cfg_key_nfacctd_bgp_peer_src_as_map},
   {"bgp_src_local_pref_map", cfg_key_nfacctd_bgp_src_local_pref_map},
@@ -734,10 +746,16 @@ static const struct _dictionary_line dictionary[] = {
   {"bgp_table_per_peer_buckets", cfg_key_nfacctd_bgp_table_per_peer_buckets},
   {"bgp_table_attr_hash_buckets", cfg_key_nfacctd_bgp_table_attr_hash_buckets},
   {"bgp_table_per_peer_hash", cfg_key_nfacctd_bgp_table_per_peer_hash},
+  {"bgp_lookup_cache_entries", cfg_key_nfacctd_bgp_lookup_cache_entries},
   {"bgp_table_dump_output", cfg_key_nfacctd_bgp_table_dump_output},
   {"bgp_table_dump_file", cfg_key_nfacctd_bgp_table_dump_file},
   {"bgp_table_dump_latest_file", cfg_key_nfacctd_bgp_table_dump_latest_file},
   {"bgp_table_dump_refresh_time", cfg_key_nfacctd_bgp_table_dump_refresh_time},
+  {"bgp_table_dump_workers", cfg_key_nfacctd_bgp_table_dump_workers},
+  {"bgp_table_dump_checkpoint", cfg_key_nfacctd_bgp_table_dump_checkpoint},
+  {"bgp_table_snapshot_file", cfg_key_nfacctd_bgp_table_snapshot_file},
+  {"bgp_table_snapshot_refresh_time", cfg_key_nfacctd_bgp_table_snapshot_refresh_time},
+  {"bgp_table_snapshot_stale_time", cfg_key_nfacctd_bgp_table_snapshot_stale_time},
   {"bgp_table_dump_amqp_host", cfg_key_nfacctd_bgp_table_dump_amqp_host},
   {"bgp_table_dump_amqp_vhost", cfg_key_nfacctd_bgp_table_dump_amqp_vhost},
   {"bgp_table_dump_amqp_user", cfg_key_nfacctd_bgp_table_dump_amqp_user},
@@ -772,6 +790,8 @@ static const struct _dictionary_line dictionary[] = {
   {"bmp_daemon_ipprec", cfg_key_nfacctd_bmp_ip_precedence},
   {"bmp_daemon_batch", cfg_key_nfacctd_bmp_batch},
   {"bmp_daemon_batch_interval", cfg_key_nfacctd_bmp_batch_interval},
+  {"bmp_daemon_threads", cfg_key_nfacctd_bmp_threads},
+  {"bmp_daemon_nlri_batch", cfg_key_nfacctd_bmp_nlri_batch},
   {"bmp_daemon_msglog_output", cfg_key_nfacctd_bmp_msglog_output},
   {"bmp_daemon_msglog_file", cfg_key_nfacctd_bmp_msglog_file},
   {"bmp_daemon_msglog_amqp_host", cfg_key_nfacctd_bmp_msglog_amqp_host},
@@ -802,6 +822,7 @@ static const struct _dictionary_line dictionary[] = {
   {"bmp_dump_file", cfg_key_nfacctd_bmp_dump_file},
   {"bmp_dump_latest_file", cfg_key_nfacctd_bmp_dump_latest_file},
   {"bmp_dump_refresh_time", cfg_key_nfacctd_bmp_dump_refresh_time},
+  {"bmp_dump_workers", cfg_key_nfacctd_bmp_dump_workers},
   {"bmp_dump_amqp_host", cfg_key_nfacctd_bmp_dump_amqp_host},
   {"bmp_dump_amqp_vhost", cfg_key_nfacctd_bmp_dump_amqp_vhost},
   {"bmp_dump_amqp_user", cfg_key_nfacctd_bmp_dump_amqp_user},
@@ -394,6 +394,10 @@
 #define PRINT_OUTPUT_JSON	0x00000004
 #define PRINT_OUTPUT_EVENT	0x00000008
 #define PRINT_OUTPUT_AVRO  	0x00000010
+#define PRINT_OUTPUT_PARQUET	0x00000020
+
+#define PRINT_COMPRESSION_NONE	0
+#define PRINT_COMPRESSION_GZIP	1
 
 #define DIRECTION_UNKNOWN	0x00000000
 #define DIRECTION_IN		0x00000001
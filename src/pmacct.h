@@ -206,6 +206,7 @@ struct plugin_requests {
   int line_num;			/* line number being processed */
   int map_entries;		/* number of map entries: wins over global setting */
   int map_row_len;		/* map row length: wins over global setting */
+  u_int8_t bg_load;		/* map loaded by the background helper thread */
   struct ptm_complex ptm_c;	/* flags a map that requires parsing of the records (ie. tee plugin) */
 };
 
@@ -227,6 +228,11 @@ typedef struct {
 #include <avro.h>
 #endif
 
+#if (defined WITH_PARQUET)
+#include <arrow-glib/arrow-glib.h>
+#include <parquet-glib/parquet-glib.h>
+#endif
+
 #include "pmacct-defines.h"
 #include "network.h"
 #include "pretag.h"
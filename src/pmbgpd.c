@@ -245,7 +245,7 @@ int main(int argc,char **argv, char **envp)
   /* signal handling we want to inherit to plugins (when not re-defined elsewhere) */
   signal(SIGCHLD, startup_handle_falling_child); /* takes note of plugins failed during startup phase */
   signal(SIGHUP, reload); /* handles reopening of syslog channel */
-  signal(SIGUSR1, SIG_IGN);
+  signal(SIGUSR1, push_stats);
   signal(SIGUSR2, reload_maps); /* sets to true the reload_maps flag */
   signal(SIGPIPE, SIG_IGN); /* we want to exit gracefully when a pipe is broken */
   signal(SIGINT, my_sigint_handler);
@@ -334,6 +334,7 @@ void bgp_lg_daemon_worker_json(void *zh, void *zs)
         if (!ret) ret = bgp_lg_daemon_ip_lookup(req.data, &ipl_rep, FUNC_TYPE_BGP); 
 
         bgp_lg_daemon_encode_reply_ip_lookup_json(sock, &ipl_rep, ret);
+        bgp_rib_read_exit();
       }
       break;
     case BGP_LG_QT_GET_PEERS:
@@ -35,8 +35,14 @@
 #include "bgp/bgp_xcs.h"
 #include "bgp/bgp_xcs-data.h"
 #include "crc32.h"
+#include "thread_pool.h"
 #include "pmacct-data.h"
 
+/* variables to be exported away */
+thread_pool_t *id_file_bg_pool;
+pthread_mutex_t id_file_bg_mutex = PTHREAD_MUTEX_INITIALIZER;
+int id_file_bg_runner_active;
+
 /*
    XXX: load_id_file() interface cleanup pending:
    - if a table is tag-related then it is passed as argument t
@@ -678,6 +684,9 @@ void load_id_file(int acct_type, char *filename, struct id_table *t, struct plug
   if (tmp.e) free(tmp.e) ;
   if (buf) free(buf) ;
 
+  /* background loads get their caching flags applied at swap time */
+  if (t && !req->bg_load) pretag_map_caching_apply(acct_type, t);
+
   Log(LOG_INFO, "INFO ( %s/%s ): [%s] map successfully (re)loaded.\n", config.name, config.type, filename);
 
   return;
@@ -686,7 +695,11 @@ void load_id_file(int acct_type, char *filename, struct id_table *t, struct plug
   if (*map_allocated && tmp.e) free(tmp.e) ;
   if (buf) free(buf);
 
-  if (t && t->timestamp) {
+  if (req->bg_load) {
+    /* current map is left in place by load_id_file_bg_runner() */
+    Log(LOG_WARNING, "WARN ( %s/%s ): [%s] Rolling back old map.\n", config.name, config.type, filename);
+  }
+  else if (t && t->timestamp) {
     Log(LOG_WARNING, "WARN ( %s/%s ): [%s] Rolling back old map.\n", config.name, config.type, filename);
 
     /* we update the timestamp to avoid loops */
@@ -736,6 +749,234 @@ void load_pre_tag_map(int acct_type, char *filename, struct id_table *t, struct
   }
 }
 
+/*
+   load_id_file_bg(): (re)loads a tag-related map in a helper thread if
+   maps_refresh_background is enabled and the table was already loaded
+   successfully once; returns TRUE if the reload was deferred, in which
+   case the new table is swapped in by load_id_file_bg_commit(). In all
+   other cases it falls back to load_id_file() and returns FALSE.
+*/
+int load_id_file_bg(int acct_type, char *filename, struct id_table *t, struct plugin_requests *req, int *map_allocated)
+{
+  struct id_file_bg_job *job = NULL;
+  int idx;
+
+  if (!config.maps_refresh_background || !filename || !t || !req || !map_allocated ||
+      !(*map_allocated) || !t->timestamp) {
+    load_id_file(acct_type, filename, t, req, map_allocated);
+    return FALSE;
+  }
+
+  pthread_mutex_lock(&id_file_bg_mutex);
+
+  for (idx = 0; idx < MAX_ID_FILE_BG_JOBS; idx++) {
+    if (id_file_bg_jobs[idx].t == t) {
+      job = &id_file_bg_jobs[idx];
+      break;
+    }
+    else if (!job && !id_file_bg_jobs[idx].t) job = &id_file_bg_jobs[idx];
+  }
+
+  if (!job) {
+    pthread_mutex_unlock(&id_file_bg_mutex);
+
+    Log(LOG_WARNING, "WARN ( %s/%s ): [%s] out of background reload slots. Reloading in foreground.\n",
+	config.name, config.type, filename);
+    load_id_file(acct_type, filename, t, req, map_allocated);
+    return FALSE;
+  }
+
+  if (job->state != ID_FILE_BG_IDLE) {
+    job->reload = TRUE;
+    pthread_mutex_unlock(&id_file_bg_mutex);
+
+    Log(LOG_INFO, "INFO ( %s/%s ): [%s] background reload in progress. Rescheduled.\n",
+	config.name, config.type, filename);
+    return TRUE;
+  }
+
+  job->t = t;
+  job->acct_type = acct_type;
+  job->filename = filename;
+  memcpy(&job->req, req, sizeof(struct plugin_requests));
+  job->state = ID_FILE_BG_QUEUED;
+
+  load_id_file_bg_kick();
+  pthread_mutex_unlock(&id_file_bg_mutex);
+
+  Log(LOG_INFO, "INFO ( %s/%s ): [%s] map scheduled for background reload.\n", config.name, config.type, filename);
+
+  return TRUE;
+}
+
+int load_pre_tag_map_bg(int acct_type, char *filename, struct id_table *t, struct plugin_requests *req,
+			int *map_allocated, int map_entries, int map_row_len)
+{
+  int ret;
+
+  if (req) {
+    req->map_entries = map_entries;
+    req->map_row_len = map_row_len;
+  }
+
+  ret = load_id_file_bg(acct_type, filename, t, req, map_allocated);
+
+  if (req) {
+    req->map_entries = FALSE;
+    req->map_row_len = FALSE;
+  }
+
+  return ret;
+}
+
+/* to be called with id_file_bg_mutex held */
+void load_id_file_bg_kick()
+{
+  if (id_file_bg_runner_active) return;
+
+  if (!id_file_bg_pool) {
+    id_file_bg_pool = allocate_thread_pool(1);
+    assert(id_file_bg_pool);
+  }
+
+  id_file_bg_runner_active = TRUE;
+  send_to_pool(id_file_bg_pool, load_id_file_bg_runner, NULL);
+}
+
+void load_id_file_bg_runner()
+{
+  struct id_file_bg_job *job;
+  int idx, map_allocated;
+
+  pthread_mutex_lock(&id_file_bg_mutex);
+
+  for (idx = 0; idx < MAX_ID_FILE_BG_JOBS; ) {
+    job = &id_file_bg_jobs[idx];
+
+    if (job->state == ID_FILE_BG_QUEUED) {
+      job->state = ID_FILE_BG_RUNNING;
+      memset(&job->shadow, 0, sizeof(struct id_table));
+
+      /* bg_load makes load_id_file() give up, instead of bailing out, in
+	 case of errors; the current map stays in place */
+      job->req.bg_load = TRUE;
+      pthread_mutex_unlock(&id_file_bg_mutex);
+
+      map_allocated = FALSE;
+      load_id_file(job->acct_type, job->filename, &job->shadow, &job->req, &map_allocated);
+
+      pthread_mutex_lock(&id_file_bg_mutex);
+
+      /* filename is set by load_id_file() only upon a successful load */
+      if (job->shadow.filename) {
+	job->state = ID_FILE_BG_DONE;
+	id_file_bg_done++;
+      }
+      else {
+	if (job->shadow.e) free(job->shadow.e);
+	memset(&job->shadow, 0, sizeof(struct id_table));
+
+	job->state = (job->reload ? ID_FILE_BG_QUEUED : ID_FILE_BG_IDLE);
+	job->reload = FALSE;
+      }
+
+      idx = 0;
+    }
+    else if (job->state == ID_FILE_BG_FREE) {
+      job->state = ID_FILE_BG_RUNNING;
+      pthread_mutex_unlock(&id_file_bg_mutex);
+
+      pretag_destroy_table(&job->old);
+
+      pthread_mutex_lock(&id_file_bg_mutex);
+      job->state = (job->reload ? ID_FILE_BG_QUEUED : ID_FILE_BG_IDLE);
+      job->reload = FALSE;
+
+      idx = 0;
+    }
+    else idx++;
+  }
+
+  id_file_bg_runner_active = FALSE;
+  pthread_mutex_unlock(&id_file_bg_mutex);
+}
+
+/*
+   load_id_file_bg_commit(): to be called by the Core Process at a point
+   where no references to map entries are held, ie. in between packets;
+   swaps in tables reloaded by the helper thread.
+*/
+void load_id_file_bg_commit()
+{
+  struct id_file_bg_job *job;
+  int idx, swapped = FALSE;
+
+  if (!id_file_bg_done) return;
+
+  pthread_mutex_lock(&id_file_bg_mutex);
+
+  for (idx = 0; idx < MAX_ID_FILE_BG_JOBS; idx++) {
+    job = &id_file_bg_jobs[idx];
+
+    if (job->state == ID_FILE_BG_DONE) {
+      memcpy(&job->old, job->t, sizeof(struct id_table));
+      memcpy(job->t, &job->shadow, sizeof(struct id_table));
+      memset(&job->shadow, 0, sizeof(struct id_table));
+      pretag_map_caching_apply(job->acct_type, job->t);
+
+      job->state = ID_FILE_BG_FREE;
+      id_file_bg_done--;
+      swapped = TRUE;
+
+      Log(LOG_INFO, "INFO ( %s/%s ): [%s] map swapped in.\n", config.name, config.type, job->filename);
+    }
+  }
+
+  if (swapped) {
+    /* invalidate bgp_agent_map and sampling_map caches */
+    gettimeofday(&reload_map_tstamp, NULL);
+    load_id_file_bg_kick();
+  }
+
+  pthread_mutex_unlock(&id_file_bg_mutex);
+}
+
+void pretag_destroy_table(struct id_table *t)
+{
+  int index;
+
+  if (!t) return;
+
+  if (config.maps_index && pretag_index_have_one(t)) pretag_index_destroy(t);
+
+  if (t->e) {
+    for (index = 0; index < t->num; index++) {
+      pcap_freecode(&t->e[index].key.filter);
+      pretag_free_label(&t->e[index].label);
+    }
+
+    free(t->e);
+  }
+
+  memset(t, 0, sizeof(struct id_table));
+}
+
+/*
+   pretag_map_caching_apply(): bgp_agent_map and sampling_map lookups are
+   cached by nfacctd and sfacctd unless the map makes use of keys which
+   are not part of the cache key (PRETAG_FLAG_NOCACHE). To be called by
+   the Core Process only.
+*/
+void pretag_map_caching_apply(int acct_type, struct id_table *t)
+{
+  int caching;
+
+  caching = ((config.acct_type == ACCT_NF || config.acct_type == ACCT_SF) && !(t->flags & PRETAG_FLAG_NOCACHE));
+
+  if (acct_type == MAP_SAMPLING) sampling_map_caching = caching;
+  else if (acct_type == MAP_BGP_TO_XFLOW_AGENT) bta_map_caching = caching;
+}
+
 void pretag_init_vars(struct packet_ptrs *pptrs, struct id_table *t)
 {
   if (!pptrs) return;
@@ -29,6 +29,13 @@
 #define ID_TABLE_INDEX_DEPTH 8
 #define ID_TABLE_INDEX_RESULTS (MAX_ID_TABLE_INDEXES * 8)
 
+#define MAX_ID_FILE_BG_JOBS		(MAX_N_PLUGINS + 8)
+#define ID_FILE_BG_IDLE			0
+#define ID_FILE_BG_QUEUED		1
+#define ID_FILE_BG_RUNNING		2
+#define ID_FILE_BG_DONE			3
+#define ID_FILE_BG_FREE			4
+
 #define PRETAG_IN_IFACE			0x000000001ULL
 #define PRETAG_OUT_IFACE		0x000000002ULL
 #define PRETAG_NEXTHOP			0x000000004ULL
@@ -75,6 +82,7 @@
 #define PRETAG_MAP_RCODE_LABEL		0x00008000
 
 #define PRETAG_FLAG_NEG			0x00000001
+#define PRETAG_FLAG_NOCACHE		0x00000002
 
 #define IDT_INDEX_HASH_BASE(entries)	(entries * 2)
 
@@ -229,6 +237,20 @@ struct id_table {
   u_int32_t flags;
 };
 
+/* background (re)load of a map: the helper thread builds 'shadow' which
+   is then swapped into 't' by the Core Process at a safe point; the table
+   swapped out is parked into 'old' and freed by the helper thread */
+struct id_file_bg_job {
+  int state;
+  int reload;			/* further reload requested while busy */
+  int acct_type;
+  char *filename;
+  struct id_table *t;
+  struct id_table shadow;
+  struct id_table old;
+  struct plugin_requests req;
+};
+
 struct _map_dictionary_line {
   char key[SRVBUFLEN];
   int (*func)(char *, struct id_entry *, char *, struct plugin_requests *, int);
@@ -257,6 +279,13 @@ struct pretag_label_filter {
 #endif
 EXT void load_id_file(int, char *, struct id_table *, struct plugin_requests *, int *);
 EXT void load_pre_tag_map(int, char *, struct id_table *, struct plugin_requests *, int *, int, int);
+EXT int load_id_file_bg(int, char *, struct id_table *, struct plugin_requests *, int *);
+EXT int load_pre_tag_map_bg(int, char *, struct id_table *, struct plugin_requests *, int *, int, int);
+EXT void load_id_file_bg_runner();
+EXT void load_id_file_bg_kick();
+EXT void load_id_file_bg_commit();
+EXT void pretag_destroy_table(struct id_table *);
+EXT void pretag_map_caching_apply(int, struct id_table *);
 EXT u_int8_t pt_check_neg(char **, u_int32_t *);
 EXT char * pt_check_range(char *);
 EXT void pretag_init_vars(struct packet_ptrs *, struct id_table *);
@@ -288,6 +317,9 @@ EXT int bitr_map_allocated;
 EXT int sampling_map_allocated;
 EXT int custom_primitives_allocated;
 
+EXT struct id_file_bg_job id_file_bg_jobs[MAX_ID_FILE_BG_JOBS];
+EXT volatile int id_file_bg_done;
+
 EXT int bta_map_caching; 
 EXT int sampling_map_caching; 
 
@@ -215,8 +215,9 @@ int PT_map_input_handler(char *filename, struct id_entry *e, char *value, struct
   int x = 0, len;
   char *endptr;
 
-  if (acct_type == MAP_SAMPLING) sampling_map_caching = FALSE;
-  if (acct_type == MAP_BGP_TO_XFLOW_AGENT) bta_map_caching = FALSE; 
+  /* lookups can't be cached: iface is not part of the cache key */
+  if (acct_type == MAP_SAMPLING || acct_type == MAP_BGP_TO_XFLOW_AGENT)
+    ((struct id_table *) req->key_value_table)->flags |= PRETAG_FLAG_NOCACHE;
   if (req->ptm_c.load_ptm_plugin == PLUGIN_ID_TEE) req->ptm_c.load_ptm_res = TRUE;
 
   e->key.input.neg = pt_check_neg(&value, &((struct id_table *) req->key_value_table)->flags);
@@ -250,8 +251,9 @@ int PT_map_output_handler(char *filename, struct id_entry *e, char *value, struc
   int x = 0, len;
   char *endptr;
 
-  if (acct_type == MAP_SAMPLING) sampling_map_caching = FALSE;
-  if (acct_type == MAP_BGP_TO_XFLOW_AGENT) bta_map_caching = FALSE; 
+  /* lookups can't be cached: iface is not part of the cache key */
+  if (acct_type == MAP_SAMPLING || acct_type == MAP_BGP_TO_XFLOW_AGENT)
+    ((struct id_table *) req->key_value_table)->flags |= PRETAG_FLAG_NOCACHE;
   if (req->ptm_c.load_ptm_plugin == PLUGIN_ID_TEE) req->ptm_c.load_ptm_res = TRUE;
 
   e->key.output.neg = pt_check_neg(&value, &((struct id_table *) req->key_value_table)->flags);
@@ -2148,7 +2150,7 @@ int pretag_id_handler(struct packet_ptrs *pptrs, void *id, void *e)
 	    char tmp_stdcomms[MAX_BGP_STD_COMMS];
 
 	    if (info->attr->community && info->attr->community->str) {
-	      evaluate_comm_patterns(tmp_stdcomms, info->attr->community->str, std_comm_patterns_to_asn, MAX_BGP_STD_COMMS);
+	      evaluate_std_comm_patterns(tmp_stdcomms, info->attr->community, &std_comm_matchers_to_asn, MAX_BGP_STD_COMMS);
 	      copy_stdcomm_to_asn(tmp_stdcomms, (as_t *)tid, FALSE);
 	    }
           }
@@ -2427,7 +2429,7 @@ int BPAS_bgp_peer_dst_as_handler(struct packet_ptrs *pptrs, void *unused, void *
           char tmp_stdcomms[MAX_BGP_STD_COMMS];
 
           if (info->attr->community && info->attr->community->str) {
-            evaluate_comm_patterns(tmp_stdcomms, info->attr->community->str, std_comm_patterns_to_asn, MAX_BGP_STD_COMMS);
+            evaluate_std_comm_patterns(tmp_stdcomms, info->attr->community, &std_comm_matchers_to_asn, MAX_BGP_STD_COMMS);
             copy_stdcomm_to_asn(tmp_stdcomms, &asn, FALSE);
           }
         }
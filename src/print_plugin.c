@@ -29,6 +29,7 @@
 #include "plugin_common.h"
 #include "plugin_cmn_json.h"
 #include "plugin_cmn_avro.h"
+#include "plugin_cmn_parquet.h"
 #include "print_plugin.h"
 #include "ip_flow.h"
 #include "classifier.h"
@@ -93,12 +94,35 @@ void print_plugin(int pipe_fd, struct configuration *cfgptr, void *ptr)
   if (config.print_output & PRINT_OUTPUT_JSON) {
     compose_json(config.what_to_count, config.what_to_count_2);
   }
+  else if (config.print_output & PRINT_OUTPUT_CSV) {
+    P_csv_compose_handlers(config.what_to_count, config.what_to_count_2, is_event);
+  }
   else if (config.print_output & PRINT_OUTPUT_AVRO) {
 #ifdef WITH_AVRO
     avro_acct_schema = build_avro_schema(config.what_to_count, config.what_to_count_2);
     if (config.avro_schema_output_file) write_avro_schema_to_file(config.avro_schema_output_file, avro_acct_schema);
 #endif
   }
+  else if (config.print_output & PRINT_OUTPUT_PARQUET) {
+    if (!config.sql_table) {
+      Log(LOG_ERR, "ERROR ( %s/%s ): print_output set to parquet requires print_output_file. Exiting ..\n", config.name, config.type);
+      exit_plugin(1);
+    }
+
+    if (config.print_output_file_append) {
+      Log(LOG_WARNING, "WARN ( %s/%s ): print_output_file_append is not supported with parquet output; disabling.\n", config.name, config.type);
+      config.print_output_file_append = FALSE;
+    }
+
+#ifdef WITH_PARQUET
+    pm_parquet_table_init(&parquet_table, config.what_to_count, config.what_to_count_2);
+#endif
+  }
+
+  if (config.print_output_compression && !(config.print_output & PRINT_OUTPUT_CSV)) {
+    Log(LOG_WARNING, "WARN ( %s/%s ): print_output_compression applies to csv output only; disabling.\n", config.name, config.type);
+    config.print_output_compression = PRINT_COMPRESSION_NONE;
+  }
 
   /* setting function pointers */
   if (config.what_to_count & (COUNT_SUM_HOST|COUNT_SUM_NET))
@@ -337,8 +361,12 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
   struct primitives_ptrs prim_ptrs, elem_prim_ptrs;
   struct pkt_data dummy_data, elem_dummy_data;
   pid_t writer_pid = getpid();
+  struct pm_json_buf json_enc;
+  struct P_outbuf csv_ob;
 #ifdef WITH_AVRO
   avro_file_writer_t avro_writer;
+  avro_value_iface_t *avro_iface = NULL;
+  avro_value_t avro_value;
 #endif
 
   if (!index) {
@@ -362,9 +390,25 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
   memset(&dummy_data, 0, sizeof(dummy_data));
   memset(&elem_prim_ptrs, 0, sizeof(elem_prim_ptrs));
   memset(&elem_dummy_data, 0, sizeof(elem_dummy_data));
+  memset(&json_enc, 0, sizeof(json_enc));
+  memset(&csv_ob, 0, sizeof(csv_ob));
 
   fd_buf = malloc(OUTPUT_FILE_BUFSZ);
 
+  if (config.print_output & PRINT_OUTPUT_CSV) P_outbuf_init(&csv_ob, OUTPUT_FILE_BUFSZ);
+
+#ifdef WITH_JANSSON
+  if (config.print_output & PRINT_OUTPUT_JSON) pm_json_buf_init(&json_enc, 0);
+#endif
+
+#ifdef WITH_AVRO
+  /* class and value are built once and reused for all records */
+  if (config.print_output & PRINT_OUTPUT_AVRO) {
+    avro_iface = avro_generic_class_from_schema(avro_acct_schema);
+    check_i(avro_generic_value_new(avro_iface, &avro_value));
+  }
+#endif
+
   for (j = 0, stop = 0; (!stop) && P_preprocess_funcs[j]; j++)
     stop = P_preprocess_funcs[j](queue, &index, j);
 
@@ -394,7 +438,10 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
     }
     else strlcpy(current_table, config.sql_table, SRVBUFLEN);
 
-    if (config.print_output & PRINT_OUTPUT_AVRO) {
+    if (config.print_output & PRINT_OUTPUT_PARQUET) {
+      /* columns are buffered in parquet_table and the file is written at the end */
+    }
+    else if (config.print_output & PRINT_OUTPUT_AVRO) {
       int file_is_empty, ret;
 #ifdef WITH_AVRO
       f = open_output_file(current_table, "ab", TRUE);
@@ -431,8 +478,12 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
         else memset(fd_buf, 0, OUTPUT_FILE_BUFSZ);
       }
 
+      if (config.print_output & PRINT_OUTPUT_CSV) P_outbuf_set_file(&csv_ob, f);
+
       if (config.print_markers) {
-	if ((config.print_output & PRINT_OUTPUT_CSV) || (config.print_output & PRINT_OUTPUT_FORMATTED))
+	if (config.print_output & PRINT_OUTPUT_CSV)
+	  P_outbuf_marker(&csv_ob, "START", writer_pid);
+	else if (config.print_output & PRINT_OUTPUT_FORMATTED)
 	  fprintf(f, "--START (%u)--\n", writer_pid);
 	else if (config.print_output & PRINT_OUTPUT_JSON) {
           void *json_obj;
@@ -446,7 +497,7 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
 	if (config.print_output & PRINT_OUTPUT_FORMATTED)
 	  P_write_stats_header_formatted(f, is_event);
 	else if (config.print_output & PRINT_OUTPUT_CSV)
-	  P_write_stats_header_csv(f, is_event);
+	  P_write_stats_header_csv(&csv_ob, is_event);
       }
     }
   }
@@ -459,8 +510,12 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
         Log(LOG_WARNING, "WARN ( %s/%s ): Failed locking print_output_lock_file: %s\n", config.name, config.type, config.print_output_lock_file);
     }
 
+    if (config.print_output & PRINT_OUTPUT_CSV) P_outbuf_set_file(&csv_ob, stdout);
+
     if (config.print_markers) {
-      if ((config.print_output & PRINT_OUTPUT_CSV) || (config.print_output & PRINT_OUTPUT_FORMATTED))
+      if (config.print_output & PRINT_OUTPUT_CSV)
+        P_outbuf_marker(&csv_ob, "START", writer_pid);
+      else if (config.print_output & PRINT_OUTPUT_FORMATTED)
         fprintf(stdout, "--START (%u)--\n", writer_pid);
       else if (config.print_output & PRINT_OUTPUT_JSON) {
         void *json_obj;
@@ -475,7 +530,7 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
       if (config.print_output & PRINT_OUTPUT_FORMATTED)
         P_write_stats_header_formatted(stdout, is_event);
       else if (config.print_output & PRINT_OUTPUT_CSV)
-        P_write_stats_header_csv(stdout, is_event);
+        P_write_stats_header_csv(&csv_ob, is_event);
     }
   }
 
@@ -869,363 +924,30 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
         else fprintf(f, "\n");
       }
       else if (f && config.print_output & PRINT_OUTPUT_CSV) {
-        if (config.what_to_count & COUNT_TAG) fprintf(f, "%s%llu", write_sep(sep, &count), data->tag);
-        if (config.what_to_count & COUNT_TAG2) fprintf(f, "%s%llu", write_sep(sep, &count), data->tag2);
-	if (config.what_to_count_2 & COUNT_LABEL) P_fprintf_csv_string(f, pvlen, COUNT_INT_LABEL, write_sep(sep, &count), empty_string);
-        if (config.what_to_count & COUNT_CLASS) fprintf(f, "%s%s", write_sep(sep, &count), ((data->class && class[(data->class)-1].id) ? class[(data->class)-1].protocol : "unknown" ));
-  #if defined (WITH_NDPI)
-        if (config.what_to_count_2 & COUNT_NDPI_CLASS) {
-	  snprintf(ndpi_class, SUPERSHORTBUFLEN, "%s/%s",
-		ndpi_get_proto_name(pm_ndpi_wfl->ndpi_struct, data->ndpi_class.master_protocol),
-		ndpi_get_proto_name(pm_ndpi_wfl->ndpi_struct, data->ndpi_class.app_protocol));
-	  fprintf(f, "%s%s", write_sep(sep, &count), ndpi_class);
-	}
-  #endif
-  #if defined (HAVE_L2)
-        if (config.what_to_count & (COUNT_SRC_MAC|COUNT_SUM_MAC)) {
-          etheraddr_string(data->eth_shost, src_mac);
-          fprintf(f, "%s%s", write_sep(sep, &count), src_mac);
-        }
-        if (config.what_to_count & COUNT_DST_MAC) {
-          etheraddr_string(data->eth_dhost, dst_mac);
-          fprintf(f, "%s%s", write_sep(sep, &count), dst_mac);
-        }
-        if (config.what_to_count & COUNT_VLAN) fprintf(f, "%s%u", write_sep(sep, &count), data->vlan_id); 
-        if (config.what_to_count & COUNT_COS) fprintf(f, "%s%u", write_sep(sep, &count), data->cos); 
-        if (config.what_to_count & COUNT_ETHERTYPE) fprintf(f, "%s%x", write_sep(sep, &count), data->etype); 
-  #endif
-        if (config.what_to_count & (COUNT_SRC_AS|COUNT_SUM_AS)) fprintf(f, "%s%u", write_sep(sep, &count), data->src_as); 
-        if (config.what_to_count & COUNT_DST_AS) fprintf(f, "%s%u", write_sep(sep, &count), data->dst_as); 
-  
-        if (config.what_to_count & COUNT_STD_COMM) {
-          char *str_ptr = NULL;
-
-          vlen_prims_get(pvlen, COUNT_INT_STD_COMM, &str_ptr);
-          if (str_ptr) {
-            bgp_comm = str_ptr;
-            while (bgp_comm) {
-              bgp_comm = strchr(str_ptr, ' ');
-              if (bgp_comm) *bgp_comm = '_';
-            }
-
-          }
-
-          P_fprintf_csv_string(f, pvlen, COUNT_INT_STD_COMM, write_sep(sep, &count), empty_string);
-        }
-
-        if (config.what_to_count & COUNT_EXT_COMM) {
-          char *str_ptr = NULL;
-
-          vlen_prims_get(pvlen, COUNT_INT_EXT_COMM, &str_ptr);
-          if (str_ptr) {
-            bgp_comm = str_ptr;
-            while (bgp_comm) {
-              bgp_comm = strchr(str_ptr, ' ');
-              if (bgp_comm) *bgp_comm = '_';
-            }
-          }
-
-          P_fprintf_csv_string(f, pvlen, COUNT_INT_EXT_COMM, write_sep(sep, &count), empty_string);
-        }
-
-        if (config.what_to_count_2 & COUNT_LRG_COMM) {
-          char *str_ptr = NULL;
-
-          vlen_prims_get(pvlen, COUNT_INT_LRG_COMM, &str_ptr);
-          if (str_ptr) {
-            bgp_comm = str_ptr;
-            while (bgp_comm) {
-              bgp_comm = strchr(str_ptr, ' ');
-              if (bgp_comm) *bgp_comm = '_';
-            }
-          }
-
-          P_fprintf_csv_string(f, pvlen, COUNT_INT_LRG_COMM, write_sep(sep, &count), empty_string);
-        }
-
-        if (config.what_to_count & COUNT_SRC_STD_COMM) {
-          char *str_ptr = NULL;
-
-          vlen_prims_get(pvlen, COUNT_INT_SRC_STD_COMM, &str_ptr);
-          if (str_ptr) {
-            bgp_comm = str_ptr;
-            while (bgp_comm) {
-              bgp_comm = strchr(str_ptr, ' ');
-              if (bgp_comm) *bgp_comm = '_';
-            }
-
-          }
-
-          P_fprintf_csv_string(f, pvlen, COUNT_INT_SRC_STD_COMM, write_sep(sep, &count), empty_string);
-        }
-
-        if (config.what_to_count & COUNT_SRC_EXT_COMM) {
-          char *str_ptr = NULL;
-
-          vlen_prims_get(pvlen, COUNT_INT_SRC_EXT_COMM, &str_ptr);
-          if (str_ptr) {
-            bgp_comm = str_ptr;
-            while (bgp_comm) {
-              bgp_comm = strchr(str_ptr, ' ');
-              if (bgp_comm) *bgp_comm = '_';
-            }
-          }
-
-          P_fprintf_csv_string(f, pvlen, COUNT_INT_SRC_EXT_COMM, write_sep(sep, &count), empty_string);
-        }
-
-        if (config.what_to_count_2 & COUNT_SRC_LRG_COMM) {
-          char *str_ptr = NULL;
-
-          vlen_prims_get(pvlen, COUNT_INT_SRC_LRG_COMM, &str_ptr);
-          if (str_ptr) {
-            bgp_comm = str_ptr;
-            while (bgp_comm) {
-              bgp_comm = strchr(str_ptr, ' ');
-              if (bgp_comm) *bgp_comm = '_';
-            }
-          }
-
-          P_fprintf_csv_string(f, pvlen, COUNT_INT_SRC_LRG_COMM, write_sep(sep, &count), empty_string);
-        }
-  
-	if (config.what_to_count & COUNT_AS_PATH) {
-	  char *str_ptr = NULL;
-
-	  vlen_prims_get(pvlen, COUNT_INT_AS_PATH, &str_ptr);
-	  if (str_ptr) {
-	    as_path = str_ptr;
-            while (as_path) {
-              as_path = strchr(str_ptr, ' ');
-              if (as_path) *as_path = '_';
-	    }
-
-	  }
-
-	  P_fprintf_csv_string(f, pvlen, COUNT_INT_AS_PATH, write_sep(sep, &count), empty_string);
-	}
-
-        if (config.what_to_count & COUNT_SRC_AS_PATH) {
-          char *str_ptr = NULL;
-
-          vlen_prims_get(pvlen, COUNT_INT_SRC_AS_PATH, &str_ptr);
-          if (str_ptr) {
-            as_path = str_ptr;
-            while (as_path) {
-              as_path = strchr(str_ptr, ' ');
-              if (as_path) *as_path = '_';
-            }
-
-          }
-
-          P_fprintf_csv_string(f, pvlen, COUNT_INT_SRC_AS_PATH, write_sep(sep, &count), empty_string);
-        }
-
-        if (config.what_to_count & COUNT_LOCAL_PREF) fprintf(f, "%s%u", write_sep(sep, &count), pbgp->local_pref);
-        if (config.what_to_count & COUNT_SRC_LOCAL_PREF) fprintf(f, "%s%u", write_sep(sep, &count), pbgp->src_local_pref);
-        if (config.what_to_count & COUNT_MED) fprintf(f, "%s%u", write_sep(sep, &count), pbgp->med);
-        if (config.what_to_count & COUNT_SRC_MED) fprintf(f, "%s%u", write_sep(sep, &count), pbgp->src_med);
-
-        if (config.what_to_count & COUNT_PEER_SRC_AS) fprintf(f, "%s%u", write_sep(sep, &count), pbgp->peer_src_as);
-        if (config.what_to_count & COUNT_PEER_DST_AS) fprintf(f, "%s%u", write_sep(sep, &count), pbgp->peer_dst_as);
-  
-        if (config.what_to_count & COUNT_PEER_SRC_IP) {
-          addr_to_str(ip_address, &pbgp->peer_src_ip);
-          fprintf(f, "%s%s", write_sep(sep, &count), ip_address);
-        }
-        if (config.what_to_count & COUNT_PEER_DST_IP) {
-          addr_to_str(ip_address, &pbgp->peer_dst_ip);
-          fprintf(f, "%s%s", write_sep(sep, &count), ip_address);
-        }
-  
-        if (config.what_to_count & COUNT_IN_IFACE) fprintf(f, "%s%u", write_sep(sep, &count), data->ifindex_in);
-        if (config.what_to_count & COUNT_OUT_IFACE) fprintf(f, "%s%u", write_sep(sep, &count), data->ifindex_out);
-  
-        if (config.what_to_count & COUNT_MPLS_VPN_RD) {
-          bgp_rd2str(rd_str, &pbgp->mpls_vpn_rd);
-          fprintf(f, "%s%s", write_sep(sep, &count), rd_str);
-        }
-  
-        if (config.what_to_count & (COUNT_SRC_HOST|COUNT_SUM_HOST)) {
-          addr_to_str(src_host, &data->src_ip);
-          fprintf(f, "%s%s", write_sep(sep, &count), src_host);
-        }
-        if (config.what_to_count & (COUNT_SRC_NET|COUNT_SUM_NET)) {
-          addr_to_str(src_host, &data->src_net);
-          fprintf(f, "%s%s", write_sep(sep, &count), src_host);
-        }
-
-        if (config.what_to_count & COUNT_DST_HOST) {
-          addr_to_str(dst_host, &data->dst_ip);
-          fprintf(f, "%s%s", write_sep(sep, &count), dst_host);
-        }
-        if (config.what_to_count & COUNT_DST_NET) {
-          addr_to_str(dst_host, &data->dst_net);
-          fprintf(f, "%s%s", write_sep(sep, &count), dst_host);
-        }
-  
-        if (config.what_to_count & COUNT_SRC_NMASK) fprintf(f, "%s%u", write_sep(sep, &count), data->src_nmask);
-        if (config.what_to_count & COUNT_DST_NMASK) fprintf(f, "%s%u", write_sep(sep, &count), data->dst_nmask);
-        if (config.what_to_count & (COUNT_SRC_PORT|COUNT_SUM_PORT)) fprintf(f, "%s%u", write_sep(sep, &count), data->src_port);
-        if (config.what_to_count & COUNT_DST_PORT) fprintf(f, "%s%u", write_sep(sep, &count), data->dst_port);
-        if (config.what_to_count & COUNT_TCPFLAGS) fprintf(f, "%s%u", write_sep(sep, &count), queue[j]->tcp_flags);
-  
-        if (config.what_to_count & COUNT_IP_PROTO) {
-          if (!config.num_protos && (data->proto < protocols_number))
-	    fprintf(f, "%s%s", write_sep(sep, &count), _protocols[data->proto].name);
-          else
-	    fprintf(f, "%s%d", write_sep(sep, &count), data->proto);
-        }
-  
-        if (config.what_to_count & COUNT_IP_TOS) fprintf(f, "%s%u", write_sep(sep, &count), data->tos);
-  
-  #if defined WITH_GEOIP
-        if (config.what_to_count_2 & COUNT_SRC_HOST_COUNTRY) fprintf(f, "%s%s", write_sep(sep, &count), GeoIP_code_by_id(data->src_ip_country.id));
-        if (config.what_to_count_2 & COUNT_DST_HOST_COUNTRY) fprintf(f, "%s%s", write_sep(sep, &count), GeoIP_code_by_id(data->dst_ip_country.id));
-  #endif
-  #if defined WITH_GEOIPV2
-        if (config.what_to_count_2 & COUNT_SRC_HOST_COUNTRY) fprintf(f, "%s%s", write_sep(sep, &count), data->src_ip_country.str);
-        if (config.what_to_count_2 & COUNT_DST_HOST_COUNTRY) fprintf(f, "%s%s", write_sep(sep, &count), data->dst_ip_country.str);
-        if (config.what_to_count_2 & COUNT_SRC_HOST_POCODE) fprintf(f, "%s%s", write_sep(sep, &count), data->src_ip_pocode.str);
-        if (config.what_to_count_2 & COUNT_DST_HOST_POCODE) fprintf(f, "%s%s", write_sep(sep, &count), data->dst_ip_pocode.str);
-  #endif
-  
-        if (config.what_to_count_2 & COUNT_SAMPLING_RATE) fprintf(f, "%s%u", write_sep(sep, &count), data->sampling_rate);
-  
-        if (config.what_to_count_2 & COUNT_POST_NAT_SRC_HOST) {
-          addr_to_str(src_host, &pnat->post_nat_src_ip);
-          fprintf(f, "%s%s", write_sep(sep, &count), src_host);
-        }
-        if (config.what_to_count_2 & COUNT_POST_NAT_DST_HOST) {
-          addr_to_str(dst_host, &pnat->post_nat_dst_ip);
-          fprintf(f, "%s%s", write_sep(sep, &count), dst_host);
-        }
-        if (config.what_to_count_2 & COUNT_POST_NAT_SRC_PORT) fprintf(f, "%s%u", write_sep(sep, &count), pnat->post_nat_src_port);
-        if (config.what_to_count_2 & COUNT_POST_NAT_DST_PORT) fprintf(f, "%s%u", write_sep(sep, &count), pnat->post_nat_dst_port);
-        if (config.what_to_count_2 & COUNT_NAT_EVENT) fprintf(f, "%s%u", write_sep(sep, &count), pnat->nat_event);
-  
-        if (config.what_to_count_2 & COUNT_MPLS_LABEL_TOP) fprintf(f, "%s%u", write_sep(sep, &count), pmpls->mpls_label_top);
-        if (config.what_to_count_2 & COUNT_MPLS_LABEL_BOTTOM) fprintf(f, "%s%u", write_sep(sep, &count), pmpls->mpls_label_bottom);
-        if (config.what_to_count_2 & COUNT_MPLS_STACK_DEPTH) fprintf(f, "%s%u", write_sep(sep, &count), pmpls->mpls_stack_depth);
-
-	if (config.what_to_count_2 & COUNT_TUNNEL_SRC_HOST) {
-	  addr_to_str(src_host, &ptun->tunnel_src_ip);
-	  fprintf(f, "%s%s", write_sep(sep, &count), src_host);
-	}
-	if (config.what_to_count_2 & COUNT_TUNNEL_DST_HOST) {
-	  addr_to_str(dst_host, &ptun->tunnel_dst_ip);
-	  fprintf(f, "%s%s", write_sep(sep, &count), dst_host);
-	}
-
-	if (config.what_to_count_2 & COUNT_TUNNEL_IP_PROTO) {
-	  if (!config.num_protos && (ptun->tunnel_proto < protocols_number))
-	    fprintf(f, "%s%s", write_sep(sep, &count), _protocols[ptun->tunnel_proto].name);
-	  else
-	    fprintf(f, "%s%d", write_sep(sep, &count), ptun->tunnel_proto);
-	}
-
-	if (config.what_to_count_2 & COUNT_TUNNEL_IP_TOS) fprintf(f, "%s%u", write_sep(sep, &count), ptun->tunnel_tos);
-  
-        if (config.what_to_count_2 & COUNT_TIMESTAMP_START) {
-	  char tstamp_str[VERYSHORTBUFLEN];
-
-	  compose_timestamp(tstamp_str, VERYSHORTBUFLEN, &pnat->timestamp_start, TRUE,
-			    config.timestamps_since_epoch, config.timestamps_rfc3339,
-			    config.timestamps_utc);
-
-          fprintf(f, "%s%s", write_sep(sep, &count), tstamp_str);
-        }
-  
-        if (config.what_to_count_2 & COUNT_TIMESTAMP_END) {
-	  char tstamp_str[VERYSHORTBUFLEN];
-
-	  compose_timestamp(tstamp_str, VERYSHORTBUFLEN, &pnat->timestamp_end, TRUE,
-			    config.timestamps_since_epoch, config.timestamps_rfc3339,
-			    config.timestamps_utc);
-
-          fprintf(f, "%s%s", write_sep(sep, &count), tstamp_str);
-        }
-
-        if (config.what_to_count_2 & COUNT_TIMESTAMP_ARRIVAL) {
-	  char tstamp_str[VERYSHORTBUFLEN];
-
-	  compose_timestamp(tstamp_str, VERYSHORTBUFLEN, &pnat->timestamp_arrival, TRUE,
-			    config.timestamps_since_epoch, config.timestamps_rfc3339,
-			    config.timestamps_utc);
-
-          fprintf(f, "%s%s", write_sep(sep, &count), tstamp_str);
-        }
-
-        if (config.nfacctd_stitching && queue[j]->stitch) {
-	  char tstamp_str[VERYSHORTBUFLEN];
-
-	  compose_timestamp(tstamp_str, VERYSHORTBUFLEN, &queue[j]->stitch->timestamp_min, TRUE,
-			    config.timestamps_since_epoch, config.timestamps_rfc3339,
-			    config.timestamps_utc);
-
-          fprintf(f, "%s%s", write_sep(sep, &count), tstamp_str);
-
-	  compose_timestamp(tstamp_str, VERYSHORTBUFLEN, &queue[j]->stitch->timestamp_max, TRUE,
-			    config.timestamps_since_epoch, config.timestamps_rfc3339,
-			    config.timestamps_utc);
-
-          fprintf(f, "%s%s", write_sep(sep, &count), tstamp_str);
-        }
-
-        if (config.what_to_count_2 & COUNT_EXPORT_PROTO_SEQNO) fprintf(f, "%s%u", write_sep(sep, &count), data->export_proto_seqno);
-        if (config.what_to_count_2 & COUNT_EXPORT_PROTO_VERSION) fprintf(f, "%s%u", write_sep(sep, &count), data->export_proto_version);
-  
-        /* all custom primitives printed here */
-        {
-          int cp_idx;
-  
-          for (cp_idx = 0; cp_idx < config.cpptrs.num; cp_idx++) {
-            if (config.cpptrs.primitive[cp_idx].ptr->len != PM_VARIABLE_LENGTH) {
-              char cp_str[SRVBUFLEN];
-
-	      custom_primitive_value_print(cp_str, SRVBUFLEN, pcust, &config.cpptrs.primitive[cp_idx], FALSE);
-              fprintf(f, "%s%s", write_sep(sep, &count), cp_str);
-	    }
-	    else {
-	      char *label_ptr = NULL;
+	int idx;
 
-	      vlen_prims_get(pvlen, config.cpptrs.primitive[cp_idx].ptr->type, &label_ptr);
-	      if (!label_ptr) label_ptr = empty_string;
-	      fprintf(f, "%s%s", write_sep(sep, &count), label_ptr);
-	    }
-          }
-        }
-  
-        if (!is_event) {
-  #if defined HAVE_64BIT_COUNTERS
-          fprintf(f, "%s%llu", write_sep(sep, &count), queue[j]->packet_counter);
-          if (config.what_to_count & COUNT_FLOWS) fprintf(f, "%s%llu", write_sep(sep, &count), queue[j]->flow_counter);
-          fprintf(f, "%s%llu\n", write_sep(sep, &count), queue[j]->bytes_counter);
-  #else
-          fprintf(f, "%s%lu", write_sep(sep, &count), queue[j]->packet_counter);
-          if (config.what_to_count & COUNT_FLOWS) fprintf(f, "%s%lu", write_sep(sep, &count), queue[j]->flow_counter);
-          fprintf(f, "%s%lu\n", write_sep(sep, &count), queue[j]->bytes_counter);
-  #endif
-        }
-        else fprintf(f, "\n");
+	csv_ob.fields = 0;
+	for (idx = 0; idx < N_PRIMITIVES && P_csv_handlers[idx]; idx++) P_csv_handlers[idx](&csv_ob, queue[j]);
+	P_outbuf_append(&csv_ob, "\n", 1);
       }
       else if (f && config.print_output & PRINT_OUTPUT_JSON) {
 #ifdef WITH_JANSSON
-	json_t *json_obj = json_object();
 	int idx;
 
-	for (idx = 0; idx < N_PRIMITIVES && cjhandler[idx]; idx++) cjhandler[idx](json_obj, queue[j]);
-        if (json_obj) write_and_free_json(f, json_obj);
+	pm_json_buf_begin(&json_enc);
+	for (idx = 0; idx < N_PRIMITIVES && cjhandler[idx]; idx++) cjhandler[idx](&json_enc, queue[j]);
+	pm_json_buf_end(&json_enc);
+	pm_json_buf_append(&json_enc, "\n", 1);
+
+	fwrite(json_enc.base, json_enc.len, 1, f);
 #endif
       }
       else if (f && config.print_output & PRINT_OUTPUT_AVRO) {
 #ifdef WITH_AVRO
-        avro_value_iface_t *avro_iface = avro_generic_class_from_schema(avro_acct_schema);
-
-        avro_value_t avro_value = compose_avro(config.what_to_count, config.what_to_count_2, queue[j]->flow_type,
-                         &queue[j]->primitives, pbgp, pnat, pmpls, ptun, pcust, pvlen, queue[j]->bytes_counter,
-                         queue[j]->packet_counter, queue[j]->flow_counter, queue[j]->tcp_flags, NULL,
-                         queue[j]->stitch, avro_iface);
+        compose_avro(config.what_to_count, config.what_to_count_2, queue[j]->flow_type,
+                     &queue[j]->primitives, pbgp, pnat, pmpls, ptun, pcust, pvlen, queue[j]->bytes_counter,
+                     queue[j]->packet_counter, queue[j]->flow_counter, queue[j]->tcp_flags, NULL,
+                     queue[j]->stitch, &avro_value);
 
         if (config.sql_table) {
           if (avro_file_writer_append_value(avro_writer, &avro_value)) {
@@ -1246,11 +968,15 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
           fprintf(f, "%s\n", json_str);
           free(json_str);
         }
-
-        avro_value_iface_decref(avro_iface);
-        avro_value_decref(&avro_value);
 #else
         if (config.debug) Log(LOG_DEBUG, "DEBUG ( %s/%s ): compose_avro(): AVRO object not created due to missing --enable-avro\n", config.name, config.type);
+#endif
+      }
+      else if (config.print_output & PRINT_OUTPUT_PARQUET) {
+#ifdef WITH_PARQUET
+        pm_parquet_table_append(&parquet_table, config.what_to_count, queue[j]->flow_type, &queue[j]->primitives,
+				pbgp, queue[j]->bytes_counter, queue[j]->packet_counter, queue[j]->flow_counter,
+				queue[j]->tcp_flags, &queue[j]->basetime);
 #endif
       }
     }
@@ -1259,7 +985,9 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
   duration = time(NULL)-start;
 
   if (f && config.print_markers) {
-    if ((config.print_output & PRINT_OUTPUT_CSV) || (config.print_output & PRINT_OUTPUT_FORMATTED))
+    if (config.print_output & PRINT_OUTPUT_CSV)
+      P_outbuf_marker(&csv_ob, "END", writer_pid);
+    else if (config.print_output & PRINT_OUTPUT_FORMATTED)
       fprintf(f, "--END (%u)--\n", writer_pid);
     else if (config.print_output & PRINT_OUTPUT_JSON) {
       void *json_obj;
@@ -1268,12 +996,18 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
       if (json_obj) write_and_free_json(f, json_obj);
     }
   }
+
+  if (config.print_output & PRINT_OUTPUT_CSV) P_outbuf_close_file(&csv_ob);
     
   if (config.sql_table) {
 #ifdef WITH_AVRO
     if (config.print_output & PRINT_OUTPUT_AVRO)
       avro_file_writer_flush(avro_writer);
 #endif
+#ifdef WITH_PARQUET
+    if (config.print_output & PRINT_OUTPUT_PARQUET)
+      pm_parquet_table_write(&parquet_table, current_table);
+#endif
 
     if (config.print_latest_file) {
       if (!safe_action) {
@@ -1282,11 +1016,11 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
       }
     }
 
-#ifdef WITH_AVRO
     if (config.print_output & PRINT_OUTPUT_AVRO) {
+#ifdef WITH_AVRO
       avro_file_writer_close(avro_writer);
-    }
 #endif
+    }
     else {
       if (f) close_output_file(f);
     }
@@ -1306,6 +1040,15 @@ void P_cache_purge(struct chained_cache *queue[], int index, int safe_action)
   if (config.sql_trigger_exec && !safe_action) P_trigger_exec(config.sql_trigger_exec); 
 
   if (empty_pcust) free(empty_pcust);
+  if (json_enc.base) free(json_enc.base);
+  P_outbuf_free(&csv_ob);
+
+#ifdef WITH_AVRO
+  if (avro_iface) {
+    avro_value_decref(&avro_value);
+    avro_value_iface_decref(avro_iface);
+  }
+#endif
 }
 
 void P_write_stats_header_formatted(FILE *f, int is_event)
@@ -1425,112 +1168,818 @@ void P_write_stats_header_formatted(FILE *f, int is_event)
   else fprintf(f, "\n");
 }
 
-void P_write_stats_header_csv(FILE *f, int is_event)
+void P_write_stats_header_csv(struct P_outbuf *ob, int is_event)
 {
-  char *sep = config.print_output_separator;
-  int count = 0;
+  ob->fields = 0;
 
-  if (config.what_to_count & COUNT_TAG) fprintf(f, "%sTAG", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_TAG2) fprintf(f, "%sTAG2", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_LABEL) fprintf(f, "%sLABEL", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_CLASS) fprintf(f, "%sCLASS", write_sep(sep, &count));
+  if (config.what_to_count & COUNT_TAG) P_csv_field_str(ob, "TAG");
+  if (config.what_to_count & COUNT_TAG2) P_csv_field_str(ob, "TAG2");
+  if (config.what_to_count_2 & COUNT_LABEL) P_csv_field_str(ob, "LABEL");
+  if (config.what_to_count & COUNT_CLASS) P_csv_field_str(ob, "CLASS");
 #if defined (WITH_NDPI)
-  if (config.what_to_count_2 & COUNT_NDPI_CLASS) fprintf(f, "%sCLASS", write_sep(sep, &count));
+  if (config.what_to_count_2 & COUNT_NDPI_CLASS) P_csv_field_str(ob, "CLASS");
 #endif
 #if defined HAVE_L2
-  if (config.what_to_count & (COUNT_SRC_MAC|COUNT_SUM_MAC)) fprintf(f, "%sSRC_MAC", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_DST_MAC) fprintf(f, "%sDST_MAC", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_VLAN) fprintf(f, "%sVLAN", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_COS) fprintf(f, "%sCOS", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_ETHERTYPE) fprintf(f, "%sETYPE", write_sep(sep, &count));
+  if (config.what_to_count & (COUNT_SRC_MAC|COUNT_SUM_MAC)) P_csv_field_str(ob, "SRC_MAC");
+  if (config.what_to_count & COUNT_DST_MAC) P_csv_field_str(ob, "DST_MAC");
+  if (config.what_to_count & COUNT_VLAN) P_csv_field_str(ob, "VLAN");
+  if (config.what_to_count & COUNT_COS) P_csv_field_str(ob, "COS");
+  if (config.what_to_count & COUNT_ETHERTYPE) P_csv_field_str(ob, "ETYPE");
 #endif
-  if (config.what_to_count & (COUNT_SRC_AS|COUNT_SUM_AS)) fprintf(f, "%sSRC_AS", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_DST_AS) fprintf(f, "%sDST_AS", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_STD_COMM) fprintf(f, "%sCOMMS", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_EXT_COMM) fprintf(f, "%sECOMMS", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_LRG_COMM) fprintf(f, "%sLCOMMS", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_SRC_STD_COMM) fprintf(f, "%sSRC_COMMS", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_SRC_EXT_COMM) fprintf(f, "%sSRC_ECOMMS", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_SRC_LRG_COMM) fprintf(f, "%sSRC_LCOMMS", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_AS_PATH) fprintf(f, "%sAS_PATH", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_SRC_AS_PATH) fprintf(f, "%sSRC_AS_PATH", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_LOCAL_PREF) fprintf(f, "%sPREF", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_SRC_LOCAL_PREF) fprintf(f, "%sSRC_PREF", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_MED) fprintf(f, "%sMED", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_SRC_MED) fprintf(f, "%sSRC_MED", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_PEER_SRC_AS) fprintf(f, "%sPEER_SRC_AS", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_PEER_DST_AS) fprintf(f, "%sPEER_DST_AS", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_PEER_SRC_IP) fprintf(f, "%sPEER_SRC_IP", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_PEER_DST_IP) fprintf(f, "%sPEER_DST_IP", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_IN_IFACE) fprintf(f, "%sIN_IFACE", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_OUT_IFACE) fprintf(f, "%sOUT_IFACE", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_MPLS_VPN_RD) fprintf(f, "%sMPLS_VPN_RD", write_sep(sep, &count));
-  if (config.what_to_count & (COUNT_SRC_HOST|COUNT_SUM_HOST)) fprintf(f, "%sSRC_IP", write_sep(sep, &count));
-  if (config.what_to_count & (COUNT_SRC_NET|COUNT_SUM_NET)) fprintf(f, "%sSRC_NET", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_DST_HOST) fprintf(f, "%sDST_IP", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_DST_NET) fprintf(f, "%sDST_NET", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_SRC_NMASK) fprintf(f, "%sSRC_MASK", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_DST_NMASK) fprintf(f, "%sDST_MASK", write_sep(sep, &count));
-  if (config.what_to_count & (COUNT_SRC_PORT|COUNT_SUM_PORT)) fprintf(f, "%sSRC_PORT", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_DST_PORT) fprintf(f, "%sDST_PORT", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_TCPFLAGS) fprintf(f, "%sTCP_FLAGS", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_IP_PROTO) fprintf(f, "%sPROTOCOL", write_sep(sep, &count));
-  if (config.what_to_count & COUNT_IP_TOS) fprintf(f, "%sTOS", write_sep(sep, &count));
+  if (config.what_to_count & (COUNT_SRC_AS|COUNT_SUM_AS)) P_csv_field_str(ob, "SRC_AS");
+  if (config.what_to_count & COUNT_DST_AS) P_csv_field_str(ob, "DST_AS");
+  if (config.what_to_count & COUNT_STD_COMM) P_csv_field_str(ob, "COMMS");
+  if (config.what_to_count & COUNT_EXT_COMM) P_csv_field_str(ob, "ECOMMS");
+  if (config.what_to_count_2 & COUNT_LRG_COMM) P_csv_field_str(ob, "LCOMMS");
+  if (config.what_to_count & COUNT_SRC_STD_COMM) P_csv_field_str(ob, "SRC_COMMS");
+  if (config.what_to_count & COUNT_SRC_EXT_COMM) P_csv_field_str(ob, "SRC_ECOMMS");
+  if (config.what_to_count_2 & COUNT_SRC_LRG_COMM) P_csv_field_str(ob, "SRC_LCOMMS");
+  if (config.what_to_count & COUNT_AS_PATH) P_csv_field_str(ob, "AS_PATH");
+  if (config.what_to_count & COUNT_SRC_AS_PATH) P_csv_field_str(ob, "SRC_AS_PATH");
+  if (config.what_to_count & COUNT_LOCAL_PREF) P_csv_field_str(ob, "PREF");
+  if (config.what_to_count & COUNT_SRC_LOCAL_PREF) P_csv_field_str(ob, "SRC_PREF");
+  if (config.what_to_count & COUNT_MED) P_csv_field_str(ob, "MED");
+  if (config.what_to_count & COUNT_SRC_MED) P_csv_field_str(ob, "SRC_MED");
+  if (config.what_to_count & COUNT_PEER_SRC_AS) P_csv_field_str(ob, "PEER_SRC_AS");
+  if (config.what_to_count & COUNT_PEER_DST_AS) P_csv_field_str(ob, "PEER_DST_AS");
+  if (config.what_to_count & COUNT_PEER_SRC_IP) P_csv_field_str(ob, "PEER_SRC_IP");
+  if (config.what_to_count & COUNT_PEER_DST_IP) P_csv_field_str(ob, "PEER_DST_IP");
+  if (config.what_to_count & COUNT_IN_IFACE) P_csv_field_str(ob, "IN_IFACE");
+  if (config.what_to_count & COUNT_OUT_IFACE) P_csv_field_str(ob, "OUT_IFACE");
+  if (config.what_to_count & COUNT_MPLS_VPN_RD) P_csv_field_str(ob, "MPLS_VPN_RD");
+  if (config.what_to_count & (COUNT_SRC_HOST|COUNT_SUM_HOST)) P_csv_field_str(ob, "SRC_IP");
+  if (config.what_to_count & (COUNT_SRC_NET|COUNT_SUM_NET)) P_csv_field_str(ob, "SRC_NET");
+  if (config.what_to_count & COUNT_DST_HOST) P_csv_field_str(ob, "DST_IP");
+  if (config.what_to_count & COUNT_DST_NET) P_csv_field_str(ob, "DST_NET");
+  if (config.what_to_count & COUNT_SRC_NMASK) P_csv_field_str(ob, "SRC_MASK");
+  if (config.what_to_count & COUNT_DST_NMASK) P_csv_field_str(ob, "DST_MASK");
+  if (config.what_to_count & (COUNT_SRC_PORT|COUNT_SUM_PORT)) P_csv_field_str(ob, "SRC_PORT");
+  if (config.what_to_count & COUNT_DST_PORT) P_csv_field_str(ob, "DST_PORT");
+  if (config.what_to_count & COUNT_TCPFLAGS) P_csv_field_str(ob, "TCP_FLAGS");
+  if (config.what_to_count & COUNT_IP_PROTO) P_csv_field_str(ob, "PROTOCOL");
+  if (config.what_to_count & COUNT_IP_TOS) P_csv_field_str(ob, "TOS");
 #if defined (WITH_GEOIP) || defined (WITH_GEOIPV2)
-  if (config.what_to_count_2 & COUNT_SRC_HOST_COUNTRY) fprintf(f, "%sSH_COUNTRY", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_DST_HOST_COUNTRY) fprintf(f, "%sDH_COUNTRY", write_sep(sep, &count));
+  if (config.what_to_count_2 & COUNT_SRC_HOST_COUNTRY) P_csv_field_str(ob, "SH_COUNTRY");
+  if (config.what_to_count_2 & COUNT_DST_HOST_COUNTRY) P_csv_field_str(ob, "DH_COUNTRY");
 #endif
 #if defined (WITH_GEOIPV2)
-  if (config.what_to_count_2 & COUNT_SRC_HOST_POCODE) fprintf(f, "%sSH_POCODE", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_DST_HOST_POCODE) fprintf(f, "%sDH_POCODE", write_sep(sep, &count));
+  if (config.what_to_count_2 & COUNT_SRC_HOST_POCODE) P_csv_field_str(ob, "SH_POCODE");
+  if (config.what_to_count_2 & COUNT_DST_HOST_POCODE) P_csv_field_str(ob, "DH_POCODE");
 #endif
-  if (config.what_to_count_2 & COUNT_SAMPLING_RATE) fprintf(f, "%sSAMPLING_RATE", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_POST_NAT_SRC_HOST) fprintf(f, "%sPOST_NAT_SRC_IP", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_POST_NAT_DST_HOST) fprintf(f, "%sPOST_NAT_DST_IP", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_POST_NAT_SRC_PORT) fprintf(f, "%sPOST_NAT_SRC_PORT", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_POST_NAT_DST_PORT) fprintf(f, "%sPOST_NAT_DST_PORT", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_NAT_EVENT) fprintf(f, "%sNAT_EVENT", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_MPLS_LABEL_TOP) fprintf(f, "%sMPLS_LABEL_TOP", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_MPLS_LABEL_BOTTOM) fprintf(f, "%sMPLS_LABEL_BOTTOM", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_MPLS_STACK_DEPTH) fprintf(f, "%sMPLS_STACK_DEPTH", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_TUNNEL_SRC_HOST) fprintf(f, "%sTUNNEL_SRC_IP", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_TUNNEL_DST_HOST) fprintf(f, "%sTUNNEL_DST_IP", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_TUNNEL_IP_PROTO) fprintf(f, "%sTUNNEL_PROTOCOL", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_TUNNEL_IP_TOS) fprintf(f, "%sTUNNEL_TOS", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_TIMESTAMP_START) fprintf(f, "%sTIMESTAMP_START", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_TIMESTAMP_END) fprintf(f, "%sTIMESTAMP_END", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_TIMESTAMP_ARRIVAL) fprintf(f, "%sTIMESTAMP_ARRIVAL", write_sep(sep, &count));
+  if (config.what_to_count_2 & COUNT_SAMPLING_RATE) P_csv_field_str(ob, "SAMPLING_RATE");
+  if (config.what_to_count_2 & COUNT_POST_NAT_SRC_HOST) P_csv_field_str(ob, "POST_NAT_SRC_IP");
+  if (config.what_to_count_2 & COUNT_POST_NAT_DST_HOST) P_csv_field_str(ob, "POST_NAT_DST_IP");
+  if (config.what_to_count_2 & COUNT_POST_NAT_SRC_PORT) P_csv_field_str(ob, "POST_NAT_SRC_PORT");
+  if (config.what_to_count_2 & COUNT_POST_NAT_DST_PORT) P_csv_field_str(ob, "POST_NAT_DST_PORT");
+  if (config.what_to_count_2 & COUNT_NAT_EVENT) P_csv_field_str(ob, "NAT_EVENT");
+  if (config.what_to_count_2 & COUNT_MPLS_LABEL_TOP) P_csv_field_str(ob, "MPLS_LABEL_TOP");
+  if (config.what_to_count_2 & COUNT_MPLS_LABEL_BOTTOM) P_csv_field_str(ob, "MPLS_LABEL_BOTTOM");
+  if (config.what_to_count_2 & COUNT_MPLS_STACK_DEPTH) P_csv_field_str(ob, "MPLS_STACK_DEPTH");
+  if (config.what_to_count_2 & COUNT_TUNNEL_SRC_HOST) P_csv_field_str(ob, "TUNNEL_SRC_IP");
+  if (config.what_to_count_2 & COUNT_TUNNEL_DST_HOST) P_csv_field_str(ob, "TUNNEL_DST_IP");
+  if (config.what_to_count_2 & COUNT_TUNNEL_IP_PROTO) P_csv_field_str(ob, "TUNNEL_PROTOCOL");
+  if (config.what_to_count_2 & COUNT_TUNNEL_IP_TOS) P_csv_field_str(ob, "TUNNEL_TOS");
+  if (config.what_to_count_2 & COUNT_TIMESTAMP_START) P_csv_field_str(ob, "TIMESTAMP_START");
+  if (config.what_to_count_2 & COUNT_TIMESTAMP_END) P_csv_field_str(ob, "TIMESTAMP_END");
+  if (config.what_to_count_2 & COUNT_TIMESTAMP_ARRIVAL) P_csv_field_str(ob, "TIMESTAMP_ARRIVAL");
   if (config.nfacctd_stitching) {
-    fprintf(f, "%sTIMESTAMP_MIN", write_sep(sep, &count));
-    fprintf(f, "%sTIMESTAMP_MAX", write_sep(sep, &count));
+    P_csv_field_str(ob, "TIMESTAMP_MIN");
+    P_csv_field_str(ob, "TIMESTAMP_MAX");
   }
-  if (config.what_to_count_2 & COUNT_EXPORT_PROTO_SEQNO) fprintf(f, "%sEXPORT_PROTO_SEQNO", write_sep(sep, &count));
-  if (config.what_to_count_2 & COUNT_EXPORT_PROTO_VERSION) fprintf(f, "%sEXPORT_PROTO_VERSION", write_sep(sep, &count));
+  if (config.what_to_count_2 & COUNT_EXPORT_PROTO_SEQNO) P_csv_field_str(ob, "EXPORT_PROTO_SEQNO");
+  if (config.what_to_count_2 & COUNT_EXPORT_PROTO_VERSION) P_csv_field_str(ob, "EXPORT_PROTO_VERSION");
 
   /* all custom primitives printed here */
-  { 
+  {
     char cp_str[SRVBUFLEN];
     int cp_idx;
 
     for (cp_idx = 0; cp_idx < config.cpptrs.num; cp_idx++) {
       custom_primitive_header_print(cp_str, SRVBUFLEN, &config.cpptrs.primitive[cp_idx], FALSE);
-      fprintf(f, "%s%s", write_sep(sep, &count), cp_str);
+      P_csv_field_str(ob, cp_str);
     }
   }
 
   if (!is_event) {
-    fprintf(f, "%sPACKETS", write_sep(sep, &count));
-    if (config.what_to_count & COUNT_FLOWS) fprintf(f, "%sFLOWS", write_sep(sep, &count));
-    fprintf(f, "%sBYTES\n", write_sep(sep, &count));
+    P_csv_field_str(ob, "PACKETS");
+    if (config.what_to_count & COUNT_FLOWS) P_csv_field_str(ob, "FLOWS");
+    P_csv_field_str(ob, "BYTES");
   }
-  else fprintf(f, "\n");
+
+  P_outbuf_append(ob, "\n", 1);
+}
+
+
+/*
+   Output buffer for the CSV writer: rows are formatted straight into a
+   large buffer which is handed over to the (optionally gzip-compressed)
+   output file in big chunks, bypassing fprintf() per field.
+*/
+void P_outbuf_init(struct P_outbuf *ob, size_t size)
+{
+  memset(ob, 0, sizeof(struct P_outbuf));
+
+  ob->base = pm_malloc(size);
+  ob->size = size;
+  ob->sep = config.print_output_separator;
+  ob->sep_len = strlen(ob->sep);
+}
+
+void P_outbuf_set_file(struct P_outbuf *ob, FILE *f)
+{
+  ob->f = f;
+
+#if defined (HAVE_ZLIB)
+  if (f && f != stdout && config.print_output_compression == PRINT_COMPRESSION_GZIP) {
+    int fd = dup(fileno(f));
+
+    if (fd == -1 || !(ob->gz = gzdopen(fd, "ab"))) {
+      Log(LOG_ERR, "ERROR ( %s/%s ): P_outbuf_set_file(): unable to open gzip stream. Exiting.\n", config.name, config.type);
+      exit_plugin(1);
+    }
+  }
+#endif
+}
+
+void P_outbuf_flush(struct P_outbuf *ob)
+{
+  if (!ob->len) return;
+
+#if defined (HAVE_ZLIB)
+  if (ob->gz) {
+    if (gzwrite(ob->gz, ob->base, ob->len) <= 0)
+      Log(LOG_WARNING, "WARN ( %s/%s ): P_outbuf_flush(): gzwrite() failed.\n", config.name, config.type);
+  }
+  else
+#endif
+  if (ob->f) {
+    if (fwrite(ob->base, ob->len, 1, ob->f) != 1)
+      Log(LOG_WARNING, "WARN ( %s/%s ): P_outbuf_flush(): fwrite() failed (%s).\n", config.name, config.type, strerror(errno));
+  }
+
+  ob->len = 0;
+}
+
+/* flushes pending output; the FILE itself is left to the caller */
+void P_outbuf_close_file(struct P_outbuf *ob)
+{
+  P_outbuf_flush(ob);
+
+#if defined (HAVE_ZLIB)
+  if (ob->gz) {
+    gzclose(ob->gz);
+    ob->gz = NULL;
+  }
+#endif
+
+  ob->f = NULL;
 }
 
-void P_fprintf_csv_string(FILE *f, struct pkt_vlen_hdr_primitives *pvlen, pm_cfgreg_t wtc, char *sep, char *empty_string)
+void P_outbuf_free(struct P_outbuf *ob)
 {
-  char *string_ptr = NULL;
+  if (ob->base) free(ob->base);
+  memset(ob, 0, sizeof(struct P_outbuf));
+}
 
-  vlen_prims_get(pvlen, wtc, &string_ptr);
-  if (!string_ptr) string_ptr = empty_string;
-  fprintf(f, "%s%s", sep, string_ptr);
+void P_outbuf_marker(struct P_outbuf *ob, char *marker, pid_t writer_pid)
+{
+  P_outbuf_append(ob, "--", 2);
+  P_outbuf_str(ob, marker);
+  P_outbuf_append(ob, " (", 2);
+  P_outbuf_uint(ob, writer_pid);
+  P_outbuf_append(ob, ")--\n", 4);
+}
+
+static char *P_outbuf_reserve(struct P_outbuf *ob, size_t len)
+{
+  if (ob->len + len > ob->size) P_outbuf_flush(ob);
+
+  return ob->base + ob->len;
+}
+
+void P_outbuf_append(struct P_outbuf *ob, const char *str, size_t len)
+{
+  if (len > ob->size) {
+    struct P_outbuf direct;
+
+    /* larger than the whole buffer: flush and hand it over as it is */
+    P_outbuf_flush(ob);
+    memcpy(&direct, ob, sizeof(struct P_outbuf));
+    direct.base = (char *) str;
+    direct.len = len;
+    P_outbuf_flush(&direct);
+    return;
+  }
+
+  memcpy(P_outbuf_reserve(ob, len), str, len);
+  ob->len += len;
+}
+
+void P_outbuf_str(struct P_outbuf *ob, const char *str)
+{
+  P_outbuf_append(ob, str, strlen(str));
+}
+
+void P_outbuf_uint(struct P_outbuf *ob, u_int64_t value)
+{
+  char digits[20], *ptr;
+  int len = 0;
+
+  do {
+    digits[len++] = '0' + (value % 10);
+    value /= 10;
+  } while (value);
+
+  ptr = P_outbuf_reserve(ob, len);
+  ob->len += len;
+  while (len) *ptr++ = digits[--len];
+}
+
+void P_outbuf_addr(struct P_outbuf *ob, struct host_addr *a)
+{
+  char *ptr;
+
+  if (a->family == AF_INET) {
+    u_char *octet = (u_char *) &a->address.ipv4.s_addr;
+    int idx;
+
+    for (idx = 0; idx < 4; idx++) {
+      if (idx) P_outbuf_append(ob, ".", 1);
+      P_outbuf_uint(ob, octet[idx]);
+    }
+  }
+  else {
+    ptr = P_outbuf_reserve(ob, INET6_ADDRSTRLEN);
+    addr_to_str(ptr, a);
+    ob->len += strlen(ptr);
+  }
+}
+
+static void P_csv_sep(struct P_outbuf *ob)
+{
+  if (ob->fields) P_outbuf_append(ob, ob->sep, ob->sep_len);
+  ob->fields++;
+}
+
+void P_csv_field_str(struct P_outbuf *ob, const char *str)
+{
+  P_csv_sep(ob);
+  P_outbuf_str(ob, str);
+}
+
+void P_csv_field_uint(struct P_outbuf *ob, u_int64_t value)
+{
+  P_csv_sep(ob);
+  P_outbuf_uint(ob, value);
+}
+
+void P_csv_field_addr(struct P_outbuf *ob, struct host_addr *a)
+{
+  P_csv_sep(ob);
+  P_outbuf_addr(ob, a);
+}
+
+/* as_path and communities get their spaces replaced by underscores */
+void P_csv_field_vlen(struct P_outbuf *ob, struct pkt_vlen_hdr_primitives *pvlen, pm_cfgreg_t wtc, int underscore)
+{
+  char *str_ptr = NULL, *ptr;
+  size_t len;
+
+  P_csv_sep(ob);
+
+  vlen_prims_get(pvlen, wtc, &str_ptr);
+  if (!str_ptr) return;
+
+  len = strlen(str_ptr);
+  if (!underscore || len > ob->size) {
+    P_outbuf_append(ob, str_ptr, len);
+    return;
+  }
+
+  ptr = P_outbuf_reserve(ob, len);
+  ob->len += len;
+  for (; *str_ptr; str_ptr++, ptr++) *ptr = (*str_ptr == ' ') ? '_' : *str_ptr;
+}
+
+static struct pkt_bgp_primitives P_csv_empty_pbgp;
+static struct pkt_nat_primitives P_csv_empty_pnat;
+static struct pkt_mpls_primitives P_csv_empty_pmpls;
+static struct pkt_tunnel_primitives P_csv_empty_ptun;
+static char *P_csv_empty_pcust;
+
+#define P_CSV_PBGP(cc)	((cc)->pbgp ? (cc)->pbgp : &P_csv_empty_pbgp)
+#define P_CSV_PNAT(cc)	((cc)->pnat ? (cc)->pnat : &P_csv_empty_pnat)
+#define P_CSV_PMPLS(cc)	((cc)->pmpls ? (cc)->pmpls : &P_csv_empty_pmpls)
+#define P_CSV_PTUN(cc)	((cc)->ptun ? (cc)->ptun : &P_csv_empty_ptun)
+
+static void P_csv_tag(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.tag);
+}
+
+static void P_csv_tag2(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.tag2);
+}
+
+static void P_csv_label(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_vlen(ob, cc->pvlen, COUNT_INT_LABEL, FALSE);
+}
+
+static void P_csv_class(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  pm_class_t class_id = cc->primitives.class;
+
+  P_csv_field_str(ob, ((class_id && class[class_id-1].id) ? class[class_id-1].protocol : "unknown"));
+}
+
+#if defined (WITH_NDPI)
+static void P_csv_ndpi_class(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  char ndpi_class[SUPERSHORTBUFLEN];
+
+  snprintf(ndpi_class, SUPERSHORTBUFLEN, "%s/%s",
+	ndpi_get_proto_name(pm_ndpi_wfl->ndpi_struct, cc->primitives.ndpi_class.master_protocol),
+	ndpi_get_proto_name(pm_ndpi_wfl->ndpi_struct, cc->primitives.ndpi_class.app_protocol));
+  P_csv_field_str(ob, ndpi_class);
+}
+#endif
+
+#if defined (HAVE_L2)
+static void P_csv_src_mac(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  char mac[18];
+
+  etheraddr_string(cc->primitives.eth_shost, mac);
+  P_csv_field_str(ob, mac);
+}
+
+static void P_csv_dst_mac(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  char mac[18];
+
+  etheraddr_string(cc->primitives.eth_dhost, mac);
+  P_csv_field_str(ob, mac);
+}
+
+static void P_csv_vlan(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.vlan_id);
+}
+
+static void P_csv_cos(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.cos);
+}
+
+static void P_csv_etype(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  char etype[VERYSHORTBUFLEN];
+
+  snprintf(etype, VERYSHORTBUFLEN, "%x", cc->primitives.etype);
+  P_csv_field_str(ob, etype);
+}
+#endif
+
+static void P_csv_src_as(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.src_as);
+}
+
+static void P_csv_dst_as(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.dst_as);
+}
+
+static void P_csv_std_comm(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_vlen(ob, cc->pvlen, COUNT_INT_STD_COMM, TRUE);
+}
+
+static void P_csv_ext_comm(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_vlen(ob, cc->pvlen, COUNT_INT_EXT_COMM, TRUE);
+}
+
+static void P_csv_lrg_comm(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_vlen(ob, cc->pvlen, COUNT_INT_LRG_COMM, TRUE);
+}
+
+static void P_csv_src_std_comm(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_vlen(ob, cc->pvlen, COUNT_INT_SRC_STD_COMM, TRUE);
+}
+
+static void P_csv_src_ext_comm(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_vlen(ob, cc->pvlen, COUNT_INT_SRC_EXT_COMM, TRUE);
+}
+
+static void P_csv_src_lrg_comm(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_vlen(ob, cc->pvlen, COUNT_INT_SRC_LRG_COMM, TRUE);
+}
+
+static void P_csv_as_path(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_vlen(ob, cc->pvlen, COUNT_INT_AS_PATH, TRUE);
+}
+
+static void P_csv_src_as_path(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_vlen(ob, cc->pvlen, COUNT_INT_SRC_AS_PATH, TRUE);
+}
+
+static void P_csv_local_pref(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PBGP(cc)->local_pref);
+}
+
+static void P_csv_src_local_pref(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PBGP(cc)->src_local_pref);
+}
+
+static void P_csv_med(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PBGP(cc)->med);
+}
+
+static void P_csv_src_med(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PBGP(cc)->src_med);
+}
+
+static void P_csv_peer_src_as(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PBGP(cc)->peer_src_as);
+}
+
+static void P_csv_peer_dst_as(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PBGP(cc)->peer_dst_as);
+}
+
+static void P_csv_peer_src_ip(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_addr(ob, &P_CSV_PBGP(cc)->peer_src_ip);
+}
+
+static void P_csv_peer_dst_ip(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_addr(ob, &P_CSV_PBGP(cc)->peer_dst_ip);
+}
+
+static void P_csv_in_iface(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.ifindex_in);
+}
+
+static void P_csv_out_iface(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.ifindex_out);
+}
+
+static void P_csv_mpls_vpn_rd(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  char rd_str[SRVBUFLEN];
+
+  bgp_rd2str(rd_str, &P_CSV_PBGP(cc)->mpls_vpn_rd);
+  P_csv_field_str(ob, rd_str);
+}
+
+static void P_csv_src_host(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_addr(ob, &cc->primitives.src_ip);
+}
+
+static void P_csv_src_net(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_addr(ob, &cc->primitives.src_net);
+}
+
+static void P_csv_dst_host(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_addr(ob, &cc->primitives.dst_ip);
+}
+
+static void P_csv_dst_net(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_addr(ob, &cc->primitives.dst_net);
+}
+
+static void P_csv_src_nmask(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.src_nmask);
+}
+
+static void P_csv_dst_nmask(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.dst_nmask);
+}
+
+static void P_csv_src_port(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.src_port);
+}
+
+static void P_csv_dst_port(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.dst_port);
+}
+
+static void P_csv_tcp_flags(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->tcp_flags);
+}
+
+static void P_csv_proto_name(struct P_outbuf *ob, u_int8_t proto)
+{
+  if (!config.num_protos && (proto < protocols_number))
+    P_csv_field_str(ob, _protocols[proto].name);
+  else
+    P_csv_field_uint(ob, proto);
+}
+
+static void P_csv_proto(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_proto_name(ob, cc->primitives.proto);
+}
+
+static void P_csv_tos(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.tos);
+}
+
+#if defined (WITH_GEOIP)
+static void P_csv_src_host_country(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  const char *code = GeoIP_code_by_id(cc->primitives.src_ip_country.id);
+
+  P_csv_field_str(ob, code ? code : "");
+}
+
+static void P_csv_dst_host_country(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  const char *code = GeoIP_code_by_id(cc->primitives.dst_ip_country.id);
+
+  P_csv_field_str(ob, code ? code : "");
+}
+#endif
+
+#if defined (WITH_GEOIPV2)
+static void P_csv_src_host_country(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_str(ob, cc->primitives.src_ip_country.str);
+}
+
+static void P_csv_dst_host_country(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_str(ob, cc->primitives.dst_ip_country.str);
+}
+
+static void P_csv_src_host_pocode(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_str(ob, cc->primitives.src_ip_pocode.str);
+}
+
+static void P_csv_dst_host_pocode(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_str(ob, cc->primitives.dst_ip_pocode.str);
+}
+#endif
+
+static void P_csv_sampling_rate(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.sampling_rate);
+}
+
+static void P_csv_post_nat_src_host(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_addr(ob, &P_CSV_PNAT(cc)->post_nat_src_ip);
+}
+
+static void P_csv_post_nat_dst_host(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_addr(ob, &P_CSV_PNAT(cc)->post_nat_dst_ip);
+}
+
+static void P_csv_post_nat_src_port(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PNAT(cc)->post_nat_src_port);
+}
+
+static void P_csv_post_nat_dst_port(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PNAT(cc)->post_nat_dst_port);
+}
+
+static void P_csv_nat_event(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PNAT(cc)->nat_event);
+}
+
+static void P_csv_mpls_label_top(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PMPLS(cc)->mpls_label_top);
+}
+
+static void P_csv_mpls_label_bottom(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PMPLS(cc)->mpls_label_bottom);
+}
+
+static void P_csv_mpls_stack_depth(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PMPLS(cc)->mpls_stack_depth);
+}
+
+static void P_csv_tunnel_src_host(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_addr(ob, &P_CSV_PTUN(cc)->tunnel_src_ip);
+}
+
+static void P_csv_tunnel_dst_host(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_addr(ob, &P_CSV_PTUN(cc)->tunnel_dst_ip);
+}
+
+static void P_csv_tunnel_proto(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_proto_name(ob, P_CSV_PTUN(cc)->tunnel_proto);
+}
+
+static void P_csv_tunnel_tos(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, P_CSV_PTUN(cc)->tunnel_tos);
+}
+
+static void P_csv_timestamp(struct P_outbuf *ob, struct timeval *tv)
+{
+  char tstamp_str[VERYSHORTBUFLEN];
+
+  compose_timestamp(tstamp_str, VERYSHORTBUFLEN, tv, TRUE,
+		    config.timestamps_since_epoch, config.timestamps_rfc3339,
+		    config.timestamps_utc);
+  P_csv_field_str(ob, tstamp_str);
+}
+
+static void P_csv_timestamp_start(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_timestamp(ob, &P_CSV_PNAT(cc)->timestamp_start);
+}
+
+static void P_csv_timestamp_end(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_timestamp(ob, &P_CSV_PNAT(cc)->timestamp_end);
+}
+
+static void P_csv_timestamp_arrival(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_timestamp(ob, &P_CSV_PNAT(cc)->timestamp_arrival);
+}
+
+static void P_csv_stitching(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  if (cc->stitch) {
+    P_csv_timestamp(ob, &cc->stitch->timestamp_min);
+    P_csv_timestamp(ob, &cc->stitch->timestamp_max);
+  }
+}
+
+static void P_csv_export_proto_seqno(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.export_proto_seqno);
+}
+
+static void P_csv_export_proto_version(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->primitives.export_proto_version);
+}
+
+static void P_csv_custom_primitives(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  char *pcust = cc->pcust ? cc->pcust : P_csv_empty_pcust;
+  int cp_idx;
+
+  for (cp_idx = 0; cp_idx < config.cpptrs.num; cp_idx++) {
+    if (config.cpptrs.primitive[cp_idx].ptr->len != PM_VARIABLE_LENGTH) {
+      char cp_str[SRVBUFLEN];
+
+      custom_primitive_value_print(cp_str, SRVBUFLEN, pcust, &config.cpptrs.primitive[cp_idx], FALSE);
+      P_csv_field_str(ob, cp_str);
+    }
+    else P_csv_field_vlen(ob, cc->pvlen, config.cpptrs.primitive[cp_idx].ptr->type, FALSE);
+  }
+}
+
+static void P_csv_packets(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->packet_counter);
+}
+
+static void P_csv_flows(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->flow_counter);
+}
+
+static void P_csv_bytes(struct P_outbuf *ob, struct chained_cache *cc)
+{
+  P_csv_field_uint(ob, cc->bytes_counter);
+}
+
+/* sets up, once, the ordered list of field writers for CSV rows */
+void P_csv_compose_handlers(u_int64_t wtc, u_int64_t wtc_2, int is_event)
+{
+  int idx = 0;
+
+  memset(&P_csv_handlers, 0, sizeof(P_csv_handlers));
+
+  if (config.cpptrs.len) {
+    P_csv_empty_pcust = pm_malloc(config.cpptrs.len);
+    memset(P_csv_empty_pcust, 0, config.cpptrs.len);
+  }
+
+  if (wtc & COUNT_TAG) P_csv_handlers[idx++] = P_csv_tag;
+  if (wtc & COUNT_TAG2) P_csv_handlers[idx++] = P_csv_tag2;
+  if (wtc_2 & COUNT_LABEL) P_csv_handlers[idx++] = P_csv_label;
+  if (wtc & COUNT_CLASS) P_csv_handlers[idx++] = P_csv_class;
+#if defined (WITH_NDPI)
+  if (wtc_2 & COUNT_NDPI_CLASS) P_csv_handlers[idx++] = P_csv_ndpi_class;
+#endif
+#if defined (HAVE_L2)
+  if (wtc & (COUNT_SRC_MAC|COUNT_SUM_MAC)) P_csv_handlers[idx++] = P_csv_src_mac;
+  if (wtc & COUNT_DST_MAC) P_csv_handlers[idx++] = P_csv_dst_mac;
+  if (wtc & COUNT_VLAN) P_csv_handlers[idx++] = P_csv_vlan;
+  if (wtc & COUNT_COS) P_csv_handlers[idx++] = P_csv_cos;
+  if (wtc & COUNT_ETHERTYPE) P_csv_handlers[idx++] = P_csv_etype;
+#endif
+  if (wtc & (COUNT_SRC_AS|COUNT_SUM_AS)) P_csv_handlers[idx++] = P_csv_src_as;
+  if (wtc & COUNT_DST_AS) P_csv_handlers[idx++] = P_csv_dst_as;
+  if (wtc & COUNT_STD_COMM) P_csv_handlers[idx++] = P_csv_std_comm;
+  if (wtc & COUNT_EXT_COMM) P_csv_handlers[idx++] = P_csv_ext_comm;
+  if (wtc_2 & COUNT_LRG_COMM) P_csv_handlers[idx++] = P_csv_lrg_comm;
+  if (wtc & COUNT_SRC_STD_COMM) P_csv_handlers[idx++] = P_csv_src_std_comm;
+  if (wtc & COUNT_SRC_EXT_COMM) P_csv_handlers[idx++] = P_csv_src_ext_comm;
+  if (wtc_2 & COUNT_SRC_LRG_COMM) P_csv_handlers[idx++] = P_csv_src_lrg_comm;
+  if (wtc & COUNT_AS_PATH) P_csv_handlers[idx++] = P_csv_as_path;
+  if (wtc & COUNT_SRC_AS_PATH) P_csv_handlers[idx++] = P_csv_src_as_path;
+  if (wtc & COUNT_LOCAL_PREF) P_csv_handlers[idx++] = P_csv_local_pref;
+  if (wtc & COUNT_SRC_LOCAL_PREF) P_csv_handlers[idx++] = P_csv_src_local_pref;
+  if (wtc & COUNT_MED) P_csv_handlers[idx++] = P_csv_med;
+  if (wtc & COUNT_SRC_MED) P_csv_handlers[idx++] = P_csv_src_med;
+  if (wtc & COUNT_PEER_SRC_AS) P_csv_handlers[idx++] = P_csv_peer_src_as;
+  if (wtc & COUNT_PEER_DST_AS) P_csv_handlers[idx++] = P_csv_peer_dst_as;
+  if (wtc & COUNT_PEER_SRC_IP) P_csv_handlers[idx++] = P_csv_peer_src_ip;
+  if (wtc & COUNT_PEER_DST_IP) P_csv_handlers[idx++] = P_csv_peer_dst_ip;
+  if (wtc & COUNT_IN_IFACE) P_csv_handlers[idx++] = P_csv_in_iface;
+  if (wtc & COUNT_OUT_IFACE) P_csv_handlers[idx++] = P_csv_out_iface;
+  if (wtc & COUNT_MPLS_VPN_RD) P_csv_handlers[idx++] = P_csv_mpls_vpn_rd;
+  if (wtc & (COUNT_SRC_HOST|COUNT_SUM_HOST)) P_csv_handlers[idx++] = P_csv_src_host;
+  if (wtc & (COUNT_SRC_NET|COUNT_SUM_NET)) P_csv_handlers[idx++] = P_csv_src_net;
+  if (wtc & COUNT_DST_HOST) P_csv_handlers[idx++] = P_csv_dst_host;
+  if (wtc & COUNT_DST_NET) P_csv_handlers[idx++] = P_csv_dst_net;
+  if (wtc & COUNT_SRC_NMASK) P_csv_handlers[idx++] = P_csv_src_nmask;
+  if (wtc & COUNT_DST_NMASK) P_csv_handlers[idx++] = P_csv_dst_nmask;
+  if (wtc & (COUNT_SRC_PORT|COUNT_SUM_PORT)) P_csv_handlers[idx++] = P_csv_src_port;
+  if (wtc & COUNT_DST_PORT) P_csv_handlers[idx++] = P_csv_dst_port;
+  if (wtc & COUNT_TCPFLAGS) P_csv_handlers[idx++] = P_csv_tcp_flags;
+  if (wtc & COUNT_IP_PROTO) P_csv_handlers[idx++] = P_csv_proto;
+  if (wtc & COUNT_IP_TOS) P_csv_handlers[idx++] = P_csv_tos;
+#if defined (WITH_GEOIP) || defined (WITH_GEOIPV2)
+  if (wtc_2 & COUNT_SRC_HOST_COUNTRY) P_csv_handlers[idx++] = P_csv_src_host_country;
+  if (wtc_2 & COUNT_DST_HOST_COUNTRY) P_csv_handlers[idx++] = P_csv_dst_host_country;
+#endif
+#if defined (WITH_GEOIPV2)
+  if (wtc_2 & COUNT_SRC_HOST_POCODE) P_csv_handlers[idx++] = P_csv_src_host_pocode;
+  if (wtc_2 & COUNT_DST_HOST_POCODE) P_csv_handlers[idx++] = P_csv_dst_host_pocode;
+#endif
+  if (wtc_2 & COUNT_SAMPLING_RATE) P_csv_handlers[idx++] = P_csv_sampling_rate;
+  if (wtc_2 & COUNT_POST_NAT_SRC_HOST) P_csv_handlers[idx++] = P_csv_post_nat_src_host;
+  if (wtc_2 & COUNT_POST_NAT_DST_HOST) P_csv_handlers[idx++] = P_csv_post_nat_dst_host;
+  if (wtc_2 & COUNT_POST_NAT_SRC_PORT) P_csv_handlers[idx++] = P_csv_post_nat_src_port;
+  if (wtc_2 & COUNT_POST_NAT_DST_PORT) P_csv_handlers[idx++] = P_csv_post_nat_dst_port;
+  if (wtc_2 & COUNT_NAT_EVENT) P_csv_handlers[idx++] = P_csv_nat_event;
+  if (wtc_2 & COUNT_MPLS_LABEL_TOP) P_csv_handlers[idx++] = P_csv_mpls_label_top;
+  if (wtc_2 & COUNT_MPLS_LABEL_BOTTOM) P_csv_handlers[idx++] = P_csv_mpls_label_bottom;
+  if (wtc_2 & COUNT_MPLS_STACK_DEPTH) P_csv_handlers[idx++] = P_csv_mpls_stack_depth;
+  if (wtc_2 & COUNT_TUNNEL_SRC_HOST) P_csv_handlers[idx++] = P_csv_tunnel_src_host;
+  if (wtc_2 & COUNT_TUNNEL_DST_HOST) P_csv_handlers[idx++] = P_csv_tunnel_dst_host;
+  if (wtc_2 & COUNT_TUNNEL_IP_PROTO) P_csv_handlers[idx++] = P_csv_tunnel_proto;
+  if (wtc_2 & COUNT_TUNNEL_IP_TOS) P_csv_handlers[idx++] = P_csv_tunnel_tos;
+  if (wtc_2 & COUNT_TIMESTAMP_START) P_csv_handlers[idx++] = P_csv_timestamp_start;
+  if (wtc_2 & COUNT_TIMESTAMP_END) P_csv_handlers[idx++] = P_csv_timestamp_end;
+  if (wtc_2 & COUNT_TIMESTAMP_ARRIVAL) P_csv_handlers[idx++] = P_csv_timestamp_arrival;
+  if (config.nfacctd_stitching) P_csv_handlers[idx++] = P_csv_stitching;
+  if (wtc_2 & COUNT_EXPORT_PROTO_SEQNO) P_csv_handlers[idx++] = P_csv_export_proto_seqno;
+  if (wtc_2 & COUNT_EXPORT_PROTO_VERSION) P_csv_handlers[idx++] = P_csv_export_proto_version;
+  if (config.cpptrs.num) P_csv_handlers[idx++] = P_csv_custom_primitives;
+
+  if (!is_event) {
+    P_csv_handlers[idx++] = P_csv_packets;
+    if (wtc & COUNT_FLOWS) P_csv_handlers[idx++] = P_csv_flows;
+    P_csv_handlers[idx++] = P_csv_bytes;
+  }
 }
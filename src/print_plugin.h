@@ -22,6 +22,22 @@
 /* includes */
 #include <sys/poll.h>
 
+/* structures */
+struct P_outbuf {
+  char *base;
+  size_t len;
+  size_t size;
+  char *sep;
+  int sep_len;
+  int fields;
+  FILE *f;
+#if defined (HAVE_ZLIB)
+  gzFile gz;
+#endif
+};
+
+typedef void (*P_csv_handler)(struct P_outbuf *, struct chained_cache *);
+
 /* prototypes */
 #if (!defined __PRINT_PLUGIN_C)
 #define EXT extern
@@ -31,8 +47,24 @@
 EXT void print_plugin(int, struct configuration *, void *);
 EXT void P_cache_purge(struct chained_cache *[], int, int);
 EXT void P_write_stats_header_formatted(FILE *, int);
-EXT void P_write_stats_header_csv(FILE *, int);
-EXT void P_fprintf_csv_string(FILE *, struct pkt_vlen_hdr_primitives *, pm_cfgreg_t, char *, char *);
+EXT void P_write_stats_header_csv(struct P_outbuf *, int);
+
+EXT void P_outbuf_init(struct P_outbuf *, size_t);
+EXT void P_outbuf_set_file(struct P_outbuf *, FILE *);
+EXT void P_outbuf_flush(struct P_outbuf *);
+EXT void P_outbuf_close_file(struct P_outbuf *);
+EXT void P_outbuf_free(struct P_outbuf *);
+EXT void P_outbuf_append(struct P_outbuf *, const char *, size_t);
+EXT void P_outbuf_str(struct P_outbuf *, const char *);
+EXT void P_outbuf_uint(struct P_outbuf *, u_int64_t);
+EXT void P_outbuf_addr(struct P_outbuf *, struct host_addr *);
+EXT void P_outbuf_marker(struct P_outbuf *, char *, pid_t);
+
+EXT void P_csv_field_str(struct P_outbuf *, const char *);
+EXT void P_csv_field_uint(struct P_outbuf *, u_int64_t);
+EXT void P_csv_field_addr(struct P_outbuf *, struct host_addr *);
+EXT void P_csv_field_vlen(struct P_outbuf *, struct pkt_vlen_hdr_primitives *, pm_cfgreg_t, int);
+EXT void P_csv_compose_handlers(u_int64_t, u_int64_t, int);
 #undef EXT
 
 /* global variables */
@@ -42,4 +74,8 @@ EXT void P_fprintf_csv_string(FILE *, struct pkt_vlen_hdr_primitives *, pm_cfgre
 #define EXT
 #endif
 EXT int print_output_stdout_header;
+EXT P_csv_handler P_csv_handlers[N_PRIMITIVES];
+#ifdef WITH_PARQUET
+EXT struct pm_parquet_table parquet_table;
+#endif
 #undef EXT
@@ -968,6 +968,7 @@ int main(int argc,char **argv, char **envp)
       sf_cnt_misc_db = &inter_domain_misc_dbs[FUNC_TYPE_SFLOW_COUNTER];
       config.sfacctd_counter_max_nodes = MAX_SF_CNT_LOG_ENTRIES;
       memset(sf_cnt_misc_db, 0, sizeof(struct bgp_misc_structs));
+      bgp_misc_locks_init(sf_cnt_misc_db);
       sf_cnt_link_misc_structs(sf_cnt_misc_db);
 
       sf_cnt_misc_db->peers_log = malloc(MAX_SF_CNT_LOG_ENTRIES*sizeof(struct bgp_peer_log));
@@ -1010,6 +1011,9 @@ int main(int argc,char **argv, char **envp)
 
   /* Main loop */
   for (;;) {
+    /* done with BGP/BMP lookup results of the previous packet */
+    if (config.nfacctd_bgp || config.nfacctd_bmp) bgp_rib_read_exit();
+
     if (!config.pcap_savefile) {
       ret = recvfrom(config.sock, sflow_packet, SFLOW_MAX_MSG_SIZE, 0, (struct sockaddr *) &client, &clen);
     }
@@ -1032,25 +1036,22 @@ int main(int argc,char **argv, char **envp)
     if (!allowed) continue;
 
     if (reload_map) {
-      bta_map_caching = TRUE;
-      sampling_map_caching = TRUE;
-
       if (config.nfacctd_allow_file) load_allow_file(config.nfacctd_allow_file, &allow);
 
       load_networks(config.networks_file, &nt, &nc);
 
       if (config.nfacctd_bgp && config.nfacctd_bgp_peer_as_src_map)
-        load_id_file(MAP_BGP_PEER_AS_SRC, config.nfacctd_bgp_peer_as_src_map, &bpas_table, &req, &bpas_map_allocated);
+        load_id_file_bg(MAP_BGP_PEER_AS_SRC, config.nfacctd_bgp_peer_as_src_map, &bpas_table, &req, &bpas_map_allocated);
       if (config.nfacctd_bgp && config.nfacctd_bgp_src_local_pref_map)
-        load_id_file(MAP_BGP_SRC_LOCAL_PREF, config.nfacctd_bgp_src_local_pref_map, &blp_table, &req, &blp_map_allocated);
+        load_id_file_bg(MAP_BGP_SRC_LOCAL_PREF, config.nfacctd_bgp_src_local_pref_map, &blp_table, &req, &blp_map_allocated);
       if (config.nfacctd_bgp && config.nfacctd_bgp_src_med_map)
-        load_id_file(MAP_BGP_SRC_MED, config.nfacctd_bgp_src_med_map, &bmed_table, &req, &bmed_map_allocated);
+        load_id_file_bg(MAP_BGP_SRC_MED, config.nfacctd_bgp_src_med_map, &bmed_table, &req, &bmed_map_allocated);
       if (config.nfacctd_bgp && config.nfacctd_bgp_to_agent_map)
-        load_id_file(MAP_BGP_TO_XFLOW_AGENT, config.nfacctd_bgp_to_agent_map, &bta_table, &req, &bta_map_allocated);
+        load_id_file_bg(MAP_BGP_TO_XFLOW_AGENT, config.nfacctd_bgp_to_agent_map, &bta_table, &req, &bta_map_allocated);
       if (config.nfacctd_flow_to_rd_map)
-        load_id_file(MAP_FLOW_TO_RD, config.nfacctd_flow_to_rd_map, &bitr_table, &req, &bitr_map_allocated);
+        load_id_file_bg(MAP_FLOW_TO_RD, config.nfacctd_flow_to_rd_map, &bitr_table, &req, &bitr_map_allocated);
       if (config.sampling_map) {
-        load_id_file(MAP_SAMPLING, config.sampling_map, &sampling_table, &req, &sampling_map_allocated);
+        load_id_file_bg(MAP_SAMPLING, config.sampling_map, &sampling_table, &req, &sampling_map_allocated);
         set_sampling_table(&pptrs, (u_char *) &sampling_table);
       }
 
@@ -27,6 +27,7 @@
 #include "pmacct-data.h"
 #include "plugin_hooks.h"
 #include "bgp/bgp.h"
+#include "bmp/bmp.h"
 
 /* extern */
 extern struct plugins_list_entry *plugin_list;
@@ -222,6 +223,15 @@ void push_stats()
   else if (config.acct_type == ACCT_NF || config.acct_type == ACCT_SF)
     print_status_table(now, XFLOW_STATUS_TABLE_SZ);
 
+  if (config.bgp_lookup_cache_entries && (config.nfacctd_bgp || config.nfacctd_bmp))
+    bgp_lookup_cache_print_stats(now);
+
+  if (config.nfacctd_bgp || config.nfacctd_bmp || config.acct_type == ACCT_PMBGP || config.acct_type == ACCT_PMBMP)
+    bgp_attr_mem_print_stats(now);
+
+  if (config.nfacctd_bmp || config.acct_type == ACCT_PMBMP)
+    bmp_peers_print_stats(now);
+
   signal(SIGUSR1, push_stats);
 }
 
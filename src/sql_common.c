@@ -402,6 +402,201 @@ int sql_cache_flush_pending(struct db_cache *queue[], int index, struct insert_d
   }
 }
 
+/* Splits the purge queue in sql_writer_connections slices, each purged by its
+   own process over its own DB connection while the calling writer waits for
+   them. Cache entries, hence rows, are unique across slices: the DB is free
+   to work on them concurrently. Per-slice counters are sent back over a pipe
+   and summed up, so that the purge is reported and triggered as a whole */
+void sql_purge_pool(struct db_cache *queue[], int index, struct insert_data *idata)
+{
+  struct sql_pool_stats stats, totals;
+  pid_t *pids, writer_pid = getpid();
+  int *fds, conns = config.sql_writer_connections, idx, start, len, status, pipefd[2];
+  time_t start_time = time(NULL);
+
+  if (conns > index) conns = index;
+
+  pids = malloc(conns * sizeof(pid_t));
+  fds = malloc(conns * sizeof(int));
+  if (!pids || !fds) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): malloc() failed (sql_purge_pool). Exiting ..\n", config.name, config.type);
+    exit_plugin(1);
+  }
+
+  /* dynamic tables are created upfront, not by all slices at once */
+  if (idata->dyn_table && config.sql_table_schema) sql_pool_create_tables(queue, index);
+
+  memset(&totals, 0, sizeof(totals));
+  sql_pool_stats_take(idata, &stats);
+
+  for (idx = 0, start = 0; idx < conns; idx++, start += len) {
+    len = (index / conns) + ((idx < (index % conns)) ? 1 : 0);
+    pids[idx] = 0;
+    fds[idx] = ERR;
+
+    if (pipe(pipefd) == -1) {
+      pipefd[0] = pipefd[1] = ERR;
+      pids[idx] = -1;
+    }
+    else pids[idx] = fork();
+
+    switch (pids[idx]) {
+    case 0: /* Child */
+      close(pipefd[0]);
+      pm_setproctitle("%s %s [%s]", config.type, "Plugin -- DB Writer", config.name);
+      sql_purge_slice(&queue[start], len, idata);
+
+      sql_pool_stats_take(idata, &stats);
+      if (write(pipefd[1], &stats, sizeof(stats)) != sizeof(stats))
+	Log(LOG_WARNING, "WARN ( %s/%s ): Unable to report DB writer connection stats: %s\n", config.name, config.type, strerror(errno));
+
+      exit(0);
+    case -1:
+      Log(LOG_WARNING, "WARN ( %s/%s ): Unable to start DB writer connection: %s\n", config.name, config.type, strerror(errno));
+      /* fallthrough */
+    default:
+      if (pids[idx] > 0) {
+	close(pipefd[1]);
+	fds[idx] = pipefd[0];
+	break;
+      }
+
+      if (pipefd[0] != ERR) {
+	close(pipefd[0]);
+	close(pipefd[1]);
+      }
+
+      /* no process to hand it over: the slice is purged here */
+      sql_purge_slice(&queue[start], len, idata);
+      sql_pool_stats_take(idata, &stats);
+      sql_pool_stats_add(&totals, &stats);
+      break;
+    }
+  }
+
+  for (idx = 0; idx < conns; idx++) {
+    if (pids[idx] > 0) {
+      if (read(fds[idx], &stats, sizeof(stats)) == sizeof(stats)) sql_pool_stats_add(&totals, &stats);
+      close(fds[idx]);
+
+      while (waitpid(pids[idx], &status, 0) == -1 && errno == EINTR);
+    }
+  }
+
+  idata->ten = totals.ten;
+  idata->een = totals.een;
+  idata->qn = totals.qn;
+  idata->iqn = totals.iqn;
+  idata->uqn = totals.uqn;
+  idata->elap_time = time(NULL)-start_time;
+
+  Log(LOG_INFO, "INFO ( %s/%s ): *** Purging cache - POOL END (PID: %u, CONNS: %u, QN: %u/%u, ET: %u) ***\n",
+		config.name, config.type, writer_pid, conns, idata->qn, index, idata->elap_time);
+
+  if (config.sql_trigger_exec) {
+    if (queue[0]) idata->basetime = queue[0]->basetime;
+    SQL_SetENV_child(idata);
+  }
+
+  free(pids);
+  free(fds);
+}
+
+/* moves the purge counters of 'idata' over to 'stats', leaving them zeroed */
+void sql_pool_stats_take(struct insert_data *idata, struct sql_pool_stats *stats)
+{
+  stats->ten = idata->ten;
+  stats->een = idata->een;
+  stats->qn = idata->qn;
+  stats->iqn = idata->iqn;
+  stats->uqn = idata->uqn;
+
+  idata->ten = idata->een = idata->qn = idata->iqn = idata->uqn = 0;
+}
+
+void sql_pool_stats_add(struct sql_pool_stats *totals, struct sql_pool_stats *stats)
+{
+  totals->ten += stats->ten;
+  totals->een += stats->een;
+  totals->qn += stats->qn;
+  totals->iqn += stats->iqn;
+  totals->uqn += stats->uqn;
+}
+
+/* runs the sql_table_schema once per dynamic table in the queue, by a process
+   of its own so that the writer connection state is not touched; slices are
+   then told not to create tables on the primary DB themselves */
+void sql_pool_create_tables(struct db_cache *queue[], int index)
+{
+  struct primitives_ptrs prim_ptrs;
+  struct pkt_data dummy_data;
+  char (*tables)[SRVBUFLEN] = NULL, tmpbuf[LONGLONGSRVBUFLEN];
+  int idx, tables_idx, tables_num = 0, tables_max = 0, status;
+  time_t stamp;
+  pid_t pid;
+
+  switch (pid = fork()) {
+  case 0: /* Child */
+    pm_setproctitle("%s %s [%s]", config.type, "Plugin -- DB Writer", config.name);
+
+    if (!strcmp(config.type, "mysql"))
+      (*sqlfunc_cbr.connect)(&p, config.sql_host);
+    else
+      (*sqlfunc_cbr.connect)(&p, NULL);
+
+    memset(&prim_ptrs, 0, sizeof(prim_ptrs));
+    memset(&dummy_data, 0, sizeof(dummy_data));
+    prim_ptrs.data = &dummy_data;
+
+    for (idx = 0; idx < index && !p.fail; idx++) {
+      if (tables_num == tables_max) {
+	tables_max = (tables_max ? (tables_max * 2) : 8);
+	tables = realloc(tables, tables_max * SRVBUFLEN);
+	if (!tables) break;
+      }
+
+      stamp = queue[idx]->basetime;
+      primptrs_set_all_from_db_cache(&prim_ptrs, queue[idx]);
+
+      strlcpy(tables[tables_num], config.sql_table, SRVBUFLEN);
+      handle_dynname_internal_strings_same(tables[tables_num], SRVBUFLEN, tmpbuf, &prim_ptrs, DYN_STR_SQL_TABLE);
+      pm_strftime_same(tables[tables_num], SRVBUFLEN, tmpbuf, &stamp, config.timestamps_utc);
+
+      for (tables_idx = (tables_num - 1); tables_idx >= 0; tables_idx--) {
+	if (!strcmp(tables[tables_idx], tables[tables_num])) break;
+      }
+
+      if (tables_idx < 0) {
+	sql_create_table(&p, &stamp, &prim_ptrs);
+	tables_num++;
+      }
+    }
+
+    if (p.connected) (*sqlfunc_cbr.close)(&bed);
+
+    exit(0);
+  case -1:
+    Log(LOG_WARNING, "WARN ( %s/%s ): Unable to fork DB writer for tables creation: %s\n", config.name, config.type, strerror(errno));
+    return;
+  default: /* Parent */
+    while (waitpid(pid, &status, 0) == -1 && errno == EINTR);
+    sql_pool_tables_created = TRUE;
+    break;
+  }
+}
+
+void sql_purge_slice(struct db_cache *queue[], int index, struct insert_data *idata)
+{
+  if (!strcmp(config.type, "mysql"))
+    (*sqlfunc_cbr.connect)(&p, config.sql_host);
+  else
+    (*sqlfunc_cbr.connect)(&p, NULL);
+
+  (*sqlfunc_cbr.purge)(queue, index, idata);
+
+  (*sqlfunc_cbr.close)(&bed);
+}
+
 void sql_cache_handle_flush_event(struct insert_data *idata, time_t *refresh_deadline, struct ports_table *pt)
 {
   int ret;
@@ -415,18 +610,24 @@ void sql_cache_handle_flush_event(struct insert_data *idata, time_t *refresh_dea
       signal(SIGHUP, SIG_IGN);
       pm_setproctitle("%s %s [%s]", config.type, "Plugin -- DB Writer", config.name);
 
-      if (qq_ptr) {
+      if (qq_ptr && config.sql_writer_connections > 1) {
         if (dump_writers_get_flags() == CHLD_WARNING) sql_db_fail(&p);
-        if (!strcmp(config.type, "mysql"))
-          (*sqlfunc_cbr.connect)(&p, config.sql_host);
-        else
-          (*sqlfunc_cbr.connect)(&p, NULL);
+        sql_purge_pool(queries_queue, qq_ptr, idata);
       }
+      else {
+        if (qq_ptr) {
+          if (dump_writers_get_flags() == CHLD_WARNING) sql_db_fail(&p);
+          if (!strcmp(config.type, "mysql"))
+            (*sqlfunc_cbr.connect)(&p, config.sql_host);
+          else
+            (*sqlfunc_cbr.connect)(&p, NULL);
+        }
 
-      /* qq_ptr check inside purge function along with a Log() call */
-      (*sqlfunc_cbr.purge)(queries_queue, qq_ptr, idata);
+        /* qq_ptr check inside purge function along with a Log() call */
+        (*sqlfunc_cbr.purge)(queries_queue, qq_ptr, idata);
 
-      if (qq_ptr) (*sqlfunc_cbr.close)(&bed);
+        if (qq_ptr) (*sqlfunc_cbr.close)(&bed);
+      }
 
       if (config.sql_trigger_exec) {
         if (idata->now > idata->triggertime) sql_trigger_exec(config.sql_trigger_exec);
@@ -3195,6 +3396,9 @@ void sql_create_table(struct DBdesc *db, time_t *basetime, struct primitives_ptr
   char buf[LARGEBUFLEN], tmpbuf[LARGEBUFLEN];
   int ret;
 
+  /* already taken care of by sql_pool_create_tables() */
+  if (sql_pool_tables_created && db == &p) return;
+
   ret = read_SQLquery_from_file(config.sql_table_schema, buf, LARGEBUFLEN);
   if (ret) {
     handle_dynname_internal_strings_same(buf, LARGEBUFLEN, tmpbuf, prim_ptrs, DYN_STR_SQL_TABLE);
@@ -3245,6 +3449,125 @@ int sql_compose_static_set_event()
   return set_primitives;
 }
 
+/* Turns each format in frags into a bind format, ie. conversions only, each
+   followed by SQL_BIND_SEP, and appends its SQL counterpart, ie. conversions
+   (and quotes around them) replaced by '?' placeholders, to bf->sql. frags are
+   walked up to num or, if num is negative, up to the first unset entry */
+void sql_bind_compose(struct frags *frags, int num, struct sql_bind_frags *bf)
+{
+  char bind[SRVBUFLEN], *src, *start;
+  int idx, sql_len, bind_len, spec_len;
+  u_int8_t type;
+
+  memset(bf, 0, sizeof(struct sql_bind_frags));
+  sql_len = 0;
+
+  for (idx = 0; (num < 0) ? frags[idx].type : (idx < num); idx++) {
+    /* these handlers copy their fragment verbatim, no values involved */
+    if (frags[idx].handler == count_noop_setclause_handler || frags[idx].handler == count_noop_setclause_event_handler) {
+      strlcpy(bf->sql + sql_len, frags[idx].string, sizeof(bf->sql) - sql_len);
+      sql_len = strlen(bf->sql);
+      frags[idx].string[0] = '\0';
+      continue;
+    }
+
+    bind_len = 0;
+    for (src = frags[idx].string; *src && sql_len < (sizeof(bf->sql) - 1); src++) {
+      if (*src != '%') {
+        bf->sql[sql_len++] = *src;
+        continue;
+      }
+
+      if (*(src + 1) == '%') {
+        bf->sql[sql_len++] = '%';
+        src++;
+        continue;
+      }
+
+      for (start = src++; *src && strchr("0123456789.-+ #hlLqjzt", *src); src++);
+      if (!*src) break;
+
+      spec_len = (src - start) + 1;
+      if ((bind_len + spec_len + 1) >= sizeof(bind) || bf->num >= SQL_BIND_MAX) break;
+      memcpy(bind + bind_len, start, spec_len);
+      bind_len += spec_len;
+      bind[bind_len++] = SQL_BIND_SEP;
+
+      if (*src == 'd' || *src == 'i' || *src == 'u') type = SQL_BIND_INT;
+      else type = SQL_BIND_TEXT;
+
+      /* quoted literal: the quotes go away with it */
+      if (sql_len && bf->sql[sql_len - 1] == '\'' && *(src + 1) == '\'') {
+        sql_len--;
+        src++;
+        type = SQL_BIND_TEXT;
+      }
+
+      bf->sql[sql_len++] = '?';
+      bf->type[bf->num++] = type;
+    }
+
+    bf->sql[sql_len] = '\0';
+    bind[bind_len] = '\0';
+    strlcpy(frags[idx].string, bind, sizeof(frags[idx].string));
+  }
+}
+
+void sql_bind_compose_static(int primitives)
+{
+  sql_bind_compose(values, primitives, &bind_values);
+  sql_bind_compose(where, primitives, &bind_where);
+  sql_bind_compose(set, -1, &bind_set);
+  sql_bind_compose(set_event, -1, &bind_set_event);
+}
+
+/* Composes the text of the prepared statement of the given type; to be
+   called once the table name in insert_clause/update_clause is final */
+void sql_bind_compose_stmt(int type, char *buf, int len)
+{
+  switch (type) {
+  case SQL_STMT_UPDATE:
+    snprintf(buf, len, "%s%s%s", update_clause, bind_set.sql, bind_where.sql);
+    break;
+  case SQL_STMT_UPDATE_EVENT:
+    snprintf(buf, len, "%s%s%s", update_clause, bind_set_event.sql, bind_where.sql);
+    break;
+  case SQL_STMT_INSERT:
+    snprintf(buf, len, "%s%s%s%s", insert_clause, insert_counters_clause, bind_values.sql,
+	     (config.what_to_count & COUNT_FLOWS) ? ", ?, ?, ?)" : ", ?, ?)");
+    break;
+  case SQL_STMT_INSERT_EVENT:
+    snprintf(buf, len, "%s%s%s)", insert_clause, insert_nocounters_clause, bind_values.sql);
+    break;
+  default:
+    buf[0] = '\0';
+    break;
+  }
+}
+
+/* Splits in place the output of the handlers into bind parameters; returns
+   their number or ERR if it does not match the prepared statement */
+int sql_bind_parse(char *buf, struct sql_bind_frags *bf, struct sql_bind_param *params)
+{
+  char *ptr;
+  int num = 0;
+
+  while ((ptr = strchr(buf, SQL_BIND_SEP))) {
+    if (num >= bf->num) return ERR;
+
+    *ptr = '\0';
+    params[num].value = buf;
+    params[num].len = ptr - buf;
+    params[num].type = bf->type[num];
+    num++;
+    buf = ptr + 1;
+  }
+
+  if (num != bf->num) return ERR;
+
+  return num;
+}
+
 int sql_compose_static_set(int have_flows)
 {
   int set_primitives=0;
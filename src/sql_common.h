@@ -116,6 +116,15 @@ struct insert_data {
   unsigned int uqn; /* UPDATEs query number */
 };
 
+/* purge counters of a writer connection, see sql_purge_pool() */
+struct sql_pool_stats {
+  unsigned int ten;
+  unsigned int een;
+  unsigned int qn;
+  unsigned int iqn;
+  unsigned int uqn;
+};
+
 struct db_cache {
   struct pkt_primitives primitives;
   pm_counter_t bytes_counter;
@@ -152,6 +161,31 @@ struct frags {
   char string[SRVBUFLEN];
 };
 
+/* Prepared statements: frags are rewritten so that handlers print raw values,
+   each one terminated by SQL_BIND_SEP, in place of SQL literals */
+#define SQL_BIND_SEP		'\x1f'
+#define SQL_BIND_INT		1
+#define SQL_BIND_TEXT		2
+#define SQL_BIND_MAX		((N_PRIMITIVES+2)*2)
+
+#define SQL_STMT_UPDATE		0
+#define SQL_STMT_UPDATE_EVENT	1
+#define SQL_STMT_INSERT		2
+#define SQL_STMT_INSERT_EVENT	3
+#define SQL_STMT_MAX		4
+
+struct sql_bind_frags {
+  char sql[LONGLONGSRVBUFLEN];
+  u_int8_t type[SQL_BIND_MAX];
+  int num;
+};
+
+struct sql_bind_param {
+  char *value;
+  int len;
+  u_int8_t type;
+};
+
 /* Backend descriptors */
 struct DBdesc {
   void *desc;
@@ -341,6 +375,11 @@ EXT void sql_db_ok(struct DBdesc *);
 EXT void sql_db_fail(struct DBdesc *);
 EXT void sql_db_errmsg(struct DBdesc *);
 EXT int sql_query(struct BE_descs *, struct db_cache *, struct insert_data *);
+EXT void sql_purge_pool(struct db_cache *[], int, struct insert_data *);
+EXT void sql_purge_slice(struct db_cache *[], int, struct insert_data *);
+EXT void sql_pool_stats_take(struct insert_data *, struct sql_pool_stats *);
+EXT void sql_pool_stats_add(struct sql_pool_stats *, struct sql_pool_stats *);
+EXT void sql_pool_create_tables(struct db_cache *[], int);
 EXT void sql_exit_gracefully(int);
 EXT int sql_evaluate_primitives(int);
 EXT void sql_create_table(struct DBdesc *, time_t *, struct primitives_ptrs *);
@@ -348,6 +387,10 @@ EXT void sql_invalidate_shadow_entries(struct db_cache *[], int *);
 EXT int sql_select_locking_style(char *);
 EXT int sql_compose_static_set(int); 
 EXT int sql_compose_static_set_event(); 
+EXT void sql_bind_compose(struct frags *, int, struct sql_bind_frags *);
+EXT void sql_bind_compose_static(int);
+EXT void sql_bind_compose_stmt(int, char *, int);
+EXT int sql_bind_parse(char *, struct sql_bind_frags *, struct sql_bind_param *);
 EXT void primptrs_set_all_from_db_cache(struct primitives_ptrs *, struct db_cache *);
 
 EXT void sql_sum_host_insert(struct primitives_ptrs *, struct insert_data *);
@@ -394,6 +437,7 @@ EXT struct frags values[N_PRIMITIVES+2];
 EXT struct frags copy_values[N_PRIMITIVES+2];
 EXT struct frags set[N_PRIMITIVES+2];
 EXT struct frags set_event[N_PRIMITIVES+2];
+EXT struct sql_bind_frags bind_values, bind_where, bind_set, bind_set_event;
 EXT int glob_num_primitives; /* last resort for signal handling */
 EXT int glob_basetime; /* last resort for signal handling */
 EXT time_t glob_new_basetime; /* last resort for signal handling */
@@ -407,6 +451,7 @@ EXT struct DBdesc p;
 EXT struct DBdesc b;
 EXT struct BE_descs bed;
 EXT struct largebuf envbuf;
+EXT int sql_pool_tables_created; /* dynamic tables created by sql_purge_pool() */
 EXT time_t now; /* PostgreSQL */
 #undef EXT
 #endif /* #if (!defined __SQL_COMMON_EXPORT) */
@@ -403,6 +403,130 @@ int SQLI_cache_dbop(struct DBdesc *db, struct db_cache *cache_elem, struct inser
   return ret;
 }
 
+int SQLI_cache_dbop_prepared(struct DBdesc *db, struct db_cache *cache_elem, struct insert_data *idata)
+{
+  struct sql_bind_param bvalues[SQL_BIND_MAX], bwhere[SQL_BIND_MAX], bset[SQL_BIND_MAX];
+  sqlite3_stmt *stmt;
+  char *ptr_values, *ptr_where, *ptr_set;
+  int num=0, num_set=0, nvalues, nwhere, nset=0, ret=0, event=FALSE;
+
+  if (cache_elem->flow_type == NF9_FTYPE_EVENT || cache_elem->flow_type == NF9_FTYPE_OPTION) event = TRUE;
+
+  /* collecting values to bind; frags print them out raw */
+  ptr_where = where_clause;
+  ptr_values = values_clause;
+  ptr_set = set_clause;
+  where_clause[0] = '\0';
+  values_clause[0] = '\0';
+  set_clause[0] = '\0';
+
+  for (num = 0; num < idata->num_primitives; num++)
+    (*where[num].handler)(cache_elem, idata, num, &ptr_values, &ptr_where);
+
+  if (event) {
+    for (num_set = 0; set_event[num_set].type; num_set++)
+      (*set_event[num_set].handler)(cache_elem, idata, num_set, &ptr_set, NULL);
+  }
+  else {
+    for (num_set = 0; set[num_set].type; num_set++)
+      (*set[num_set].handler)(cache_elem, idata, num_set, &ptr_set, NULL);
+  }
+
+  nvalues = sql_bind_parse(values_clause, &bind_values, bvalues);
+  nwhere = sql_bind_parse(where_clause, &bind_where, bwhere);
+  if (num_set) nset = sql_bind_parse(set_clause, event ? &bind_set_event : &bind_set, bset);
+
+  if (nvalues < 0 || nwhere < 0 || nset < 0) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): Unable to bind values to prepared statements.\n", config.name, config.type);
+    return TRUE;
+  }
+
+  if (!config.sql_dont_try_update && num_set) {
+    stmt = SQLI_get_stmt(db, event ? SQL_STMT_UPDATE_EVENT : SQL_STMT_UPDATE);
+    if (!stmt) goto signal_error;
+
+    SQLI_bind_params(stmt, 1, bset, nset);
+    SQLI_bind_params(stmt, nset+1, bwhere, nwhere);
+    ret = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (ret != SQLITE_DONE) goto signal_error;
+    ret = 0;
+  }
+
+  if (config.sql_dont_try_update || !num_set || (sqlite3_changes(db->desc) == 0)) {
+    /* UPDATE failed, trying with an INSERT query */
+    stmt = SQLI_get_stmt(db, event ? SQL_STMT_INSERT_EVENT : SQL_STMT_INSERT);
+    if (!stmt) goto signal_error;
+
+    SQLI_bind_params(stmt, 1, bvalues, nvalues);
+    if (!event) {
+      sqlite3_bind_int64(stmt, nvalues+1, (sqlite3_int64) cache_elem->packet_counter);
+      sqlite3_bind_int64(stmt, nvalues+2, (sqlite3_int64) cache_elem->bytes_counter);
+      if (config.what_to_count & COUNT_FLOWS) sqlite3_bind_int64(stmt, nvalues+3, (sqlite3_int64) cache_elem->flows_counter);
+    }
+
+    ret = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (ret != SQLITE_DONE) goto signal_error;
+    ret = 0;
+    idata->iqn++;
+  }
+  else idata->uqn++;
+
+  idata->een++;
+
+  return ret;
+
+  signal_error:
+  SQLI_get_errmsg(db);
+  if (db->errmsg) Log(LOG_ERR, "ERROR ( %s/%s ): %s\n\n", config.name, config.type, db->errmsg);
+
+  return TRUE;
+}
+
+static sqlite3_stmt *SQLI_get_stmt(struct DBdesc *db, int type)
+{
+  sqlite3_stmt **stmt = &sqlite3_stmts[db->type == BE_TYPE_BACKUP ? BE_TYPE_BACKUP : BE_TYPE_PRIMARY][type];
+
+  if (!(*stmt)) {
+    sql_bind_compose_stmt(type, sql_data, sizeof(sql_data));
+    if (sqlite3_prepare_v2(db->desc, sql_data, -1, stmt, NULL) != SQLITE_OK) {
+      Log(LOG_DEBUG, "DEBUG ( %s/%s ): FAILED query follows:\n%s\n", config.name, config.type, sql_data);
+      *stmt = NULL;
+    }
+    else Log(LOG_DEBUG, "DEBUG ( %s/%s ): prepared: %s\n", config.name, config.type, sql_data);
+  }
+
+  return *stmt;
+}
+
+static void SQLI_bind_params(sqlite3_stmt *stmt, int first, struct sql_bind_param *params, int num)
+{
+  int idx;
+
+  for (idx = 0; idx < num; idx++) {
+    if (params[idx].type == SQL_BIND_INT)
+      sqlite3_bind_int64(stmt, first+idx, (sqlite3_int64) strtoll(params[idx].value, NULL, 10));
+    else
+      sqlite3_bind_text(stmt, first+idx, params[idx].value, params[idx].len, SQLITE_STATIC);
+  }
+}
+
+/* statements embed the (possibly dynamic) table name: they are re-prepared
+   on each transaction */
+void SQLI_finalize_stmts(struct DBdesc *db)
+{
+  sqlite3_stmt **stmts = sqlite3_stmts[db->type == BE_TYPE_BACKUP ? BE_TYPE_BACKUP : BE_TYPE_PRIMARY];
+  int idx;
+
+  for (idx = 0; idx < SQL_STMT_MAX; idx++) {
+    if (stmts[idx]) {
+      sqlite3_finalize(stmts[idx]);
+      stmts[idx] = NULL;
+    }
+  }
+}
+
 void SQLI_cache_purge(struct db_cache *queue[], int index, struct insert_data *idata)
 {
   struct db_cache *LastElemCommitted = NULL;
@@ -657,12 +781,16 @@ int SQLI_compose_static_queries()
     }
   }
 
+
+  if (config.sql_prepared_statements) sql_bind_compose_static(primitives);
   return primitives;
 }
 
 void SQLI_Lock(struct DBdesc *db)
 {
   if (!db->fail) {
+    if (config.sql_prepared_statements) SQLI_finalize_stmts(db);
+
     if (sqlite3_exec(db->desc, lock_clause, NULL, NULL, NULL)) {
       SQLI_get_errmsg(db);
       sql_db_errmsg(db);
@@ -691,8 +819,14 @@ void SQLI_DB_Connect(struct DBdesc *db, char *host)
 
 void SQLI_DB_Close(struct BE_descs *bed)
 {
-  if (bed->p->connected) sqlite3_close(bed->p->desc);
-  if (bed->b->connected) sqlite3_close(bed->b->desc);
+  if (bed->p->connected) {
+    SQLI_finalize_stmts(bed->p);
+    sqlite3_close(bed->p->desc);
+  }
+  if (bed->b->connected) {
+    SQLI_finalize_stmts(bed->b);
+    sqlite3_close(bed->b->desc);
+  }
 }
 
 void SQLI_create_dyn_table(struct DBdesc *db, char *buf)
@@ -725,7 +859,8 @@ void SQLI_set_callbacks(struct sqlfunc_cb_registry *cbr)
   cbr->close = SQLI_DB_Close;
   cbr->lock = SQLI_Lock;
   cbr->unlock = SQLI_Unlock;
-  cbr->op = SQLI_cache_dbop;
+  if (!config.sql_prepared_statements) cbr->op = SQLI_cache_dbop;
+  else cbr->op = SQLI_cache_dbop_prepared;
   cbr->create_table = SQLI_create_dyn_table; 
   cbr->purge = SQLI_cache_purge;
   cbr->create_backend = SQLI_create_backend;
@@ -755,6 +890,17 @@ void SQLI_init_default_values(struct insert_data *idata)
   
   if (config.sql_backup_host) idata->recover = TRUE;
 
+  if (config.sql_prepared_statements) {
+    if (config.num_hosts) {
+      Log(LOG_WARNING, "WARN ( %s/%s ): sql_prepared_statements is not compatible with sql_num_hosts. Disabled.\n", config.name, config.type);
+      config.sql_prepared_statements = FALSE;
+    }
+    else if (config.sql_multi_values) {
+      Log(LOG_WARNING, "WARN ( %s/%s ): sql_multi_values is superseded by sql_prepared_statements. Ignored.\n", config.name, config.type);
+      config.sql_multi_values = FALSE;
+    }
+  }
+
   if (config.sql_multi_values) {
     multi_values_buffer = malloc(config.sql_multi_values);
     if (!multi_values_buffer) {
@@ -766,6 +912,11 @@ void SQLI_init_default_values(struct insert_data *idata)
   }
 
   if (config.sql_locking_style) idata->locks = sql_select_locking_style(config.sql_locking_style);
+
+  if (config.sql_writer_connections > 1) {
+    Log(LOG_WARNING, "WARN ( %s/%s ): sql_writer_connections is not supported: SQLite allows a single writer per database. Ignored.\n", config.name, config.type);
+    config.sql_writer_connections = 1;
+  }
 }
 
 void SQLI_sqlite3_get_version()
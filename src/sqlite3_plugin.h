@@ -25,6 +25,10 @@
 /* prototypes */
 void sqlite3_plugin(int, struct configuration *, void *);
 int SQLI_cache_dbop(struct DBdesc *, struct db_cache *, struct insert_data *);
+int SQLI_cache_dbop_prepared(struct DBdesc *, struct db_cache *, struct insert_data *);
+static sqlite3_stmt *SQLI_get_stmt(struct DBdesc *, int);
+static void SQLI_bind_params(sqlite3_stmt *, int, struct sql_bind_param *, int);
+void SQLI_finalize_stmts(struct DBdesc *);
 void SQLI_cache_purge(struct db_cache *[], int, struct insert_data *);
 int SQLI_evaluate_history(int);
 int SQLI_compose_static_queries();
@@ -50,3 +54,4 @@ static char sqlite3_table_v6[] = "acct_v6";
 static char sqlite3_table_v7[] = "acct_v7";
 static char sqlite3_table_v8[] = "acct_v8";
 static char sqlite3_table_bgp[] = "acct_bgp";
+static sqlite3_stmt *sqlite3_stmts[BE_TYPE_BACKUP+1][SQL_STMT_MAX];
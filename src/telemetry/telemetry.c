@@ -38,6 +38,9 @@
 /* variables to be exported away */
 thread_pool_t *telemetry_pool;
 
+/* Global variables */
+static thread_pool_t *telemetry_workers_pool;
+
 /* Functions */
 void telemetry_wrapper()
 {
@@ -107,6 +110,7 @@ void telemetry_daemon(void *t_data_void)
 
   telemetry_misc_db = &inter_domain_misc_dbs[FUNC_TYPE_TELEMETRY];
   memset(telemetry_misc_db, 0, sizeof(telemetry_misc_structs));
+  bgp_misc_locks_init(telemetry_misc_db);
 
   /* initialize variables */
   if (config.telemetry_port_tcp && config.telemetry_port_udp) {
@@ -406,6 +410,12 @@ void telemetry_daemon(void *t_data_void)
       }
       dump_refresh_deadline = tmp_time;
       dump_refresh_deadline += config.telemetry_dump_refresh_time; /* it's a deadline not a basetime */
+
+      /* writers would overwrite each other's files otherwise */
+      if (config.telemetry_dump_workers > 1 && config.telemetry_dump_file && !strstr(config.telemetry_dump_file, "$peer_src_ip")) {
+        Log(LOG_WARNING, "WARN ( %s/%s ): 'telemetry_dump_workers' requires $peer_src_ip in 'telemetry_dump_file'. Using a single writer.\n", config.name, t_data->log_str);
+        config.telemetry_dump_workers = 1;
+      }
     }
     else {
       config.telemetry_dump_file = NULL;
@@ -422,6 +432,13 @@ void telemetry_daemon(void *t_data_void)
 
   telemetry_link_misc_structs(telemetry_misc_db);
 
+  if (config.telemetry_threads) {
+    if (telemetry_misc_db->msglog_backend_methods)
+      telemetry_workers_init(t_data, config.telemetry_threads, config.telemetry_queue_size);
+    else
+      Log(LOG_WARNING, "WARN ( %s/%s ): 'telemetry_daemon_threads' requires msglog output. Ignored.\n", config.name, t_data->log_str);
+  }
+
   for (;;) {
     select_again:
 
@@ -473,6 +490,7 @@ void telemetry_daemon(void *t_data_void)
 	  if (peer->fd) {
 	    if (t_data->now > (peer_udp_timeout->last_msg + config.telemetry_udp_timeout)) {
 	      Log(LOG_INFO, "INFO ( %s/%s ): [%s] telemetry UDP peer removed (timeout).\n", config.name, t_data->log_str, peer->addr_str);
+	      telemetry_peer_queue_drain(peer);
 	      telemetry_peer_close(peer, FUNC_TYPE_TELEMETRY);
 	      if (telemetry_is_zjson(decoder)) telemetry_peer_z_close(peer_z);
 	      recalc_fds = TRUE;
@@ -489,6 +507,9 @@ void telemetry_daemon(void *t_data_void)
     }
 
     if (reload_log_telemetry_thread) {
+      /* decode workers may be writing */
+      pthread_mutex_lock(&telemetry_misc_db->msglog_mutex);
+
       for (peers_idx = 0; peers_idx < config.telemetry_max_peers; peers_idx++) {
         if (telemetry_misc_db->peers_log[peers_idx].fd) {
           fclose(telemetry_misc_db->peers_log[peers_idx].fd);
@@ -498,13 +519,16 @@ void telemetry_daemon(void *t_data_void)
         else break;
       }
 
+      pthread_mutex_unlock(&telemetry_misc_db->msglog_mutex);
       reload_log_telemetry_thread = FALSE;
     }
 
     if (telemetry_misc_db->msglog_backend_methods || telemetry_misc_db->dump_backend_methods) {
+      pthread_mutex_lock(&telemetry_misc_db->msglog_mutex);
       gettimeofday(&telemetry_misc_db->log_tstamp, NULL);
       compose_timestamp(telemetry_misc_db->log_tstamp_str, SRVBUFLEN, &telemetry_misc_db->log_tstamp, TRUE,
 			config.timestamps_since_epoch, config.timestamps_rfc3339, config.timestamps_utc);
+      pthread_mutex_unlock(&telemetry_misc_db->msglog_mutex);
 
       if (telemetry_misc_db->dump_backend_methods) {
         while (telemetry_misc_db->log_tstamp.tv_sec > dump_refresh_deadline) {
@@ -524,8 +548,10 @@ void telemetry_daemon(void *t_data_void)
         time_t last_fail = P_broker_timers_get_last_fail(&telemetry_daemon_msglog_amqp_host.btimers);
 
         if (last_fail && ((last_fail + P_broker_timers_get_retry_interval(&telemetry_daemon_msglog_amqp_host.btimers)) <= telemetry_misc_db->log_tstamp.tv_sec)) {
+          pthread_mutex_lock(&telemetry_misc_db->msglog_mutex);
           telemetry_daemon_msglog_init_amqp_host();
           p_amqp_connect_to_publish(&telemetry_daemon_msglog_amqp_host);
+          pthread_mutex_unlock(&telemetry_misc_db->msglog_mutex);
         }
       }
 #endif
@@ -534,8 +560,11 @@ void telemetry_daemon(void *t_data_void)
       if (config.telemetry_msglog_kafka_topic) {
         time_t last_fail = P_broker_timers_get_last_fail(&telemetry_daemon_msglog_kafka_host.btimers);
 
-        if (last_fail && ((last_fail + P_broker_timers_get_retry_interval(&telemetry_daemon_msglog_kafka_host.btimers)) <= telemetry_misc_db->log_tstamp.tv_sec))
+        if (last_fail && ((last_fail + P_broker_timers_get_retry_interval(&telemetry_daemon_msglog_kafka_host.btimers)) <= telemetry_misc_db->log_tstamp.tv_sec)) {
+          pthread_mutex_lock(&telemetry_misc_db->msglog_mutex);
           telemetry_daemon_msglog_init_kafka_host();
+          pthread_mutex_unlock(&telemetry_misc_db->msglog_mutex);
+        }
       }
 #endif
     }
@@ -737,6 +766,7 @@ void telemetry_daemon(void *t_data_void)
     if (ret <= 0) {
       Log(LOG_INFO, "INFO ( %s/%s ): [%s] connection reset by peer (%d).\n", config.name, t_data->log_str, peer->addr_str, errno);
       FD_CLR(peer->fd, &bkp_read_descs);
+      telemetry_peer_queue_drain(peer);
       telemetry_peer_close(peer, FUNC_TYPE_TELEMETRY);
       if (telemetry_is_zjson(decoder)) telemetry_peer_z_close(peer_z);
       recalc_fds = TRUE;
@@ -751,6 +781,144 @@ void telemetry_daemon(void *t_data_void)
   }
 }
 
+int telemetry_workers_init(struct telemetry_data *t_data, int num, int queue_size)
+{
+  u_int32_t size;
+  int idx;
+
+  if (num <= 0) return 0;
+
+  if (!queue_size) queue_size = TELEMETRY_QUEUE_SIZE_DEFAULT;
+  for (size = 1; size < queue_size; size <<= 1);
+
+  telemetry_peers_queue = malloc(config.telemetry_max_peers * sizeof(telemetry_peer_queue));
+  telemetry_workers = malloc(num * sizeof(telemetry_worker));
+  if (!telemetry_peers_queue || !telemetry_workers) {
+    Log(LOG_ERR, "ERROR ( %s/%s ): Unable to malloc() telemetry workers structure. Terminating.\n", config.name, t_data->log_str);
+    exit_all(1);
+  }
+  memset(telemetry_peers_queue, 0, config.telemetry_max_peers * sizeof(telemetry_peer_queue));
+  memset(telemetry_workers, 0, num * sizeof(telemetry_worker));
+
+  for (idx = 0; idx < num; idx++) {
+    telemetry_workers[idx].id = idx;
+    telemetry_workers[idx].size = size;
+    telemetry_workers[idx].t_data = t_data;
+    pthread_mutex_init(&telemetry_workers[idx].mutex, NULL);
+    pthread_cond_init(&telemetry_workers[idx].cond, NULL);
+
+    telemetry_workers[idx].ring = malloc(size * sizeof(telemetry_queue_msg));
+    if (!telemetry_workers[idx].ring) {
+      Log(LOG_ERR, "ERROR ( %s/%s ): Unable to malloc() telemetry worker #%d queue. Terminating.\n", config.name, t_data->log_str, idx);
+      exit_all(1);
+    }
+    memset(telemetry_workers[idx].ring, 0, size * sizeof(telemetry_queue_msg));
+  }
+
+  telemetry_workers_pool = allocate_thread_pool(num);
+  assert(telemetry_workers_pool);
+
+  for (idx = 0; idx < num; idx++)
+    send_to_pool(telemetry_workers_pool, telemetry_worker_daemon, &telemetry_workers[idx]);
+
+  telemetry_workers_num = num;
+  Log(LOG_INFO, "INFO ( %s/%s ): %d telemetry decode worker thread(s) initialized (queue size: %u)\n",
+      config.name, t_data->log_str, num, size);
+
+  return num;
+}
+
+void telemetry_worker_daemon(void *tw_void)
+{
+  telemetry_worker *tw = tw_void;
+  telemetry_queue_msg *tqm;
+  char event_type[] = "log";
+  u_int32_t head = 0;
+
+  for (;;) {
+    if (head == __atomic_load_n(&tw->tail, __ATOMIC_ACQUIRE)) {
+      pthread_mutex_lock(&tw->mutex);
+      __atomic_store_n(&tw->sleeping, TRUE, __ATOMIC_SEQ_CST);
+
+      while (head == __atomic_load_n(&tw->tail, __ATOMIC_SEQ_CST))
+	pthread_cond_wait(&tw->cond, &tw->mutex);
+
+      __atomic_store_n(&tw->sleeping, FALSE, __ATOMIC_RELAXED);
+      pthread_mutex_unlock(&tw->mutex);
+    }
+
+    tqm = &tw->ring[head & (tw->size - 1)];
+    telemetry_log_msg(tqm->peer, tw->t_data, tqm->data, tqm->len, tqm->data_decoder, tqm->seq,
+		      event_type, config.telemetry_msglog_output);
+
+    /* the peer may be closed as soon as its depth is back to zero */
+    __atomic_sub_fetch(&telemetry_peers_queue[tqm->peer - telemetry_peers].depth, 1, __ATOMIC_RELEASE);
+
+    head++;
+    __atomic_store_n(&tw->head, head, __ATOMIC_RELEASE);
+  }
+}
+
+/* Copies the message in peer->buf to the queue of the worker the peer is bound to */
+int telemetry_worker_enqueue(telemetry_peer *peer, int data_decoder, u_int64_t seq)
+{
+  int peers_idx = (peer - telemetry_peers);
+  telemetry_worker *tw = &telemetry_workers[peers_idx % telemetry_workers_num];
+  telemetry_peer_queue *tpq = &telemetry_peers_queue[peers_idx];
+  telemetry_queue_msg *tqm;
+  u_int32_t tail = tw->tail;
+  char *new_data;
+
+  if ((tail - __atomic_load_n(&tw->head, __ATOMIC_ACQUIRE)) >= tw->size) {
+    tpq->drops++;
+    return ERR;
+  }
+
+  tqm = &tw->ring[tail & (tw->size - 1)];
+
+  if (tqm->size < peer->msglen) {
+    new_data = realloc(tqm->data, peer->msglen);
+    if (!new_data) {
+      tpq->drops++;
+      return ERR;
+    }
+
+    tqm->data = new_data;
+    tqm->size = peer->msglen;
+  }
+
+  memcpy(tqm->data, peer->buf.base, peer->msglen);
+  tqm->len = peer->msglen;
+  tqm->peer = peer;
+  tqm->data_decoder = data_decoder;
+  tqm->seq = seq;
+
+  __atomic_add_fetch(&tpq->depth, 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&tw->tail, (tail + 1), __ATOMIC_SEQ_CST);
+
+  if (__atomic_load_n(&tw->sleeping, __ATOMIC_SEQ_CST)) {
+    pthread_mutex_lock(&tw->mutex);
+    pthread_cond_signal(&tw->cond);
+    pthread_mutex_unlock(&tw->mutex);
+  }
+
+  return SUCCESS;
+}
+
+/* Waits for the messages of the peer still queued to be logged, ie. before closing it */
+void telemetry_peer_queue_drain(telemetry_peer *peer)
+{
+  telemetry_peer_queue *tpq;
+
+  if (!telemetry_workers_num || !peer) return;
+
+  tpq = &telemetry_peers_queue[peer - telemetry_peers];
+
+  while (__atomic_load_n(&tpq->depth, __ATOMIC_ACQUIRE)) usleep(1000);
+
+  tpq->drops = 0;
+}
+
 void telemetry_prepare_thread(struct telemetry_data *t_data)
 {
   if (!t_data) return;
@@ -31,6 +31,7 @@
 #define TELEMETRY_UDP_MAXMSG		65535
 #define TELEMETRY_CISCO_HDR_LEN		12
 #define TELEMETRY_LOG_STATS_INTERVAL	120	
+#define TELEMETRY_QUEUE_SIZE_DEFAULT	1024
 
 #define TELEMETRY_DECODER_UNKNOWN	0
 #define TELEMETRY_DECODER_JSON		1
@@ -106,6 +107,42 @@ typedef struct _telemetry_peer_z telemetry_peer_z;
 typedef struct _telemetry_peer_udp_cache telemetry_peer_udp_cache;
 typedef struct _telemetry_peer_udp_timeout telemetry_peer_udp_timeout;
 
+/* raw message handed over by the receiver to a decode worker */
+struct _telemetry_queue_msg {
+  telemetry_peer *peer;
+  int data_decoder;
+  u_int64_t seq;
+  u_int32_t len;
+  u_int32_t size;
+  char *data;
+};
+
+/*
+  Decode worker: single-producer single-consumer ring, the receiver
+  advances tail and the worker head; the worker sleeps on cond only
+  when the ring is found empty.
+*/
+struct _telemetry_worker {
+  int id;
+  struct _telemetry_queue_msg *ring;
+  u_int32_t size; /* power of two */
+  u_int32_t head;
+  u_int32_t tail;
+  int sleeping;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  struct telemetry_data *t_data;
+};
+
+struct _telemetry_peer_queue {
+  u_int32_t depth; /* messages queued and not yet logged */
+  u_int64_t drops;
+};
+
+typedef struct _telemetry_queue_msg telemetry_queue_msg;
+typedef struct _telemetry_worker telemetry_worker;
+typedef struct _telemetry_peer_queue telemetry_peer_queue;
+
 /* more includes */
 #include "telemetry_logdump.h"
 #include "telemetry_msg.h"
@@ -121,6 +158,10 @@ EXT void telemetry_wrapper();
 EXT void telemetry_daemon(void *);
 EXT void telemetry_prepare_thread(struct telemetry_data *);
 EXT void telemetry_prepare_daemon(struct telemetry_data *);
+EXT int telemetry_workers_init(struct telemetry_data *, int, int);
+EXT void telemetry_worker_daemon(void *);
+EXT int telemetry_worker_enqueue(telemetry_peer *, int, u_int64_t);
+EXT void telemetry_peer_queue_drain(telemetry_peer *);
 #undef EXT
 
 /* global variables */
@@ -135,4 +176,7 @@ EXT telemetry_peer *telemetry_peers;
 EXT telemetry_peer_z *telemetry_peers_z;
 EXT void *telemetry_peers_udp_cache;
 EXT telemetry_peer_udp_timeout *telemetry_peers_udp_timeout; 
+EXT telemetry_peer_queue *telemetry_peers_queue;
+EXT telemetry_worker *telemetry_workers;
+EXT int telemetry_workers_num;
 #undef EXT
@@ -54,29 +54,22 @@ int telemetry_log_msg(telemetry_peer *peer, struct telemetry_data *t_data, void
   if (!strcmp(event_type, "dump")) etype = TELEMETRY_LOGDUMP_ET_DUMP;
   else if (!strcmp(event_type, "log")) etype = TELEMETRY_LOGDUMP_ET_LOG;
 
-#ifdef WITH_RABBITMQ
-  if ((config.telemetry_msglog_amqp_routing_key && etype == TELEMETRY_LOGDUMP_ET_LOG) ||
-      (config.telemetry_dump_amqp_routing_key && etype == TELEMETRY_LOGDUMP_ET_DUMP))
-    p_amqp_set_routing_key(peer->log->amqp_host, peer->log->filename);
-#endif
-
-#ifdef WITH_KAFKA
-  if ((config.telemetry_msglog_kafka_topic && etype == TELEMETRY_LOGDUMP_ET_LOG) ||
-      (config.telemetry_dump_kafka_topic && etype == TELEMETRY_LOGDUMP_ET_DUMP))
-    p_kafka_set_topic(peer->log->kafka_host, peer->log->filename);
-#endif
-
   if (output == PRINT_OUTPUT_JSON) {
 #ifdef WITH_JANSSON
     json_t *obj = json_object();
-    char tstamp_str[SRVBUFLEN];
+    char tstamp_str[SRVBUFLEN], *file_str = NULL, *broker_str = NULL;
+    int to_file, to_broker;
 
     json_object_set_new_nocheck(obj, "event_type", json_string(event_type));
 
     json_object_set_new_nocheck(obj, "seq", json_integer((json_int_t)log_seq));
 
-    if (etype == BGP_LOGDUMP_ET_LOG)
+    /* decode workers log concurrently: timestamp and outputs are shared */
+    if (etype == BGP_LOGDUMP_ET_LOG) {
+      pthread_mutex_lock(&tms->msglog_mutex);
       json_object_set_new_nocheck(obj, "timestamp", json_string(tms->log_tstamp_str));
+      pthread_mutex_unlock(&tms->msglog_mutex);
+    }
     else if (etype == BGP_LOGDUMP_ET_DUMP)
       json_object_set_new_nocheck(obj, "timestamp", json_string(tms->dump.tstamp_str));
 
@@ -103,15 +96,45 @@ int telemetry_log_msg(telemetry_peer *peer, struct telemetry_data *t_data, void
       json_object_set_new_nocheck(obj, "serialization", json_string("gpb"));
     }
 
-    if ((config.telemetry_msglog_file && etype == TELEMETRY_LOGDUMP_ET_LOG) ||
-        (config.telemetry_dump_file && etype == TELEMETRY_LOGDUMP_ET_DUMP))
-      write_and_free_json(peer->log->fd, obj);
+    to_file = ((config.telemetry_msglog_file && etype == TELEMETRY_LOGDUMP_ET_LOG) ||
+               (config.telemetry_dump_file && etype == TELEMETRY_LOGDUMP_ET_DUMP));
+
+    to_broker = ((config.telemetry_msglog_amqp_routing_key && etype == TELEMETRY_LOGDUMP_ET_LOG) ||
+                 (config.telemetry_dump_amqp_routing_key && etype == TELEMETRY_LOGDUMP_ET_DUMP) ||
+                 (config.telemetry_msglog_kafka_topic && etype == TELEMETRY_LOGDUMP_ET_LOG) ||
+                 (config.telemetry_dump_kafka_topic && etype == TELEMETRY_LOGDUMP_ET_DUMP));
+
+    /* serialized out of the lock, only the output is serialized; writer_id
+       is added to a shallow copy so that file records keep their format */
+    if (to_broker) {
+      json_t *broker_obj = json_copy(obj);
+
+      if (broker_obj) {
+        add_writer_name_and_pid_json(broker_obj, config.proc_name, writer_pid);
+        broker_str = compose_json_str(broker_obj);
+      }
+    }
+
+    if (to_file) file_str = compose_json_str(obj);
+    else json_decref(obj);
+
+    if ((to_file && !file_str) || (to_broker && !broker_str)) {
+      free(file_str);
+      free(broker_str);
+      return ERR;
+    }
+
+    if (etype == TELEMETRY_LOGDUMP_ET_LOG) pthread_mutex_lock(&tms->msglog_mutex);
+
+    if (to_file) {
+      if (peer->log->fd) fprintf(peer->log->fd, "%s\n", file_str);
+    }
 
 #ifdef WITH_RABBITMQ
     if ((config.telemetry_msglog_amqp_routing_key && etype == TELEMETRY_LOGDUMP_ET_LOG) ||
         (config.telemetry_dump_amqp_routing_key && etype == TELEMETRY_LOGDUMP_ET_DUMP)) {
-      add_writer_name_and_pid_json(obj, config.proc_name, writer_pid);
-      amqp_ret = write_and_free_json_amqp(peer->log->amqp_host, obj);
+      p_amqp_set_routing_key(peer->log->amqp_host, peer->log->filename);
+      amqp_ret = write_string_amqp(peer->log->amqp_host, broker_str);
       p_amqp_unset_routing_key(peer->log->amqp_host);
     }
 #endif
@@ -119,11 +142,16 @@ int telemetry_log_msg(telemetry_peer *peer, struct telemetry_data *t_data, void
 #ifdef WITH_KAFKA
     if ((config.telemetry_msglog_kafka_topic && etype == TELEMETRY_LOGDUMP_ET_LOG) ||
         (config.telemetry_dump_kafka_topic && etype == TELEMETRY_LOGDUMP_ET_DUMP)) {
-      add_writer_name_and_pid_json(obj, config.proc_name, writer_pid);
-      kafka_ret = write_and_free_json_kafka(peer->log->kafka_host, obj);
+      p_kafka_set_topic(peer->log->kafka_host, peer->log->filename);
+      kafka_ret = write_string_kafka(peer->log->kafka_host, broker_str, strlen(broker_str));
       p_kafka_unset_topic(peer->log->kafka_host);
     }
 #endif
+
+    if (etype == TELEMETRY_LOGDUMP_ET_LOG) pthread_mutex_unlock(&tms->msglog_mutex);
+
+    free(file_str);
+    free(broker_str);
 #endif
   }
 
@@ -261,6 +289,9 @@ void telemetry_handle_dump_event(struct telemetry_data *t_data)
     signal(SIGHUP, SIG_IGN);
     pm_setproctitle("%s %s [%s]", config.type, "Core Process -- Telemetry Dump Writer", config.name);
 
+    /* peers are shared among writers; each one has its own outputs */
+    bgp_dump_writers_spawn(tms, config.telemetry_dump_workers);
+
     memset(last_filename, 0, sizeof(last_filename));
     memset(current_filename, 0, sizeof(current_filename));
     fd_buf = malloc(OUTPUT_FILE_BUFSZ);
@@ -281,12 +312,13 @@ void telemetry_handle_dump_event(struct telemetry_data *t_data)
 #endif
 
     dumper_pid = getpid();
-    Log(LOG_INFO, "INFO ( %s/%s ): *** Dumping telemetry data - START (PID: %u) ***\n", config.name, t_data->log_str, dumper_pid);
+    Log(LOG_INFO, "INFO ( %s/%s ): *** Dumping telemetry data - START (PID: %u, WRITER: %u/%u) ***\n", config.name, t_data->log_str, dumper_pid,
+	tms->dump.writer.id, tms->dump.writer.num);
     start = time(NULL);
     tables_num = 0;
 
     for (peer = NULL, saved_peer = NULL, peers_idx = 0; peers_idx < config.telemetry_max_peers; peers_idx++) {
-      if (telemetry_peers[peers_idx].fd) {
+      if (telemetry_peers[peers_idx].fd && bgp_dump_writer_owns(tms, peers_idx)) {
         peer = &telemetry_peers[peers_idx];
         peer->log = &peer_log; /* abusing telemetry_peer a bit, but we are in a child */
         tdsell = peer->bmp_se;
@@ -376,8 +408,8 @@ void telemetry_handle_dump_event(struct telemetry_data *t_data)
 
     duration = time(NULL)-start;
 
-    Log(LOG_INFO, "INFO ( %s/%s ): *** Dumping telemetry data - END (PID: %u, PEERS: %u ET: %u) ***\n",
-                config.name, t_data->log_str, dumper_pid, tables_num, duration);
+    Log(LOG_INFO, "INFO ( %s/%s ): *** Dumping telemetry data - END (PID: %u, WRITER: %u/%u, PEERS: %u ET: %u) ***\n",
+                config.name, t_data->log_str, dumper_pid, tms->dump.writer.id, tms->dump.writer.num, tables_num, duration);
 
     exit(0);
   default: /* Parent */
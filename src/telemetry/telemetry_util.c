@@ -170,6 +170,16 @@ void telemetry_log_peer_stats(telemetry_peer *peer, struct telemetry_data *t_dat
 	config.name, t_data->log_str, peer->addr_str, peer->tcp_port, peer->stats.packets,
 	peer->stats.packet_bytes, peer->stats.msg_bytes, peer->stats.msg_errors);
 
+  if (telemetry_workers_num) {
+    telemetry_peer_queue *tpq = &telemetry_peers_queue[peer - telemetry_peers];
+
+    Log(LOG_INFO, "INFO ( %s/%s ): [%s:%u] Queue_Depth: %u Queue_Drops: %llu\n",
+	config.name, t_data->log_str, peer->addr_str, peer->tcp_port,
+	__atomic_load_n(&tpq->depth, __ATOMIC_RELAXED), (unsigned long long)tpq->drops);
+
+    tpq->drops = 0;
+  }
+
   t_data->global_stats.packets += peer->stats.packets;
   t_data->global_stats.packet_bytes += peer->stats.packet_bytes;
   t_data->global_stats.msg_bytes += peer->stats.msg_bytes;